@@ -333,9 +333,11 @@ void Rover::one_second_loop(void)
         }
         if (should_log(MASK_LOG_PM)) {
             Log_Write_Performance();
+            scheduler.write_task_stats_log();
         }
         G_Dt_max = 0;
         resetPerfData();
+        scheduler.reset_task_stats();
     }
 
     // save compass offsets once a minute
@@ -448,6 +448,9 @@ bool GCS_MAVLINK_Rover::try_send_message(enum ap_message id)
         send_vibration(rover.ins);
         break;
 
+    case MSG_SCHED_STATS:
+        return send_sched_stats(rover.scheduler);
+
     case MSG_BATTERY2:
         CHECK_PAYLOAD_SIZE(BATTERY2);
         send_battery2(rover.battery);
@@ -496,6 +499,7 @@ bool GCS_MAVLINK_Rover::try_send_message(enum ap_message id)
     case MSG_GIMBAL_REPORT:
     case MSG_POSITION_TARGET_GLOBAL_INT:
     case MSG_LANDING:
+    case MSG_GYRO_FFT:
         break;  // just here to prevent a warning
     }
     return true;
@@ -704,6 +708,7 @@ GCS_MAVLINK_Rover::data_stream_send(void)
         send_message(MSG_EKF_STATUS_REPORT);
         send_message(MSG_VIBRATION);
         send_message(MSG_RPM);
+        send_message(MSG_SCHED_STATS);
     }
 }
 
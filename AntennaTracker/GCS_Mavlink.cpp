@@ -269,6 +269,8 @@ bool GCS_MAVLINK_Tracker::try_send_message(enum ap_message id)
     case MSG_POSITION_TARGET_GLOBAL_INT:
     case MSG_AOA_SSA:
     case MSG_LANDING:
+    case MSG_GYRO_FFT:
+    case MSG_SCHED_STATS:
         break; // just here to prevent a warning
     }
     return true;
@@ -75,6 +75,7 @@
 #include "Copter.h"
 
 #define SCHED_TASK(func, rate_hz, max_time_micros) SCHED_TASK_CLASS(Copter, &copter, func, rate_hz, max_time_micros)
+#define SCHED_TASK_ASYNC_ONLY(func, rate_hz, max_time_micros) SCHED_TASK_CLASS_FLAGS(Copter, &copter, func, rate_hz, max_time_micros, AP_SCHEDULER_TASK_ASYNC | AP_SCHEDULER_TASK_ASYNC_ONLY)
 
 /*
   scheduler table for fast CPUs - all regular tasks apart from the fast_loop()
@@ -137,6 +138,7 @@ const AP_Scheduler::Task Copter::scheduler_tasks[] = {
     SCHED_TASK(afs_fs_check,          10,    100),
 #endif
     SCHED_TASK(terrain_update,        10,    100),
+    SCHED_TASK_ASYNC_ONLY(terrain_io, 50,   2000),
 #if GRIPPER_ENABLED == ENABLED
     SCHED_TASK(gripper_update,        10,     75),
 #endif
@@ -190,8 +192,11 @@ void Copter::barometer_accumulate(void)
 
 void Copter::perf_update(void)
 {
-    if (should_log(MASK_LOG_PM))
+    if (should_log(MASK_LOG_PM)) {
         Log_Write_Performance();
+        scheduler.write_task_stats_log();
+        motors->write_latency_log();
+    }
     if (scheduler.debug()) {
         gcs().send_text(MAV_SEVERITY_WARNING, "PERF: %u/%u %lu %lu",
                           (unsigned)perf_info_get_num_long_running(),
@@ -200,6 +205,8 @@ void Copter::perf_update(void)
                           (unsigned long)perf_info_get_min_time());
     }
     perf_info_reset();
+    scheduler.reset_task_stats();
+    motors->reset_latency_stats();
     pmTest1 = 0;
 }
 
@@ -257,6 +264,9 @@ void Copter::fast_loop()
     // send outputs to the motors library immediately
     motors_output();
 
+    // move the gyro notch filter to follow the new motor outputs
+    update_dynamic_notch();
+
     // run EKF state estimator (expensive)
     // --------------------
     read_AHRS();
@@ -395,6 +405,7 @@ void Copter::ten_hz_logging_loop()
     }
     if (should_log(MASK_LOG_IMU) || should_log(MASK_LOG_IMU_FAST) || should_log(MASK_LOG_IMU_RAW)) {
         DataFlash.Log_Write_Vibration(ins);
+        g2.gyro_fft.write_log();
     }
     if (should_log(MASK_LOG_CTUN)) {
         attitude_control->control_monitor_log();
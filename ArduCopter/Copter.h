@@ -62,6 +62,7 @@
 #include <AP_Proximity/AP_Proximity.h>
 #include <AP_Stats/AP_Stats.h>     // statistics library
 #include <AP_Beacon/AP_Beacon.h>
+#include <AP_GyroFFT/AP_GyroFFT.h>
 #include <AP_OpticalFlow/AP_OpticalFlow.h>     // Optical Flow library
 #include <AP_RSSI/AP_RSSI.h>                   // RSSI Library
 #include <Filter/Filter.h>             // Filter library
@@ -711,6 +712,7 @@ private:
     void send_current_waypoint(mavlink_channel_t chan);
     void send_rpm(mavlink_channel_t chan);
     void rpm_update();
+    void update_dynamic_notch();
     void button_update();
     void init_proximity();
     void update_proximity();
@@ -1058,6 +1060,7 @@ private:
     void epm_update();
     void gripper_update();
     void terrain_update();
+    void terrain_io();
     void terrain_logging();
     bool terrain_use();
     void report_batt_monitor();
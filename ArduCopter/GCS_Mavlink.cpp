@@ -515,6 +515,12 @@ bool GCS_MAVLINK_Copter::try_send_message(enum ap_message id)
         send_vibration(copter.ins);
         break;
 
+    case MSG_GYRO_FFT:
+        return send_gyro_fft(copter.g2.gyro_fft);
+
+    case MSG_SCHED_STATS:
+        return send_sched_stats(copter.scheduler);
+
     case MSG_MISSION_ITEM_REACHED:
         CHECK_PAYLOAD_SIZE(MISSION_ITEM_REACHED);
         mavlink_msg_mission_item_reached_send(chan, mission_item_reached_index);
@@ -730,6 +736,8 @@ GCS_MAVLINK_Copter::data_stream_send(void)
         send_message(MSG_MAG_CAL_PROGRESS);
         send_message(MSG_EKF_STATUS_REPORT);
         send_message(MSG_VIBRATION);
+        send_message(MSG_GYRO_FFT);
+        send_message(MSG_SCHED_STATS);
         send_message(MSG_RPM);
     }
 
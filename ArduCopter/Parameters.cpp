@@ -1014,6 +1014,10 @@ const AP_Param::GroupInfo ParametersG2::var_info[] = {
 
     // ID 19 reserved for TCAL (PR pending)
     // ID 20 reserved for TX_TYPE (PR pending)
+
+    // @Group: FFT_
+    // @Path: ../libraries/AP_GyroFFT/AP_GyroFFT.cpp
+    AP_SUBGROUPINFO(gyro_fft, "FFT_", 21, ParametersG2, AP_GyroFFT),
     
     AP_GROUPEND
 };
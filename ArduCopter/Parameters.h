@@ -570,6 +570,9 @@ public:
     
     // control over servo output ranges
     SRV_Channels servo_channels;
+
+    // in-flight gyro noise analysis
+    AP_GyroFFT gyro_fft;
 };
 
 extern const AP_Param::Info        var_info[];
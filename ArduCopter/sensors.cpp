@@ -97,6 +97,12 @@ void Copter::rpm_update(void)
     }
 }
 
+// move the gyro harmonic notch to follow motor speed
+void Copter::update_dynamic_notch()
+{
+    ins.update_harmonic_notch(motors->get_throttle(), rpm_sensor.get_rpm(0));
+}
+
 // initialise compass
 void Copter::init_compass()
 {
@@ -345,6 +345,9 @@ void Copter::startup_INS_ground()
     // Warm up and calibrate gyro offsets
     ins.init(scheduler.get_loop_rate_hz());
 
+    // start gyro noise analysis now the gyro rates are known
+    g2.gyro_fft.init(ins);
+
     // reset ahrs including gyro bias
     ahrs.reset();
 }
@@ -17,6 +17,15 @@ void Copter::terrain_update()
 #endif
 }
 
+// terrain disk IO, on a scheduler worker thread. Not run at all without
+// SCHED_ASYNC or on boards without workers, where the IO timer does it
+void Copter::terrain_io()
+{
+#if AP_TERRAIN_AVAILABLE && AC_TERRAIN
+    terrain.io_task();
+#endif
+}
+
 // log terrain data - should be called at 1hz
 void Copter::terrain_logging()
 {
@@ -170,6 +170,9 @@ void Plane::ahrs_update()
 
     ahrs.update();
 
+    // move the gyro notch filter to follow motor speed
+    update_dynamic_notch();
+
     if (should_log(MASK_LOG_IMU)) {
         Log_Write_IMU();
     }
@@ -292,8 +295,10 @@ void Plane::update_logging2(void)
     if (should_log(MASK_LOG_RC))
         Log_Write_RC();
 
-    if (should_log(MASK_LOG_IMU))
+    if (should_log(MASK_LOG_IMU)) {
         DataFlash.Log_Write_Vibration(ins);
+        g2.gyro_fft.write_log();
+    }
 }
 
 
@@ -383,9 +388,11 @@ void Plane::log_perf_info()
 
     if (should_log(MASK_LOG_PM)) {
         Log_Write_Performance();
+        scheduler.write_task_stats_log();
     }
 
     resetPerfData();
+    scheduler.reset_task_stats();
 }
 
 void Plane::compass_save()
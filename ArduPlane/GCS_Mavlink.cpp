@@ -662,6 +662,12 @@ bool GCS_MAVLINK_Plane::try_send_message(enum ap_message id)
         send_vibration(plane.ins);
         break;
 
+    case MSG_GYRO_FFT:
+        return send_gyro_fft(plane.g2.gyro_fft);
+
+    case MSG_SCHED_STATS:
+        return send_sched_stats(plane.scheduler);
+
     case MSG_RPM:
         CHECK_PAYLOAD_SIZE(RPM);
         plane.send_rpm(chan);
@@ -907,6 +913,8 @@ GCS_MAVLINK_Plane::data_stream_send(void)
         send_message(MSG_EKF_STATUS_REPORT);
         send_message(MSG_GIMBAL_REPORT);
         send_message(MSG_VIBRATION);
+        send_message(MSG_GYRO_FFT);
+        send_message(MSG_SCHED_STATS);
     }
 
     if (plane.gcs_out_of_time) return;
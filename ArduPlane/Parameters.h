@@ -544,6 +544,9 @@ public:
 
     // mask of channels to do manual pass-thru for
     AP_Int32 manual_rc_mask;
+
+    // in-flight gyro noise analysis
+    AP_GyroFFT gyro_fft;
 };
 
 extern const AP_Param::Info var_info[];
@@ -54,6 +54,7 @@
 #include <AP_RPM/AP_RPM.h>
 #include <AP_Stats/AP_Stats.h>     // statistics library
 #include <AP_Beacon/AP_Beacon.h>
+#include <AP_GyroFFT/AP_GyroFFT.h>
 
 #include <AP_AdvancedFailsafe/AP_AdvancedFailsafe.h>
 #include <APM_Control/APM_Control.h>
@@ -982,6 +983,7 @@ float prev_rng_time =0.0f;
     void read_battery(void);
     void read_receiver_rssi(void);
     void rpm_update(void);
+    void update_dynamic_notch(void);
     void button_update(void);
     void stats_update();
     void ice_update(void);
@@ -243,6 +243,21 @@ void Plane::rpm_update(void)
     }
 }
 
+/*
+  move the gyro harmonic notch to follow motor speed. VTOL motors
+  are followed when they are running, otherwise the forward motor
+ */
+void Plane::update_dynamic_notch(void)
+{
+    float throttle;
+    if (quadplane.available() && quadplane.in_vtol_mode()) {
+        throttle = quadplane.motors->get_throttle();
+    } else {
+        throttle = SRV_Channels::get_output_scaled(SRV_Channel::k_throttle) * 0.01f;
+    }
+    ins.update_harmonic_notch(throttle, rpm_sensor.get_rpm(0));
+}
+
 /*
   update AP_Button
  */
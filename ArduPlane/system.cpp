@@ -650,6 +650,9 @@ void Plane::startup_INS_ground(void)
     ins.init(scheduler.get_loop_rate_hz());
     ahrs.reset();
 
+    // start gyro noise analysis now the gyro rates are known
+    g2.gyro_fft.init(ins);
+
     // read Baro pressure at ground
     //-----------------------------
     init_barometer(true);
@@ -105,6 +105,8 @@ void Sub::perf_update(void)
 {
     if (should_log(MASK_LOG_PM)) {
         Log_Write_Performance();
+        scheduler.write_task_stats_log();
+        motors.write_latency_log();
     }
     if (scheduler.debug()) {
         gcs().send_text(MAV_SEVERITY_WARNING, "PERF: %u/%u %lu %lu",
@@ -114,6 +116,8 @@ void Sub::perf_update(void)
                           (unsigned long)perf_info_get_min_time());
     }
     perf_info_reset();
+    scheduler.reset_task_stats();
+    motors.reset_latency_stats();
     pmTest1 = 0;
 }
 
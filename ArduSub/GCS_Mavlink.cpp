@@ -644,6 +644,7 @@ bool GCS_MAVLINK_Sub::try_send_message(enum ap_message id)
     case MSG_POSITION_TARGET_GLOBAL_INT:
     case MSG_AOA_SSA:
     case MSG_LANDING:
+    case MSG_GYRO_FFT:
         // unused
         break;
 
@@ -657,6 +658,9 @@ bool GCS_MAVLINK_Sub::try_send_message(enum ap_message id)
         send_vibration(sub.ins);
         break;
 
+    case MSG_SCHED_STATS:
+        return send_sched_stats(sub.scheduler);
+
     case MSG_MISSION_ITEM_REACHED:
         CHECK_PAYLOAD_SIZE(MISSION_ITEM_REACHED);
         mavlink_msg_mission_item_reached_send(chan, mission_item_reached_index);
@@ -871,6 +875,7 @@ GCS_MAVLINK_Sub::data_stream_send(void)
 #if RPM_ENABLED == ENABLED
         send_message(MSG_RPM);
 #endif
+        send_message(MSG_SCHED_STATS);
     }
 
     if (sub.gcs_out_of_time) {
@@ -0,0 +1,646 @@
+#include "LogIndex.h"
+
+#include <DataFlash/DFBlockCodec.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// don't split small logs into chunks smaller than this
+#define LOG_INDEX_MIN_CHUNK (1024*1024UL)
+
+// sidecar index file layout: header, then for each defined type a
+// log_index_type followed by its checkpoints
+#define LOG_INDEX_MAGIC "DFINDEX1"
+
+struct PACKED log_index_header {
+    char magic[8];
+    uint64_t log_size;
+    int64_t log_mtime;
+    uint64_t nmessages;
+    uint64_t skipped;
+    uint16_t ntypes;
+};
+
+struct PACKED log_index_type {
+    struct log_Format fmt;
+    uint8_t time;
+    uint64_t count;
+    uint64_t first_us;
+    uint64_t last_us;
+    uint64_t first_offset;
+    uint32_t ncheckpoints;
+};
+
+LogIndex::LogIndex()
+{
+    memset(_types, 0, sizeof(_types));
+    clear();
+}
+
+LogIndex::~LogIndex()
+{
+    clear();
+}
+
+void LogIndex::free_stats(LogIndexStats &s)
+{
+    free(s.checkpoints);
+    memset(&s, 0, sizeof(s));
+}
+
+/*
+  forget everything but the format of FMT itself
+ */
+void LogIndex::clear()
+{
+    for (uint16_t t=0; t<256; t++) {
+        free_stats(_types[t].stats);
+    }
+    memset(_types, 0, sizeof(_types));
+    _nmessages = 0;
+    _skipped = 0;
+    _log_size = 0;
+    _log_mtime = 0;
+    _map = nullptr;
+
+    struct log_Format f {};
+    f.head1 = HEAD_BYTE1;
+    f.head2 = HEAD_BYTE2;
+    f.msgid = LOG_FORMAT_MSG;
+    f.type = LOG_FORMAT_MSG;
+    f.length = sizeof(struct log_Format);
+    strncpy(f.name, "FMT", sizeof(f.name));
+    strncpy(f.format, "BBnNZ", sizeof(f.format));
+    strncpy(f.labels, "Type,Length,Name,Format,Columns", sizeof(f.labels));
+    set_format(f);
+}
+
+/*
+  see if the first field of a format is a timestamp we can index by
+ */
+static bool first_label_is(const struct log_Format &f, const char *label)
+{
+    const size_t len = strlen(label);
+    return strncmp(f.labels, label, len) == 0 &&
+        (f.labels[len] == ',' || f.labels[len] == 0);
+}
+
+void LogIndex::set_format(const struct log_Format &f)
+{
+    LogIndexType &t = _types[f.type];
+    t.fmt = f;
+    t.time = LOG_INDEX_TIME_NONE;
+    if (f.format[0] == 'Q' && first_label_is(f, "TimeUS")) {
+        t.time = LOG_INDEX_TIME_US;
+    } else if (f.format[0] == 'I' && first_label_is(f, "TimeMS")) {
+        t.time = LOG_INDEX_TIME_MS;
+    }
+}
+
+/*
+  check a FMT message found by searching for its header bytes. The
+  length it gives must match the sizes of its fields
+ */
+bool LogIndex::valid_format(const struct log_Format &f) const
+{
+    if (f.length < LOG_PACKET_HEADER_LEN || f.name[0] == 0) {
+        return false;
+    }
+    for (uint8_t i=0; i<sizeof(f.name) && f.name[i] != 0; i++) {
+        if (f.name[i] < 0x20 || f.name[i] > 0x7e) {
+            return false;
+        }
+    }
+    uint16_t len = LOG_PACKET_HEADER_LEN;
+    for (uint8_t i=0; i<sizeof(f.format) && f.format[i] != 0; i++) {
+        switch (f.format[i]) {
+        case 'b': case 'B': case 'M':
+            len += 1;
+            break;
+        case 'h': case 'H': case 'c': case 'C':
+            len += 2;
+            break;
+        case 'i': case 'I': case 'e': case 'E': case 'L': case 'f': case 'n':
+            len += 4;
+            break;
+        case 'd': case 'q': case 'Q':
+            len += 8;
+            break;
+        case 'N':
+            len += 16;
+            break;
+        case 'Z': case 'a':
+            len += 64;
+            break;
+        default:
+            return false;
+        }
+    }
+    return len == f.length;
+}
+
+uint64_t LogIndex::msg_time_us(uint8_t t, const uint8_t *msg) const
+{
+    switch (_types[t].time) {
+    case LOG_INDEX_TIME_US: {
+        uint64_t time_us;
+        memcpy(&time_us, &msg[LOG_PACKET_HEADER_LEN], sizeof(time_us));
+        return time_us;
+    }
+    case LOG_INDEX_TIME_MS: {
+        uint32_t time_ms;
+        memcpy(&time_ms, &msg[LOG_PACKET_HEADER_LEN], sizeof(time_ms));
+        return time_ms * 1000ULL;
+    }
+    }
+    return 0;
+}
+
+bool LogIndex::message_at(const uint8_t *log, uint64_t ofs, uint8_t &len) const
+{
+    if (_log_size - ofs < LOG_PACKET_HEADER_LEN ||
+        log[ofs] != HEAD_BYTE1 || log[ofs+1] != HEAD_BYTE2) {
+        return false;
+    }
+    len = _types[log[ofs+2]].fmt.length;
+    return len != 0 && _log_size - ofs >= len;
+}
+
+uint64_t LogIndex::resync(const uint8_t *log, uint64_t ofs) const
+{
+    while (ofs < _log_size) {
+        const uint8_t *p = (const uint8_t *)memchr(&log[ofs], HEAD_BYTE1, _log_size - ofs);
+        if (p == nullptr) {
+            break;
+        }
+        ofs = p - log;
+        uint64_t next = ofs;
+        uint8_t n;
+        for (n=0; n<LOG_INDEX_SYNC_MESSAGES && next < _log_size; n++) {
+            uint8_t len;
+            if (!message_at(log, next, len)) {
+                break;
+            }
+            next += len;
+        }
+        if (n == LOG_INDEX_SYNC_MESSAGES || next == _log_size) {
+            return ofs;
+        }
+        ofs++;
+    }
+    return _log_size;
+}
+
+const uint8_t *LogIndex::map_log(const char *logfile) const
+{
+    int fd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (fd == -1) {
+        perror(logfile);
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        (uint64_t)st.st_size != _log_size ||
+        (int64_t)st.st_mtime != _log_mtime ||
+        _log_size == 0) {
+        ::printf("%s has changed since it was indexed\n", logfile);
+        ::close(fd);
+        return nullptr;
+    }
+    void *p = mmap(nullptr, _log_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        perror(logfile);
+        return nullptr;
+    }
+    return (const uint8_t *)p;
+}
+
+void LogIndex::unmap_log(const uint8_t *log) const
+{
+    munmap((void *)log, _log_size);
+}
+
+bool LogIndex::add_checkpoint(LogIndexStats &s, uint64_t time_us, uint64_t offset)
+{
+    if (s.ncheckpoints == s.checkpoint_space) {
+        const uint32_t space = s.checkpoint_space ? s.checkpoint_space * 2 : 16;
+        LogIndexCheckpoint *c = (LogIndexCheckpoint *)realloc(s.checkpoints, space * sizeof(*c));
+        if (c == nullptr) {
+            return false;
+        }
+        s.checkpoints = c;
+        s.checkpoint_space = space;
+    }
+    s.checkpoints[s.ncheckpoints].time_us = time_us;
+    s.checkpoints[s.ncheckpoints].offset = offset;
+    s.ncheckpoints++;
+    return true;
+}
+
+/*
+  collect the FMT messages in a chunk
+ */
+void LogIndex::find_formats(chunk &c)
+{
+    for (uint64_t ofs = c.start; ofs < c.end; ofs++) {
+        const uint8_t *p = (const uint8_t *)memchr(&_map[ofs], HEAD_BYTE1, c.end - ofs);
+        if (p == nullptr) {
+            break;
+        }
+        ofs = p - _map;
+        if (_log_size - ofs < sizeof(struct log_Format)) {
+            break;
+        }
+        if (p[1] != HEAD_BYTE2 || p[2] != LOG_FORMAT_MSG) {
+            continue;
+        }
+        struct log_Format f;
+        memcpy(&f, p, sizeof(f));
+        if (!valid_format(f)) {
+            continue;
+        }
+        if (c.nformats == c.format_space) {
+            const uint32_t space = c.format_space ? c.format_space * 2 : 64;
+            struct log_Format *formats = (struct log_Format *)realloc(c.formats, space * sizeof(f));
+            if (formats == nullptr) {
+                return;
+            }
+            c.formats = formats;
+            c.format_space = space;
+        }
+        c.formats[c.nformats++] = f;
+    }
+}
+
+/*
+  parse the messages of a chunk from from, which is known to be the
+  start of a message if in_sync is set, or else from the first point
+  after it where the log is in sync.
+
+  A message is a checkpoint if it is the first of its type in its
+  LOG_INDEX_CHECKPOINT_BYTES of the log, which doesn't depend on where
+  the chunks start. The first of each type in a chunk is kept as one
+  for merge() to check against the chunk before
+ */
+void LogIndex::index_chunk(chunk &c, uint64_t from, bool in_sync)
+{
+    for (uint16_t t=0; t<256; t++) {
+        free_stats(c.stats[t]);
+    }
+    c.nmessages = 0;
+    c.skipped = 0;
+
+    uint64_t ofs = in_sync ? from : resync(_map, from);
+    c.first_msg = ofs;
+    while (ofs < c.end) {
+        uint8_t len;
+        if (!message_at(_map, ofs, len)) {
+            const uint64_t next = resync(_map, ofs+1);
+            c.skipped += next - ofs;
+            ofs = next;
+            continue;
+        }
+        const uint8_t t = _map[ofs+2];
+        LogIndexStats &s = c.stats[t];
+        const uint64_t time_us = msg_time_us(t, &_map[ofs]);
+        if (s.count == 0) {
+            s.first_offset = ofs;
+            s.first_us = time_us;
+            s.last_us = time_us;
+        } else {
+            s.first_us = MIN(s.first_us, time_us);
+            s.last_us = MAX(s.last_us, time_us);
+        }
+        if (s.count == 0 ||
+            ofs / LOG_INDEX_CHECKPOINT_BYTES !=
+            s.checkpoints[s.ncheckpoints-1].offset / LOG_INDEX_CHECKPOINT_BYTES) {
+            add_checkpoint(s, time_us, ofs);
+        }
+        s.count++;
+        c.nmessages++;
+        ofs += len;
+    }
+    c.next_msg = ofs;
+}
+
+void *LogIndex::find_formats_thread(void *arg)
+{
+    chunk *c = (chunk *)arg;
+    c->index->find_formats(*c);
+    return nullptr;
+}
+
+void *LogIndex::index_chunk_thread(void *arg)
+{
+    chunk *c = (chunk *)arg;
+    c->index->index_chunk(*c, c->start, false);
+    return nullptr;
+}
+
+/*
+  run fn on every chunk, each in its own thread
+ */
+void LogIndex::run_threads(chunk *chunks, uint8_t n, void *(*fn)(void *))
+{
+    pthread_t threads[UINT8_MAX];
+    bool started[UINT8_MAX];
+    for (uint8_t i=0; i<n; i++) {
+        started[i] = pthread_create(&threads[i], nullptr, fn, &chunks[i]) == 0;
+        if (!started[i]) {
+            // run it here instead
+            fn(&chunks[i]);
+        }
+    }
+    for (uint8_t i=0; i<n; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], nullptr);
+        }
+    }
+}
+
+/*
+  add the statistics of a chunk to those of the log. Chunks must be
+  merged in order so checkpoints stay sorted by offset
+ */
+void LogIndex::merge(const chunk &c)
+{
+    for (uint16_t t=0; t<256; t++) {
+        const LogIndexStats &cs = c.stats[t];
+        if (cs.count == 0) {
+            continue;
+        }
+        LogIndexStats &s = _types[t].stats;
+        if (s.count == 0) {
+            s.first_offset = cs.first_offset;
+            s.first_us = cs.first_us;
+            s.last_us = cs.last_us;
+        } else {
+            s.first_us = MIN(s.first_us, cs.first_us);
+            s.last_us = MAX(s.last_us, cs.last_us);
+        }
+        for (uint32_t i=0; i<cs.ncheckpoints; i++) {
+            const LogIndexCheckpoint &cp = cs.checkpoints[i];
+            if (i == 0 && s.ncheckpoints != 0 &&
+                cp.offset / LOG_INDEX_CHECKPOINT_BYTES ==
+                s.checkpoints[s.ncheckpoints-1].offset / LOG_INDEX_CHECKPOINT_BYTES) {
+                // not the first of its type in this part of the log
+                continue;
+            }
+            add_checkpoint(s, cp.time_us, cp.offset);
+        }
+        s.count += cs.count;
+    }
+    _nmessages += c.nmessages;
+    _skipped += c.skipped;
+}
+
+bool LogIndex::build(const char *logfile, uint8_t nthreads)
+{
+    clear();
+
+    int fd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (fd == -1) {
+        perror(logfile);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::printf("%s: not a regular file\n", logfile);
+        ::close(fd);
+        return false;
+    }
+    _log_size = st.st_size;
+    _log_mtime = st.st_mtime;
+    if (_log_size == 0) {
+        ::close(fd);
+        return true;
+    }
+    void *p = mmap(nullptr, _log_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        perror(logfile);
+        return false;
+    }
+    _map = (const uint8_t *)p;
+
+    if (DFBlockDecoder::is_block(_map, _log_size)) {
+        ::printf("%s is compressed, unpack it with Replay --unpack first\n", logfile);
+        munmap(p, _log_size);
+        _map = nullptr;
+        return false;
+    }
+
+    uint8_t n = MAX(nthreads, 1);
+    if (n > _log_size / LOG_INDEX_MIN_CHUNK) {
+        n = _log_size / LOG_INDEX_MIN_CHUNK + 1;
+    }
+    chunk *chunks = new chunk[n]();
+    for (uint8_t i=0; i<n; i++) {
+        chunks[i].index = this;
+        chunks[i].start = _log_size * i / n;
+        chunks[i].end = _log_size * (i+1) / n;
+    }
+
+    // the first definition of each type wins, as a log reader would
+    // see it before any message of that type
+    run_threads(chunks, n, find_formats_thread);
+    for (uint8_t i=0; i<n; i++) {
+        for (uint32_t j=0; j<chunks[i].nformats; j++) {
+            const struct log_Format &f = chunks[i].formats[j];
+            if (f.type != LOG_FORMAT_MSG && _types[f.type].fmt.length == 0) {
+                set_format(f);
+            }
+        }
+        free(chunks[i].formats);
+        chunks[i].formats = nullptr;
+    }
+
+    run_threads(chunks, n, index_chunk_thread);
+
+    // a chunk that resynced somewhere other than where the one before
+    // it stopped was misled by data that looked like messages, so
+    // parse it again from the right place
+    for (uint8_t i=1; i<n; i++) {
+        if (chunks[i].first_msg != chunks[i-1].next_msg) {
+            index_chunk(chunks[i], chunks[i-1].next_msg, true);
+        }
+    }
+    chunks[0].skipped += chunks[0].first_msg;
+
+    for (uint8_t i=0; i<n; i++) {
+        merge(chunks[i]);
+        for (uint16_t t=0; t<256; t++) {
+            free_stats(chunks[i].stats[t]);
+        }
+    }
+    delete[] chunks;
+
+    munmap(p, _log_size);
+    _map = nullptr;
+    return true;
+}
+
+uint64_t LogIndex::start_offset(uint8_t t, uint64_t time_us) const
+{
+    const LogIndexStats &s = _types[t].stats;
+    if (s.count == 0) {
+        return _log_size;
+    }
+    if (_types[t].time == LOG_INDEX_TIME_NONE) {
+        return s.first_offset;
+    }
+    // last checkpoint strictly before time_us, as messages with equal
+    // timestamps may come just before a checkpoint
+    uint32_t lo = 0;
+    uint32_t hi = s.ncheckpoints;
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (s.checkpoints[mid].time_us < time_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return s.first_offset;
+    }
+    return s.checkpoints[lo-1].offset;
+}
+
+uint64_t LogIndex::end_offset(uint8_t t, uint64_t time_us) const
+{
+    const LogIndexStats &s = _types[t].stats;
+    if (s.count == 0) {
+        return 0;
+    }
+    if (_types[t].time == LOG_INDEX_TIME_NONE || s.last_us <= time_us) {
+        return _log_size;
+    }
+    // first checkpoint after time_us
+    uint32_t lo = 0;
+    uint32_t hi = s.ncheckpoints;
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (s.checkpoints[mid].time_us <= time_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == s.ncheckpoints) {
+        return _log_size;
+    }
+    return s.checkpoints[lo].offset;
+}
+
+bool LogIndex::save(const char *idxfile) const
+{
+    FILE *f = fopen(idxfile, "wb");
+    if (f == nullptr) {
+        perror(idxfile);
+        return false;
+    }
+
+    struct log_index_header hdr {};
+    memcpy(hdr.magic, LOG_INDEX_MAGIC, sizeof(hdr.magic));
+    hdr.log_size = _log_size;
+    hdr.log_mtime = _log_mtime;
+    hdr.nmessages = _nmessages;
+    hdr.skipped = _skipped;
+    for (uint16_t t=0; t<256; t++) {
+        if (_types[t].fmt.length != 0) {
+            hdr.ntypes++;
+        }
+    }
+    fwrite(&hdr, sizeof(hdr), 1, f);
+
+    for (uint16_t t=0; t<256; t++) {
+        const LogIndexType &type = _types[t];
+        if (type.fmt.length == 0) {
+            continue;
+        }
+        struct log_index_type it {};
+        it.fmt = type.fmt;
+        it.time = type.time;
+        it.count = type.stats.count;
+        it.first_us = type.stats.first_us;
+        it.last_us = type.stats.last_us;
+        it.first_offset = type.stats.first_offset;
+        it.ncheckpoints = type.stats.ncheckpoints;
+        fwrite(&it, sizeof(it), 1, f);
+        fwrite(type.stats.checkpoints, sizeof(LogIndexCheckpoint), it.ncheckpoints, f);
+    }
+
+    if (ferror(f) || fclose(f) != 0) {
+        perror(idxfile);
+        unlink(idxfile);
+        return false;
+    }
+    return true;
+}
+
+bool LogIndex::load(const char *idxfile, const char *logfile)
+{
+    clear();
+
+    struct stat st;
+    if (stat(logfile, &st) != 0) {
+        return false;
+    }
+    FILE *f = fopen(idxfile, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    struct log_index_header hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        memcmp(hdr.magic, LOG_INDEX_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.log_size != (uint64_t)st.st_size ||
+        hdr.log_mtime != (int64_t)st.st_mtime) {
+        // missing, or built from an older copy of the log
+        fclose(f);
+        return false;
+    }
+    _log_size = hdr.log_size;
+    _log_mtime = hdr.log_mtime;
+    _nmessages = hdr.nmessages;
+    _skipped = hdr.skipped;
+
+    for (uint16_t i=0; i<hdr.ntypes; i++) {
+        struct log_index_type it;
+        if (fread(&it, sizeof(it), 1, f) != 1) {
+            break;
+        }
+        set_format(it.fmt);
+        LogIndexStats &s = _types[it.fmt.type].stats;
+        free_stats(s);
+        s.count = it.count;
+        s.first_us = it.first_us;
+        s.last_us = it.last_us;
+        s.first_offset = it.first_offset;
+        if (it.ncheckpoints == 0) {
+            continue;
+        }
+        s.checkpoints = (LogIndexCheckpoint *)malloc(it.ncheckpoints * sizeof(LogIndexCheckpoint));
+        if (s.checkpoints == nullptr ||
+            fread(s.checkpoints, sizeof(LogIndexCheckpoint), it.ncheckpoints, f) != it.ncheckpoints) {
+            break;
+        }
+        s.ncheckpoints = it.ncheckpoints;
+        s.checkpoint_space = it.ncheckpoints;
+    }
+    const bool ok = !ferror(f) && feof(f) == 0 && fgetc(f) == EOF;
+    fclose(f);
+    if (!ok) {
+        clear();
+    }
+    return ok;
+}
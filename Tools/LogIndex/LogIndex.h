@@ -0,0 +1,136 @@
+#pragma once
+
+/*
+  index of a DataFlash log: the formats of its message types, their
+  counts and time ranges, and a checkpoint at the first message of
+  each type in every LOG_INDEX_CHECKPOINT_BYTES of the log so a time
+  range can be read without parsing the log from the start.
+
+  The log is memory mapped and indexed in parallel chunks. Each chunk
+  is parsed from the first point after its start where
+  LOG_INDEX_SYNC_MESSAGES messages follow each other, and chunks whose
+  start doesn't line up with the end of the chunk before them are
+  parsed again from there, so the index is the same whatever the
+  number of threads.
+ */
+
+#include <DataFlash/DataFlash.h>
+
+#define LOG_INDEX_CHECKPOINT_BYTES    (64*1024UL)
+#define LOG_INDEX_SYNC_MESSAGES       3
+
+// how a message type is timestamped
+enum log_index_time {
+    LOG_INDEX_TIME_NONE = 0,
+    LOG_INDEX_TIME_US   = 1, // first field is a uint64_t TimeUS
+    LOG_INDEX_TIME_MS   = 2, // first field is a uint32_t TimeMS
+};
+
+struct LogIndexCheckpoint {
+    uint64_t time_us;
+    uint64_t offset;
+};
+
+struct LogIndexStats {
+    uint64_t count;
+    uint64_t first_us;
+    uint64_t last_us;
+    uint64_t first_offset;
+    uint32_t ncheckpoints;
+    uint32_t checkpoint_space;
+    LogIndexCheckpoint *checkpoints;
+};
+
+struct LogIndexType {
+    struct log_Format fmt; // length is 0 for types the log doesn't define
+    uint8_t time;          // log_index_time
+    LogIndexStats stats;
+};
+
+class LogIndex {
+public:
+    LogIndex();
+    ~LogIndex();
+
+    // index logfile using nthreads threads
+    bool build(const char *logfile, uint8_t nthreads);
+
+    // sidecar index file, checked against the size and modification
+    // time of the log it was built from
+    bool save(const char *idxfile) const;
+    bool load(const char *idxfile, const char *logfile);
+
+    const LogIndexType &type(uint8_t t) const { return _types[t]; }
+
+    /*
+      offsets to read between to see every message of type t from
+      time_us on, and every one up to time_us. Timestamps of a type
+      are assumed to increase through the log
+     */
+    uint64_t start_offset(uint8_t t, uint64_t time_us) const;
+    uint64_t end_offset(uint8_t t, uint64_t time_us) const;
+
+    // timestamp of a message of type t, 0 if it has none
+    uint64_t msg_time_us(uint8_t t, const uint8_t *msg) const;
+
+    /*
+      memory map the log the index was built from, to read with
+      message_at() and resync(). Returns nullptr if it has changed
+      since it was indexed
+     */
+    const uint8_t *map_log(const char *logfile) const;
+    void unmap_log(const uint8_t *log) const;
+
+    // true if a complete message of a known type starts at ofs
+    bool message_at(const uint8_t *log, uint64_t ofs, uint8_t &len) const;
+
+    /*
+      first offset at or after ofs where LOG_INDEX_SYNC_MESSAGES
+      messages follow each other, or where messages run up to the end
+      of the log. Returns the log size if there is none
+     */
+    uint64_t resync(const uint8_t *log, uint64_t ofs) const;
+
+    uint64_t nmessages() const { return _nmessages; }
+    uint64_t skipped() const { return _skipped; }
+    uint64_t log_size() const { return _log_size; }
+
+private:
+    LogIndexType _types[256];
+    uint64_t _nmessages;
+    uint64_t _skipped;     // bytes that didn't parse as messages
+    uint64_t _log_size;
+    int64_t _log_mtime;
+
+    // state of the log being indexed
+    const uint8_t *_map;
+
+    struct chunk {
+        LogIndex *index;
+        uint64_t start;
+        uint64_t end;
+        uint64_t first_msg;   // first message parsed
+        uint64_t next_msg;    // end of the last message parsed
+        uint64_t nmessages;
+        uint64_t skipped;
+        LogIndexStats stats[256];
+        // FMT messages found in the chunk
+        uint32_t nformats;
+        uint32_t format_space;
+        struct log_Format *formats;
+    };
+
+    static void *find_formats_thread(void *arg);
+    static void *index_chunk_thread(void *arg);
+    void find_formats(chunk &c);
+    void index_chunk(chunk &c, uint64_t from, bool in_sync);
+    void run_threads(chunk *chunks, uint8_t n, void *(*fn)(void *));
+    void merge(const chunk &c);
+
+    bool valid_format(const struct log_Format &f) const;
+    void set_format(const struct log_Format &f);
+
+    static bool add_checkpoint(LogIndexStats &s, uint64_t time_us, uint64_t offset);
+    static void free_stats(LogIndexStats &s);
+    void clear();
+};
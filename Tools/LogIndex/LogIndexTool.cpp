@@ -0,0 +1,230 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  index DataFlash logs and query them by message type and time:
+
+    LogIndex -- [options] LOG.BIN...
+
+  The index of LOG.BIN is kept in LOG.BIN.idx and rebuilt when the log
+  changes.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/getopt_cpp.h>
+
+#include "LogIndex.h"
+#include "LogQuery.h"
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class LogIndexTool : public AP_HAL::HAL::Callbacks {
+public:
+    void setup() override;
+    void loop() override {}
+
+private:
+    uint8_t nthreads;
+    bool rebuild;
+    bool info;
+    const char *types;
+    bool query;
+    uint64_t from_us;
+    uint64_t to_us = UINT64_MAX;
+
+    void usage(void);
+    void parse_command_line(uint8_t argc, char * const argv[], uint8_t &nlogs, char * const *&logs);
+    bool get_index(LogIndex &index, const char *logfile);
+    void print_info(const LogIndex &index);
+};
+
+static LogIndexTool tool;
+
+void LogIndexTool::usage(void)
+{
+    ::printf("Usage: LogIndex -- [options] LOG.BIN...\n");
+    ::printf("Options:\n");
+    ::printf("\t-j N               index with N threads\n");
+    ::printf("\t--rebuild          rebuild the index even if it is up to date\n");
+    ::printf("\t--info             print the message types in the log\n");
+    ::printf("\t--types LIST       print messages of these types, comma separated\n");
+    ::printf("\t--from SECONDS     print messages from this time\n");
+    ::printf("\t--to SECONDS       print messages up to this time\n");
+}
+
+enum {
+    OPT_REBUILD = 128,
+    OPT_INFO,
+    OPT_TYPES,
+    OPT_FROM,
+    OPT_TO,
+};
+
+void LogIndexTool::parse_command_line(uint8_t argc, char * const argv[], uint8_t &nlogs, char * const *&logs)
+{
+    const struct GetOptLong::option options[] = {
+        {"help",            false,  0, 'h'},
+        {"rebuild",         false,  0, OPT_REBUILD},
+        {"info",            false,  0, OPT_INFO},
+        {"types",           true,   0, OPT_TYPES},
+        {"from",            true,   0, OPT_FROM},
+        {"to",              true,   0, OPT_TO},
+        {0, false, 0, 0}
+    };
+
+    const long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    nthreads = constrain_int32(ncpus, 1, UINT8_MAX);
+
+    GetOptLong gopt(argc, argv, "j:h", options);
+
+    int opt;
+    while ((opt = gopt.getoption()) != -1) {
+        switch (opt) {
+        case 'j':
+            nthreads = constrain_int32(strtol(gopt.optarg, NULL, 0), 1, UINT8_MAX);
+            break;
+
+        case OPT_REBUILD:
+            rebuild = true;
+            break;
+
+        case OPT_INFO:
+            info = true;
+            break;
+
+        case OPT_TYPES:
+            types = gopt.optarg;
+            query = true;
+            break;
+
+        case OPT_FROM:
+            from_us = atof(gopt.optarg) * 1.0e6;
+            query = true;
+            break;
+
+        case OPT_TO:
+            to_us = atof(gopt.optarg) * 1.0e6;
+            query = true;
+            break;
+
+        case 'h':
+        default:
+            usage();
+            exit(0);
+        }
+    }
+
+    nlogs = argc - gopt.optind;
+    logs = &argv[gopt.optind];
+}
+
+/*
+  load the index of a log, building it if it is missing or stale
+ */
+bool LogIndexTool::get_index(LogIndex &index, const char *logfile)
+{
+    char idxfile[PATH_MAX];
+    snprintf(idxfile, sizeof(idxfile), "%s.idx", logfile);
+
+    if (!rebuild && index.load(idxfile, logfile)) {
+        return true;
+    }
+
+    const uint64_t start_us = AP_HAL::micros64();
+    if (!index.build(logfile, nthreads)) {
+        return false;
+    }
+    const uint64_t dt_us = AP_HAL::micros64() - start_us;
+    ::fprintf(stderr, "Indexed %s: %" PRIu64 " messages in %.3fs (%.1f MB/s)\n",
+              logfile, index.nmessages(), dt_us * 1.0e-6,
+              dt_us ? index.log_size() / (double)dt_us : 0.0);
+    if (index.skipped() != 0) {
+        ::fprintf(stderr, "Skipped %" PRIu64 " bytes of corrupt data\n", index.skipped());
+    }
+
+    // an index we can't save is still good for this run
+    index.save(idxfile);
+    return true;
+}
+
+void LogIndexTool::print_info(const LogIndex &index)
+{
+    ::printf("%-5s %10s %12s %12s %9s\n", "Type", "Count", "First", "Last", "Rate");
+    for (uint16_t t=0; t<256; t++) {
+        const LogIndexType &type = index.type(t);
+        if (type.stats.count == 0) {
+            continue;
+        }
+        ::printf("%-5.4s %10" PRIu64, type.fmt.name, type.stats.count);
+        if (type.time == LOG_INDEX_TIME_NONE) {
+            ::printf("\n");
+            continue;
+        }
+        const double first = type.stats.first_us * 1.0e-6;
+        const double last = type.stats.last_us * 1.0e-6;
+        ::printf(" %12.3f %12.3f", first, last);
+        if (last > first) {
+            ::printf(" %7.1fHz", (type.stats.count - 1) / (last - first));
+        }
+        ::printf("\n");
+    }
+    ::printf("%" PRIu64 " messages, %" PRIu64 " bytes skipped\n",
+             index.nmessages(), index.skipped());
+}
+
+void LogIndexTool::setup()
+{
+    uint8_t argc;
+    char * const *argv;
+
+    hal.util->commandline_arguments(argc, argv);
+
+    uint8_t nlogs;
+    char * const *logs;
+    parse_command_line(argc, argv, nlogs, logs);
+    if (nlogs == 0) {
+        usage();
+        exit(1);
+    }
+
+    for (uint8_t i=0; i<nlogs; i++) {
+        LogIndex index;
+        if (!get_index(index, logs[i])) {
+            exit(1);
+        }
+        if (info) {
+            print_info(index);
+        }
+        if (query) {
+            LogQuery q(index);
+            if (types != nullptr && !q.set_types(types)) {
+                continue;
+            }
+            q.set_range(from_us, to_us);
+            if (!q.run(logs[i])) {
+                exit(1);
+            }
+        }
+    }
+    exit(0);
+}
+
+AP_HAL_MAIN_CALLBACKS(&tool);
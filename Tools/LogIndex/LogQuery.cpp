@@ -0,0 +1,163 @@
+#include "LogQuery.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+LogQuery::LogQuery(const LogIndex &index) :
+    _index(index)
+{
+}
+
+bool LogQuery::set_types(const char *list)
+{
+    char *str = strdup(list);
+    if (str == nullptr) {
+        return false;
+    }
+    char *saveptr = nullptr;
+    for (char *p=strtok_r(str, ",", &saveptr); p; p=strtok_r(nullptr, ",", &saveptr)) {
+        bool found = false;
+        for (uint16_t t=0; t<256; t++) {
+            const struct log_Format &f = _index.type(t).fmt;
+            if (f.length != 0 && strncmp(f.name, p, sizeof(f.name)) == 0 &&
+                strlen(p) <= sizeof(f.name)) {
+                _selected[t] = true;
+                found = true;
+            }
+        }
+        if (!found) {
+            ::printf("No messages of type %s in log\n", p);
+            free(str);
+            return false;
+        }
+    }
+    free(str);
+    _any_selected = true;
+    return true;
+}
+
+bool LogQuery::run(const char *logfile)
+{
+    if (!_any_selected) {
+        for (uint16_t t=0; t<256; t++) {
+            _selected[t] = _index.type(t).stats.count != 0;
+        }
+    }
+
+    // read from the earliest message of any selected type in the
+    // range to just past the last one
+    uint64_t start = _index.log_size();
+    uint64_t end = 0;
+    for (uint16_t t=0; t<256; t++) {
+        if (!_selected[t]) {
+            continue;
+        }
+        start = MIN(start, _index.start_offset(t, _from_us));
+        end = MAX(end, _index.end_offset(t, _to_us));
+    }
+    if (start >= end) {
+        return true;
+    }
+
+    const uint8_t *log = _index.map_log(logfile);
+    if (log == nullptr) {
+        return false;
+    }
+    // start is a checkpoint, so always the start of a message
+    uint64_t ofs = start;
+    while (ofs < end) {
+        uint8_t len;
+        if (!_index.message_at(log, ofs, len)) {
+            ofs = _index.resync(log, ofs+1);
+            continue;
+        }
+        handle_msg(&log[ofs]);
+        ofs += len;
+    }
+    _index.unmap_log(log);
+    return true;
+}
+
+void LogQuery::handle_msg(const uint8_t *msg)
+{
+    const uint8_t t = msg[2];
+    if (!_selected[t]) {
+        return;
+    }
+    if (_index.type(t).time != LOG_INDEX_TIME_NONE) {
+        const uint64_t time_us = _index.msg_time_us(t, msg);
+        if (time_us < _from_us || time_us > _to_us) {
+            return;
+        }
+    }
+    print_msg(_index.type(t).fmt, msg);
+    _nprinted++;
+}
+
+/*
+  print a message in the same form as mavlogdump.py
+ */
+void LogQuery::print_msg(const struct log_Format &f, const uint8_t *msg) const
+{
+    char labels[sizeof(f.labels)+1];
+    memcpy(labels, f.labels, sizeof(f.labels));
+    labels[sizeof(f.labels)] = 0;
+
+    char name[sizeof(f.name)+1];
+    memcpy(name, f.name, sizeof(f.name));
+    name[sizeof(f.name)] = 0;
+    ::printf("%s {", name);
+
+    const uint8_t *p = &msg[LOG_PACKET_HEADER_LEN];
+    char *saveptr = nullptr;
+    const char *label = strtok_r(labels, ",", &saveptr);
+    for (uint8_t i=0; i<sizeof(f.format) && f.format[i] != 0 && label != nullptr; i++) {
+        ::printf("%s%s : ", i == 0 ? "" : ", ", label);
+        label = strtok_r(nullptr, ",", &saveptr);
+        switch (f.format[i]) {
+#define PRINT_FIELD(ctype, fmt, cast) { ctype v; memcpy(&v, p, sizeof(v)); ::printf(fmt, cast v); p += sizeof(v); break; }
+        case 'b': PRINT_FIELD(int8_t, "%d", (int));
+        case 'B':
+        case 'M': PRINT_FIELD(uint8_t, "%u", (unsigned));
+        case 'h': PRINT_FIELD(int16_t, "%d", (int));
+        case 'H': PRINT_FIELD(uint16_t, "%u", (unsigned));
+        case 'i': PRINT_FIELD(int32_t, "%d", (int));
+        case 'I': PRINT_FIELD(uint32_t, "%u", (unsigned));
+        case 'q': PRINT_FIELD(int64_t, "%" PRId64, (int64_t));
+        case 'Q': PRINT_FIELD(uint64_t, "%" PRIu64, (uint64_t));
+        case 'f': PRINT_FIELD(float, "%g", (double));
+        case 'd': PRINT_FIELD(double, "%g", (double));
+        case 'c': PRINT_FIELD(int16_t, "%.2f", 0.01*);
+        case 'C': PRINT_FIELD(uint16_t, "%.2f", 0.01*);
+        case 'e': PRINT_FIELD(int32_t, "%.2f", 0.01*);
+        case 'E': PRINT_FIELD(uint32_t, "%.2f", 0.01*);
+        case 'L': PRINT_FIELD(int32_t, "%.7f", 1.0e-7*);
+#undef PRINT_FIELD
+        case 'n':
+        case 'N':
+        case 'Z': {
+            const uint8_t len = f.format[i] == 'n' ? 4 : f.format[i] == 'N' ? 16 : 64;
+            ::printf("%.*s", (int)strnlen((const char *)p, len), (const char *)p);
+            p += len;
+            break;
+        }
+        case 'a': {
+            ::printf("[");
+            for (uint8_t j=0; j<32; j++) {
+                int16_t v;
+                memcpy(&v, p, sizeof(v));
+                ::printf("%s%d", j == 0 ? "" : ", ", (int)v);
+                p += sizeof(v);
+            }
+            ::printf("]");
+            break;
+        }
+        default:
+            // the index only holds formats it could size
+            break;
+        }
+    }
+    ::printf("}\n");
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "LogIndex.h"
+
+/*
+  print the messages of some types in a time range of a log, reading
+  only the part of it the index says holds them. Corrupt data is
+  skipped the same way the index skipped it
+ */
+class LogQuery
+{
+public:
+    LogQuery(const LogIndex &index);
+
+    // select message types by name, all types with messages if none are
+    bool set_types(const char *list);
+    void set_range(uint64_t from_us, uint64_t to_us) {
+        _from_us = from_us;
+        _to_us = to_us;
+    }
+
+    bool run(const char *logfile);
+    uint64_t nprinted() const { return _nprinted; }
+
+private:
+    const LogIndex &_index;
+    bool _selected[256] {};
+    bool _any_selected = false;
+    uint64_t _from_us = 0;
+    uint64_t _to_us = UINT64_MAX;
+    uint64_t _nprinted = 0;
+
+    void handle_msg(const uint8_t *msg);
+    void print_msg(const struct log_Format &f, const uint8_t *msg) const;
+};
@@ -0,0 +1,260 @@
+#include <AP_gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "LogIndex.h"
+#include "LogQuery.h"
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+#define LOG_TEST_MSG  1
+#define LOG_OTHER_MSG 2
+#define LOG_FLAG_MSG  3
+
+struct PACKED log_Test {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    float roll;
+    float pitch;
+};
+
+struct PACKED log_Other {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t count;
+};
+
+struct PACKED log_Flag {
+    LOG_PACKET_HEADER;
+    uint8_t flag;
+};
+
+/*
+  a log of a few million bytes with runs of garbage between messages,
+  as left by torn writes. The garbage never holds a message of a known
+  type, so what a reader should find in the log is known exactly
+ */
+class LogBuilder {
+public:
+    LogBuilder() {
+        snprintf(path, sizeof(path), "/tmp/test_log_index_XXXXXX");
+        const int fd = mkstemp(path);
+        f = fd == -1 ? nullptr : fdopen(fd, "wb");
+    }
+
+    ~LogBuilder() {
+        unlink(path);
+    }
+
+    char path[64];
+    FILE *f;
+    uint64_t count[256] {};
+    uint64_t first_us[256] {};
+    uint64_t last_us[256] {};
+    uint64_t garbage_bytes = 0;
+
+    void add(const void *msg, uint8_t size) {
+        fwrite(msg, size, 1, f);
+        const uint8_t t = ((const uint8_t *)msg)[2];
+        count[t]++;
+    }
+
+    void add_timed(const void *msg, uint8_t size, uint64_t time_us) {
+        const uint8_t t = ((const uint8_t *)msg)[2];
+        if (count[t] == 0) {
+            first_us[t] = time_us;
+        }
+        last_us[t] = time_us;
+        add(msg, size);
+    }
+
+    void add_fmt(uint8_t type, uint8_t length, const char *name, const char *format, const char *labels) {
+        struct log_Format fmt {};
+        fmt.head1 = HEAD_BYTE1;
+        fmt.head2 = HEAD_BYTE2;
+        fmt.msgid = LOG_FORMAT_MSG;
+        fmt.type = type;
+        fmt.length = length;
+        strncpy(fmt.name, name, sizeof(fmt.name));
+        strncpy(fmt.format, format, sizeof(fmt.format));
+        strncpy(fmt.labels, labels, sizeof(fmt.labels));
+        add(&fmt, sizeof(fmt));
+    }
+
+    // random bytes, with header bytes only where they can't start a
+    // message of a known type
+    void add_garbage() {
+        const uint16_t len = 1 + random() % 300;
+        for (uint16_t i = 0; i < len; i++) {
+            uint8_t b = random();
+            if (b == HEAD_BYTE1) {
+                b = 0;
+            }
+            if (i + 3 <= len && random() % 16 == 0) {
+                // a header of a type the log doesn't define
+                const uint8_t hdr[3] { HEAD_BYTE1, HEAD_BYTE2, 0xF0 };
+                fwrite(hdr, sizeof(hdr), 1, f);
+                i += 2;
+                continue;
+            }
+            if (random() % 16 == 0) {
+                b = HEAD_BYTE1;
+                fputc(b, f);
+                b = 0;
+                if (++i == len) {
+                    break;
+                }
+            }
+            fputc(b, f);
+        }
+        garbage_bytes += len;
+    }
+
+    bool build(uint32_t n) {
+        if (f == nullptr) {
+            return false;
+        }
+        add_garbage();
+        add_fmt(LOG_FORMAT_MSG, sizeof(struct log_Format), "FMT", "BBnNZ", "Type,Length,Name,Format,Columns");
+        add_fmt(LOG_TEST_MSG, sizeof(struct log_Test), "TST", "Qff", "TimeUS,Roll,Pitch");
+        add_fmt(LOG_OTHER_MSG, sizeof(struct log_Other), "OTH", "QI", "TimeUS,Count");
+        add_fmt(LOG_FLAG_MSG, sizeof(struct log_Flag), "FLG", "B", "Flag");
+        for (uint32_t i = 0; i < n; i++) {
+            struct log_Test t {};
+            t.head1 = HEAD_BYTE1;
+            t.head2 = HEAD_BYTE2;
+            t.msgid = LOG_TEST_MSG;
+            t.time_us = 1000000 + i * 2500ULL;
+            t.roll = (random() % 1000) * 1.0e-3f;
+            t.pitch = (random() % 1000) * -1.0e-3f;
+            add_timed(&t, sizeof(t), t.time_us);
+            if (i % 4 == 0) {
+                struct log_Other o {};
+                o.head1 = HEAD_BYTE1;
+                o.head2 = HEAD_BYTE2;
+                o.msgid = LOG_OTHER_MSG;
+                o.time_us = t.time_us + 100;
+                o.count = i / 4;
+                add_timed(&o, sizeof(o), o.time_us);
+            }
+            if (i % 1000 == 0) {
+                struct log_Flag fl {};
+                fl.head1 = HEAD_BYTE1;
+                fl.head2 = HEAD_BYTE2;
+                fl.msgid = LOG_FLAG_MSG;
+                fl.flag = i / 1000;
+                add(&fl, sizeof(fl));
+            }
+            if (i % 97 == 0) {
+                add_garbage();
+            }
+        }
+        return fclose(f) == 0;
+    }
+};
+
+/*
+  the log is built once for all the tests, whatever order they run in
+ */
+class LogIndexTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase() {
+        srandom(1);
+        builder = new LogBuilder();
+        built = builder->build(200000);
+    }
+
+    static void TearDownTestCase() {
+        delete builder;
+        builder = nullptr;
+    }
+
+    void SetUp() override {
+        ASSERT_TRUE(built);
+    }
+
+    static LogBuilder *builder;
+    static bool built;
+};
+
+LogBuilder *LogIndexTest::builder;
+bool LogIndexTest::built;
+
+/*
+  the index must hold exactly what is in the log, skipping every byte
+  of garbage
+ */
+TEST_F(LogIndexTest, SkipsGarbage)
+{
+    LogIndex index;
+    ASSERT_TRUE(index.build(builder->path, 1));
+
+    uint64_t nmessages = 0;
+    for (uint16_t t = 0; t < 256; t++) {
+        EXPECT_EQ(builder->count[t], index.type(t).stats.count) << "type " << t;
+        nmessages += builder->count[t];
+    }
+    EXPECT_EQ(nmessages, index.nmessages());
+    EXPECT_EQ(builder->garbage_bytes, index.skipped());
+    for (uint8_t t : { LOG_TEST_MSG, LOG_OTHER_MSG }) {
+        EXPECT_EQ(builder->first_us[t], index.type(t).stats.first_us);
+        EXPECT_EQ(builder->last_us[t], index.type(t).stats.last_us);
+    }
+    EXPECT_EQ(LOG_INDEX_TIME_US, index.type(LOG_TEST_MSG).time);
+    EXPECT_EQ(LOG_INDEX_TIME_NONE, index.type(LOG_FLAG_MSG).time);
+}
+
+/*
+  indexing in parallel chunks must give the same index as one thread
+ */
+TEST_F(LogIndexTest, ThreadsMatchSerial)
+{
+    LogIndex serial;
+    ASSERT_TRUE(serial.build(builder->path, 1));
+    // the log must be big enough to be split
+    ASSERT_GT(serial.log_size(), 3 * 1024 * 1024ULL);
+
+    for (uint8_t nthreads : { 2, 3, 4 }) {
+        LogIndex parallel;
+        ASSERT_TRUE(parallel.build(builder->path, nthreads));
+        EXPECT_EQ(serial.nmessages(), parallel.nmessages());
+        EXPECT_EQ(serial.skipped(), parallel.skipped());
+        for (uint16_t t = 0; t < 256; t++) {
+            const LogIndexStats &s = serial.type(t).stats;
+            const LogIndexStats &p = parallel.type(t).stats;
+            EXPECT_EQ(s.count, p.count);
+            EXPECT_EQ(s.first_us, p.first_us);
+            EXPECT_EQ(s.last_us, p.last_us);
+            EXPECT_EQ(s.first_offset, p.first_offset);
+            ASSERT_EQ(s.ncheckpoints, p.ncheckpoints) << (int)nthreads << " threads, type " << t;
+            for (uint32_t i = 0; i < s.ncheckpoints; i++) {
+                EXPECT_EQ(s.checkpoints[i].offset, p.checkpoints[i].offset);
+                EXPECT_EQ(s.checkpoints[i].time_us, p.checkpoints[i].time_us);
+            }
+        }
+    }
+}
+
+/*
+  a query reads from a checkpoint across the garbage to the end of the
+  range
+ */
+TEST_F(LogIndexTest, QueryRange)
+{
+    LogIndex index;
+    ASSERT_TRUE(index.build(builder->path, 4));
+
+    const uint64_t from_us = 200000000;
+    const uint64_t to_us = 200500000;
+    LogQuery q(index);
+    ASSERT_TRUE(q.set_types("TST"));
+    q.set_range(from_us, to_us);
+    ASSERT_TRUE(q.run(builder->path));
+    // TST every 2.5ms from 1s
+    EXPECT_EQ((to_us - from_us) / 2500 + 1, q.nprinted());
+}
+
+AP_GTEST_MAIN()
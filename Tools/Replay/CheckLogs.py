@@ -3,7 +3,7 @@
 run Replay over a set of logs to check for code regressions
 '''
 
-import optparse, os, sys
+import optparse, os, sys, shutil, tempfile, multiprocessing
 
 parser = optparse.OptionParser("CheckLogs")
 parser.add_option("--logdir", type='string', default='testlogs', help='directory of logs to use')
@@ -11,6 +11,8 @@ parser.add_option("--create-checked-logs", action='store_true', default=False, h
 parser.add_option("--tolerance-euler", type=float, default=3, help="tolerance for euler angles in degrees");
 parser.add_option("--tolerance-pos", type=float, default=2, help="tolerance for position angles in meters");
 parser.add_option("--tolerance-vel", type=float, default=2, help="tolerance for velocity in meters/second");
+parser.add_option("--jobs", "-j", type=int, default=multiprocessing.cpu_count(), help="number of logs to replay in parallel")
+parser.add_option("--replay", type='string', default='./Replay.elf', help="path to Replay binary")
 
 opts, args = parser.parse_args()
 
@@ -26,15 +28,46 @@ def run_cmd(cmd, dir=".", show=False, output=False, checkfail=True):
     else:
         return call(cmd, shell=True, cwd=dir)
 
+def run_in_workdir(cmd):
+    '''run a command in a private scratch directory. Replay keeps
+    its global state (logs/, eeprom.bin, replay_results.txt) relative to
+    the current directory, so each parallel run needs its own'''
+    workdir = tempfile.mkdtemp(prefix="replay-")
+    run_cmd(cmd, dir=workdir, checkfail=False)
+    return workdir
+
 def run_replay(logfile):
-    '''run Replay on one logfile'''
+    '''run Replay on one logfile, returning its result lines'''
     print("Processing %s" % logfile)
-    cmd = "./Replay.elf -- --check %s --tolerance-euler=%f --tolerance-pos=%f --tolerance-vel=%f " % (
-        logfile,
+    cmd = "%s -- --check %s --tolerance-euler=%f --tolerance-pos=%f --tolerance-vel=%f " % (
+        os.path.abspath(opts.replay),
+        os.path.abspath(logfile),
         opts.tolerance_euler,
         opts.tolerance_pos,
         opts.tolerance_vel)
-    run_cmd(cmd, checkfail=False)
+    workdir = run_in_workdir(cmd)
+    results = []
+    try:
+        for line in open(os.path.join(workdir, "replay_results.txt"), "r"):
+            # report the log by the name we were given, not the abspath
+            a = line.rstrip("\n").split("\t")
+            a[0] = logfile
+            results.append("\t".join(a) + "\n")
+    except IOError:
+        print("No results for %s" % logfile)
+    shutil.rmtree(workdir, ignore_errors=True)
+    return results
+
+def run_parallel(func, file_list):
+    '''run func over file_list using opts.jobs worker processes'''
+    if opts.jobs <= 1 or len(file_list) <= 1:
+        return [func(f) for f in file_list]
+    pool = multiprocessing.Pool(min(opts.jobs, len(file_list)))
+    try:
+        return pool.map(func, file_list, chunksize=1)
+    finally:
+        pool.close()
+        pool.join()
 
 def get_log_list():
     '''get a list of log files to process'''
@@ -150,11 +183,34 @@ def check_logs():
         print(ex)
         pass
 
-    for logfile in log_list:
-        run_replay(logfile)
+    results = run_parallel(run_replay, sorted(log_list))
+
+    # results are written in log order regardless of completion order
+    f = open("replay_results.txt", "w")
+    for lines in results:
+        f.writelines(lines)
+    f.close()
 
     create_html_results()
 
+def create_checked_log(f):
+    '''create a CHEK log for one log file'''
+    import glob
+    print("Processing %s" % f)
+    cmd = "%s -- --check-generate %s" % (os.path.abspath(opts.replay), os.path.abspath(f))
+    workdir = run_in_workdir(cmd)
+    outlogs = glob.glob(os.path.join(workdir, "logs", "*.BIN"))
+    if len(outlogs) != 1:
+        print("Failed to generate log for %s" % f)
+        shutil.rmtree(workdir, ignore_errors=True)
+        return False
+    name, ext = os.path.splitext(f)
+    newname = name + '-checked.bin'
+    shutil.move(outlogs[0], newname)
+    shutil.rmtree(workdir, ignore_errors=True)
+    print("Created %s" % newname)
+    return True
+
 def create_checked_logs():
     '''create a set of CHEK logs'''
     import glob, os, sys
@@ -170,21 +226,9 @@ def create_checked_logs():
     if len(file_list) == 0:
         print("No files to process")
         sys.exit(1)
-    for f in file_list:
-        print("Processing %s" % f)
-        log_list_current = set(glob.glob("logs/*.BIN"))
-        cmd = "./Replay.elf -- --check-generate %s" % f
-        run_cmd(cmd, checkfail=True)
-        log_list_after = set(glob.glob("logs/*.BIN"))
-        changed = log_list_after.difference(log_list_current)
-        if len(changed) != 1:
-            print("Failed to generate log for %s" % f)
+    for ok in run_parallel(create_checked_log, file_list):
+        if not ok:
             sys.exit(1)
-        outlog = list(changed)[0]
-        name, ext = os.path.splitext(f)
-        newname = name + '-checked.bin'
-        os.rename(outlog, newname)
-        print("Created %s" % newname)
 
 if opts.create_checked_logs:
     create_checked_logs()
@@ -1,24 +1,178 @@
 #include "DataFlashFileReader.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
+DataFlashFileReader::~DataFlashFileReader()
+{
+    if (map_base != nullptr) {
+        munmap(map_base, map_size);
+    }
+    free(buf);
+    delete decoder;
+    free(block_buf);
+    if (fd != -1) {
+        ::close(fd);
+    }
+}
+
 bool DataFlashFileReader::open_log(const char *logfile)
 {
     fd = ::open(logfile, O_RDONLY|O_CLOEXEC);
     if (fd == -1) {
         return false;
     }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        // private writable mapping: handle_msg() may patch the message
+        // id in place without that reaching the file
+        void *p = mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            map_base = (uint8_t *)p;
+            map_size = st.st_size;
+            madvise(map_base, map_size, MADV_SEQUENTIAL);
+            return check_compressed();
+        }
+    }
+
+    // fall back to chunked reads, e.g. for pipes
+    buf = (uint8_t *)malloc(LOGREADER_READ_CHUNK);
+    if (buf == nullptr) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    return check_compressed();
+}
+
+/*
+  set up decoding if the log was written with LOG_FILE_COMPRESS
+ */
+bool DataFlashFileReader::check_compressed(void)
+{
+    const uint8_t *hdr = file_peek(DF_BLOCK_HEADER_LEN);
+    if (hdr == nullptr || !DFBlockDecoder::is_block(hdr, DF_BLOCK_HEADER_LEN)) {
+        return true;
+    }
+    decoder = new DFBlockDecoder();
+    // room for a whole block behind the tail of a partly read message
+    block_buf = (uint8_t *)malloc(DF_BLOCK_MAX_RAW + 256);
+    if (decoder == nullptr || block_buf == nullptr) {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+
+/*
+  decode the next block of a compressed log after what is left of
+  the current one
+ */
+bool DataFlashFileReader::next_block(void)
+{
+    memmove(block_buf, &block_buf[block_ofs], block_len - block_ofs);
+    block_len -= block_ofs;
+    block_ofs = 0;
+
+    const uint8_t *hdr = file_peek(DF_BLOCK_HEADER_LEN);
+    if (hdr == nullptr) {
+        return false;
+    }
+    const uint32_t len = DFBlockDecoder::block_length(hdr);
+    if (len == 0) {
+        printf("bad block header\n");
+        return false;
+    }
+    const uint8_t *block = file_peek(len);
+    if (block == nullptr) {
+        // the last block of a log may be cut short
+        return false;
+    }
+    if (!decoder->decode(block, len, &block_buf[block_len])) {
+        printf("corrupt block\n");
+        return false;
+    }
+    block_len += DFBlockDecoder::raw_length(block);
+    file_consume(len);
     return true;
 }
 
+/*
+  return a pointer to the next len bytes of the log without consuming
+  them, or nullptr at the end of the log. The pointer is valid until
+  the next call to peek()
+ */
+uint8_t *DataFlashFileReader::peek(size_t len)
+{
+    if (decoder != nullptr) {
+        while (block_len - block_ofs < len) {
+            if (!next_block()) {
+                return nullptr;
+            }
+        }
+        return &block_buf[block_ofs];
+    }
+    return file_peek(len);
+}
+
+void DataFlashFileReader::consume(size_t len)
+{
+    if (decoder != nullptr) {
+        block_ofs += len;
+    } else {
+        file_consume(len);
+    }
+}
+
+/*
+  as peek(), but for the bytes of the log file itself
+ */
+uint8_t *DataFlashFileReader::file_peek(size_t len)
+{
+    if (map_base != nullptr) {
+        if (map_size - map_ofs < len) {
+            return nullptr;
+        }
+        return &map_base[map_ofs];
+    }
+
+    if (buf_len - buf_ofs < len) {
+        // move the unconsumed tail to the front and refill
+        memmove(buf, &buf[buf_ofs], buf_len - buf_ofs);
+        buf_len -= buf_ofs;
+        buf_ofs = 0;
+        while (buf_len < len) {
+            ssize_t n = ::read(fd, &buf[buf_len], LOGREADER_READ_CHUNK - buf_len);
+            if (n <= 0) {
+                return nullptr;
+            }
+            buf_len += n;
+        }
+    }
+    return &buf[buf_ofs];
+}
+
+void DataFlashFileReader::file_consume(size_t len)
+{
+    if (map_base != nullptr) {
+        map_ofs += len;
+    } else {
+        buf_ofs += len;
+    }
+}
+
 bool DataFlashFileReader::update(char type[5])
 {
-    uint8_t hdr[3];
-    if (::read(fd, hdr, 3) != 3) {
+    const uint8_t *hdr = peek(3);
+    if (hdr == nullptr) {
         return false;
     }
     if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
@@ -27,11 +181,13 @@ bool DataFlashFileReader::update(char type[5])
     }
 
     if (hdr[2] == LOG_FORMAT_MSG) {
-        struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (::read(fd, &f.type, sizeof(f)-3) != sizeof(f)-3) {
+        const uint8_t *p = peek(sizeof(struct log_Format));
+        if (p == nullptr) {
             return false;
         }
+        struct log_Format f;
+        memcpy(&f, p, sizeof(f));
+        consume(sizeof(f));
         memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
         strncpy(type, "FMT", 3);
         type[3] = 0;
@@ -52,12 +208,11 @@ bool DataFlashFileReader::update(char type[5])
         exit(1);
     }
 
-    uint8_t msg[f.length];
-
-    memcpy(msg, hdr, 3);
-    if (::read(fd, &msg[3], f.length-3) != f.length-3) {
+    uint8_t *msg = peek(f.length);
+    if (msg == nullptr) {
         return false;
     }
+    consume(f.length);
 
     strncpy(type, f.name, 4);
     type[4] = 0;
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <DataFlash/DataFlash.h>
+#include <DataFlash/DFBlockCodec.h>
 
 class DataFlashFileReader
 {
 public:
+    virtual ~DataFlashFileReader();
+
     bool open_log(const char *logfile);
     bool update(char type[5]);
 
@@ -18,4 +21,31 @@ protected:
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
     struct log_Format formats[LOGREADER_MAX_FORMATS] {};
+
+private:
+    // the whole log is mapped copy-on-write when possible so messages
+    // can be handed to handle_msg() without copying them
+    uint8_t *map_base = nullptr;
+    size_t map_size = 0;
+    size_t map_ofs = 0;
+
+    // otherwise the log is read in large chunks into this buffer,
+    // which must hold the largest compressed block
+#define LOGREADER_READ_CHUNK 131072
+    uint8_t *buf = nullptr;
+    size_t buf_len = 0;
+    size_t buf_ofs = 0;
+
+    // compressed logs are decoded a block at a time into block_buf
+    DFBlockDecoder *decoder = nullptr;
+    uint8_t *block_buf = nullptr;
+    size_t block_len = 0;
+    size_t block_ofs = 0;
+
+    uint8_t *peek(size_t len);
+    void consume(size_t len);
+    uint8_t *file_peek(size_t len);
+    void file_consume(size_t len);
+    bool check_compressed(void);
+    bool next_block(void);
 };
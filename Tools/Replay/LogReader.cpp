@@ -152,7 +152,10 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	memcpy(name, f.name, 4);
 	debug("Defining log format for type (%d) (%s)\n", f.type, name);
 
-        if (save_message_type(name)) {
+        save_msgid[f.type] = save_message_type(name);
+        output_msgid[f.type] = !in_list(name, nottypes);
+
+        if (save_msgid[f.type]) {
             /* 
                any messages which we won't be generating internally in
                replay should get the original FMT header
@@ -277,17 +280,13 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 }
 
 bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
-    char name[5];
-    memset(name, '\0', 5);
-    memcpy(name, f.name, 4);
-
-    if (save_message_type(name)) {
+    if (save_msgid[f.type]) {
         if (mapped_msgid[msg[2]] == 0) {
             printf("Unknown msgid %u\n", (unsigned)msg[2]);
             exit(1);
         }
         msg[2] = mapped_msgid[msg[2]];
-        if (!in_list(name, nottypes)) {
+        if (output_msgid[f.type]) {
             dataflash.WriteBlock(msg, f.length);        
         }
         // a MsgHandler would probably have found a timestamp and
@@ -61,6 +61,11 @@ private:
     // mapping from original msgid to output msgid
     uint8_t mapped_msgid[256] {};
 
+    // per-msgid copy/output decisions, resolved once from the FMT
+    // message rather than by name for every message in the log
+    bool save_msgid[256] {};
+    bool output_msgid[256] {};
+
     // next available msgid for mapping
     uint8_t next_msgid = 1;
 
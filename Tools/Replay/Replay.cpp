@@ -156,6 +156,7 @@ void Replay::usage(void)
     ::printf("\t--logmatch         match logging rate to source\n");
     ::printf("\t--no-params        don't use parameters from the log\n");
     ::printf("\t--no-fpe           do not generate floating point exceptions\n");
+    ::printf("\t--unpack FILE      write the log to FILE uncompressed and exit\n");
 }
 
 
@@ -171,6 +172,7 @@ enum {
     OPT_NOPARAMS,
     OPT_PARAM_FILE,
     OPT_NO_FPE,
+    OPT_UNPACK,
 };
 
 void Replay::flush_dataflash(void) {
@@ -227,6 +229,7 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"logmatch",        false,  0, OPT_LOGMATCH},
         {"no-params",       false,  0, OPT_NOPARAMS},
         {"no-fpe",          false,  0, OPT_NO_FPE},
+        {"unpack",          true,   0, OPT_UNPACK},
         {0, false, 0, 0}
     };
 
@@ -310,6 +313,10 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             generate_fpe = false;
             break;
 
+        case OPT_UNPACK:
+            unpack_filename = gopt.optarg;
+            break;
+
         case 'h':
         default:
             usage();
@@ -375,6 +382,44 @@ bool IMUCounter::handle_msg(const struct log_Format &f, uint8_t *msg) {
     return true;
 }
 
+/*
+  copy every message of a log to a file, which turns a log written
+  with LOG_FILE_COMPRESS into an ordinary one
+ */
+class LogUnpacker : public DataFlashFileReader {
+public:
+    LogUnpacker(FILE *_out) : out(_out) {}
+    bool handle_log_format_msg(const struct log_Format &f) override {
+        return fwrite(&f, sizeof(f), 1, out) == 1;
+    }
+    bool handle_msg(const struct log_Format &f, uint8_t *msg) override {
+        return fwrite(msg, f.length, 1, out) == 1;
+    }
+private:
+    FILE *out;
+};
+
+void Replay::unpack_log(void)
+{
+    FILE *out = xfopen(unpack_filename, "wb");
+    LogUnpacker reader(out);
+    if (!reader.open_log(filename)) {
+        perror(filename);
+        exit(1);
+    }
+    uint32_t count = 0;
+    char type[5];
+    while (reader.update(type)) {
+        count++;
+    }
+    if (ferror(out) || fclose(out) != 0) {
+        perror(unpack_filename);
+        exit(1);
+    }
+    ::printf("Wrote %u messages to %s\n", (unsigned)count, unpack_filename);
+    exit(0);
+}
+
 /*
   find information about the log
  */
@@ -506,6 +551,10 @@ void Replay::setup()
 
     _parse_command_line(argc, argv);
 
+    if (unpack_filename != NULL) {
+        unpack_log();
+    }
+
     if (!check_generate) {
         logreader.set_save_chek_messages(true);
     }
@@ -140,6 +140,7 @@ private:
     const char **nottypes = NULL;
     uint16_t downsample = 0;
     bool logmatch = false;
+    const char *unpack_filename = NULL;
     uint32_t output_counter = 0;
     uint64_t last_timestamp = 0;
 
@@ -172,6 +173,7 @@ private:
     bool show_error(const char *text, float max_error, float tolerance);
     void report_checks();
     bool find_log_info(struct log_information &info);
+    void unpack_log(void);
     const char **parse_list_from_string(const char *str);
     bool parse_param_line(char *line, char **vname, float &value);
     void load_param_file(const char *filename);
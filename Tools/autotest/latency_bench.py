@@ -0,0 +1,156 @@
+#!/usr/bin/env python
+
+"""
+IMU-to-motor latency benchmark.
+
+Runs a copter SITL in lockstep mode for a fixed amount of simulated
+time, then reads the MLAT messages from its DataFlash log. MLAT holds
+the distribution of the age of the gyro sample used by the attitude
+controller at the time the motor outputs calculated from it were
+written. The benchmark fails if the median latency is above a fixed
+limit, or has regressed against a saved baseline.
+
+Simulated time stands still while the autopilot code runs, so on SITL
+the latency is measured against the host's monotonic clock rather than
+AP_HAL::micros64(). It is the time the fast loop spends between the
+sample and the motor outputs, which lockstep does not change.
+
+Example:
+  Tools/autotest/latency_bench.py --save-baseline latency.json
+  Tools/autotest/latency_bench.py --baseline latency.json
+"""
+from __future__ import print_function
+
+import glob
+import json
+import optparse
+import os
+import shutil
+import sys
+
+from pymavlink import mavutil
+
+from pysim import headless, util
+
+
+class BenchFailed(Exception):
+    pass
+
+
+def run_sitl(opts):
+    """run SITL until the requested simulated time has passed and return its log"""
+    if os.path.exists(opts.use_dir):
+        shutil.rmtree(opts.use_dir)
+    os.makedirs(opts.use_dir)
+    defaults = os.path.join(opts.use_dir, "latency.parm")
+    with open(defaults, "w") as f:
+        f.write("LOG_DISARMED 1\n")
+    defaults_list = [util.reltopdir("Tools/autotest/default_params/copter.parm"), defaults]
+    args = ["-w",
+            "--lockstep",
+            "--seed", "1",
+            "--defaults", ",".join(defaults_list)]
+    sitl = headless.start(opts.binary, opts.instance, opts.model, opts.use_dir, args)
+    mav = None
+    try:
+        mav = headless.connect(opts.instance, sitl)
+        headless.wait_heartbeat(mav)
+        mav.mav.request_data_stream_send(mav.target_system, mav.target_component,
+                                         mavutil.mavlink.MAV_DATA_STREAM_ALL, 4, 1)
+        while True:
+            m = mav.recv_match(type='ATTITUDE', blocking=True, timeout=10)
+            if m is None:
+                raise BenchFailed("vehicle stopped sending")
+            if m.time_boot_ms * 1.0e-3 >= opts.duration:
+                break
+    finally:
+        if mav is not None:
+            mav.close()
+        headless.stop(sitl)
+    logs = sorted(glob.glob(os.path.join(opts.use_dir, "logs", "*.BIN")), key=os.path.getmtime)
+    if len(logs) == 0:
+        raise BenchFailed("no DataFlash log written")
+    return logs[-1]
+
+
+def read_latency(logfile):
+    """return the MLAT messages of a log as a list of dicts"""
+    dflog = mavutil.mavlink_connection(logfile)
+    ret = []
+    while True:
+        m = dflog.recv_match(type='MLAT')
+        if m is None:
+            break
+        ret.append(m.to_dict())
+    return ret
+
+
+def median(values):
+    values = sorted(values)
+    n = len(values)
+    if n == 0:
+        return 0
+    if n % 2 == 1:
+        return values[n // 2]
+    return 0.5 * (values[n // 2 - 1] + values[n // 2])
+
+
+parser = optparse.OptionParser("latency_bench.py [options]")
+parser.add_option("", "--binary", type='string', default=None, help="SITL binary to run (default: build/sitl/bin/arducopter)")
+parser.add_option("", "--model", type='string', default="+", help="simulation model")
+parser.add_option("", "--duration", type='float', default=120.0, help="simulated seconds to run for")
+parser.add_option("", "--max-p50", type='float', default=2500.0, help="fail if median latency is above this many microseconds")
+parser.add_option("", "--baseline", type='string', default=None, help="JSON baseline to compare against")
+parser.add_option("", "--tolerance", type='float', default=10.0, help="allowed regression against the baseline in percent")
+parser.add_option("", "--save-baseline", type='string', default=None, help="write the results as a new baseline")
+parser.add_option("", "--log", type='string', default=None, help="analyse an existing DataFlash log instead of running SITL")
+parser.add_option("", "--use-dir", type='string', default="latency_bench", help="directory to run SITL in")
+parser.add_option("-I", "--instance", type='int', default=0, help="SITL instance number")
+
+(opts, args) = parser.parse_args()
+
+try:
+    logfile = opts.log
+    if logfile is None:
+        opts.binary = headless.find_binary("ArduCopter", opts.binary)
+        opts.use_dir = os.path.abspath(opts.use_dir)
+        logfile = run_sitl(opts)
+
+    mlat = read_latency(logfile)
+    # the first interval includes startup, before the loop has settled
+    mlat = mlat[1:]
+    if len(mlat) == 0:
+        raise BenchFailed("no MLAT messages in %s" % logfile)
+
+    result = {
+        "p50_us": median([m["P50"] for m in mlat]),
+        "p90_us": median([m["P90"] for m in mlat]),
+        "p99_us": median([m["P99"] for m in mlat]),
+        "max_us": max([m["Max"] for m in mlat]),
+        "samples": sum([m["N"] for m in mlat]),
+    }
+    print("latency over %u samples: p50=%.0fus p90=%.0fus p99=%.0fus max=%uus" % (
+        result["samples"], result["p50_us"], result["p90_us"], result["p99_us"], result["max_us"]))
+
+    if opts.save_baseline is not None:
+        with open(opts.save_baseline, "w") as f:
+            json.dump(result, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("saved baseline to %s" % opts.save_baseline)
+
+    if result["p50_us"] > opts.max_p50:
+        raise BenchFailed("median latency %.0fus above limit %.0fus" % (result["p50_us"], opts.max_p50))
+
+    if opts.baseline is not None:
+        with open(opts.baseline) as f:
+            baseline = json.load(f)
+        limit = baseline["p50_us"] * (1.0 + opts.tolerance * 0.01)
+        if result["p50_us"] > limit:
+            raise BenchFailed("median latency regressed: %.0fus against baseline %.0fus (limit %.0fus)" % (
+                result["p50_us"], baseline["p50_us"], limit))
+        print("median latency within %.0f%% of baseline %.0fus" % (opts.tolerance, baseline["p50_us"]))
+except (BenchFailed, headless.SITLError) as e:
+    print("FAILED: %s" % e)
+    sys.exit(1)
+
+print("PASSED")
@@ -0,0 +1,472 @@
+#!/usr/bin/env python
+
+"""
+Monte-Carlo batch simulation harness.
+
+Flies one mission many times in SITL lockstep mode, varying parameters,
+wind and sensor noise between trials, and summarises how the vehicle
+performed across the whole distribution rather than for a single flight.
+
+The sweep is described in a JSON file:
+
+  {
+    "trials": 20,
+    "seed": 1,
+    "timeout": 600,
+    "params": {
+      "ATC_RAT_RLL_P": [0.10, 0.135, 0.17],
+      "SIM_WIND_SPD": {"uniform": [0, 8]},
+      "SIM_WIND_DIR": {"uniform": [0, 360]},
+      "SIM_GYR_RND": {"gauss": [0.05, 0.02]}
+    }
+  }
+
+Parameters given as lists are swept (every combination is a sweep
+point); parameters given as distributions are drawn afresh for every
+trial. Every trial gets its own seed, which is also passed to SITL so
+its sensor noise and drawn parameters are reproducible. The flight
+itself is not exactly: parameters, the mission and commands reach the
+vehicle over a TCP link in wall-clock time, so re-running a trial with
+the same seed gives a similar flight, not the same one.
+
+Per trial we record the horizontal distance from the current mission
+leg, the altitude error, the EKF innovation test ratios and the
+runtime of every scheduler task, as reported in the DEBUG_VECT
+messages the vehicle sends when SCHED_PROFILE is set. Tasks are keyed
+by their index in the task table, as their names are cut short.
+Results are written as one CSV row per trial, with the task runtimes in
+a second CSV, and a summary per sweep point is printed at the end.
+
+All waits are on the vehicle's state and simulated time, so no trial
+times out because the machine runs it slowly. A trial that goes
+wrong in any way is recorded as failed and the rest carry on.
+
+Example:
+  Tools/autotest/montecarlo.py -v ArduCopter -j 8 \\
+      --mission Tools/autotest/copter_mission.txt --sweep sweep.json
+"""
+from __future__ import print_function
+
+import csv
+import itertools
+import json
+import math
+import multiprocessing
+import optparse
+import os
+import random
+import shutil
+import sys
+import time
+
+from pymavlink import mavutil, mavwp
+
+from pysim import headless
+
+# vehicles which fly missions in AUTO, with the mode each is armed in
+# before MAV_CMD_MISSION_START switches it to AUTO. Copter won't arm in
+# AUTO, and only skips its throttle check when armed in GUIDED
+vehicles = ["ArduCopter", "ArduPlane", "APMrover2"]
+arm_modes = {
+    "ArduCopter": "GUIDED",
+    "ArduPlane": "MANUAL",
+    "APMrover2": "MANUAL",
+}
+
+metric_names = [
+    "xtrack_mean", "xtrack_max",
+    "alt_err_mean", "alt_err_max",
+    "ekf_vel_max", "ekf_pos_max", "ekf_hgt_max", "ekf_mag_max",
+    "task_avg_max", "task_p99_max", "task_max_max",
+]
+
+
+class TrialFailed(Exception):
+    pass
+
+
+class Stat(object):
+    """running mean/max of a series"""
+    def __init__(self):
+        self.total = 0.0
+        self.count = 0
+        self.max = 0.0
+
+    def add(self, value):
+        self.total += value
+        self.count += 1
+        self.max = max(self.max, value)
+
+    def mean(self):
+        if self.count == 0:
+            return 0.0
+        return self.total / self.count
+
+
+class SimClock(object):
+    """simulated time, from the time_boot_ms of messages the vehicle sends"""
+    def __init__(self):
+        self.ms = None
+
+    def update(self, m):
+        t = getattr(m, 'time_boot_ms', None)
+        if t is not None:
+            self.ms = t
+
+
+def wait_for(mav, clock, condition, timeout, what, retry=None, retry_interval=1.0):
+    """
+    receive messages until condition(m) is true, giving up after timeout
+    simulated seconds. retry() is called first, and again every
+    retry_interval simulated seconds
+    """
+    start_ms = None
+    last_retry_ms = None
+    if retry is not None:
+        retry()
+    while True:
+        # only a stalled vehicle goes quiet for this long
+        m = mav.recv_match(blocking=True, timeout=30)
+        if m is None:
+            raise TrialFailed("vehicle stopped sending while waiting for %s" % what)
+        clock.update(m)
+        if condition(m):
+            return m
+        if clock.ms is None:
+            continue
+        if start_ms is None:
+            start_ms = clock.ms
+            last_retry_ms = clock.ms
+        if clock.ms - start_ms > timeout * 1000:
+            raise TrialFailed("timed out waiting for %s" % what)
+        if retry is not None and clock.ms - last_retry_ms > retry_interval * 1000:
+            retry()
+            last_retry_ms = clock.ms
+
+
+def sweep_points(spec):
+    """return a list of dicts, one per combination of swept parameters"""
+    swept = sorted([k for (k, v) in spec.get("params", {}).items() if isinstance(v, list)])
+    values = [spec["params"][k] for k in swept]
+    return [dict(zip(swept, combination)) for combination in itertools.product(*values)]
+
+
+def draw_params(spec, point, seed):
+    """parameters for one trial: the sweep point plus random draws"""
+    rng = random.Random(seed)
+    params = dict(point)
+    for (name, value) in sorted(spec.get("params", {}).items()):
+        if isinstance(value, list):
+            continue
+        if isinstance(value, dict) and "uniform" in value:
+            params[name] = rng.uniform(*value["uniform"])
+        elif isinstance(value, dict) and "gauss" in value:
+            params[name] = rng.gauss(*value["gauss"])
+        else:
+            params[name] = float(value)
+    return params
+
+
+def leg_distance(pos, start, end):
+    """horizontal distance in meters from pos to the leg start->end"""
+    # flat earth approximation, fine over the length of a mission leg
+    scale = 6378100.0 * math.pi / 180.0
+    coslat = math.cos(math.radians(start[0]))
+    px = (pos[1] - start[1]) * scale * coslat
+    py = (pos[0] - start[0]) * scale
+    ex = (end[1] - start[1]) * scale * coslat
+    ey = (end[0] - start[0]) * scale
+    length_sq = ex * ex + ey * ey
+    if length_sq < 1.0:
+        return math.sqrt(px * px + py * py)
+    t = max(0.0, min(1.0, (px * ex + py * ey) / length_sq))
+    dx = px - t * ex
+    dy = py - t * ey
+    return math.sqrt(dx * dx + dy * dy)
+
+
+def upload_mission(mav, clock, wploader, timeout=30):
+    """send the mission using the MISSION_COUNT/MISSION_REQUEST handshake"""
+    # MISSION_COUNT replaces any mission the vehicle has
+    def is_reply(m):
+        return m.get_type() in ['MISSION_REQUEST', 'MISSION_ACK']
+    m = wait_for(mav, clock, is_reply, timeout, "mission upload",
+                 retry=lambda: mav.waypoint_count_send(wploader.count()))
+    while m.get_type() != 'MISSION_ACK':
+        wp = wploader.wp(m.seq)
+        wp.target_system = mav.target_system
+        wp.target_component = mav.target_component
+        mav.mav.send(wp)
+        m = wait_for(mav, clock, is_reply, timeout, "mission upload")
+    if m.type != mavutil.mavlink.MAV_MISSION_ACCEPTED:
+        raise TrialFailed("mission rejected (%u)" % m.type)
+
+
+def set_params(mav, clock, params, timeout=10):
+    # each parameter is sent until the vehicle reports the new value
+    for (name, value) in sorted(params.items()):
+        def is_set(m):
+            return (m.get_type() == 'PARAM_VALUE' and m.param_id == name and
+                    abs(m.param_value - value) <= 1.0e-3 * max(1.0, abs(value)))
+        wait_for(mav, clock, is_set, timeout, "%s to be set" % name,
+                 retry=lambda: mav.param_set_send(name, value))
+
+
+def set_mode(mav, clock, name, timeout=30):
+    mode = mav.mode_mapping()[name]
+    def in_mode(m):
+        return (m.get_type() == 'HEARTBEAT' and m.get_srcComponent() == 1 and
+                m.custom_mode == mode)
+    wait_for(mav, clock, in_mode, timeout, "%s mode" % name,
+             retry=lambda: mav.set_mode(mode))
+
+
+def is_armed(m):
+    return (m.get_type() == 'HEARTBEAT' and m.get_srcComponent() == 1 and
+            (m.base_mode & mavutil.mavlink.MAV_MODE_FLAG_SAFETY_ARMED) != 0)
+
+
+def start_mission(mav, clock, vehicle, timeout=120):
+    """arm in the vehicle's arming mode, then start the mission in AUTO"""
+    set_mode(mav, clock, arm_modes[vehicle])
+    # arming fails until the EKF has converged; keep trying
+    wait_for(mav, clock, is_armed, timeout, "arming",
+             retry=mav.arducopter_arm, retry_interval=2.0)
+    auto = mav.mode_mapping()['AUTO']
+    def in_auto(m):
+        return is_armed(m) and m.custom_mode == auto
+    wait_for(mav, clock, in_auto, 30, "mission start",
+             retry=lambda: mav.mav.command_long_send(
+                 mav.target_system, mav.target_component,
+                 mavutil.mavlink.MAV_CMD_MISSION_START, 0, 0, 0, 0, 0, 0, 0, 0))
+
+
+def fly_mission(mav, clock, vehicle, wploader, timeout):
+    """arm, fly the mission in AUTO and collect metrics until it ends"""
+    series = ["xtrack", "alt_err", "ekf_vel", "ekf_pos", "ekf_hgt", "ekf_mag"]
+    stats = dict([(name, Stat()) for name in series])
+    # per task: average, 99th percentile and maximum runtime in us
+    tasks = {}
+    legs = [(wploader.wp(i).x, wploader.wp(i).y) for i in range(wploader.count())]
+    last_seq = wploader.count() - 1
+    wait_for(mav, clock, lambda m: m.get_type() == 'GPS_RAW_INT' and m.fix_type >= 3,
+             120, "GPS fix")
+    start_mission(mav, clock, vehicle)
+
+    current_seq = 1
+    start_ms = clock.ms
+    while True:
+        m = mav.recv_match(blocking=True, timeout=30)
+        if m is None:
+            raise TrialFailed("vehicle stopped sending")
+        clock.update(m)
+        if clock.ms is not None:
+            if start_ms is None:
+                start_ms = clock.ms
+            if (clock.ms - start_ms) * 1.0e-3 > timeout:
+                raise TrialFailed("mission timed out")
+        mtype = m.get_type()
+        if mtype == 'HEARTBEAT' and m.get_srcComponent() == 1:
+            if not is_armed(m):
+                # disarmed after landing at the end of the mission
+                break
+            # keep the throttle off zero so a multicopter isn't taken
+            # as landed while it climbs
+            mav.mav.rc_channels_override_send(mav.target_system, mav.target_component,
+                                              0, 0, 1500, 0, 0, 0, 0, 0)
+        elif mtype == 'MISSION_CURRENT':
+            current_seq = m.seq
+        elif mtype == 'MISSION_ITEM_REACHED' and m.seq >= last_seq:
+            break
+        elif mtype == 'GLOBAL_POSITION_INT' and 0 < current_seq < len(legs):
+            pos = (m.lat * 1.0e-7, m.lon * 1.0e-7)
+            start = legs[current_seq - 1]
+            end = legs[current_seq]
+            if end[0] != 0 or end[1] != 0:
+                if start[0] == 0 and start[1] == 0:
+                    start = end
+                stats["xtrack"].add(leg_distance(pos, start, end))
+        elif mtype == 'NAV_CONTROLLER_OUTPUT':
+            stats["alt_err"].add(abs(m.alt_error))
+        elif mtype == 'EKF_STATUS_REPORT':
+            stats["ekf_vel"].add(m.velocity_variance)
+            stats["ekf_pos"].add(m.pos_horiz_variance)
+            stats["ekf_hgt"].add(m.pos_vert_variance)
+            stats["ekf_mag"].add(m.compass_variance)
+        elif mtype == 'DEBUG_VECT':
+            # named "<task index>:<task name>", the name cut short to
+            # fit, so tasks are told apart by their index
+            (task_id, _, task_name) = m.name.partition(':')
+            if not task_id.isdigit():
+                continue
+            task = tasks.setdefault(int(task_id), [task_name, Stat(), 0.0, 0.0])
+            task[1].add(m.x)
+            task[2] = max(task[2], m.y)
+            task[3] = max(task[3], m.z)
+
+    task_rows = [{"id": task_id, "task": t[0], "avg_us": t[1].mean(), "p99_us": t[2], "max_us": t[3]}
+                 for (task_id, t) in sorted(tasks.items())]
+    slowest = max(task_rows, key=lambda t: t["p99_us"]) if task_rows else None
+    return {
+        "xtrack_mean": stats["xtrack"].mean(),
+        "xtrack_max": stats["xtrack"].max,
+        "alt_err_mean": stats["alt_err"].mean(),
+        "alt_err_max": stats["alt_err"].max,
+        "ekf_vel_max": stats["ekf_vel"].max,
+        "ekf_pos_max": stats["ekf_pos"].max,
+        "ekf_hgt_max": stats["ekf_hgt"].max,
+        "ekf_mag_max": stats["ekf_mag"].max,
+        "task_avg_max": max([t["avg_us"] for t in task_rows] or [0.0]),
+        "task_p99_max": max([t["p99_us"] for t in task_rows] or [0.0]),
+        "task_max_max": max([t["max_us"] for t in task_rows] or [0.0]),
+        "slowest_task": "%u:%s" % (slowest["id"], slowest["task"]) if slowest else "",
+        "tasks": task_rows,
+    }
+
+
+def run_trial(job):
+    """run one trial in its own SITL instance; called in a worker process"""
+    (opts, trial, point_index, params, seed) = job
+    instance = free_instances.get()
+    trial_dir = os.path.join(opts.use_dir, "trial%05u" % trial)
+    args = ["-w",
+            "--home", opts.home,
+            "--lockstep",
+            "--seed", str(seed)]
+    if opts.defaults is not None:
+        args.extend(["--defaults", opts.defaults])
+    result = {"trial": trial, "point": point_index, "seed": seed, "status": "ok", "tasks": []}
+    result.update(params)
+    sitl = None
+    mav = None
+    try:
+        sitl = headless.start(opts.binary, instance, opts.model, trial_dir, args)
+        mav = headless.connect(instance, sitl)
+        headless.wait_heartbeat(mav)
+        mav.mav.request_data_stream_send(mav.target_system, mav.target_component,
+                                         mavutil.mavlink.MAV_DATA_STREAM_ALL, 10, 1)
+        clock = SimClock()
+        wploader = mavwp.MAVWPLoader()
+        wploader.load(opts.mission)
+        set_params(mav, clock, params)
+        upload_mission(mav, clock, wploader)
+        result.update(fly_mission(mav, clock, opts.vehicle, wploader, opts.timeout))
+    except (TrialFailed, headless.SITLError) as e:
+        result["status"] = str(e)
+    except Exception as e:
+        # anything else is a failed trial too, not a reason to stop
+        # the others
+        result["status"] = "error: %s" % e
+    finally:
+        if mav is not None:
+            mav.close()
+        if sitl is not None:
+            headless.stop(sitl)
+        free_instances.put(instance)
+    if not opts.keep_logs and result["status"] == "ok":
+        shutil.rmtree(trial_dir, ignore_errors=True)
+    return result
+
+
+def init_worker(instances):
+    global free_instances
+    free_instances = instances
+
+
+def summarise(points, results):
+    """print mean and worst case of each metric per sweep point"""
+    for (index, point) in enumerate(points):
+        rows = [r for r in results if r["point"] == index and r["status"] == "ok"]
+        failed = len([r for r in results if r["point"] == index]) - len(rows)
+        desc = " ".join(["%s=%s" % (k, point[k]) for k in sorted(point.keys())]) or "(no sweep)"
+        print("%s: %u trials, %u failed" % (desc, len(rows), failed))
+        if len(rows) == 0:
+            continue
+        for name in metric_names:
+            values = sorted([r[name] for r in rows])
+            p95 = values[min(len(values) - 1, int(0.95 * len(values)))]
+            print("  %-14s mean %9.3f  p95 %9.3f  max %9.3f" %
+                  (name, sum(values) / len(values), p95, values[-1]))
+
+
+parser = optparse.OptionParser("montecarlo.py [options]")
+parser.add_option("-v", "--vehicle", type='string', default="ArduCopter", help="vehicle type (%s)" % ", ".join(vehicles))
+parser.add_option("", "--binary", type='string', default=None, help="SITL binary to run (default: build/sitl/bin/<vehicle>)")
+parser.add_option("", "--model", type='string', default=None, help="simulation model (default depends on vehicle)")
+parser.add_option("", "--home", type='string', default="-35.363261,149.165230,584,353", help="home location (lat,lng,alt,yaw)")
+parser.add_option("", "--defaults", type='string', default=None, help="defaults file(s) for every trial")
+parser.add_option("", "--mission", type='string', help="mission file to fly")
+parser.add_option("", "--sweep", type='string', help="JSON sweep specification")
+parser.add_option("-j", "--jobs", type='int', default=multiprocessing.cpu_count(), help="number of trials to run in parallel")
+parser.add_option("", "--timeout", type='float', default=None, help="simulated seconds before a trial is abandoned")
+parser.add_option("", "--use-dir", type='string', default="montecarlo", help="directory to hold per-trial state")
+parser.add_option("", "--keep-logs", action='store_true', default=False, help="keep the directory of successful trials")
+parser.add_option("-o", "--output", type='string', default="montecarlo.csv", help="CSV file for per-trial results")
+parser.add_option("", "--task-output", type='string', default="montecarlo-tasks.csv", help="CSV file for per-trial scheduler task runtimes")
+
+(opts, args) = parser.parse_args()
+
+if opts.mission is None or opts.sweep is None:
+    parser.error("--mission and --sweep are required")
+if opts.vehicle not in vehicles:
+    parser.error("unknown vehicle %s" % opts.vehicle)
+
+try:
+    opts.binary = headless.find_binary(opts.vehicle, opts.binary)
+except headless.SITLError as e:
+    print(e)
+    sys.exit(1)
+opts.model = opts.model or headless.default_model(opts.vehicle)
+opts.mission = os.path.abspath(opts.mission)
+opts.use_dir = os.path.abspath(opts.use_dir)
+if opts.defaults is not None:
+    opts.defaults = ",".join([os.path.abspath(x) for x in opts.defaults.split(",")])
+
+with open(opts.sweep) as f:
+    spec = json.load(f)
+if opts.timeout is None:
+    opts.timeout = float(spec.get("timeout", 600))
+
+points = sweep_points(spec)
+trials_per_point = int(spec.get("trials", 1))
+base_seed = int(spec.get("seed", 1))
+jobs = []
+for (index, point) in enumerate(points):
+    for i in range(trials_per_point):
+        trial = len(jobs)
+        seed = base_seed + trial
+        jobs.append((opts, trial, index, draw_params(spec, point, seed), seed))
+
+print("Running %u trials (%u sweep points x %u) on %u cores" %
+      (len(jobs), len(points), trials_per_point, opts.jobs))
+
+# each worker needs its own SITL instance number so ports don't clash
+instances = multiprocessing.Manager().Queue()
+for i in range(opts.jobs):
+    instances.put(i)
+pool = multiprocessing.Pool(opts.jobs, init_worker, (instances,))
+
+param_names = sorted(set(itertools.chain(*[j[3].keys() for j in jobs])))
+fieldnames = ["trial", "point", "seed", "status"] + param_names + metric_names + ["slowest_task"]
+task_fieldnames = ["trial", "id", "task", "avg_us", "p99_us", "max_us"]
+results = []
+start = time.time()
+with open(opts.output, "w") as f, open(opts.task_output, "w") as tf:
+    writer = csv.DictWriter(f, fieldnames=fieldnames)
+    writer.writeheader()
+    task_writer = csv.DictWriter(tf, fieldnames=task_fieldnames)
+    task_writer.writeheader()
+    for result in pool.imap_unordered(run_trial, jobs):
+        for task in result.pop("tasks"):
+            task["trial"] = result["trial"]
+            task_writer.writerow(task)
+        results.append(result)
+        writer.writerow(result)
+        f.flush()
+        tf.flush()
+        print("trial %u: %s (%u/%u, %.0fs)" %
+              (result["trial"], result["status"], len(results), len(jobs), time.time() - start))
+pool.close()
+pool.join()
+
+summarise(points, results)
@@ -0,0 +1,87 @@
+"""
+start SITL instances headless and connect to them directly over
+MAVLink, without MAVProxy. Shared by swarm.py, montecarlo.py and
+latency_bench.py
+"""
+from __future__ import print_function
+
+import os
+import subprocess
+import time
+
+from pymavlink import mavutil
+
+from . import util
+
+# uartA of instance I listens on BASE_PORT + 10*I
+BASE_PORT = 5760
+
+# SITL binary, default model and waf target of each vehicle
+vehicle_binaries = {
+    "ArduCopter": ("arducopter", "+", "copter"),
+    "ArduPlane": ("arduplane", "plane", "plane"),
+    "APMrover2": ("ardurover", "rover", "rover"),
+    "ArduSub": ("ardusub", "vectored", "sub"),
+}
+
+
+class SITLError(Exception):
+    pass
+
+
+def find_binary(vehicle, binary=None):
+    """absolute path of the SITL binary to run for vehicle, checking it has been built"""
+    (binary_name, model, target) = vehicle_binaries[vehicle]
+    if binary is None:
+        binary = util.reltopdir(os.path.join("build", "sitl", "bin", binary_name))
+    binary = os.path.abspath(binary)
+    if not os.path.exists(binary):
+        raise SITLError("SITL binary %s not found; build with ./waf configure --board sitl && ./waf %s" %
+                        (binary, target))
+    return binary
+
+
+def default_model(vehicle):
+    return vehicle_binaries[vehicle][1]
+
+
+def start(binary, instance, model, directory, args=()):
+    """start SITL instance in directory, with its output in sitl.log there"""
+    if not os.path.exists(directory):
+        os.makedirs(directory)
+    cmd = [binary,
+           "-S",
+           "-I%u" % instance,
+           "--model", model,
+           "--disable-fgview"] + list(args)
+    with open(os.path.join(directory, "sitl.log"), "w") as log:
+        return subprocess.Popen(cmd, cwd=directory, stdout=log, stderr=subprocess.STDOUT)
+
+
+def stop(process):
+    if process.poll() is None:
+        process.terminate()
+    process.wait()
+
+
+def connect(instance, process=None, timeout=30):
+    """
+    connect to the uartA of SITL instance, retrying while it starts up.
+    Gives up early if process has exited
+    """
+    port = BASE_PORT + 10 * instance
+    deadline = time.time() + timeout
+    while True:
+        try:
+            return mavutil.mavlink_connection("tcp:127.0.0.1:%u" % port,
+                                              source_system=255,
+                                              robust_parsing=True)
+        except Exception:
+            if time.time() > deadline or (process is not None and process.poll() is not None):
+                raise SITLError("could not connect to SITL instance %u on port %u" % (instance, port))
+            time.sleep(0.1)
+
+
+def wait_heartbeat(mav, timeout=30):
+    if mav.wait_heartbeat(timeout=timeout) is None:
+        raise SITLError("no heartbeat from SITL")
@@ -488,6 +488,8 @@ def start_vehicle(binary, autotest, opts, stuff, loc):
         cmd.append("-w")
     cmd.extend(["--model", stuff["model"]])
     cmd.extend(["--speedup", str(opts.speedup)])
+    if opts.lockstep:
+        cmd.append("--lockstep")
     if opts.sitl_instance_args:
         cmd.extend(opts.sitl_instance_args.split(" "))  # this could be a lot better..
     if opts.mavlink_gimbal:
@@ -620,6 +622,7 @@ group_sim.add_option("-M", "--mavlink-gimbal", action='store_true', default=Fals
 group_sim.add_option("-L", "--location", type='string', default='CMAC', help="select start location from Tools/autotest/locations.txt")
 group_sim.add_option("-l", "--custom-location", type='string', default=None, help="set custom start location")
 group_sim.add_option("-S", "--speedup", default=1, type='int', help="set simulation speedup (1 for wall clock time)")
+group_sim.add_option("", "--lockstep", action='store_true', default=False, help="run simulation as fast as possible, with repeatable timing")
 group_sim.add_option("-t", "--tracker-location", default='CMAC_PILOTSBOX', type='string', help="set antenna tracker start location")
 group_sim.add_option("-w", "--wipe-eeprom", action='store_true', default=False, help="wipe EEPROM and reload parameters")
 group_sim.add_option("-m", "--mavproxy-args", default=None, type='string', help="additional arguments to pass to mavproxy.py")
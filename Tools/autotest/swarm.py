@@ -0,0 +1,245 @@
+#!/usr/bin/env python
+
+"""
+Run a headless swarm of SITL vehicles behind a single MAVLink router.
+
+Each vehicle is a SITL process started without FlightGear view, console
+or MAVProxy, in its own directory (so eeprom.bin and logs don't
+collide), with a unique SYSID_THISMAV and a home position laid out on
+a grid. This script is the only other process: it connects to every
+vehicle's uartA and forwards traffic between the vehicles and any
+number of GCS outputs, so a ground station sees the whole swarm on one
+link. Vehicles only see each other's messages when they are addressed
+to them, or are of a type given with --share.
+
+The vehicles all run against the wall clock, sped up by --speedup, so
+their simulated times stay together and the traffic routed between
+them is current. SITL's --lockstep mode can't be used here, as each
+vehicle would run as fast as it could on its own clock.
+
+Example:
+  Tools/autotest/swarm.py -v ArduCopter -n 50 --speedup 2 --out udp:127.0.0.1:14550 --share GLOBAL_POSITION_INT
+"""
+from __future__ import print_function
+
+import atexit
+import collections
+import errno
+import math
+import optparse
+import os
+import select
+import socket
+import sys
+import time
+
+from pymavlink import mavutil
+
+from pysim import headless
+
+
+def location_offset(lat, lng, north_m, east_m):
+    """return lat/lng moved by the given distances in meters"""
+    radius_of_earth = 6378100.0
+    dlat = north_m / radius_of_earth
+    dlng = east_m / (radius_of_earth * math.cos(math.radians(lat)))
+    return (lat + math.degrees(dlat), lng + math.degrees(dlng))
+
+
+def instance_home(opts, i):
+    """home string for vehicle i, laid out on a square grid"""
+    (lat, lng, alt, hdg) = [float(x) for x in opts.home.split(',')]
+    columns = int(math.ceil(math.sqrt(opts.count)))
+    north = (i // columns) * opts.spacing
+    east = (i % columns) * opts.spacing
+    (lat, lng) = location_offset(lat, lng, north, east)
+    return "%.7f,%.7f,%.1f,%.0f" % (lat, lng, alt, hdg)
+
+
+def start_vehicle(opts, binary, model, i):
+    """start SITL instance i in its own directory"""
+    instance_dir = os.path.join(opts.use_dir, "vehicle%u" % (i + 1))
+    if not os.path.exists(instance_dir):
+        os.makedirs(instance_dir)
+
+    defaults = os.path.join(instance_dir, "swarm.parm")
+    with open(defaults, "w") as f:
+        f.write("SYSID_THISMAV %u\n" % (i + 1))
+
+    args = ["--home", instance_home(opts, i),
+            "--speedup", str(opts.speedup),
+            "--defaults", ",".join(opts.defaults + [defaults])]
+    if opts.wipe_eeprom:
+        args.append("-w")
+    return headless.start(binary, i, model, instance_dir, args)
+
+
+class Link(object):
+    """
+    a vehicle or GCS connection with its own queue of outgoing messages.
+    Writes never block, so a slow link only delays its own traffic
+    """
+    def __init__(self, conn, sysid=None):
+        self.conn = conn
+        self.sysid = sysid
+        self.queue = collections.deque()
+        self.queued_bytes = 0
+        self.dropped = 0
+        self.received = 0
+        # pymavlink's TCP connections are non-blocking sockets, which we
+        # write to directly so partly sent messages can be resumed.
+        # Anything else is datagram based and written whole
+        self.stream = isinstance(conn, mavutil.mavtcp)
+
+    def fd(self):
+        return self.conn.fd
+
+    def is_vehicle(self):
+        return self.sysid is not None
+
+    def send(self, buf, max_queue):
+        """queue a message, dropping it if the link is too far behind"""
+        if self.queued_bytes + len(buf) > max_queue:
+            self.dropped += 1
+            return
+        self.queue.append(buf)
+        self.queued_bytes += len(buf)
+
+    def flush(self):
+        """write as much of the queue as the link will take without blocking"""
+        while self.queue:
+            buf = self.queue[0]
+            if not self.stream:
+                self.conn.write(buf)
+                n = len(buf)
+            else:
+                try:
+                    n = self.conn.port.send(buf)
+                except socket.error as e:
+                    if e.errno in (errno.EAGAIN, errno.EWOULDBLOCK):
+                        return
+                    raise
+            self.queued_bytes -= n
+            if n < len(buf):
+                self.queue[0] = buf[n:]
+                return
+            self.queue.popleft()
+
+
+def route(vehicles, outputs, opts):
+    """
+    forward traffic between the vehicles and the outputs until
+    interrupted. Every vehicle message goes to every output. A vehicle
+    only gets another vehicle's message if it is addressed to its
+    sysid, or is one of the types listed with --share
+    """
+    links = vehicles + outputs
+    fds = {}
+    for link in links:
+        fds[link.fd()] = link
+    by_sysid = {}
+    for v in vehicles:
+        by_sysid[v.sysid] = v
+    share = set(opts.share)
+    last_report = time.time()
+    while True:
+        pending = [link.fd() for link in links if link.queue and link.stream]
+        (readable, writable, _) = select.select(list(fds.keys()), pending, [], 1.0)
+        for fd in readable:
+            src = fds[fd]
+            while True:
+                msg = src.conn.recv_msg()
+                if msg is None:
+                    break
+                if msg.get_type() == 'BAD_DATA':
+                    continue
+                buf = msg.get_msgbuf()
+                target = getattr(msg, 'target_system', 0)
+                if src.is_vehicle():
+                    src.received += 1
+                    for dst in outputs:
+                        dst.send(buf, opts.max_queue)
+                    if target in by_sysid and target != src.sysid:
+                        by_sysid[target].send(buf, opts.max_queue)
+                    elif target == 0 and msg.get_type() in share:
+                        for dst in vehicles:
+                            if dst is not src:
+                                dst.send(buf, opts.max_queue)
+                elif target in by_sysid:
+                    by_sysid[target].send(buf, opts.max_queue)
+                else:
+                    for dst in vehicles:
+                        dst.send(buf, opts.max_queue)
+        for link in links:
+            link.flush()
+        now = time.time()
+        if now - last_report > 10:
+            active = len([v for v in vehicles if v.received > 0])
+            dropped = sum([link.dropped for link in links])
+            print("swarm: %u/%u vehicles active, %u messages, %u dropped in %.0fs" %
+                  (active, len(vehicles), sum([v.received for v in vehicles]), dropped, now - last_report))
+            for link in links:
+                link.received = 0
+                link.dropped = 0
+            last_report = now
+
+
+parser = optparse.OptionParser("swarm.py [options]")
+parser.add_option("-v", "--vehicle", type='string', default="ArduCopter", help="vehicle type (%s)" % ", ".join(sorted(headless.vehicle_binaries.keys())))
+parser.add_option("-n", "--count", type='int', default=10, help="number of vehicles")
+parser.add_option("", "--binary", type='string', default=None, help="SITL binary to run (default: build/sitl/bin/<vehicle>)")
+parser.add_option("", "--model", type='string', default=None, help="simulation model (default depends on vehicle)")
+parser.add_option("", "--home", type='string', default="-35.363261,149.165230,584,353", help="home of the first vehicle (lat,lng,alt,yaw)")
+parser.add_option("", "--spacing", type='float', default=10.0, help="grid spacing between vehicle homes in meters")
+parser.add_option("", "--speedup", type='int', default=1, help="simulation speedup, the same for every vehicle")
+parser.add_option("", "--defaults", type='string', action="append", default=[], help="additional defaults file for every vehicle")
+parser.add_option("", "--use-dir", type='string', default="swarm", help="directory to hold per-vehicle state")
+parser.add_option("", "--out", type='string', action="append", default=[], help="GCS output, e.g. udp:127.0.0.1:14550")
+parser.add_option("", "--share", type='string', action="append", default=[], help="message type every vehicle sends to all the others, e.g. GLOBAL_POSITION_INT")
+parser.add_option("", "--max-queue", type='int', default=65536, help="bytes queued for a link before messages to it are dropped")
+parser.add_option("-w", "--wipe-eeprom", action='store_true', default=False, help="wipe EEPROM and reload parameters")
+
+(opts, args) = parser.parse_args()
+
+if opts.vehicle not in headless.vehicle_binaries:
+    print("Unknown vehicle %s" % opts.vehicle)
+    sys.exit(1)
+
+try:
+    binary = headless.find_binary(opts.vehicle, opts.binary)
+except headless.SITLError as e:
+    print(e)
+    sys.exit(1)
+model = opts.model or headless.default_model(opts.vehicle)
+opts.defaults = [os.path.abspath(x) for x in opts.defaults]
+opts.use_dir = os.path.abspath(opts.use_dir)
+
+processes = []
+
+
+def kill_swarm():
+    # stop them all before waiting for any
+    for p in processes:
+        if p.poll() is None:
+            p.terminate()
+    for p in processes:
+        headless.stop(p)
+
+atexit.register(kill_swarm)
+
+for i in range(opts.count):
+    processes.append(start_vehicle(opts, binary, model, i))
+
+try:
+    vehicles = [Link(headless.connect(i, processes[i], timeout=60), sysid=i+1) for i in range(opts.count)]
+except headless.SITLError as e:
+    print(e)
+    sys.exit(1)
+print("swarm: connected to %u vehicles" % len(vehicles))
+
+outputs = [Link(mavutil.mavlink_connection(out, input=False)) for out in opts.out]
+
+try:
+    route(vehicles, outputs, opts)
+except KeyboardInterrupt:
+    pass
@@ -0,0 +1,149 @@
+#!/usr/bin/env python
+'''
+turn an LTTng trace of the ardupilot:stage tracepoints into per-stage
+latency histograms
+
+Record a trace on the vehicle with:
+  lttng create fastloop
+  lttng enable-event -u 'ardupilot:stage'
+  lttng start ; sleep 30 ; lttng stop
+
+then run either
+  lttng_latency.py ~/lttng-traces/fastloop-*
+or
+  babeltrace ~/lttng-traces/fastloop-* | lttng_latency.py -
+
+Every stage is measured from the IMU_PUBLISH of the chosen IMU which
+started the loop, and IMU_PUBLISH itself from the latest raw sample of
+that IMU. The stage numbers match enum trace_point in
+libraries/AP_HAL/Util.h
+'''
+from __future__ import print_function
+
+import optparse
+import re
+import subprocess
+import sys
+
+TRACE_IMU_SAMPLE = 0
+TRACE_IMU_PUBLISH = 1
+TRACE_EKF_PREDICT = 2
+TRACE_EKF_FUSE = 3
+TRACE_ATT_CONTROL = 4
+TRACE_MOTOR_OUTPUT = 5
+TRACE_LOG_ENQUEUE = 6
+
+stage_names = {
+    TRACE_IMU_SAMPLE: "IMU_SAMPLE",
+    TRACE_IMU_PUBLISH: "IMU_PUBLISH",
+    TRACE_EKF_PREDICT: "EKF_PREDICT",
+    TRACE_EKF_FUSE: "EKF_FUSE",
+    TRACE_ATT_CONTROL: "ATT_CONTROL",
+    TRACE_MOTOR_OUTPUT: "MOTOR_OUTPUT",
+    TRACE_LOG_ENQUEUE: "LOG_ENQUEUE",
+}
+
+event_re = re.compile(r'ardupilot:stage:.*\{\s*point\s*=\s*(\d+),\s*instance\s*=\s*(\d+),\s*time_us\s*=\s*(\d+)\s*\}')
+
+parser = optparse.OptionParser("lttng_latency.py [options] <TRACEDIR|->")
+parser.add_option("--imu", type='int', default=0, help="IMU instance which starts a loop")
+parser.add_option("--core", type='int', default=None, help="only count EKF points from this core")
+parser.add_option("--max-us", type='int', default=20000, help="ignore latencies above this (dropped events)")
+parser.add_option("--buckets", type='int', default=20, help="number of histogram buckets")
+parser.add_option("--width", type='int', default=50, help="histogram bar width")
+
+opts, args = parser.parse_args()
+
+if len(args) != 1:
+    parser.print_help()
+    sys.exit(1)
+
+
+def read_events(source):
+    '''yield (point, instance, time_us) from babeltrace text output'''
+    if source == '-':
+        f = sys.stdin
+    else:
+        f = subprocess.Popen(['babeltrace', source], stdout=subprocess.PIPE,
+                             universal_newlines=True).stdout
+    for line in f:
+        m = event_re.search(line)
+        if m is None:
+            continue
+        yield (int(m.group(1)), int(m.group(2)), int(m.group(3)))
+
+
+def percentile(values, pct):
+    '''nearest-rank percentile of a sorted list'''
+    if len(values) == 0:
+        return 0
+    idx = int(round(pct / 100.0 * (len(values) - 1)))
+    return values[idx]
+
+
+def print_histogram(values):
+    '''print an ASCII histogram of sorted latencies'''
+    lo = values[0]
+    hi = values[-1]
+    step = max(1, (hi - lo + opts.buckets) // opts.buckets)
+    counts = [0] * opts.buckets
+    for v in values:
+        counts[min((v - lo) // step, opts.buckets - 1)] += 1
+    peak = max(counts)
+    for i in range(opts.buckets):
+        if counts[i] == 0:
+            continue
+        bar = '#' * max(1, counts[i] * opts.width // peak)
+        print("  %6u-%-6u %7u %s" % (lo + i * step, lo + (i + 1) * step - 1, counts[i], bar))
+
+
+latencies = {}
+for p in stage_names:
+    latencies[p] = []
+
+last_sample = {}
+loop_start = None
+seen = set()
+nevents = 0
+
+for (point, instance, time_us) in read_events(args[0]):
+    nevents += 1
+    if point == TRACE_IMU_SAMPLE:
+        last_sample[instance] = time_us
+        continue
+    if point == TRACE_IMU_PUBLISH:
+        if instance != opts.imu:
+            continue
+        if instance in last_sample:
+            latencies[point].append(time_us - last_sample[instance])
+        loop_start = time_us
+        seen = set()
+        continue
+    if loop_start is None:
+        continue
+    if point in (TRACE_EKF_PREDICT, TRACE_EKF_FUSE) and opts.core is not None and instance != opts.core:
+        continue
+    if point != TRACE_LOG_ENQUEUE:
+        # only the first occurrence after the loop start is latency,
+        # later ones are other EKF cores or repeated calls
+        if point in seen:
+            continue
+        seen.add(point)
+    dt = time_us - loop_start
+    if dt < 0 or dt > opts.max_us:
+        continue
+    latencies[point].append(dt)
+
+if nevents == 0:
+    print("No ardupilot:stage events found")
+    sys.exit(1)
+
+print("%u events" % nevents)
+for p in sorted(stage_names.keys()):
+    values = sorted(latencies[p])
+    if len(values) == 0:
+        continue
+    print("%-12s n=%-7u min=%-6u mean=%-8.1f p50=%-6u p90=%-6u p99=%-6u max=%u (usec)" % (
+        stage_names[p], len(values), values[0], sum(values) / float(len(values)),
+        percentile(values, 50), percentile(values, 90), percentile(values, 99), values[-1]))
+    print_histogram(values)
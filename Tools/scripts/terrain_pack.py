@@ -0,0 +1,137 @@
+#!/usr/bin/env python
+'''
+pack a directory of terrain .DAT files into a single TERRAIN.PAK file,
+which SITL and Linux boards memory map and read in place
+
+  terrain_pack.py terrain/ terrain/TERRAIN.PAK
+
+Only blocks of the chosen grid spacing with a valid CRC are packed. An
+existing pack is replaced by renaming the new one over it. The
+file layout is described with struct terrain_pack_header in
+libraries/AP_Terrain/AP_Terrain.h
+
+The vehicle reads the whole pack in and locks it in memory, so it is
+only used if it is no larger than 64MB and the locked memory limit of
+the vehicle process (ulimit -l) is at least the pack size, or the
+process has CAP_IPC_LOCK. Otherwise the vehicle reports why on the
+console and to the ground station, and uses the .DAT files alone.
+'''
+from __future__ import print_function
+
+import binascii
+import glob
+import optparse
+import os
+import struct
+import sys
+
+IO_BLOCK_SIZE = 2048
+# largest pack the vehicle will use, TERRAIN_PACK_SIZE_MAX
+PACK_SIZE_MAX = 64*1024*1024
+BLOCK_SIZE = 1821
+FORMAT_VERSION = 1
+MAGIC = b'APTPACK1'
+NO_BLOCK = 0xFFFFFFFF
+
+# start of struct grid_block, up to the heights
+BLOCK_HEADER = struct.Struct('<QiiHHH')
+# end of struct grid_block, after the heights
+BLOCK_INDEX = struct.Struct('<HHhb')
+BLOCK_INDEX_OFS = BLOCK_HEADER.size + 28*32*2
+
+PACK_HEADER = struct.Struct('<8sHHIIII')
+PACK_DEGREE = struct.Struct('<hbBHHI')
+PACK_SLOT = struct.Struct('<I')
+
+parser = optparse.OptionParser("terrain_pack.py [options] <TERRAIN_DIR> <OUTPUT>")
+parser.add_option("--spacing", type='int', default=100, help="grid spacing to pack in meters")
+
+opts, args = parser.parse_args()
+if len(args) != 2:
+    parser.print_help()
+    sys.exit(1)
+
+terrain_dir, output = args
+
+
+def block_crc(data):
+    '''crc16_ccitt of a grid_block with its crc field zeroed'''
+    return binascii.crc_hqx(data[:16] + b'\0\0' + data[18:BLOCK_SIZE], 0)
+
+
+def bit_count(v):
+    return bin(v).count('1')
+
+
+# (lat_degrees, lon_degrees) -> {(grid_idx_x, grid_idx_y): block}
+degrees = {}
+nread = 0
+nbad = 0
+
+for fname in sorted(glob.glob(os.path.join(terrain_dir, '*.DAT'))):
+    f = open(fname, 'rb')
+    while True:
+        data = f.read(IO_BLOCK_SIZE)
+        if len(data) < BLOCK_SIZE:
+            break
+        (bitmap, lat, lon, crc, version, spacing) = BLOCK_HEADER.unpack_from(data, 0)
+        if bitmap == 0:
+            # never written
+            continue
+        nread += 1
+        if version != FORMAT_VERSION or spacing != opts.spacing or crc != block_crc(data):
+            nbad += 1
+            continue
+        (idx_x, idx_y, lon_degrees, lat_degrees) = BLOCK_INDEX.unpack_from(data, BLOCK_INDEX_OFS)
+        blocks = degrees.setdefault((lat_degrees, lon_degrees), {})
+        old = blocks.get((idx_x, idx_y))
+        if old is not None and bit_count(BLOCK_HEADER.unpack_from(old, 0)[0]) >= bit_count(bitmap):
+            continue
+        blocks[(idx_x, idx_y)] = data[:BLOCK_SIZE]
+    f.close()
+
+# the index, with blocks numbered in slot order
+degree_table = []
+slots = []
+block_list = []
+for key in sorted(degrees.keys()):
+    blocks = degrees[key]
+    rows = max([x for (x, y) in blocks.keys()]) + 1
+    cols = max([y for (x, y) in blocks.keys()]) + 1
+    degree_table.append(PACK_DEGREE.pack(key[1], key[0], 0, rows, cols, len(slots)))
+    for x in range(rows):
+        for y in range(cols):
+            data = blocks.get((x, y))
+            if data is None:
+                slots.append(NO_BLOCK)
+            else:
+                slots.append(len(block_list))
+                block_list.append(data)
+
+index_size = PACK_HEADER.size + len(degree_table)*PACK_DEGREE.size + len(slots)*PACK_SLOT.size
+blocks_offset = (index_size + IO_BLOCK_SIZE - 1) // IO_BLOCK_SIZE * IO_BLOCK_SIZE
+
+# write a new file and rename it over the old one. A running SITL or
+# vehicle may have the old pack mapped, and truncating that in place
+# makes its lookups fault with SIGBUS
+tmp_output = output + '.tmp'
+out = open(tmp_output, 'wb')
+out.write(PACK_HEADER.pack(MAGIC, FORMAT_VERSION, opts.spacing,
+                           len(degree_table), len(slots), len(block_list), blocks_offset))
+for d in degree_table:
+    out.write(d)
+for s in slots:
+    out.write(PACK_SLOT.pack(s))
+out.write(b'\0' * (blocks_offset - index_size))
+for data in block_list:
+    out.write(data + b'\0' * (IO_BLOCK_SIZE - len(data)))
+out.close()
+os.rename(tmp_output, output)
+
+print("Packed %u of %u blocks in %u degree squares into %s (%u bad blocks skipped)" % (
+    len(block_list), nread, len(degree_table), output, nbad))
+pack_size = blocks_offset + len(block_list)*IO_BLOCK_SIZE
+if pack_size > PACK_SIZE_MAX:
+    print("Warning: %s is over 64MB and will not be used, pack fewer degree squares" % output)
+else:
+    print("The vehicle needs ulimit -l of at least %u kB to use it" % ((pack_size + 1023) // 1024))
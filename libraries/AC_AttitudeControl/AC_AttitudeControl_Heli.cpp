@@ -1,6 +1,8 @@
 #include "AC_AttitudeControl_Heli.h"
 #include <AP_HAL/AP_HAL.h>
 
+extern const AP_HAL::HAL& hal;
+
 // table of user settable parameters
 const AP_Param::GroupInfo AC_AttitudeControl_Heli::var_info[] = {
     // parameters from parent vehicle
@@ -249,6 +251,7 @@ void AC_AttitudeControl_Heli::input_rate_bf_roll_pitch_yaw(float roll_rate_bf_cd
 void AC_AttitudeControl_Heli::rate_controller_run()
 {	
     Vector3f gyro_latest = _ahrs.get_gyro_latest();
+    _motors.set_gyro_sample_us(_ahrs.get_gyro_latest_sample_us());
 
     // call rate controllers and send output to motors object
     // if using a flybar passthrough roll and pitch directly to motors
@@ -263,6 +266,8 @@ void AC_AttitudeControl_Heli::rate_controller_run()
     } else {
         _motors.set_yaw(rate_target_to_motor_yaw(gyro_latest.z, _rate_target_ang_vel.z));
     }
+
+    HAL_TRACE(TRACE_ATT_CONTROL, 0);
 }
 
 // Update Alt_Hold angle maximum
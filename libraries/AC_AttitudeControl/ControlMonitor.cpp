@@ -41,13 +41,14 @@ void AC_AttitudeControl::control_monitor_update(void)
  */
 void AC_AttitudeControl::control_monitor_log(void)
 {
-    DataFlash_Class::instance()->Log_Write("CTRL", "TimeUS,RMSRollP,RMSRollD,RMSPitchP,RMSPitchD,RMSYaw", "Qfffff",
-                                           AP_HAL::micros64(),
-                                           (double)sqrtf(_control_monitor.rms_roll_P),
-                                           (double)sqrtf(_control_monitor.rms_roll_D),
-                                           (double)sqrtf(_control_monitor.rms_pitch_P),
-                                           (double)sqrtf(_control_monitor.rms_pitch_D),
-                                           (double)sqrtf(_control_monitor.rms_yaw));
+    DATAFLASH_LOG_MESSAGE(ctrl_msg, "CTRL", "TimeUS,RMSRollP,RMSRollD,RMSPitchP,RMSPitchD,RMSYaw", "Qfffff",
+                          uint64_t, float, float, float, float, float);
+    ctrl_msg.write(AP_HAL::micros64(),
+                   sqrtf(_control_monitor.rms_roll_P),
+                   sqrtf(_control_monitor.rms_roll_D),
+                   sqrtf(_control_monitor.rms_pitch_P),
+                   sqrtf(_control_monitor.rms_pitch_D),
+                   sqrtf(_control_monitor.rms_yaw));
 
 }
 
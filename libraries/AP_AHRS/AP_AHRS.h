@@ -282,6 +282,11 @@ public:
     // return a smoothed and corrected gyro vector using the latest ins data (which may not have been consumed by the EKF yet)
     Vector3f get_gyro_latest(void) const;
 
+    // return the capture time in microseconds of the sample behind get_gyro_latest()
+    uint64_t get_gyro_latest_sample_us(void) const {
+        return get_ins().get_gyro_sample_us(get_primary_gyro_index());
+    }
+
     // return the current estimate of the gyro drift
     virtual const Vector3f &get_gyro_drift(void) const = 0;
 
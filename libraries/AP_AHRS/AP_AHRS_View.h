@@ -42,6 +42,11 @@ public:
     // return a smoothed and corrected gyro vector using the latest ins data (which may not have been consumed by the EKF yet)
     Vector3f get_gyro_latest(void) const;
 
+    // return the capture time in microseconds of the sample behind get_gyro_latest()
+    uint64_t get_gyro_latest_sample_us(void) const {
+        return ahrs.get_gyro_latest_sample_us();
+    }
+
     // return a DCM rotation matrix representing our current
     // attitude in this view
     const Matrix3f &get_rotation_body_to_ned(void) const {
@@ -187,15 +187,6 @@ uint16_t AP_Baro_MS56XX::_read_prom_word(uint8_t word)
     return (val[0] << 8) | val[1];
 }
 
-uint32_t AP_Baro_MS56XX::_read_adc()
-{
-    uint8_t val[3];
-    if (!_dev->transfer(&CMD_MS56XX_READ_ADC, 1, val, sizeof(val))) {
-        return 0;
-    }
-    return (val[0] << 16) | (val[1] << 8) | val[2];
-}
-
 bool AP_Baro_MS56XX::_read_prom_5611(uint16_t prom[8])
 {
     /*
@@ -269,42 +260,54 @@ bool AP_Baro_MS56XX::_read_prom_5637(uint16_t prom[8])
 */
 void AP_Baro_MS56XX::_timer(void)
 {
-    uint8_t next_cmd;
-    uint8_t next_state;
-    uint32_t adc_val = _read_adc();
-
     /*
-     * If read fails, re-initiate a read command for current state or we are
-     * stuck
+     * Read the result of the running conversion and start the next one in
+     * a single batch, which is one ioctl on Linux SPI. The next conversion
+     * is chosen assuming the read succeeds, and replaced below if it fails.
      */
-    if (adc_val == 0) {
-        next_state = _state;
-    } else {
-        next_state = (_state + 1) % 5;
-    }
-
-    next_cmd = next_state == 0 ? ADDR_CMD_CONVERT_TEMPERATURE
-                               : ADDR_CMD_CONVERT_PRESSURE;
-    if (!_dev->transfer(&next_cmd, 1, nullptr, 0)) {
+    const uint8_t next_state = (_state + 1) % 5;
+    const uint8_t next_cmd = next_state == 0 ? ADDR_CMD_CONVERT_TEMPERATURE
+                                             : ADDR_CMD_CONVERT_PRESSURE;
+    uint8_t val[3] = { };
+    const AP_HAL::Device::Transfer xfers[] = {
+        { &CMD_MS56XX_READ_ADC, 1, val, sizeof(val) },
+        { &next_cmd, 1, nullptr, 0 },
+    };
+
+    if (!_dev->transfer_batch(xfers, ARRAY_SIZE(xfers))) {
+        /*
+         * We don't know which conversion is running, if any. The next
+         * read is discarded and starts the conversion after this state
+         */
+        _discard_next = true;
         return;
     }
 
-    /* if we had a failed read we are all done */
+    const uint32_t adc_val = (val[0] << 16) | (val[1] << 8) | val[2];
+
     if (adc_val == 0) {
-        // a failed read can mean the next returned value will be
-        // corrupt, we must discard it
+        /*
+         * If read fails, start the conversion for the current state again
+         * in place of the one just started. A failed read can mean the
+         * next returned value will be corrupt, we must discard it
+         */
+        const uint8_t cmd = _state == 0 ? ADDR_CMD_CONVERT_TEMPERATURE
+                                        : ADDR_CMD_CONVERT_PRESSURE;
+        _dev->transfer(&cmd, 1, nullptr, 0);
         _discard_next = true;
         return;
     }
 
+    const uint8_t state = _state;
+    _state = next_state;
+
     if (_discard_next) {
         _discard_next = false;
-        _state = next_state;
         return;
     }
 
     if (_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
-        if (_state == 0) {
+        if (state == 0) {
             _update_and_wrap_accumulator(&_accum.s_D2, adc_val,
                                          &_accum.d2_count, 32);
         } else {
@@ -312,7 +315,6 @@ void AP_Baro_MS56XX::_timer(void)
                                          &_accum.d1_count, 128);
         }
         _sem->give();
-        _state = next_state;
     }
 }
 
@@ -0,0 +1,220 @@
+#include <AP_gtest.h>
+
+#include <string>
+
+#include <AP_Baro/AP_Baro.h>
+#include <AP_Baro/AP_Baro_MS5611.h>
+#include <AP_HAL/AP_HAL.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+// calibration and readings from the MS5611-01BA03 datasheet example
+static const uint16_t prom_cal[6] = { 40127, 36924, 23317, 23282, 33464, 28312 };
+static const uint32_t adc_d1 = 9085466;
+static const uint32_t adc_d2 = 8569150;
+
+static uint16_t crc4(const uint16_t *data)
+{
+    uint16_t n_rem = 0;
+    for (uint8_t cnt = 0; cnt < 16; cnt++) {
+        if (cnt & 1) {
+            n_rem ^= data[cnt >> 1] & 0x00FF;
+        } else {
+            n_rem ^= data[cnt >> 1] >> 8;
+        }
+        for (uint8_t n_bit = 8; n_bit > 0; n_bit--) {
+            if (n_rem & 0x8000) {
+                n_rem = (n_rem << 1) ^ 0x3000;
+            } else {
+                n_rem = (n_rem << 1);
+            }
+        }
+    }
+    return (n_rem >> 12) & 0xF;
+}
+
+class FakeSemaphore : public AP_HAL::Semaphore {
+public:
+    bool take(uint32_t timeout_ms) override { return true; }
+    bool take_nonblocking() override { return true; }
+    bool give() override { return true; }
+};
+
+/*
+  an MS5611 on a bus counting the requests made to the bus driver,
+  which on Linux SPI are ioctls
+ */
+class FakeMS5611 : public AP_HAL::Device {
+public:
+    FakeMS5611(bool batching)
+        : AP_HAL::Device(BUS_TYPE_SPI)
+        , _batching(batching)
+    {
+        for (uint8_t i = 0; i < 6; i++) {
+            _prom[i+1] = prom_cal[i];
+        }
+        _prom[7] = crc4(_prom);
+    }
+
+    unsigned requests;
+    unsigned pressure_conversions;
+    unsigned temperature_conversions;
+    PeriodicCb timer;
+
+    // number of ADC reads still to fail by returning zero
+    unsigned zero_reads = 0;
+
+    // conversions started, P for pressure and T for temperature
+    std::string conversions;
+
+    bool set_speed(Speed speed) override { return true; }
+
+    bool transfer(const uint8_t *send, uint32_t send_len,
+                  uint8_t *recv, uint32_t recv_len) override
+    {
+        requests++;
+        return _transaction(send, send_len, recv, recv_len);
+    }
+
+    bool transfer_batch(const Transfer *xfers, uint8_t count) override
+    {
+        if (!_batching) {
+            return AP_HAL::Device::transfer_batch(xfers, count);
+        }
+        requests++;
+        for (uint8_t i = 0; i < count; i++) {
+            if (!_transaction(xfers[i].send, xfers[i].send_len,
+                              xfers[i].recv, xfers[i].recv_len)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    AP_HAL::Semaphore *get_semaphore() override { return &_sem; }
+
+    PeriodicHandle register_periodic_callback(uint32_t period_usec, PeriodicCb cb) override
+    {
+        timer = cb;
+        return this;
+    }
+
+    bool adjust_periodic_callback(PeriodicHandle h, uint32_t period_usec) override { return false; }
+
+private:
+    bool _batching;
+    FakeSemaphore _sem;
+    uint16_t _prom[8] {};
+    uint32_t _adc;
+
+    bool _transaction(const uint8_t *send, uint32_t send_len,
+                      uint8_t *recv, uint32_t recv_len)
+    {
+        if (send_len != 1) {
+            return false;
+        }
+        const uint8_t cmd = send[0];
+        if (cmd >= 0xA0 && cmd <= 0xAE && recv_len == 2) {
+            const uint16_t word = _prom[(cmd - 0xA0) >> 1];
+            recv[0] = word >> 8;
+            recv[1] = word & 0xFF;
+        } else if (cmd == 0x00 && recv_len == 3 && zero_reads > 0) {
+            zero_reads--;
+            recv[0] = recv[1] = recv[2] = 0;
+        } else if (cmd == 0x00 && recv_len == 3) {
+            // reading the ADC clears it, like the sensor
+            recv[0] = _adc >> 16;
+            recv[1] = _adc >> 8;
+            recv[2] = _adc;
+            _adc = 0;
+        } else if ((cmd & 0xF0) == 0x40) {
+            pressure_conversions++;
+            conversions += 'P';
+            _adc = adc_d1;
+        } else if ((cmd & 0xF0) == 0x50) {
+            temperature_conversions++;
+            conversions += 'T';
+            _adc = adc_d2;
+        }
+        return true;
+    }
+};
+
+static AP_Baro baro;
+
+/*
+  run the sensor for one second of its 100Hz timer on a bus, returning
+  the number of bus requests it made
+ */
+static unsigned run_one_second(bool batching)
+{
+    FakeMS5611 *dev = new FakeMS5611(batching);
+    AP_Baro_Backend *sensor = AP_Baro_MS56XX::probe(baro, AP_HAL::OwnPtr<AP_HAL::Device>(dev));
+    EXPECT_NE(nullptr, sensor);
+    if (sensor == nullptr) {
+        return 0;
+    }
+
+    dev->requests = 0;
+    dev->pressure_conversions = 0;
+    dev->temperature_conversions = 0;
+    for (uint8_t i = 0; i < 100; i++) {
+        dev->timer();
+    }
+    // one temperature for four pressure conversions
+    EXPECT_EQ(80U, dev->pressure_conversions);
+    EXPECT_EQ(20U, dev->temperature_conversions);
+
+    sensor->update();
+    const unsigned requests = dev->requests;
+    delete sensor;
+    return requests;
+}
+
+TEST(AP_Baro_MS56XX, BatchedReadings)
+{
+    const unsigned unbatched = run_one_second(false);
+    const unsigned batched = run_one_second(true);
+
+    // reading the ADC and starting the next conversion is one bus
+    // request per sample instead of two
+    EXPECT_EQ(200U, unbatched);
+    EXPECT_EQ(100U, batched);
+
+    // both sensors see the datasheet example: 20.07C and 1000.09mbar
+    for (uint8_t i = 0; i < 2; i++) {
+        EXPECT_NEAR(100009, baro.get_pressure(i), 5);
+        EXPECT_NEAR(20.07, baro.get_temperature(i), 0.01);
+    }
+}
+
+/*
+  a read returning zero starts the same conversion again. Its result is
+  discarded and the state machine carries on from there
+ */
+TEST(AP_Baro_MS56XX, ZeroReadRetries)
+{
+    FakeMS5611 *dev = new FakeMS5611(true);
+    AP_Baro_Backend *sensor = AP_Baro_MS56XX::probe(baro, AP_HAL::OwnPtr<AP_HAL::Device>(dev));
+    ASSERT_NE(nullptr, sensor);
+
+    // init starts a temperature conversion
+    dev->conversions.clear();
+
+    // reading it fails. The batch has already started a pressure
+    // conversion, so the temperature conversion is started again
+    dev->zero_reads = 1;
+    dev->timer();
+    EXPECT_EQ("PT", dev->conversions);
+
+    // the retried temperature is read and discarded, then the four
+    // pressures and the next temperature follow
+    for (uint8_t i = 0; i < 5; i++) {
+        dev->timer();
+    }
+    EXPECT_EQ("PTPPPPT", dev->conversions);
+
+    delete sensor;
+}
+
+AP_GTEST_MAIN()
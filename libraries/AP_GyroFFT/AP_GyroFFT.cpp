@@ -0,0 +1,284 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AP_GyroFFT.h"
+
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <DataFlash/DataFlash.h>
+
+extern const AP_HAL::HAL& hal;
+
+const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
+
+    // @Param: ENABLE
+    // @DisplayName: Gyro FFT analysis enable
+    // @Description: Enable in-flight spectral analysis of the first gyro
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO_FLAGS("ENABLE", 1, AP_GyroFFT, _enable, 0, AP_PARAM_FLAG_ENABLE),
+
+    // @Param: MINHZ
+    // @DisplayName: Minimum analysed frequency
+    // @Description: Lowest frequency searched for a noise peak
+    // @Units: Hz
+    // @Range: 10 400
+    // @User: Advanced
+    AP_GROUPINFO("MINHZ", 2, AP_GyroFFT, _min_hz, 50),
+
+    // @Param: MAXHZ
+    // @DisplayName: Maximum analysed frequency
+    // @Description: Highest frequency searched for a noise peak. Limited to just under half the analysis sample rate
+    // @Units: Hz
+    // @Range: 20 495
+    // @User: Advanced
+    AP_GROUPINFO("MAXHZ", 3, AP_GyroFFT, _max_hz, 450),
+
+    // @Param: WINDOW
+    // @DisplayName: FFT window size
+    // @Description: Number of samples in each transform. Larger windows give finer frequency resolution but cost more CPU and memory per update
+    // @Values: 32:32,64:64,128:128,256:256,512:512
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("WINDOW", 4, AP_GyroFFT, _window_size, 128),
+
+    AP_GROUPEND
+};
+
+AP_GyroFFT *AP_GyroFFT::_s_instance = nullptr;
+
+AP_GyroFFT::AP_GyroFFT() :
+    _initialised(false),
+    _gyro_instance(0),
+    _decimation(1),
+    _decimation_count(0),
+    _samples(nullptr),
+    _frame{},
+    _power(nullptr),
+    _frame_count(0),
+    _axis(0),
+    _sample_rate_hz(0),
+    _min_bin(0),
+    _max_bin(0),
+    _sem(nullptr),
+    _perf_update(nullptr)
+{
+    AP_Param::setup_object_defaults(this, var_info);
+    _s_instance = this;
+}
+
+void AP_GyroFFT::init(const AP_InertialSensor &ins)
+{
+    if (!_enable || enabled() || ins.get_gyro_count() == 0) {
+        return;
+    }
+
+    const uint16_t window = _window_size;
+    if (window < 32 || window > 512 || (window & (window - 1)) != 0) {
+        hal.console->printf("FFT: invalid window size %u\n", (unsigned)window);
+        return;
+    }
+
+    const uint16_t raw_rate = ins.get_gyro_rate_hz(_gyro_instance);
+    _decimation = constrain_int16(raw_rate / FFT_TARGET_SAMPLE_RATE_HZ, 1, 255);
+    _sample_rate_hz = float(raw_rate) / _decimation;
+
+    if (!_fft.init(window)) {
+        hal.console->printf("FFT: failed to allocate\n");
+        return;
+    }
+    bool ok = true;
+    for (uint8_t i=0; i<3; i++) {
+        _frame[i] = new float[window];
+        ok = ok && _frame[i] != nullptr;
+    }
+    _power = new float[window/2];
+    // room for a second frame to arrive while the first is analysed
+    _samples = new SPSCObjectBuffer<Vector3f>(window * 2);
+    _sem = hal.util->new_semaphore();
+    if (!ok || _power == nullptr || _samples == nullptr || _sem == nullptr) {
+        hal.console->printf("FFT: failed to allocate\n");
+        free_buffers();
+        return;
+    }
+
+    _perf_update = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "gyro_fft");
+
+    hal.console->printf("FFT: %u samples at %.0fHz, %.1fHz bins\n",
+                        (unsigned)window, (double)_sample_rate_hz, (double)(_sample_rate_hz / window));
+
+    _initialised.store(true, std::memory_order_release);
+    hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&AP_GyroFFT::update, void));
+}
+
+/*
+  free everything init() allocated, after a failed allocation
+ */
+void AP_GyroFFT::free_buffers(void)
+{
+    for (uint8_t i=0; i<3; i++) {
+        delete[] _frame[i];
+        _frame[i] = nullptr;
+    }
+    delete[] _power;
+    _power = nullptr;
+    delete _samples;
+    _samples = nullptr;
+    delete _sem;
+    _sem = nullptr;
+    _fft.free_tables();
+}
+
+/*
+  average raw samples down to the analysis rate and queue them. A full
+  queue drops samples; the frame being filled then spans the gap,
+  which only smears that one frame
+ */
+void AP_GyroFFT::sample_gyro(uint8_t instance, const Vector3f &gyro)
+{
+    if (!enabled() || instance != _gyro_instance) {
+        return;
+    }
+    _decimation_sum += gyro;
+    if (++_decimation_count < _decimation) {
+        return;
+    }
+    _samples->push(_decimation_sum / _decimation);
+    _decimation_sum.zero();
+    _decimation_count = 0;
+}
+
+/*
+  collect a frame of samples, then transform one axis per call
+ */
+void AP_GyroFFT::update(void)
+{
+    if (!enabled()) {
+        return;
+    }
+
+    const uint16_t window = _fft.size();
+
+    if (_frame_count < window) {
+        Vector3f sample;
+        while (_frame_count < window && _samples->pop(sample)) {
+            _frame[0][_frame_count] = sample.x;
+            _frame[1][_frame_count] = sample.y;
+            _frame[2][_frame_count] = sample.z;
+            _frame_count++;
+        }
+        return;
+    }
+
+    hal.util->perf_begin(_perf_update);
+
+    if (_axis == 0) {
+        update_band();
+    }
+    _fft.power_spectrum(_frame[_axis], _power);
+    find_peak(_axis);
+
+    if (++_axis == 3) {
+        if (_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+            _peak_freq = _pending_freq;
+            _peak_energy = _pending_energy;
+            _sem->give();
+        }
+        _axis = 0;
+        _frame_count = 0;
+    }
+
+    hal.util->perf_end(_perf_update);
+}
+
+/*
+  work out the bins searched from MINHZ and MAXHZ. Bin k is at
+  frequency k * rate / window; the ends are kept clear of DC and
+  Nyquist so a peak always has two neighbours
+ */
+void AP_GyroFFT::update_band(void)
+{
+    const uint16_t last_bin = _fft.size()/2 - 2;
+    const float bin_hz = _sample_rate_hz / _fft.size();
+    _min_bin = constrain_int16(ceilf(_min_hz / bin_hz), 1, last_bin - 1);
+    _max_bin = constrain_int16(_max_hz / bin_hz, _min_bin + 1, last_bin);
+}
+
+/*
+  find the largest bin in the band and refine its frequency by fitting
+  a parabola through it and its neighbours. The energy is the mean
+  square of the peak's amplitude in (rad/s)^2
+ */
+void AP_GyroFFT::find_peak(uint8_t axis)
+{
+    uint16_t peak = _min_bin;
+    for (uint16_t k=_min_bin+1; k<=_max_bin; k++) {
+        if (_power[k] > _power[peak]) {
+            peak = k;
+        }
+    }
+
+    const float a = sqrtf(_power[peak-1]);
+    const float b = sqrtf(_power[peak]);
+    const float c = sqrtf(_power[peak+1]);
+    const float denom = a - 2*b + c;
+    float delta = 0;
+    if (!is_zero(denom)) {
+        delta = constrain_float(0.5f * (a - c) / denom, -0.5f, 0.5f);
+    }
+
+    const float amplitude = 2 * b / _fft.window_sum();
+    _pending_freq[axis] = (peak + delta) * _sample_rate_hz / _fft.size();
+    _pending_energy[axis] = 0.5f * amplitude * amplitude;
+}
+
+/*
+  copy the peaks of the last complete frame and their weighted mean,
+  all under one lock so they come from the same frame
+ */
+bool AP_GyroFFT::get_peaks(struct peaks &peaks) const
+{
+    if (!enabled() || !_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return false;
+    }
+    peaks.freq_hz = _peak_freq;
+    peaks.energy = _peak_energy;
+    _sem->give();
+
+    const float total = peaks.energy.x + peaks.energy.y + peaks.energy.z;
+    peaks.center_freq_hz = 0;
+    if (total > 0) {
+        peaks.center_freq_hz = (peaks.freq_hz.x * peaks.energy.x +
+                                peaks.freq_hz.y * peaks.energy.y +
+                                peaks.freq_hz.z * peaks.energy.z) / total;
+    }
+    return true;
+}
+
+/*
+  log the peak frequency and energy on each axis, and the energy
+  weighted mean of the peak frequencies
+ */
+void AP_GyroFFT::write_log(void) const
+{
+    struct peaks peaks;
+    if (!get_peaks(peaks)) {
+        return;
+    }
+    DataFlash_Class::instance()->Log_Write("FTN1", "TimeUS,PkX,PkY,PkZ,EnX,EnY,EnZ,Ctr", "Qfffffff",
+                                           AP_HAL::micros64(),
+                                           (double)peaks.freq_hz.x, (double)peaks.freq_hz.y, (double)peaks.freq_hz.z,
+                                           (double)peaks.energy.x, (double)peaks.energy.y, (double)peaks.energy.z,
+                                           (double)peaks.center_freq_hz);
+}
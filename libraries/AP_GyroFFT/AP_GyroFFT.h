@@ -0,0 +1,120 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  in-flight spectral analysis of gyro noise. Raw samples of the first
+  gyro are decimated by the IMU backend and queued. The IO thread
+  runs one FFT per call, a single axis at a time, so the CPU cost of
+  a call is bounded by one transform of the window size
+ */
+
+#include <atomic>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+#include "RealFFT.h"
+
+// samples from faster gyros are averaged down to about this rate
+#define FFT_TARGET_SAMPLE_RATE_HZ 1000
+
+class AP_InertialSensor;
+
+class AP_GyroFFT {
+public:
+    AP_GyroFFT();
+
+    static AP_GyroFFT *get_instance() { return _s_instance; }
+
+    // allocate buffers and start analysis. Must be called after the
+    // INS has been initialised
+    void init(const AP_InertialSensor &ins);
+
+    // called by the IMU backend for every raw gyro sample
+    void sample_gyro(uint8_t instance, const Vector3f &gyro);
+
+    // called from the IO thread
+    void update(void);
+
+    // write an FTN1 log message
+    void write_log(void) const;
+
+    // results of the last complete frame
+    struct peaks {
+        Vector3f freq_hz;       // dominant peak frequency on each axis
+        Vector3f energy;        // and its energy
+        float center_freq_hz;   // mean of the peak frequencies weighted by their energy
+    };
+
+    // copy the results of one frame, false if analysis isn't running
+    bool get_peaks(struct peaks &peaks) const;
+
+    bool enabled(void) const { return _initialised.load(std::memory_order_acquire); }
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+private:
+    // free the buffers allocated by init()
+    void free_buffers(void);
+
+    // set the range of bins searched for peaks
+    void update_band(void);
+
+    // find the largest peak in the configured band of _power
+    void find_peak(uint8_t axis);
+
+    AP_Int8 _enable;
+    AP_Int16 _min_hz;
+    AP_Int16 _max_hz;
+    AP_Int16 _window_size;
+
+    // set once init() has allocated everything. The release store
+    // publishes the buffers to the backend and IO threads
+    std::atomic<bool> _initialised;
+
+    // gyro instance analysed. Only one backend thread pushes samples
+    uint8_t _gyro_instance;
+
+    // decimation state, only used by the backend thread
+    uint8_t _decimation;
+    uint8_t _decimation_count;
+    Vector3f _decimation_sum;
+
+    SPSCObjectBuffer<Vector3f> *_samples;
+
+    // the frame being analysed, one array per axis
+    float *_frame[3];
+    float *_power;
+    uint16_t _frame_count;
+    uint8_t _axis;
+
+    RealFFT _fft;
+    float _sample_rate_hz;
+    uint16_t _min_bin;
+    uint16_t _max_bin;
+
+    // results of the frame being analysed and of the last complete frame
+    Vector3f _pending_freq;
+    Vector3f _pending_energy;
+    Vector3f _peak_freq;
+    Vector3f _peak_energy;
+    AP_HAL::Semaphore *_sem;
+
+    AP_HAL::Util::perf_counter_t _perf_update;
+
+    static AP_GyroFFT *_s_instance;
+};
@@ -0,0 +1,167 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "RealFFT.h"
+
+#include <AP_Math/AP_Math.h>
+
+RealFFT::RealFFT() :
+    _size(0),
+    _window(nullptr),
+    _cos(nullptr),
+    _sin(nullptr),
+    _bitrev(nullptr),
+    _re(nullptr),
+    _im(nullptr),
+    _window_sum(0)
+{
+}
+
+RealFFT::~RealFFT()
+{
+    free_tables();
+}
+
+void RealFFT::free_tables(void)
+{
+    delete[] _window;
+    delete[] _cos;
+    delete[] _sin;
+    delete[] _bitrev;
+    delete[] _re;
+    delete[] _im;
+    _window = nullptr;
+    _cos = nullptr;
+    _sin = nullptr;
+    _bitrev = nullptr;
+    _re = nullptr;
+    _im = nullptr;
+    _size = 0;
+    _window_sum = 0;
+}
+
+bool RealFFT::init(uint16_t size)
+{
+    if (size < 4 || (size & (size - 1)) != 0 || _size != 0) {
+        return false;
+    }
+    const uint16_t half = size / 2;
+
+    _window = new float[size];
+    _cos = new float[half];
+    _sin = new float[half];
+    _bitrev = new uint16_t[half];
+    _re = new float[half];
+    _im = new float[half];
+    if (_window == nullptr || _cos == nullptr || _sin == nullptr ||
+        _bitrev == nullptr || _re == nullptr || _im == nullptr) {
+        free_tables();
+        return false;
+    }
+
+    _window_sum = 0;
+    for (uint16_t i=0; i<size; i++) {
+        _window[i] = 0.5f - 0.5f * cosf(2 * M_PI * i / size);
+        _window_sum += _window[i];
+    }
+    for (uint16_t k=0; k<half; k++) {
+        _cos[k] = cosf(2 * M_PI * k / size);
+        _sin[k] = sinf(2 * M_PI * k / size);
+    }
+
+    uint8_t bits = 0;
+    while ((1U << bits) < half) {
+        bits++;
+    }
+    for (uint16_t i=0; i<half; i++) {
+        uint16_t r = 0;
+        for (uint8_t b=0; b<bits; b++) {
+            if (i & (1U << b)) {
+                r |= 1U << (bits - 1 - b);
+            }
+        }
+        _bitrev[i] = r;
+    }
+
+    _size = size;
+    return true;
+}
+
+/*
+  iterative radix-2 decimation in time FFT. The twiddle for a
+  butterfly span of len points is W_len^j = W_size^(j*size/len),
+  so one table serves every stage
+ */
+void RealFFT::complex_fft(void)
+{
+    const uint16_t n = _size / 2;
+
+    for (uint16_t i=0; i<n; i++) {
+        const uint16_t j = _bitrev[i];
+        if (j > i) {
+            float t = _re[i]; _re[i] = _re[j]; _re[j] = t;
+            t = _im[i]; _im[i] = _im[j]; _im[j] = t;
+        }
+    }
+
+    for (uint16_t len=2; len<=n; len <<= 1) {
+        const uint16_t half = len / 2;
+        const uint16_t stride = _size / len;
+        for (uint16_t i=0; i<n; i+=len) {
+            for (uint16_t j=0; j<half; j++) {
+                const float wr = _cos[j * stride];
+                const float wi = -_sin[j * stride];
+                const uint16_t a = i + j;
+                const uint16_t b = a + half;
+                const float tr = _re[b] * wr - _im[b] * wi;
+                const float ti = _re[b] * wi + _im[b] * wr;
+                _re[b] = _re[a] - tr;
+                _im[b] = _im[a] - ti;
+                _re[a] += tr;
+                _im[a] += ti;
+            }
+        }
+    }
+}
+
+void RealFFT::power_spectrum(const float *input, float *power)
+{
+    const uint16_t n = _size / 2;
+
+    // pack even samples as real and odd samples as imaginary parts
+    for (uint16_t i=0; i<n; i++) {
+        _re[i] = input[2*i] * _window[2*i];
+        _im[i] = input[2*i+1] * _window[2*i+1];
+    }
+
+    complex_fft();
+
+    // separate the spectra of the even and odd samples and combine
+    // them into the spectrum of the real input
+    for (uint16_t k=0; k<n; k++) {
+        const uint16_t nk = (k == 0) ? 0 : n - k;
+        // even part E = (Z[k] + conj(Z[n-k])) / 2
+        const float er = 0.5f * (_re[k] + _re[nk]);
+        const float ei = 0.5f * (_im[k] - _im[nk]);
+        // odd part O = (Z[k] - conj(Z[n-k])) / 2j
+        const float or_ = 0.5f * (_im[k] + _im[nk]);
+        const float oi = -0.5f * (_re[k] - _re[nk]);
+        // X[k] = E + W_size^k * O
+        const float wr = _cos[k];
+        const float wi = -_sin[k];
+        const float xr = er + wr * or_ - wi * oi;
+        const float xi = ei + wr * oi + wi * or_;
+        power[k] = xr * xr + xi * xi;
+    }
+}
@@ -0,0 +1,60 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  real FFT of a fixed power of two size, using a complex FFT of half
+  the size. Twiddle factors and the bit reversal table are computed
+  once in init(), so transform() does no trigonometry
+ */
+
+#include <stdint.h>
+
+class RealFFT {
+public:
+    RealFFT();
+    ~RealFFT();
+
+    // allocate tables for a transform of size real samples. Size
+    // must be a power of two, at least 4
+    bool init(uint16_t size);
+
+    // free the tables, after which init() can be called again
+    void free_tables(void);
+
+    uint16_t size(void) const { return _size; }
+
+    // apply a Hann window to size samples and transform them,
+    // putting the squared magnitude of bins 0 to size/2-1 in power.
+    // Bin k is at frequency k * sample_rate / size
+    void power_spectrum(const float *input, float *power);
+
+    // sum of the window, for turning bin magnitudes into amplitudes
+    float window_sum(void) const { return _window_sum; }
+
+private:
+    // in place complex FFT of _size/2 points in _re/_im
+    void complex_fft(void);
+
+    uint16_t _size;
+    float *_window;
+    // cos and sin of 2*pi*k/_size for k < _size/2
+    float *_cos;
+    float *_sin;
+    uint16_t *_bitrev;
+    float *_re;
+    float *_im;
+    float _window_sum;
+};
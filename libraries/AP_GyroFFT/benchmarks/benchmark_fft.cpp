@@ -0,0 +1,32 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_GyroFFT/RealFFT.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+  cost of one AP_GyroFFT update: the transform of one axis of a frame
+ */
+static void BM_RealFFTPowerSpectrum(benchmark::State& state)
+{
+    const uint16_t size = state.range_x();
+    RealFFT fft;
+    fft.init(size);
+
+    float *input = new float[size];
+    float *power = new float[size/2];
+    for (uint16_t i=0; i<size; i++) {
+        input[i] = sinf(2 * M_PI * 90 * i / 1000.0f) + 0.2f * sinf(2 * M_PI * 180 * i / 1000.0f);
+    }
+
+    while (state.KeepRunning()) {
+        fft.power_spectrum(input, power);
+        gbenchmark_escape(power);
+    }
+
+    delete[] input;
+    delete[] power;
+}
+
+BENCHMARK(BM_RealFFTPowerSpectrum)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(512);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,77 @@
+#include <AP_gtest.h>
+
+#include <AP_GyroFFT/RealFFT.h>
+#include <AP_Math/AP_Math.h>
+
+#define FFT_SIZE 128
+
+/*
+  compare against a direct DFT of the windowed input
+ */
+TEST(RealFFTTest, MatchesDFT)
+{
+    RealFFT fft;
+    ASSERT_TRUE(fft.init(FFT_SIZE));
+
+    float input[FFT_SIZE];
+    float power[FFT_SIZE/2];
+    for (uint16_t i=0; i<FFT_SIZE; i++) {
+        input[i] = sinf(i * 0.37f) + 0.5f * cosf(i * 1.9f) + 0.1f * (i % 7);
+    }
+    fft.power_spectrum(input, power);
+
+    for (uint16_t k=0; k<FFT_SIZE/2; k++) {
+        double re = 0, im = 0;
+        for (uint16_t n=0; n<FFT_SIZE; n++) {
+            const double w = 0.5 - 0.5 * cos(2 * M_PI * n / FFT_SIZE);
+            re += input[n] * w * cos(2 * M_PI * k * n / FFT_SIZE);
+            im -= input[n] * w * sin(2 * M_PI * k * n / FFT_SIZE);
+        }
+        const double expected = re * re + im * im;
+        EXPECT_NEAR(expected, power[k], 1.0e-4 * (1 + expected));
+    }
+}
+
+TEST(RealFFTTest, SineAmplitude)
+{
+    RealFFT fft;
+    ASSERT_TRUE(fft.init(FFT_SIZE));
+
+    // a sine exactly on bin 10 with amplitude 0.3
+    float input[FFT_SIZE];
+    float power[FFT_SIZE/2];
+    for (uint16_t i=0; i<FFT_SIZE; i++) {
+        input[i] = 0.3f * sinf(2 * M_PI * 10 * i / FFT_SIZE);
+    }
+    fft.power_spectrum(input, power);
+
+    uint16_t peak = 0;
+    for (uint16_t k=1; k<FFT_SIZE/2; k++) {
+        if (power[k] > power[peak]) {
+            peak = k;
+        }
+    }
+    EXPECT_EQ(10, peak);
+    EXPECT_NEAR(0.3f, 2 * sqrtf(power[peak]) / fft.window_sum(), 1.0e-3f);
+}
+
+TEST(RealFFTTest, RejectsBadSize)
+{
+    RealFFT fft;
+    EXPECT_FALSE(fft.init(100));
+    EXPECT_FALSE(fft.init(2));
+    EXPECT_TRUE(fft.init(64));
+    EXPECT_FALSE(fft.init(64));
+}
+
+TEST(RealFFTTest, InitAfterFree)
+{
+    RealFFT fft;
+    EXPECT_TRUE(fft.init(64));
+    fft.free_tables();
+    EXPECT_EQ(0U, fft.size());
+    EXPECT_TRUE(fft.init(FFT_SIZE));
+    EXPECT_EQ(FFT_SIZE, fft.size());
+}
+
+AP_GTEST_MAIN()
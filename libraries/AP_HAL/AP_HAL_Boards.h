@@ -177,6 +177,16 @@
 #define HAL_WITH_UAVCAN 0
 #endif
 
+// fast loop trace points, see HAL_TRACE() in Util.h. They are only
+// built in when there is a tracer to send them to
+#ifndef HAL_TRACE_ENABLED
+#ifdef HAVE_LTTNG_UST
+#define HAL_TRACE_ENABLED 1
+#else
+#define HAL_TRACE_ENABLED 0
+#endif
+#endif
+
 // this is used as a general mechanism to make a 'small' build by
 // dropping little used features. We use this to allow us to keep
 // FMUv2 going for as long as possible
@@ -96,6 +96,37 @@ public:
     virtual bool transfer(const uint8_t *send, uint32_t send_len,
                           uint8_t *recv, uint32_t recv_len) = 0;
 
+    /*
+     * One transaction of a batch: @send_len bytes from @send are sent,
+     * then @recv_len bytes are received into @recv, as with #transfer().
+     * Either side may be empty.
+     */
+    struct Transfer {
+        const uint8_t *send;
+        uint32_t send_len;
+        uint8_t *recv;
+        uint32_t recv_len;
+    };
+
+    /*
+     * Issue @count transactions back to back, ending each one (releasing
+     * chip select on SPI) before the next. Backends that can queue several
+     * transactions in the bus driver override this to do it with a single
+     * request; by default they are issued one at a time with #transfer().
+     *
+     * Return: true if all transactions succeeded, false on failure.
+     */
+    virtual bool transfer_batch(const Transfer *xfers, uint8_t count)
+    {
+        for (uint8_t i = 0; i < count; i++) {
+            if (!transfer(xfers[i].send, xfers[i].send_len,
+                          xfers[i].recv, xfers[i].recv_len)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     /**
      * Wrapper function over #transfer() to read recv_len registers, starting
      * by first_reg, into the array pointed by recv. The read flag passed to
@@ -66,6 +66,11 @@ uint64_t AP_HAL::Util::get_system_clock_ms() const
 #endif
 }
 
+uint64_t AP_HAL::Util::monotonic_micros64() const
+{
+    return AP_HAL::micros64();
+}
+
 void AP_HAL::Util::get_system_clock_utc(int32_t &hour, int32_t &min, int32_t &sec, int32_t &ms) const
 {
      // get time of day in ms
@@ -50,6 +50,13 @@ public:
      */
     uint64_t get_system_clock_ms() const;
 
+    /*
+      get a time in microseconds that keeps running while code
+      executes, for measuring how long code takes. This is
+      AP_HAL::micros64() except on boards where that is simulated time
+     */
+    virtual uint64_t monotonic_micros64() const;
+
     /*
       get system time in UTC hours, minutes, seconds and milliseconds
      */
@@ -108,6 +115,23 @@ public:
     virtual void perf_end(perf_counter_t h) {}
     virtual void perf_count(perf_counter_t h) {}
 
+    /*
+      trace points along the path from a gyro sample to the motors.
+      Each point is stamped with AP_HAL::micros64() so points emitted
+      from different threads share one time base. Emit them with
+      HAL_TRACE() so they compile out when tracing is disabled
+     */
+    enum trace_point {
+        TRACE_IMU_SAMPLE = 0,   /**< raw gyro sample received from a sensor */
+        TRACE_IMU_PUBLISH,      /**< filtered gyro published to the frontend */
+        TRACE_EKF_PREDICT,      /**< EKF core finished state and covariance prediction */
+        TRACE_EKF_FUSE,         /**< EKF core finished fusing measurements */
+        TRACE_ATT_CONTROL,      /**< attitude rate controller has run */
+        TRACE_MOTOR_OUTPUT,     /**< motor outputs written */
+        TRACE_LOG_ENQUEUE,      /**< log message queued for writing */
+    };
+    virtual void trace(trace_point point, uint8_t instance) {}
+
     // create a new semaphore
     virtual Semaphore *new_semaphore(void) { return nullptr; }
 
@@ -121,3 +145,13 @@ protected:
     bool soft_armed = false;
     uint64_t capabilities = 0;
 };
+
+/*
+  emit a fast loop trace point, e.g. HAL_TRACE(TRACE_MOTOR_OUTPUT, 0).
+  Without HAL_TRACE_ENABLED this is nothing at all, not even the call
+ */
+#if HAL_TRACE_ENABLED
+#define HAL_TRACE(point, instance) hal.util->trace(AP_HAL::Util::point, instance)
+#else
+#define HAL_TRACE(point, instance) do {} while (0)
+#endif
@@ -250,3 +250,139 @@ int16_t ByteBuffer::peek(uint32_t ofs) const
     }
     return buf[(head+ofs)%size];
 }
+
+SPSCByteBuffer::SPSCByteBuffer(uint32_t _size)
+{
+    uint32_t n = 1;
+    while (n < _size) {
+        n <<= 1;
+    }
+    buf = (uint8_t*)malloc(n);
+    size = buf ? n : 0;
+    mask = size ? size - 1 : 0;
+}
+
+SPSCByteBuffer::~SPSCByteBuffer(void)
+{
+    free(buf);
+}
+
+uint32_t SPSCByteBuffer::available(uint32_t wanted)
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    if (tail_cache - _head < wanted) {
+        tail_cache = tail.load(std::memory_order_acquire);
+    }
+    return tail_cache - _head;
+}
+
+uint32_t SPSCByteBuffer::space(uint32_t wanted)
+{
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    if (size - (_tail - head_cache) < wanted) {
+        head_cache = head.load(std::memory_order_acquire);
+    }
+    return size - (_tail - head_cache);
+}
+
+uint8_t SPSCByteBuffer::reserve(ByteBuffer::IoVec iovec[2], uint32_t len)
+{
+    uint32_t n = space(len);
+    if (len > n) {
+        len = n;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    const uint32_t ofs = tail.load(std::memory_order_relaxed) & mask;
+    iovec[0].data = &buf[ofs];
+
+    n = size - ofs;
+    if (len <= n) {
+        iovec[0].len = len;
+        return 1;
+    }
+
+    iovec[0].len = n;
+    iovec[1].data = buf;
+    iovec[1].len = len - n;
+
+    return 2;
+}
+
+bool SPSCByteBuffer::commit(uint32_t len)
+{
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    if (len > size - (_tail - head_cache)) {
+        return false;
+    }
+    tail.store(_tail + len, std::memory_order_release);
+    return true;
+}
+
+uint32_t SPSCByteBuffer::write(const uint8_t *data, uint32_t len)
+{
+    ByteBuffer::IoVec vec[2];
+    const auto n_vec = reserve(vec, len);
+    uint32_t ret = 0;
+
+    for (int i = 0; i < n_vec; i++) {
+        memcpy(vec[i].data, data + ret, vec[i].len);
+        ret += vec[i].len;
+    }
+
+    commit(ret);
+    return ret;
+}
+
+uint8_t SPSCByteBuffer::peekiovec(ByteBuffer::IoVec iovec[2], uint32_t len)
+{
+    uint32_t n = available(len);
+    if (len > n) {
+        len = n;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    const uint32_t ofs = head.load(std::memory_order_relaxed) & mask;
+    iovec[0].data = &buf[ofs];
+
+    n = size - ofs;
+    if (len <= n) {
+        iovec[0].len = len;
+        return 1;
+    }
+
+    iovec[0].len = n;
+    iovec[1].data = buf;
+    iovec[1].len = len - n;
+
+    return 2;
+}
+
+bool SPSCByteBuffer::advance(uint32_t n)
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    if (n > available(n)) {
+        return false;
+    }
+    head.store(_head + n, std::memory_order_release);
+    return true;
+}
+
+uint32_t SPSCByteBuffer::read(uint8_t *data, uint32_t len)
+{
+    ByteBuffer::IoVec vec[2];
+    const auto n_vec = peekiovec(vec, len);
+    uint32_t ret = 0;
+
+    for (int i = 0; i < n_vec; i++) {
+        memcpy(data + ret, vec[i].data, vec[i].len);
+        ret += vec[i].len;
+    }
+
+    advance(ret);
+    return ret;
+}
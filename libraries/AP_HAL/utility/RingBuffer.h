@@ -180,6 +180,127 @@ private:
 };
 
 
+/*
+  single-producer/single-consumer circular buffer of bytes.
+
+  Unlike ByteBuffer, only the writer thread may call space(), write(),
+  reserve() and commit() and only the reader thread may call
+  available(), read(), peekiovec() and advance(). In exchange the read
+  and write indexes live on separate cache lines, each side keeps a
+  cached copy of the other side's index and only reloads it when that
+  copy says the buffer is full/empty, so in steady state the two
+  threads don't touch each other's cache lines on every call.
+
+  The size is rounded up to a power of two.
+ */
+class SPSCByteBuffer {
+public:
+    SPSCByteBuffer(uint32_t size);
+    ~SPSCByteBuffer(void);
+
+    // number of bytes available to be read. Reader only. The writer's
+    // index is only reloaded if fewer than wanted bytes are known to
+    // be available
+    uint32_t available(uint32_t wanted = UINT32_MAX);
+
+    // number of bytes space available to write. Writer only. The
+    // reader's index is only reloaded if less than wanted bytes are
+    // known to be free
+    uint32_t space(uint32_t wanted = UINT32_MAX);
+
+    // write bytes to ringbuffer. Returns number of bytes written
+    uint32_t write(const uint8_t *data, uint32_t len);
+
+    // read bytes from ringbuffer. Returns number of bytes read
+    uint32_t read(uint8_t *data, uint32_t len);
+
+    // advance the read pointer (discarding bytes)
+    bool advance(uint32_t n);
+
+    // fill out vec with up to len bytes of readable data, see
+    // ByteBuffer::peekiovec()
+    uint8_t peekiovec(ByteBuffer::IoVec vec[2], uint32_t len);
+
+    // reserve up to len bytes for writing, see ByteBuffer::reserve()
+    uint8_t reserve(ByteBuffer::IoVec vec[2], uint32_t len);
+
+    // make len reserved bytes visible to the reader
+    bool commit(uint32_t len);
+
+    // return size of ringbuffer
+    uint32_t get_size(void) const { return size; }
+
+private:
+    static const uint8_t CACHE_LINE_SIZE = 64;
+
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t mask;
+
+    // head and tail are free running; the buffer offset is index & mask
+    uint8_t _pad0[CACHE_LINE_SIZE];
+    std::atomic<uint32_t> head{0}; // where to read data, written by reader
+    uint32_t tail_cache = 0;       // reader's copy of tail
+    uint8_t _pad1[CACHE_LINE_SIZE];
+    std::atomic<uint32_t> tail{0}; // where to write data, written by writer
+    uint32_t head_cache = 0;       // writer's copy of head
+    uint8_t _pad2[CACHE_LINE_SIZE];
+};
+
+/*
+  single-producer/single-consumer ring buffer of objects of fixed
+  size, with bulk push and pop. See SPSCByteBuffer for the threading
+  rules.
+ */
+template <class T>
+class SPSCObjectBuffer {
+public:
+    SPSCObjectBuffer(uint32_t _size) :
+        buffer(_size * sizeof(T))
+    {}
+
+    // return number of objects available to be read
+    uint32_t available(void) {
+        return buffer.available() / sizeof(T);
+    }
+
+    // return number of objects that could be written
+    uint32_t space(void) {
+        return buffer.space() / sizeof(T);
+    }
+
+    // push one object
+    bool push(const T &object) {
+        return push(&object, 1) == 1;
+    }
+
+    // push up to n objects, returning the number pushed
+    uint32_t push(const T *objects, uint32_t n) {
+        const uint32_t s = buffer.space(n * sizeof(T)) / sizeof(T);
+        if (n > s) {
+            n = s;
+        }
+        return buffer.write((const uint8_t *)objects, n * sizeof(T)) / sizeof(T);
+    }
+
+    // pop earliest object off the queue
+    bool pop(T &object) {
+        return pop(&object, 1) == 1;
+    }
+
+    // pop up to n objects, returning the number popped
+    uint32_t pop(T *objects, uint32_t n) {
+        const uint32_t a = buffer.available(n * sizeof(T)) / sizeof(T);
+        if (n > a) {
+            n = a;
+        }
+        return buffer.read((uint8_t *)objects, n * sizeof(T)) / sizeof(T);
+    }
+
+private:
+    SPSCByteBuffer buffer;
+};
+
 
 /*
   ring buffer class for objects of fixed size with pointer
@@ -0,0 +1,103 @@
+#include <AP_gtest.h>
+
+#include <thread>
+#include <AP_HAL/utility/RingBuffer.h>
+
+TEST(SPSCByteBufferTest, SizeRoundsUp)
+{
+    SPSCByteBuffer buf(100);
+
+    EXPECT_EQ(128U, buf.get_size());
+    EXPECT_EQ(0U, buf.available());
+    EXPECT_EQ(128U, buf.space());
+}
+
+TEST(SPSCByteBufferTest, WrapAround)
+{
+    SPSCByteBuffer buf(16);
+    uint8_t in[12], out[12];
+
+    for (uint8_t i = 0; i < sizeof(in); i++) {
+        in[i] = i;
+    }
+
+    // every other write wraps past the end of the storage
+    for (uint8_t n = 0; n < 10; n++) {
+        EXPECT_EQ(12U, buf.write(in, sizeof(in)));
+        EXPECT_EQ(12U, buf.available());
+        EXPECT_EQ(4U, buf.space());
+        EXPECT_EQ(4U, buf.write(in, sizeof(in)));
+        EXPECT_TRUE(buf.advance(4));
+        EXPECT_EQ(12U, buf.read(out, sizeof(out)));
+        EXPECT_EQ(0, memcmp(&in[4], out, 8));
+        EXPECT_EQ(0, memcmp(in, &out[8], 4));
+        EXPECT_EQ(0U, buf.available());
+    }
+    EXPECT_FALSE(buf.advance(1));
+}
+
+TEST(SPSCObjectBufferTest, BulkPushPop)
+{
+    struct obj {
+        uint32_t a;
+        uint8_t b;
+    };
+    SPSCObjectBuffer<obj> buf(10);
+    obj in[20], out[20];
+
+    for (uint8_t i = 0; i < 20; i++) {
+        in[i].a = i;
+        in[i].b = i * 2;
+    }
+
+    // storage is rounded up, so at least the requested count fits
+    const uint32_t pushed = buf.push(in, 20);
+    EXPECT_GE(pushed, 10U);
+    EXPECT_LT(pushed, 20U);
+    EXPECT_EQ(0U, buf.space());
+    EXPECT_EQ(pushed, buf.available());
+
+    EXPECT_EQ(3U, buf.pop(out, 3));
+    EXPECT_EQ(3U, buf.push(&in[pushed], 3));
+    EXPECT_EQ(pushed, buf.pop(&out[3], 20));
+
+    for (uint32_t i = 0; i < pushed + 3; i++) {
+        EXPECT_EQ(in[i].a, out[i].a);
+        EXPECT_EQ(in[i].b, out[i].b);
+    }
+    EXPECT_FALSE(buf.pop(out[0]));
+}
+
+TEST(SPSCObjectBufferTest, CrossThread)
+{
+    const uint32_t count = 100000;
+    SPSCObjectBuffer<uint32_t> buf(64);
+
+    std::thread producer([&buf, count]() {
+        for (uint32_t i = 0; i < count; ) {
+            if (buf.push(i)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    while (expected < count) {
+        uint32_t v[16];
+        const uint32_t n = buf.pop(v, 16);
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            ASSERT_EQ(expected, v[i]);
+            expected++;
+        }
+    }
+    producer.join();
+
+    EXPECT_EQ(0U, buf.available());
+}
+
+AP_GTEST_MAIN()
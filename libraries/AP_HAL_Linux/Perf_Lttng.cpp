@@ -40,6 +40,12 @@ void Perf_Lttng::count(const char *name, uint64_t val)
     tracepoint(ardupilot, count, name, val);
 }
 
+void Perf_Lttng::trace(uint8_t point, uint8_t instance)
+{
+    // the arguments are only evaluated when the event is enabled
+    tracepoint(ardupilot, stage, point, instance, AP_HAL::micros64());
+}
+
 #else
 
 #include "Perf_Lttng.h"
@@ -49,5 +55,6 @@ using namespace Linux;
 void Perf_Lttng::begin(const char *name) { }
 void Perf_Lttng::end(const char *name) { }
 void Perf_Lttng::count(const char *name, uint64_t val) { }
+void Perf_Lttng::trace(uint8_t point, uint8_t instance) { }
 
 #endif
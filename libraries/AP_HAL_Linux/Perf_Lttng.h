@@ -25,6 +25,8 @@ public:
     void begin(const char *name);
     void end(const char *name);
     void count(const char *name, uint64_t val);
+
+    static void trace(uint8_t point, uint8_t instance);
 };
 
 }
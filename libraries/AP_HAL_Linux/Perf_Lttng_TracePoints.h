@@ -59,6 +59,21 @@ TRACEPOINT_EVENT(
     )
 )
 
+TRACEPOINT_EVENT(
+    ardupilot,
+    stage,
+    TP_ARGS(
+        uint8_t, point_arg,
+        uint8_t, instance_arg,
+        uint64_t, time_us_arg
+    ),
+    TP_FIELDS(
+        ctf_integer(uint8_t, point, point_arg)
+        ctf_integer(uint8_t, instance, instance_arg)
+        ctf_integer(uint64_t, time_us, time_us_arg)
+    )
+)
+
 #endif
 
 #include <lttng/tracepoint-event.h>
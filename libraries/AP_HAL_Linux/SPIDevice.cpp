@@ -45,6 +45,13 @@ static const AP_HAL::HAL &hal = AP_HAL::get_HAL();
 #define KHZ (1000U)
 #define SPI_CS_KERNEL -1
 
+/*
+  limits of a single chained SPI_IOC_MESSAGE: spidev rejects ioctls
+  moving more than its bufsiz module parameter, which defaults to 4096
+ */
+#define LINUX_SPI_BATCH_MAX_MSGS  16
+#define LINUX_SPI_BATCH_MAX_BYTES 4096
+
 struct SPIDesc {
     SPIDesc(const char *name_, uint16_t bus_, uint16_t subdev_, uint8_t mode_,
             uint8_t bits_per_word_, int16_t cs_pin_, uint32_t lowspeed_,
@@ -244,41 +251,20 @@ bool SPIDevice::set_speed(AP_HAL::Device::Speed speed)
     return true;
 }
 
-bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
-                         uint8_t *recv, uint32_t recv_len)
+void SPIDevice::_fill_msg(struct spi_ioc_transfer &msg, const uint8_t *send,
+                          uint8_t *recv, uint32_t len)
 {
-    struct spi_ioc_transfer msgs[2] = { };
-    unsigned nmsgs = 0;
-
-    assert(_bus.fd >= 0);
-
-    if (send && send_len != 0) {
-        msgs[nmsgs].tx_buf = (uint64_t) send;
-        msgs[nmsgs].rx_buf = 0;
-        msgs[nmsgs].len = send_len;
-        msgs[nmsgs].speed_hz = _speed;
-        msgs[nmsgs].delay_usecs = 0;
-        msgs[nmsgs].bits_per_word = _desc.bits_per_word;
-        msgs[nmsgs].cs_change = 0;
-        nmsgs++;
-    }
-
-    if (recv && recv_len != 0) {
-        msgs[nmsgs].tx_buf = 0;
-        msgs[nmsgs].rx_buf = (uint64_t) recv;
-        msgs[nmsgs].len = recv_len;
-        msgs[nmsgs].speed_hz = _speed;
-        msgs[nmsgs].delay_usecs = 0;
-        msgs[nmsgs].bits_per_word = _desc.bits_per_word;
-        msgs[nmsgs].cs_change = 0;
-        nmsgs++;
-    }
-
-    if (!nmsgs) {
-        return false;
-    }
+    msg.tx_buf = (uint64_t) send;
+    msg.rx_buf = (uint64_t) recv;
+    msg.len = len;
+    msg.speed_hz = _speed;
+    msg.delay_usecs = 0;
+    msg.bits_per_word = _desc.bits_per_word;
+    msg.cs_change = 0;
+}
 
-    int r;
+bool SPIDevice::_set_mode()
+{
     if (_bus.last_mode == _desc.mode) {
         /*
           the mode in the kernel is not tied to the file descriptor,
@@ -286,7 +272,8 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
           we last used the bus. We want to report when this happens so
           the user has a chance of figuring out when there is
           conflicted use of the SPI bus. Unfortunately this costs us
-          an extra syscall per transfer.
+          an extra syscall per ioctl, which transfer_batch() amortises
+          over all transactions of a batch.
          */
         uint8_t current_mode;
         if (ioctl(_bus.fd, SPI_IOC_RD_MODE, &current_mode) < 0) {
@@ -300,7 +287,7 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
         }
     }
     if (_desc.mode != _bus.last_mode) {
-        r = ioctl(_bus.fd, SPI_IOC_WR_MODE, &_desc.mode);
+        int r = ioctl(_bus.fd, SPI_IOC_WR_MODE, &_desc.mode);
         if (r < 0) {
             hal.console->printf("SPIDevice: error on setting mode fd=%d (%s)\n",
                                 _bus.fd, strerror(errno));
@@ -308,9 +295,35 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
         }
         _bus.last_mode = _desc.mode;
     }
+    return true;
+}
+
+bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
+                         uint8_t *recv, uint32_t recv_len)
+{
+    struct spi_ioc_transfer msgs[2] = { };
+    unsigned nmsgs = 0;
+
+    assert(_bus.fd >= 0);
+
+    if (send && send_len != 0) {
+        _fill_msg(msgs[nmsgs++], send, nullptr, send_len);
+    }
+
+    if (recv && recv_len != 0) {
+        _fill_msg(msgs[nmsgs++], nullptr, recv, recv_len);
+    }
+
+    if (!nmsgs) {
+        return false;
+    }
+
+    if (!_set_mode()) {
+        return false;
+    }
 
     _cs_assert();
-    r = ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), &msgs);
+    int r = ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), &msgs);
     _cs_release();
 
     if (r == -1) {
@@ -333,23 +346,14 @@ bool SPIDevice::transfer_fullduplex(const uint8_t *send, uint8_t *recv,
         return false;
     }
 
-    msgs[0].tx_buf = (uint64_t) send;
-    msgs[0].rx_buf = (uint64_t) recv;
-    msgs[0].len = len;
-    msgs[0].speed_hz = _speed;
-    msgs[0].delay_usecs = 0;
-    msgs[0].bits_per_word = _desc.bits_per_word;
-    msgs[0].cs_change = 0;
+    _fill_msg(msgs[0], send, recv, len);
 
-    int r = ioctl(_bus.fd, SPI_IOC_WR_MODE, &_desc.mode);
-    if (r < 0) {
-        hal.console->printf("SPIDevice: error on setting mode fd=%d (%s)\n",
-                            _bus.fd, strerror(errno));
+    if (!_set_mode()) {
         return false;
     }
 
     _cs_assert();
-    r = ioctl(_bus.fd, SPI_IOC_MESSAGE(1), &msgs);
+    int r = ioctl(_bus.fd, SPI_IOC_MESSAGE(1), &msgs);
     _cs_release();
 
     if (r == -1) {
@@ -361,6 +365,87 @@ bool SPIDevice::transfer_fullduplex(const uint8_t *send, uint8_t *recv,
     return true;
 }
 
+/*
+  chain transactions into as few SPI_IOC_MESSAGE ioctls as spidev
+  allows. With kernel chip select, cs_change on the last message of a
+  transaction makes the controller release CS before the next one. A
+  userspace CS can't be toggled in the middle of an ioctl, so those
+  devices issue transactions one at a time.
+ */
+bool SPIDevice::transfer_batch(const Transfer *xfers, uint8_t count)
+{
+    if (_desc.cs_pin != SPI_CS_KERNEL) {
+        return AP_HAL::Device::transfer_batch(xfers, count);
+    }
+
+    assert(_bus.fd >= 0);
+
+    struct spi_ioc_transfer msgs[LINUX_SPI_BATCH_MAX_MSGS] = { };
+    unsigned nmsgs = 0;
+    uint32_t nbytes = 0;
+
+    if (!_set_mode()) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        const uint32_t send_len = xfers[i].send ? xfers[i].send_len : 0;
+        const uint32_t recv_len = xfers[i].recv ? xfers[i].recv_len : 0;
+        const uint32_t len = send_len + recv_len;
+        if (len == 0) {
+            continue;
+        }
+
+        // flush what we have when this transaction doesn't fit
+        if (nmsgs > 0 && (nmsgs + 2 > LINUX_SPI_BATCH_MAX_MSGS ||
+                          nbytes + len > LINUX_SPI_BATCH_MAX_BYTES)) {
+            if (!_transfer_chain(msgs, nmsgs)) {
+                return false;
+            }
+            nmsgs = 0;
+            nbytes = 0;
+        }
+
+        if (len > LINUX_SPI_BATCH_MAX_BYTES) {
+            // too large to chain, issue on its own
+            if (!transfer(xfers[i].send, send_len, xfers[i].recv, recv_len)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (send_len != 0) {
+            _fill_msg(msgs[nmsgs++], xfers[i].send, nullptr, send_len);
+        }
+        if (recv_len != 0) {
+            _fill_msg(msgs[nmsgs++], nullptr, xfers[i].recv, recv_len);
+        }
+        msgs[nmsgs - 1].cs_change = 1;
+        nbytes += len;
+    }
+
+    if (nmsgs > 0) {
+        return _transfer_chain(msgs, nmsgs);
+    }
+
+    return true;
+}
+
+bool SPIDevice::_transfer_chain(struct spi_ioc_transfer *msgs, unsigned nmsgs)
+{
+    // CS is released at the end of the ioctl anyway; cs_change on the
+    // last message would instead keep it asserted
+    msgs[nmsgs - 1].cs_change = 0;
+
+    if (ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), msgs) == -1) {
+        hal.console->printf("SPIDevice: error transferring data fd=%d (%s)\n",
+                            _bus.fd, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
 
 void SPIDevice::_cs_assert()
 {
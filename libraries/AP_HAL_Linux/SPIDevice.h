@@ -22,6 +22,8 @@
 #include <AP_HAL/HAL.h>
 #include <AP_HAL/SPIDevice.h>
 
+struct spi_ioc_transfer;
+
 namespace Linux {
 
 class SPIBus;
@@ -46,6 +48,9 @@ public:
     bool transfer_fullduplex(const uint8_t *send, uint8_t *recv,
                              uint32_t len) override;
 
+    /* See AP_HAL::Device::transfer_batch() */
+    bool transfer_batch(const Transfer *xfers, uint8_t count) override;
+
     /* See AP_HAL::Device::get_semaphore() */
     AP_HAL::Semaphore *get_semaphore() override;
 
@@ -63,6 +68,22 @@ protected:
     AP_HAL::DigitalSource *_cs;
     uint32_t _speed;
 
+    /*
+     * Make sure the bus is in this device's SPI mode before a transfer
+     */
+    bool _set_mode();
+
+    /*
+     * Fill @msg with a single kernel transfer at the current speed
+     */
+    void _fill_msg(struct spi_ioc_transfer &msg, const uint8_t *send,
+                   uint8_t *recv, uint32_t len);
+
+    /*
+     * Issue @nmsgs chained kernel transfers in a single ioctl
+     */
+    bool _transfer_chain(struct spi_ioc_transfer *msgs, unsigned nmsgs);
+
     /*
      * Select device if using userspace CS
      */
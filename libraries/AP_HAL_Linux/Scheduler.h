@@ -14,6 +14,11 @@
 #define AP_LINUX_SENSORS_SCHED_POLICY  SCHED_FIFO
 #define AP_LINUX_SENSORS_SCHED_PRIO 12
 
+// priority of threads running main loop tasks off the main thread,
+// just below the main thread itself
+#define AP_LINUX_TASKS_SCHED_POLICY  SCHED_FIFO
+#define AP_LINUX_TASKS_SCHED_PRIO 11
+
 namespace Linux {
 
 class Scheduler : public AP_HAL::Scheduler {
@@ -17,6 +17,7 @@
 #include "Thread.h"
 
 #include <alloca.h>
+#include <sched.h>
 #include <sys/types.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -180,6 +181,17 @@ bool Thread::start(const char *name, int policy, int prio)
 
     if (_stack_size) {
         if (pthread_attr_setstacksize(&attr, _stack_size) != 0) {
+            pthread_attr_destroy(&attr);
+            return false;
+        }
+    }
+
+    if (_cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(_cpu, &cpuset);
+        if (pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset) != 0) {
+            pthread_attr_destroy(&attr);
             return false;
         }
     }
@@ -244,6 +256,17 @@ bool Thread::set_stack_size(size_t stack_size)
     return true;
 }
 
+bool Thread::set_cpu_affinity(int cpu)
+{
+    if (_started || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+
+    _cpu = cpu;
+
+    return true;
+}
+
 bool PeriodicThread::_run()
 {
     if (_period_usec == 0) {
@@ -45,6 +45,12 @@ public:
 
     bool set_stack_size(size_t stack_size);
 
+    /*
+     * Pin the thread to a single CPU. Must be called before start(). A
+     * negative value lets the kernel place the thread anywhere.
+     */
+    bool set_cpu_affinity(int cpu);
+
     virtual bool stop() { return false; }
 
     bool join();
@@ -72,6 +78,7 @@ protected:
     } _stack_debug;
 
     size_t _stack_size = 0;
+    int _cpu = -1;
 };
 
 class PeriodicThread : public Thread {
@@ -93,6 +93,11 @@ public:
         return Perf::get_instance()->count(perf);
     }
 
+    void trace(trace_point point, uint8_t instance) override
+    {
+        Perf_Lttng::trace(point, instance);
+    }
+
     // create a new semaphore
     AP_HAL::Semaphore *new_semaphore(void) override { return new Semaphore; }
 
@@ -0,0 +1,113 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "WorkerThread.h"
+
+namespace Linux {
+
+WorkerThread::WorkerThread()
+    : Thread(nullptr)
+{
+    pthread_mutex_init(&_mutex, nullptr);
+    pthread_cond_init(&_cond, nullptr);
+}
+
+WorkerThread::~WorkerThread()
+{
+    pthread_cond_destroy(&_cond);
+    pthread_mutex_destroy(&_mutex);
+}
+
+bool WorkerThread::submit(task_t task)
+{
+    if (!_started || !task) {
+        return false;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    if (_busy) {
+        pthread_mutex_unlock(&_mutex);
+        return false;
+    }
+    _pending = task;
+    _busy = true;
+    pthread_cond_broadcast(&_cond);
+    pthread_mutex_unlock(&_mutex);
+
+    return true;
+}
+
+void WorkerThread::wait()
+{
+    pthread_mutex_lock(&_mutex);
+    while (_busy) {
+        pthread_cond_wait(&_cond, &_mutex);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+bool WorkerThread::busy()
+{
+    pthread_mutex_lock(&_mutex);
+    const bool ret = _busy;
+    pthread_mutex_unlock(&_mutex);
+    return ret;
+}
+
+bool WorkerThread::stop()
+{
+    if (!is_started()) {
+        return false;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    _should_exit = true;
+    pthread_cond_broadcast(&_cond);
+    pthread_mutex_unlock(&_mutex);
+
+    return true;
+}
+
+bool WorkerThread::_run()
+{
+    pthread_mutex_lock(&_mutex);
+
+    while (true) {
+        while (!_busy && !_should_exit) {
+            pthread_cond_wait(&_cond, &_mutex);
+        }
+        if (_should_exit) {
+            break;
+        }
+
+        task_t task = _pending;
+        pthread_mutex_unlock(&_mutex);
+
+        task();
+
+        pthread_mutex_lock(&_mutex);
+        _pending = nullptr;
+        _busy = false;
+        pthread_cond_broadcast(&_cond);
+    }
+
+    // release anybody still waiting on a task that will never run
+    _busy = false;
+    pthread_cond_broadcast(&_cond);
+    pthread_mutex_unlock(&_mutex);
+
+    return true;
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <pthread.h>
+
+#include "Thread.h"
+
+namespace Linux {
+
+/*
+ * Thread that sleeps until a task is submitted, runs it once and then
+ * goes back to sleep. The submitter is expected to call wait() before
+ * submitting the next task, which gives a simple fork/join contract: all
+ * memory written by the task is visible to the caller once wait() returns.
+ */
+class WorkerThread : public Thread {
+public:
+    WorkerThread();
+    ~WorkerThread();
+
+    /*
+     * Hand @task to the worker. Returns false if the thread is not running
+     * or if the previous task has not been collected with wait() yet.
+     */
+    bool submit(task_t task);
+
+    /* Block until the last submitted task has finished */
+    void wait();
+
+    /* Return true if a submitted task has not finished yet */
+    bool busy();
+
+    bool stop() override;
+
+protected:
+    bool _run() override;
+
+    pthread_mutex_t _mutex;
+    pthread_cond_t _cond;
+
+    task_t _pending = nullptr;
+    bool _busy = false;
+};
+
+}
@@ -0,0 +1,105 @@
+#include <AP_gbenchmark.h>
+
+#include <atomic>
+#include <string.h>
+#include <thread>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+/*
+  Throughput of ByteBuffer and SPSCByteBuffer with the reader running
+  on its own thread, as the UART, DataFlash and GPS drivers use them.
+  The argument is the number of bytes per write() call.
+ */
+
+#define BUFFER_SIZE 16384
+
+template <class B>
+static void bm_cross_thread(benchmark::State& state, B &buffer)
+{
+    const uint32_t chunk = state.range_x();
+    uint8_t data[256];
+    std::atomic<bool> done{false};
+    uint64_t written = 0;
+
+    memset(data, 0x55, sizeof(data));
+
+    std::thread reader([&buffer, &done]() {
+        uint8_t rbuf[512];
+        while (!done) {
+            if (buffer.read(rbuf, sizeof(rbuf)) == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    while (state.KeepRunning()) {
+        uint32_t n = 0;
+        while (n < chunk) {
+            const uint32_t w = buffer.write(&data[n], chunk - n);
+            if (w == 0) {
+                std::this_thread::yield();
+            }
+            n += w;
+        }
+        written += chunk;
+    }
+
+    done = true;
+    reader.join();
+
+    state.SetBytesProcessed(written);
+}
+
+static void BM_ByteBufferCrossThread(benchmark::State& state)
+{
+    ByteBuffer buffer(BUFFER_SIZE);
+    bm_cross_thread(state, buffer);
+}
+
+static void BM_SPSCByteBufferCrossThread(benchmark::State& state)
+{
+    SPSCByteBuffer buffer(BUFFER_SIZE);
+    bm_cross_thread(state, buffer);
+}
+
+BENCHMARK(BM_ByteBufferCrossThread)->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK(BM_SPSCByteBufferCrossThread)->Arg(1)->Arg(16)->Arg(256);
+
+struct bm_sample {
+    uint64_t timestamp_us;
+    float data[6];
+};
+
+static void BM_ObjectBufferPushPop(benchmark::State& state)
+{
+    ObjectBuffer<bm_sample> buffer(64);
+    bm_sample in[16] {}, out[16];
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < 16; i++) {
+            buffer.push(in[i]);
+        }
+        for (uint8_t i = 0; i < 16; i++) {
+            buffer.pop(out[i]);
+        }
+        gbenchmark_escape(out);
+    }
+}
+
+static void BM_SPSCObjectBufferBulkPushPop(benchmark::State& state)
+{
+    SPSCObjectBuffer<bm_sample> buffer(64);
+    bm_sample in[16] {}, out[16];
+
+    while (state.KeepRunning()) {
+        buffer.push(in, 16);
+        buffer.pop(out, 16);
+        gbenchmark_escape(out);
+    }
+}
+
+BENCHMARK(BM_ObjectBufferPushPop);
+BENCHMARK(BM_SPSCObjectBufferBulkPushPop);
+
+BENCHMARK_MAIN()
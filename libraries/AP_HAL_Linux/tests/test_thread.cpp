@@ -22,6 +22,7 @@
 #include <AP_HAL/AP_HAL.h>
 #include <AP_HAL_Linux/Thread.h>
 #include <AP_HAL_Linux/PollerThread.h>
+#include <AP_HAL_Linux/WorkerThread.h>
 
 using namespace Linux;
 
@@ -117,4 +118,39 @@ TEST(LinuxThread, periodic_thread)
     EXPECT_TRUE(thr.join());
 }
 
+class TestWorkerJob {
+public:
+    int n_runs = 0;
+
+    void run() {
+        n_runs++;
+    }
+};
+
+TEST(LinuxThread, worker_thread)
+{
+    WorkerThread thr;
+    TestWorkerJob job;
+
+    // nothing can be submitted before the thread is started
+    EXPECT_FALSE(thr.submit(FUNCTOR_BIND(&job, &TestWorkerJob::run, void)));
+
+    EXPECT_TRUE(thr.set_cpu_affinity(0));
+    EXPECT_TRUE(thr.start(nullptr, 0, 0));
+
+    // this must fail as the thread already started
+    EXPECT_FALSE(thr.set_cpu_affinity(0));
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(thr.submit(FUNCTOR_BIND(&job, &TestWorkerJob::run, void)));
+        thr.wait();
+        EXPECT_FALSE(thr.busy());
+    }
+
+    EXPECT_EQ(job.n_runs, 100);
+
+    EXPECT_TRUE(thr.stop());
+    EXPECT_TRUE(thr.join());
+}
+
 AP_GTEST_MAIN()
@@ -160,6 +160,7 @@ private:
     float _current;
 
     bool _synthetic_clock_mode;
+    bool _lockstep;
 
     bool _use_rtscts;
     bool _use_fg_view;
@@ -52,6 +52,8 @@ void SITL_State::_usage(void)
            "\t--instance|-I N          set instance of SITL (adds 10*instance to all port numbers)\n"
            // "\t--param|-P NAME=VALUE    set some param\n"  CURRENTLY BROKEN!
            "\t--synthetic-clock|-S     set synthetic clock mode\n"
+           "\t--lockstep               run as fast as possible, deterministically\n"
+           "\t--seed SEED              seed simulated sensor noise\n"
            "\t--home|-O HOME           set home location (lat,lng,alt,yaw)\n"
            "\t--model|-M MODEL         set simulation model\n"
            "\t--fdm|-F ADDRESS         set FDM address, defaults to 127.0.0.1\n"
@@ -132,6 +134,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     float speedup = 1.0f;
     _instance = 0;
     _synthetic_clock_mode = false;
+    _lockstep = false;
     // default to CMAC
     const char *home_str = "-35.363261,149.165230,584,353";
     const char *model_str = nullptr;
@@ -177,6 +180,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_SIM_PORT_IN,
         CMDLINE_SIM_PORT_OUT,
         CMDLINE_IRLOCK_PORT,
+        CMDLINE_LOCKSTEP,
+        CMDLINE_SEED,
     };
 
     const struct GetOptLong::option options[] = {
@@ -211,6 +216,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"sim-port-in",     true,   0, CMDLINE_SIM_PORT_IN},
         {"sim-port-out",    true,   0, CMDLINE_SIM_PORT_OUT},
         {"irlock-port",     true,   0, CMDLINE_IRLOCK_PORT},
+        {"lockstep",        false,  0, CMDLINE_LOCKSTEP},
+        {"seed",            true,   0, CMDLINE_SEED},
         {0, false, 0, 0}
     };
 
@@ -330,6 +337,17 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_IRLOCK_PORT:
             _irlock_port = atoi(gopt.optarg);
             break;
+        case CMDLINE_LOCKSTEP:
+            _lockstep = true;
+            break;
+        case CMDLINE_SEED: {
+            // simulated noise, glitches and ADSB traffic all come from
+            // rand()/random()
+            const unsigned seed = strtoul(gopt.optarg, nullptr, 0);
+            srand(seed);
+            srandom(seed);
+            break;
+        }
         default:
             _usage();
             exit(1);
@@ -346,10 +364,15 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
             sitl_model = model_constructors[i].constructor(home_str, model_str);
             sitl_model->set_interface_ports(_simulator_address, _simulator_port_in, _simulator_port_out);
             sitl_model->set_speedup(speedup);
+            sitl_model->set_lockstep(_lockstep);
             sitl_model->set_instance(_instance);
             sitl_model->set_autotest_dir(autotest_dir);
             _synthetic_clock_mode = true;
-            printf("Started model %s at %s at speed %.1f\n", model_str, home_str, speedup);
+            if (_lockstep) {
+                printf("Started model %s at %s in lockstep\n", model_str, home_str);
+            } else {
+                printf("Started model %s at %s at speed %.1f\n", model_str, home_str, speedup);
+            }
             break;
         }
     }
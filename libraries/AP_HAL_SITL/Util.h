@@ -4,6 +4,8 @@
 #include "AP_HAL_SITL_Namespace.h"
 #include "Semaphores.h"
 
+#include <time.h>
+
 class HALSITL::Util : public AP_HAL::Util {
 public:
     Util(SITL_State *_sitlState) :
@@ -28,6 +30,14 @@ public:
     const char* get_custom_defaults_file() const override {
         return sitlState->defaults_path;
     }
+
+    // AP_HAL::micros64() is simulated time, which stands still while
+    // code runs, so use the host's clock
+    uint64_t monotonic_micros64() const override {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000ULL;
+    }
 private:
     SITL_State *sitlState;
 };
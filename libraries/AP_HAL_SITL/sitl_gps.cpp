@@ -36,6 +36,11 @@ extern const AP_HAL::HAL& hal;
 static uint8_t next_gps_index;
 static uint8_t gps_delay;
 
+// in lockstep mode GPS time starts from a fixed epoch rather than
+// the wall clock so that repeated runs produce identical output
+static bool gps_fixed_epoch;
+static const time_t GPS_FIXED_EPOCH_SEC = 1483228800; // 2017-01-01 00:00:00 UTC
+
 // state of GPS emulation
 static struct gps_state {
     /* pipe emulating UBLOX GPS serial stream */
@@ -134,7 +139,12 @@ static void simulation_timeval(struct timeval *tv)
     static struct timeval first_tv;
     if (first_usec == 0) {
         first_usec = now;
-        gettimeofday(&first_tv, nullptr);
+        if (gps_fixed_epoch) {
+            first_tv.tv_sec = GPS_FIXED_EPOCH_SEC;
+            first_tv.tv_usec = 0;
+        } else {
+            gettimeofday(&first_tv, nullptr);
+        }
     }
     *tv = first_tv;
     tv->tv_sec += now / 1000000ULL;
@@ -1122,6 +1132,8 @@ void SITL_State::_update_gps(double latitude, double longitude, float altitude,
     struct gps_data d;
     char c;
 
+    gps_fixed_epoch = _lockstep;
+
     // simulate delayed lock times
     if (AP_HAL::millis() < _sitl->gps_lock_time*1000UL) {
         have_lock = false;
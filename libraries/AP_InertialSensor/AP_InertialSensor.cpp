@@ -423,6 +423,10 @@ const AP_Param::GroupInfo AP_InertialSensor::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("FAST_SAMPLE",  36, AP_InertialSensor, _fast_sampling_mask,   0),
 
+    // @Group: HNTCH_
+    // @Path: ../Filter/HarmonicNotchFilter.cpp
+    AP_SUBGROUPINFO(_harmonic_notch_filter, "HNTCH_",  37, AP_InertialSensor, HarmonicNotchFilterParams),
+
     /*
       NOTE: parameter indexes have gaps above. When adding new
       parameters check for conflicts carefully
@@ -619,6 +623,16 @@ AP_InertialSensor::init(uint16_t sample_rate)
     _sample_rate = sample_rate;
     _loop_delta_t = 1.0f / sample_rate;
 
+    // the notch filters are allocated before the backends start
+    // delivering samples. The centre frequency is moved later by the
+    // vehicle code
+    if (_harmonic_notch_filter.enabled()) {
+        for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+            _gyro_harmonic_notch_filter[i].allocate_filters(_harmonic_notch_filter.harmonics());
+        }
+    }
+    _calculated_harmonic_notch_freq_hz = _harmonic_notch_filter.center_freq_hz();
+
     if (_gyro_count == 0 && _accel_count == 0) {
         _start_backends();
     }
@@ -1467,6 +1481,7 @@ void AP_InertialSensor::set_gyro(uint8_t instance, const Vector3f &gyro)
     }
     if (instance < INS_MAX_INSTANCES) {
         _gyro[instance] = gyro;
+        _gyro_sample_us[instance] = hal.util->monotonic_micros64();
         _gyro_healthy[instance] = true;
         if (_gyro_count <= instance) {
             _gyro_count = instance+1;
@@ -1549,6 +1564,46 @@ void AP_InertialSensor::calc_vibration_and_clipping(uint8_t instance, const Vect
     }
 }
 
+// set the centre frequency of the harmonic notch, following motor speed
+void AP_InertialSensor::update_harmonic_notch_freq_hz(float scaled_freq)
+{
+    // never go below the configured base frequency, so the notch
+    // stays clear of the control bandwidth at low throttle
+    _calculated_harmonic_notch_freq_hz = MAX(scaled_freq, _harmonic_notch_filter.center_freq_hz());
+}
+
+// move the harmonic notch to follow motor speed
+void AP_InertialSensor::update_harmonic_notch(float throttle, float rpm)
+{
+    if (!_harmonic_notch_filter.enabled()) {
+        return;
+    }
+    const float base_freq = _harmonic_notch_filter.center_freq_hz();
+    const float ref = _harmonic_notch_filter.reference();
+    if (is_zero(ref)) {
+        update_harmonic_notch_freq_hz(base_freq);
+        return;
+    }
+
+    switch (_harmonic_notch_filter.tracking_mode()) {
+    case HarmonicNotchFilterParams::TRACKING_THROTTLE:
+        // motor speed goes roughly as the square root of throttle
+        update_harmonic_notch_freq_hz(base_freq * safe_sqrt(throttle / ref));
+        break;
+    case HarmonicNotchFilterParams::TRACKING_RPM:
+        if (rpm > 0) {
+            update_harmonic_notch_freq_hz(rpm * ref / 60.0f);
+        } else {
+            update_harmonic_notch_freq_hz(base_freq);
+        }
+        break;
+    case HarmonicNotchFilterParams::TRACKING_FIXED:
+    default:
+        update_harmonic_notch_freq_hz(base_freq);
+        break;
+    }
+}
+
 // peak hold detector for slower mechanisms to detect spikes
 void AP_InertialSensor::set_accel_peak_hold(uint8_t instance, const Vector3f &accel)
 {
@@ -23,6 +23,7 @@
 #include <AP_Math/AP_Math.h>
 #include <Filter/LowPassFilter2p.h>
 #include <Filter/LowPassFilter.h>
+#include <Filter/HarmonicNotchFilter.h>
 
 class AP_InertialSensor_Backend;
 class AuxiliaryBus;
@@ -88,6 +89,11 @@ public:
     const Vector3f     &get_gyro(uint8_t i) const { return _gyro[i]; }
     const Vector3f     &get_gyro(void) const { return get_gyro(_primary_gyro); }
 
+    // capture time in microseconds of the newest raw sample included in
+    // the current gyro value, on the clock of hal.util->monotonic_micros64()
+    uint64_t get_gyro_sample_us(uint8_t i) const { return _gyro_sample_us[i]; }
+    uint64_t get_gyro_sample_us(void) const { return get_gyro_sample_us(_primary_gyro); }
+
     // set gyro offsets in radians/sec
     const Vector3f &get_gyro_offsets(uint8_t i) const { return _gyro_offset[i]; }
     const Vector3f &get_gyro_offsets(void) const { return get_gyro_offsets(_primary_gyro); }
@@ -201,6 +207,24 @@ public:
     // get the accel filter rate in Hz
     uint8_t get_accel_filter_hz(void) const { return _accel_filter_cutoff; }
 
+    // harmonic notch settings, used by the vehicle to move the notch
+    bool gyro_harmonic_notch_enabled(void) const { return _harmonic_notch_filter.enabled(); }
+    float get_gyro_harmonic_notch_center_freq_hz(void) const { return _harmonic_notch_filter.center_freq_hz(); }
+    float get_gyro_harmonic_notch_reference(void) const { return _harmonic_notch_filter.reference(); }
+    HarmonicNotchFilterParams::Tracking_Mode get_gyro_harmonic_notch_tracking_mode(void) const {
+        return _harmonic_notch_filter.tracking_mode();
+    }
+
+    // current centre frequency of the harmonic notch in Hz
+    float get_gyro_dynamic_notch_center_freq_hz(void) const { return _calculated_harmonic_notch_freq_hz; }
+
+    // set the centre frequency of the harmonic notch
+    void update_harmonic_notch_freq_hz(float scaled_freq);
+
+    // move the harmonic notch to follow motor speed, given throttle
+    // (0 to 1) and RPM sensor reading (negative if not available)
+    void update_harmonic_notch(float throttle, float rpm);
+
     // indicate which bit in LOG_BITMASK indicates raw logging enabled
     void set_log_raw_bit(uint32_t log_raw_bit) { _log_raw_bit = log_raw_bit; }
 
@@ -307,13 +331,17 @@ private:
     // Low Pass filters for gyro and accel
     LowPassFilter2pVector3f _accel_filter[INS_MAX_INSTANCES];
     LowPassFilter2pVector3f _gyro_filter[INS_MAX_INSTANCES];
+    // notch filters on motor noise, applied to gyros before the low pass
+    HarmonicNotchFilterVector3f _gyro_harmonic_notch_filter[INS_MAX_INSTANCES];
     Vector3f _accel_filtered[INS_MAX_INSTANCES];
     Vector3f _gyro_filtered[INS_MAX_INSTANCES];
+    uint64_t _gyro_filtered_sample_us[INS_MAX_INSTANCES];
     bool _new_accel_data[INS_MAX_INSTANCES];
     bool _new_gyro_data[INS_MAX_INSTANCES];
 
     // Most recent gyro reading
     Vector3f _gyro[INS_MAX_INSTANCES];
+    uint64_t _gyro_sample_us[INS_MAX_INSTANCES];
     Vector3f _delta_angle[INS_MAX_INSTANCES];
     float _delta_angle_dt[INS_MAX_INSTANCES];
     bool _delta_angle_valid[INS_MAX_INSTANCES];
@@ -369,6 +397,10 @@ private:
     AP_Int8     _gyro_filter_cutoff;
     AP_Int8     _gyro_cal_timing;
 
+    // harmonic notch filter parameters and current centre frequency
+    HarmonicNotchFilterParams _harmonic_notch_filter;
+    float _calculated_harmonic_notch_freq_hz;
+
     // use for attitude, velocity, position estimates
     AP_Int8     _use[INS_MAX_INSTANCES];
 
@@ -3,6 +3,7 @@
 #include "AP_InertialSensor_Backend.h"
 #include <DataFlash/DataFlash.h>
 #include <AP_Module/AP_Module.h>
+#include <AP_GyroFFT/AP_GyroFFT.h>
 #include <stdio.h>
 
 #define SENSOR_RATE_DEBUG 0
@@ -123,12 +124,15 @@ void AP_InertialSensor_Backend::_rotate_and_correct_gyro(uint8_t instance, Vecto
 void AP_InertialSensor_Backend::_publish_gyro(uint8_t instance, const Vector3f &gyro)
 {
     _imu._gyro[instance] = gyro;
+    _imu._gyro_sample_us[instance] = _imu._gyro_filtered_sample_us[instance];
     _imu._gyro_healthy[instance] = true;
 
     // publish delta angle
     _imu._delta_angle[instance] = _imu._delta_angle_acc[instance];
     _imu._delta_angle_dt[instance] = _imu._delta_angle_acc_dt[instance];
     _imu._delta_angle_valid[instance] = true;
+
+    HAL_TRACE(TRACE_IMU_PUBLISH, instance);
 }
 
 void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
@@ -137,6 +141,8 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
 {
     float dt;
 
+    HAL_TRACE(TRACE_IMU_SAMPLE, instance);
+
     _update_sensor_rate(_imu._sample_gyro_count[instance], _imu._sample_gyro_start_us[instance],
                         _imu._gyro_raw_sample_rates[instance]);
 
@@ -163,6 +169,12 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     // call gyro_sample hook if any
     AP_Module::call_hook_gyro_sample(instance, dt, gyro);
 
+    // feed in-flight spectral analysis
+    AP_GyroFFT *fft = AP_GyroFFT::get_instance();
+    if (fft != nullptr) {
+        fft->sample_gyro(instance, gyro);
+    }
+
     // push gyros if optical flow present
     if (hal.opticalflow)
         hal.opticalflow->push_gyro(gyro.x, gyro.y, dt);
@@ -192,10 +204,16 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
         _imu._last_delta_angle[instance] = delta_angle;
         _imu._last_raw_gyro[instance] = gyro;
 
-        _imu._gyro_filtered[instance] = _imu._gyro_filter[instance].apply(gyro);
+        Vector3f gyro_filtered = gyro;
+        if (_gyro_harmonic_notch_enabled()) {
+            gyro_filtered = _imu._gyro_harmonic_notch_filter[instance].apply(gyro_filtered);
+        }
+        _imu._gyro_filtered[instance] = _imu._gyro_filter[instance].apply(gyro_filtered);
         if (_imu._gyro_filtered[instance].is_nan() || _imu._gyro_filtered[instance].is_inf()) {
             _imu._gyro_filter[instance].reset();
+            _imu._gyro_harmonic_notch_filter[instance].reset();
         }
+        _imu._gyro_filtered_sample_us[instance] = sample_us?sample_us:hal.util->monotonic_micros64();
         _imu._new_gyro_data[instance] = true;
         _sem->give();
     }
@@ -384,6 +402,15 @@ void AP_InertialSensor_Backend::update_gyro(uint8_t instance)
         _last_gyro_filter_hz[instance] = _gyro_filter_cutoff();
     }
 
+    // possibly move the harmonic notch. Coefficients are only
+    // recalculated when a setting has changed
+    if (_gyro_harmonic_notch_enabled()) {
+        _imu._gyro_harmonic_notch_filter[instance].init(_gyro_raw_sample_rate(instance),
+                                                       _gyro_harmonic_notch_center_freq_hz(),
+                                                       _imu._harmonic_notch_filter.bandwidth_hz(),
+                                                       _imu._harmonic_notch_filter.attenuation_dB());
+    }
+
     _sem->give();
 }
 
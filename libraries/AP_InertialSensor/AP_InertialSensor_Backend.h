@@ -171,6 +171,10 @@ protected:
     // return the default filter frequency in Hz for the sample rate
     uint8_t _gyro_filter_cutoff(void) const { return _imu._gyro_filter_cutoff; }
 
+    // harmonic notch filter settings
+    bool _gyro_harmonic_notch_enabled(void) const { return _imu._harmonic_notch_filter.enabled(); }
+    float _gyro_harmonic_notch_center_freq_hz(void) const { return _imu._calculated_harmonic_notch_freq_hz; }
+
     // return the requested sample rate in Hz
     uint16_t get_sample_rate_hz(void) const;
 
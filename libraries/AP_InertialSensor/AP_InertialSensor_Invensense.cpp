@@ -252,9 +252,13 @@ extern const AP_HAL::HAL& hal;
 #define MPU6000_REV_D8                          0x58    // 0101			1000
 #define MPU6000_REV_D9                          0x59    // 0101			1001
 
-#define MPU_SAMPLE_SIZE 14
+#define MPU_SAMPLE_SIZE INVENSENSE_FIFO_FRAME_SIZE
 #define MPU_FIFO_DOWNSAMPLE_COUNT 8
-#define MPU_FIFO_BUFFER_LEN 16
+/*
+  most samples read from the FIFO per poll, see _read_fifo(). The
+  buffer holds all of them so a poll is always one transfer
+ */
+#define MPU_FIFO_BUFFER_LEN 32
 
 #define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
 #define uint16_val(v, idx)(((uint16_t)v[2*idx] << 8) | v[2*idx+1])
@@ -288,6 +292,7 @@ AP_InertialSensor_Invensense::~AP_InertialSensor_Invensense()
     if (_fifo_buffer != nullptr) {
         hal.util->dma_free(_fifo_buffer, MPU_FIFO_BUFFER_LEN * MPU_SAMPLE_SIZE);
     }
+    delete[] _fifo_frames;
     delete _auxiliary_bus;
 }
 
@@ -495,6 +500,10 @@ void AP_InertialSensor_Invensense::start()
     if (_fifo_buffer == nullptr) {
         AP_HAL::panic("Invensense: Unable to allocate FIFO buffer");
     }
+    _fifo_frames = new InvensenseFIFOFrame[MPU_FIFO_BUFFER_LEN];
+    if (_fifo_frames == nullptr) {
+        AP_HAL::panic("Invensense: Unable to allocate FIFO buffer");
+    }
 
     // start the timer process to read samples
     _dev->register_periodic_callback(1000, FUNCTOR_BIND_MEMBER(&AP_InertialSensor_Invensense::_poll_data, void));
@@ -558,23 +567,23 @@ void AP_InertialSensor_Invensense::_poll_data()
     _read_fifo();
 }
 
-bool AP_InertialSensor_Invensense::_accumulate(uint8_t *samples, uint8_t n_samples)
+bool AP_InertialSensor_Invensense::_accumulate(const InvensenseFIFOFrame *frames, uint8_t n_samples)
 {
     for (uint8_t i = 0; i < n_samples; i++) {
-        const uint8_t *data = samples + MPU_SAMPLE_SIZE * i;
+        const InvensenseFIFOFrame &f = frames[i];
         Vector3f accel, gyro;
         bool fsync_set = false;
 
 #if INVENSENSE_EXT_SYNC_ENABLE
-        fsync_set = (int16_val(data, 2) & 1U) != 0;
+        fsync_set = (f.accel[2] & 1U) != 0;
 #endif
         
-        accel = Vector3f(int16_val(data, 1),
-                         int16_val(data, 0),
-                         -int16_val(data, 2));
+        accel = Vector3f(f.accel[1],
+                         f.accel[0],
+                         -f.accel[2]);
         accel *= _accel_scale;
 
-        int16_t t2 = int16_val(data, 3);
+        int16_t t2 = f.temp;
         if (!_check_raw_temp(t2)) {
             debug("temp reset %d %d", _raw_temp, t2);
             _fifo_reset();
@@ -582,9 +591,9 @@ bool AP_InertialSensor_Invensense::_accumulate(uint8_t *samples, uint8_t n_sampl
         }
         float temp = t2 * temp_sensitivity + temp_zero;
         
-        gyro = Vector3f(int16_val(data, 5),
-                        int16_val(data, 4),
-                        -int16_val(data, 6));
+        gyro = Vector3f(f.gyro[1],
+                        f.gyro[0],
+                        -f.gyro[2]);
         gyro *= GYRO_SCALE;
 
         _rotate_and_correct_accel(_accel_instance, accel);
@@ -606,7 +615,7 @@ bool AP_InertialSensor_Invensense::_accumulate(uint8_t *samples, uint8_t n_sampl
   gives very good aliasing rejection at frequencies well above what
   can be handled with 1kHz sample rates.
  */
-bool AP_InertialSensor_Invensense::_accumulate_fast_sampling(uint8_t *samples, uint8_t n_samples)
+bool AP_InertialSensor_Invensense::_accumulate_fast_sampling(const InvensenseFIFOFrame *frames, uint8_t n_samples)
 {
     int32_t tsum = 0;
     const int32_t clip_limit = AP_INERTIAL_SENSOR_ACCEL_CLIP_THRESH_MSS / _accel_scale;
@@ -614,10 +623,10 @@ bool AP_InertialSensor_Invensense::_accumulate_fast_sampling(uint8_t *samples, u
     bool ret = true;
     
     for (uint8_t i = 0; i < n_samples; i++) {
-        const uint8_t *data = samples + MPU_SAMPLE_SIZE * i;
+        const InvensenseFIFOFrame &f = frames[i];
 
         // use temperatue to detect FIFO corruption
-        int16_t t2 = int16_val(data, 3);
+        int16_t t2 = f.temp;
         if (!_check_raw_temp(t2)) {
             debug("temp reset %d %d", _raw_temp, t2);
             _fifo_reset();
@@ -628,9 +637,9 @@ bool AP_InertialSensor_Invensense::_accumulate_fast_sampling(uint8_t *samples, u
 
         if ((_accum.count & 1) == 0) {
             // accel data is at 4kHz
-            Vector3f a(int16_val(data, 1),
-                       int16_val(data, 0),
-                       -int16_val(data, 2));
+            Vector3f a(f.accel[1],
+                       f.accel[0],
+                       -f.accel[2]);
             if (fabsf(a.x) > clip_limit ||
                 fabsf(a.y) > clip_limit ||
                 fabsf(a.z) > clip_limit) {
@@ -639,9 +648,9 @@ bool AP_InertialSensor_Invensense::_accumulate_fast_sampling(uint8_t *samples, u
             _accum.accel += _accum.accel_filter.apply(a);
         }
 
-        Vector3f g(int16_val(data, 5),
-                   int16_val(data, 4),
-                   -int16_val(data, 6));
+        Vector3f g(f.gyro[1],
+                   f.gyro[0],
+                   -f.gyro[2]);
 
         _accum.gyro += _accum.gyro_filter.apply(g);
         _accum.count++;
@@ -730,13 +739,15 @@ void AP_InertialSensor_Invensense::_read_fifo()
             _dev->set_chip_select(false);
         }
 
+        invensense_fifo_decode(rx, _fifo_frames, n);
+
         if (_fast_sampling) {
-            if (!_accumulate_fast_sampling(rx, n)) {
+            if (!_accumulate_fast_sampling(_fifo_frames, n)) {
                 debug("stop at %u of %u", n_samples, bytes_read/MPU_SAMPLE_SIZE);
                 break;
             }
         } else {
-            if (!_accumulate(rx, n)) {
+            if (!_accumulate(_fifo_frames, n)) {
                 break;
             }
         }
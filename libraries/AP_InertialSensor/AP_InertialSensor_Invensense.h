@@ -21,6 +21,7 @@
 #include "AP_InertialSensor.h"
 #include "AP_InertialSensor_Backend.h"
 #include "AuxiliaryBus.h"
+#include "InvensenseFIFO.h"
 
 class AP_Invensense_AuxiliaryBus;
 class AP_Invensense_AuxiliaryBusSlave;
@@ -93,8 +94,8 @@ private:
     uint8_t _register_read(uint8_t reg);
     void _register_write(uint8_t reg, uint8_t val, bool checked=false);
 
-    bool _accumulate(uint8_t *samples, uint8_t n_samples);
-    bool _accumulate_fast_sampling(uint8_t *samples, uint8_t n_samples);
+    bool _accumulate(const InvensenseFIFOFrame *frames, uint8_t n_samples);
+    bool _accumulate_fast_sampling(const InvensenseFIFOFrame *frames, uint8_t n_samples);
 
     bool _check_raw_temp(int16_t t2);
 
@@ -131,6 +132,9 @@ private:
     // buffer for fifo read
     uint8_t *_fifo_buffer;
 
+    // fifo buffer decoded into host byte order
+    InvensenseFIFOFrame *_fifo_frames;
+
     /*
       accumulators for fast sampling
       See description in _accumulate_fast_sampling()
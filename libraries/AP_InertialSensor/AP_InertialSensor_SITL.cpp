@@ -130,7 +130,10 @@ void AP_InertialSensor_SITL::generate_gyro(uint8_t instance)
 
     _rotate_and_correct_gyro(gyro_instance[instance], gyro);
     
-    _notify_new_gyro_raw_sample(gyro_instance[instance], gyro, AP_HAL::micros64());
+    // samples are generated at exactly the registered rate, so no
+    // sample time is given. The frontend then stamps them on the host
+    // clock used for the latency measurement rather than simulated time
+    _notify_new_gyro_raw_sample(gyro_instance[instance], gyro);
 }
 
 void AP_InertialSensor_SITL::timer_update(void)
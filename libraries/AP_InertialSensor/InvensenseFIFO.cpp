@@ -0,0 +1,50 @@
+#include "InvensenseFIFO.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define INVENSENSE_FIFO_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define INVENSENSE_FIFO_SSE2 1
+#endif
+
+static_assert(sizeof(InvensenseFIFOFrame) == 16, "FIFO frame must be one 16 byte vector");
+
+void invensense_fifo_decode_scalar(const uint8_t *fifo, InvensenseFIFOFrame *frames, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        const uint8_t *d = fifo + i * INVENSENSE_FIFO_FRAME_SIZE;
+        int16_t *w = &frames[i].accel[0];
+        for (uint8_t j = 0; j < INVENSENSE_FIFO_FRAME_SIZE/2; j++) {
+            w[j] = (int16_t)(((uint16_t)d[2*j] << 8) | d[2*j+1]);
+        }
+        frames[i].pad = 0;
+    }
+}
+
+/*
+  the vector paths load 16 bytes per 14 byte frame, so the last frame
+  is left to the scalar code to avoid reading past the end of the
+  buffer. The two bytes of the next frame that get swapped along land
+  in the pad word
+ */
+void invensense_fifo_decode(const uint8_t *fifo, InvensenseFIFOFrame *frames, uint16_t n)
+{
+    if (n == 0) {
+        return;
+    }
+    uint16_t i = 0;
+#if defined(INVENSENSE_FIFO_NEON)
+    for (; i + 1 < n; i++) {
+        uint8x16_t v = vld1q_u8(fifo + i * INVENSENSE_FIFO_FRAME_SIZE);
+        vst1q_u8((uint8_t *)&frames[i], vrev16q_u8(v));
+    }
+#elif defined(INVENSENSE_FIFO_SSE2)
+    for (; i + 1 < n; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(fifo + i * INVENSENSE_FIFO_FRAME_SIZE));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *)&frames[i], v);
+    }
+#endif
+    invensense_fifo_decode_scalar(fifo + i * INVENSENSE_FIFO_FRAME_SIZE, &frames[i], n - i);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <inttypes.h>
+
+/*
+  decoding of raw Invensense FIFO data. With accel, temperature and
+  gyro enabled each FIFO frame is seven big-endian 16 bit words
+ */
+#define INVENSENSE_FIFO_FRAME_SIZE 14
+
+/*
+  one FIFO frame in host byte order, still in the sensor's own axis
+  order. Padded to 8 words so a frame can be stored with one 16 byte
+  vector write; the pad word holds no data
+ */
+struct InvensenseFIFOFrame {
+    int16_t accel[3];
+    int16_t temp;
+    int16_t gyro[3];
+    int16_t pad;
+};
+
+/*
+  byte swap @n frames from @fifo into @frames, using NEON or SSE2 when
+  the target has them
+ */
+void invensense_fifo_decode(const uint8_t *fifo, InvensenseFIFOFrame *frames, uint16_t n);
+
+/*
+  plain C version of invensense_fifo_decode(), used for the last frame
+  of a buffer and on targets without vector instructions
+ */
+void invensense_fifo_decode_scalar(const uint8_t *fifo, InvensenseFIFOFrame *frames, uint16_t n);
@@ -0,0 +1,114 @@
+#include <AP_gbenchmark.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <AP_InertialSensor/InvensenseFIFO.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+  cost of decoding Invensense FIFO reads. Set INVENSENSE_FIFO_DUMP to
+  a file of raw FIFO bytes recorded from a vehicle to run over real
+  data; otherwise a dump of 8kHz samples of a vibrating, slowly
+  rotating sensor is synthesised
+ */
+#define DUMP_FRAMES 4096
+
+static uint8_t dump[DUMP_FRAMES * INVENSENSE_FIFO_FRAME_SIZE];
+static uint16_t dump_frames;
+
+static void put_word(uint8_t *p, int16_t v)
+{
+    p[0] = uint16_t(v) >> 8;
+    p[1] = uint16_t(v) & 0xff;
+}
+
+static void load_dump()
+{
+    if (dump_frames != 0) {
+        return;
+    }
+    const char *path = getenv("INVENSENSE_FIFO_DUMP");
+    if (path != nullptr) {
+        FILE *f = fopen(path, "rb");
+        if (f != nullptr) {
+            dump_frames = fread(dump, INVENSENSE_FIFO_FRAME_SIZE, DUMP_FRAMES, f);
+            fclose(f);
+        }
+    }
+    if (dump_frames != 0) {
+        return;
+    }
+    for (uint16_t i = 0; i < DUMP_FRAMES; i++) {
+        const float t = i / 8000.0f;
+        uint8_t *p = dump + i * INVENSENSE_FIFO_FRAME_SIZE;
+        put_word(p + 0, 300 * sinf(2 * M_PI * 180 * t));
+        put_word(p + 2, 200 * cosf(2 * M_PI * 180 * t));
+        put_word(p + 4, 4096 + 500 * sinf(2 * M_PI * 90 * t));
+        put_word(p + 6, 2500);
+        put_word(p + 8, 1600 * sinf(2 * M_PI * 0.5f * t) + 40 * sinf(2 * M_PI * 180 * t));
+        put_word(p + 10, 800 * cosf(2 * M_PI * 0.3f * t));
+        put_word(p + 12, 100 * sinf(2 * M_PI * 35 * t));
+    }
+    dump_frames = DUMP_FRAMES;
+}
+
+template <void (*decode)(const uint8_t *, InvensenseFIFOFrame *, uint16_t)>
+static void BM_InvensenseFIFODecode(benchmark::State& state)
+{
+    load_dump();
+    const uint16_t n = state.range_x();
+    InvensenseFIFOFrame frames[32];
+    uint16_t ofs = 0;
+
+    while (state.KeepRunning()) {
+        if (ofs + n > dump_frames) {
+            ofs = 0;
+        }
+        decode(dump + ofs * INVENSENSE_FIFO_FRAME_SIZE, frames, n);
+        gbenchmark_escape(frames);
+        ofs += n;
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+/*
+  decode plus conversion to scaled float vectors, as done per sample by
+  the backend before filtering
+ */
+static void BM_InvensenseFIFOScale(benchmark::State& state)
+{
+    load_dump();
+    const uint16_t n = state.range_x();
+    const float accel_scale = GRAVITY_MSS / 4096;
+    const float gyro_scale = 0.0174532f / 16.4f;
+    InvensenseFIFOFrame frames[32];
+    uint16_t ofs = 0;
+
+    while (state.KeepRunning()) {
+        if (ofs + n > dump_frames) {
+            ofs = 0;
+        }
+        invensense_fifo_decode(dump + ofs * INVENSENSE_FIFO_FRAME_SIZE, frames, n);
+        for (uint16_t i = 0; i < n; i++) {
+            Vector3f a(frames[i].accel[1], frames[i].accel[0], -frames[i].accel[2]);
+            Vector3f g(frames[i].gyro[1], frames[i].gyro[0], -frames[i].gyro[2]);
+            a *= accel_scale;
+            g *= gyro_scale;
+            gbenchmark_escape(&a);
+            gbenchmark_escape(&g);
+        }
+        ofs += n;
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+/*
+  8 frames is one 1kHz poll at 8kHz fast sampling, 32 is the most
+  read in one poll
+ */
+BENCHMARK_TEMPLATE(BM_InvensenseFIFODecode, invensense_fifo_decode_scalar)->Arg(1)->Arg(8)->Arg(32);
+BENCHMARK_TEMPLATE(BM_InvensenseFIFODecode, invensense_fifo_decode)->Arg(1)->Arg(8)->Arg(32);
+BENCHMARK(BM_InvensenseFIFOScale)->Arg(8)->Arg(32);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,56 @@
+#include <AP_gtest.h>
+
+#include <stdlib.h>
+
+#include <AP_InertialSensor/InvensenseFIFO.h>
+
+#define MAX_FRAMES 32
+
+TEST(InvensenseFIFOTest, ByteOrder)
+{
+    const uint8_t fifo[INVENSENSE_FIFO_FRAME_SIZE] = {
+        0x01, 0x02, 0xff, 0xfe, 0x80, 0x00, 0x7f, 0xff,
+        0x00, 0x00, 0x12, 0x34, 0xed, 0xcc,
+    };
+    InvensenseFIFOFrame f;
+
+    invensense_fifo_decode(fifo, &f, 1);
+
+    EXPECT_EQ(0x0102, f.accel[0]);
+    EXPECT_EQ(-2, f.accel[1]);
+    EXPECT_EQ(-32768, f.accel[2]);
+    EXPECT_EQ(32767, f.temp);
+    EXPECT_EQ(0, f.gyro[0]);
+    EXPECT_EQ(0x1234, f.gyro[1]);
+    EXPECT_EQ(-0x1234, f.gyro[2]);
+}
+
+/*
+  the vector path must match the scalar one for every buffer length,
+  including the last frame which is always done in scalar
+ */
+TEST(InvensenseFIFOTest, MatchesScalar)
+{
+    uint8_t fifo[MAX_FRAMES * INVENSENSE_FIFO_FRAME_SIZE];
+    InvensenseFIFOFrame expected[MAX_FRAMES];
+    InvensenseFIFOFrame frames[MAX_FRAMES];
+
+    srandom(42);
+    for (uint16_t i = 0; i < sizeof(fifo); i++) {
+        fifo[i] = random() & 0xff;
+    }
+
+    for (uint16_t n = 1; n <= MAX_FRAMES; n++) {
+        invensense_fifo_decode_scalar(fifo, expected, n);
+        invensense_fifo_decode(fifo, frames, n);
+        for (uint16_t i = 0; i < n; i++) {
+            for (uint8_t j = 0; j < 3; j++) {
+                EXPECT_EQ(expected[i].accel[j], frames[i].accel[j]);
+                EXPECT_EQ(expected[i].gyro[j], frames[i].gyro[j]);
+            }
+            EXPECT_EQ(expected[i].temp, frames[i].temp);
+        }
+    }
+}
+
+AP_GTEST_MAIN()
@@ -243,6 +243,10 @@ void AP_MotorsHeli::output()
     } else {
         output_disarmed();
     }
+
+    update_output_latency();
+
+    HAL_TRACE(TRACE_MOTOR_OUTPUT, 0);
 };
 
 // sends commands to the motors
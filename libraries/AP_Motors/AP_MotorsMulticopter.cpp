@@ -225,6 +225,10 @@ void AP_MotorsMulticopter::output()
 
     // output any booster throttle
     output_boost_throttle();
+
+    update_output_latency();
+
+    HAL_TRACE(TRACE_MOTOR_OUTPUT, 0);
 };
 
 // output booster throttle, if any
@@ -22,6 +22,7 @@
 #include "AP_Motors_Class.h"
 #include <AP_HAL/AP_HAL.h>
 #include <SRV_Channel/SRV_Channel.h>
+#include <DataFlash/DataFlash.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -40,7 +41,8 @@ AP_Motors::AP_Motors(uint16_t loop_rate, uint16_t speed_hz) :
     _batt_current(0.0f),
     _air_density_ratio(1.0f),
     _motor_map_mask(0),
-    _motor_fast_mask(0)
+    _motor_fast_mask(0),
+    _gyro_sample_us(0)
 {
     // init other flags
     _flags.armed = false;
@@ -56,6 +58,8 @@ AP_Motors::AP_Motors(uint16_t loop_rate, uint16_t speed_hz) :
     limit.yaw = true;
     limit.throttle_lower = true;
     limit.throttle_upper = true;
+
+    reset_latency_stats();
 };
 
 void AP_Motors::armed(bool arm)
@@ -211,3 +215,71 @@ void AP_Motors::add_motor_num(int8_t motor_num)
         }
     }
 }
+
+/*
+  record how old the gyro sample used by the attitude controller was
+  when the motor outputs calculated from it were written
+ */
+void AP_Motors::update_output_latency()
+{
+    if (_gyro_sample_us == 0) {
+        return;
+    }
+    uint64_t now = hal.util->monotonic_micros64();
+    if (now < _gyro_sample_us) {
+        return;
+    }
+    uint32_t latency_us = MIN(now - _gyro_sample_us, (uint64_t)UINT32_MAX);
+    uint8_t bucket = MIN(latency_us / AP_MOTORS_LATENCY_BUCKET_US, AP_MOTORS_LATENCY_BUCKETS-1);
+    _latency.histogram[bucket]++;
+    _latency.count++;
+    _latency.total_us += latency_us;
+    _latency.min_us = MIN(_latency.min_us, latency_us);
+    _latency.max_us = MAX(_latency.max_us, latency_us);
+}
+
+/*
+  return a latency percentile, interpolated within the histogram bucket
+  it falls in. The last bucket is open ended so is clamped to the max
+ */
+uint32_t AP_Motors::get_latency_percentile(float pct) const
+{
+    if (_latency.count == 0) {
+        return 0;
+    }
+    const float target = constrain_float(pct, 0, 100) * 0.01f * _latency.count;
+    uint32_t seen = 0;
+    for (uint8_t i=0; i<AP_MOTORS_LATENCY_BUCKETS; i++) {
+        const uint32_t n = _latency.histogram[i];
+        if (n > 0 && seen + n >= target) {
+            const float frac = (target - seen) / n;
+            const uint32_t ret = (i + frac) * AP_MOTORS_LATENCY_BUCKET_US;
+            return constrain_int32(ret, _latency.min_us, _latency.max_us);
+        }
+        seen += n;
+    }
+    return _latency.max_us;
+}
+
+void AP_Motors::write_latency_log() const
+{
+    if (_latency.count == 0) {
+        return;
+    }
+    DATAFLASH_LOG_MESSAGE(mlat_msg, "MLAT", "TimeUS,N,Min,Mean,P50,P90,P99,Max", "QIIIIIII",
+                          uint64_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+    mlat_msg.write(AP_HAL::micros64(),
+                   _latency.count,
+                   _latency.min_us,
+                   _latency.total_us / _latency.count,
+                   get_latency_percentile(50),
+                   get_latency_percentile(90),
+                   get_latency_percentile(99),
+                   _latency.max_us);
+}
+
+void AP_Motors::reset_latency_stats()
+{
+    memset(&_latency, 0, sizeof(_latency));
+    _latency.min_us = UINT32_MAX;
+}
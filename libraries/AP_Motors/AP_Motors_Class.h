@@ -25,6 +25,10 @@
 // motor update rate
 #define AP_MOTORS_SPEED_DEFAULT     490 // default output rate to the motors
 
+// gyro sample to motor output latency histogram
+#define AP_MOTORS_LATENCY_BUCKETS       64  // number of histogram buckets
+#define AP_MOTORS_LATENCY_BUCKET_US     50  // width of each bucket in microseconds
+
 /// @class      AP_Motors
 class AP_Motors {
 public:
@@ -166,7 +170,19 @@ public:
 
     enum pwm_type { PWM_TYPE_NORMAL=0, PWM_TYPE_ONESHOT=1, PWM_TYPE_ONESHOT125=2, PWM_TYPE_BRUSHED=3 };
     pwm_type            get_pwm_type(void) const { return (pwm_type)_pwm_type.get(); }
-    
+
+    // set capture time of the gyro sample the current roll, pitch and yaw inputs were calculated from
+    void                set_gyro_sample_us(uint64_t sample_us) { _gyro_sample_us = sample_us; }
+
+    // return a percentile (0 to 100) of gyro sample to motor output latency in microseconds
+    uint32_t            get_latency_percentile(float pct) const;
+
+    // write a MLAT message with the latency distribution since the last reset
+    void                write_latency_log() const;
+
+    // clear latency statistics
+    void                reset_latency_stats();
+
 protected:
     // output functions that should be overloaded by child classes
     virtual void        output_armed_stabilizing()=0;
@@ -229,4 +245,18 @@ protected:
     float _yaw_radio_passthrough = 0.0f;      // yaw input from pilot in -1 ~ +1 range.  used for setup and providing servo feedback while landed
 
     AP_Int8             _pwm_type;            // PWM output type
+
+    // record the age of the gyro sample behind the outputs just written, called by output()
+    void                update_output_latency();
+
+    uint64_t            _gyro_sample_us;            // capture time of the gyro sample behind the current inputs
+
+    // gyro sample to motor output latency statistics
+    struct {
+        uint32_t count;
+        uint32_t min_us;
+        uint32_t max_us;
+        uint64_t total_us;
+        uint32_t histogram[AP_MOTORS_LATENCY_BUCKETS];
+    } _latency;
 };
@@ -31,6 +31,10 @@
 #include <AP_Compass/AP_Compass.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <AP_HAL_Linux/WorkerThread.h>
+#endif
+
 class NavEKF2_core;
 class AP_AHRS;
 
@@ -376,6 +380,9 @@ private:
     AP_Float _useRngSwSpd;          // Maximum horizontal ground speed to use range finder as the primary height source (m/s)
     AP_Int8 _magMask;               // Bitmask forcng specific EKF core instances to use simple heading magnetometer fusion.
     AP_Int8 _originHgtMode;         // Bitmask controlling post alignment correction and reporting of the EKF origin height.
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    AP_Int8 _coreThreads;           // Run the update of each core on its own worker thread
+#endif
 
     // Tuning parameters
     const float gpsNEVelVarAccScale;    // Scale factor applied to NE velocity measurement variance due to manoeuvre acceleration
@@ -453,4 +460,27 @@ private:
     // new_primary - index of the ekf instance that we are about to switch to as the primary
     // old_primary - index of the ekf instance that we are currently using as the primary
     void updateLaneSwitchPosDownResetData(uint8_t new_primary, uint8_t old_primary);
+
+    // return true if the state prediction step of a core should run on
+    // this frame, given the time used so far since the IMU update
+    bool coreStatePredictEnabled(uint8_t coreIndex, uint32_t loopTime_us) const;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // a core update handed to a worker thread
+    struct core_job {
+        NavEKF2_core *core;
+        bool statePredictEnabled;
+        void run();
+    };
+
+    // per core jobs and worker threads. Core 0 always runs on the calling thread
+    core_job *coreJobs = nullptr;
+    Linux::WorkerThread *coreWorkers = nullptr;
+
+    // start the worker threads used to update the cores in parallel
+    void startCoreWorkers(void);
+
+    // update all cores in parallel, returning once every core has finished
+    void UpdateCoresParallel(const bool *statePredictEnabled);
+#endif
 };
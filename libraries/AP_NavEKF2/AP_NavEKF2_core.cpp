@@ -6,6 +6,7 @@
 #include "AP_NavEKF2_core.h"
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_Vehicle/AP_Vehicle.h>
+#include <GCS_MAVLink/GCS.h>
 
 #include <stdio.h>
 
@@ -492,6 +493,7 @@ void NavEKF2_core::UpdateFilter(bool predict)
 
         // Predict the covariance growth
         CovariancePrediction();
+        HAL_TRACE(TRACE_EKF_PREDICT, core_index);
 
         // Update states using  magnetometer data
         SelectMagFusion();
@@ -510,6 +512,7 @@ void NavEKF2_core::UpdateFilter(bool predict)
 
         // Update states using sideslip constraint assumption for fly-forward vehicles
         SelectBetaFusion();
+        HAL_TRACE(TRACE_EKF_FUSE, core_index);
 
         // Update the filter status
         updateFilterStatus();
@@ -1056,123 +1059,133 @@ void NavEKF2_core::CovariancePrediction()
     nextP[15][15] = P[15][15];
 
     if (stateIndexLim > 15) {
-        nextP[0][16] = P[0][16]*SPP[5] - P[1][16]*SPP[4] + P[2][16]*SPP[8] + P[9][16]*SPP[22] + P[12][16]*SPP[18];
-        nextP[1][16] = P[1][16]*SPP[6] - P[0][16]*SPP[2] - P[2][16]*SPP[9] + P[10][16]*SPP[22] + P[13][16]*SPP[17];
-        nextP[2][16] = P[0][16]*SPP[14] - P[1][16]*SPP[3] + P[2][16]*SPP[13] + P[11][16]*SPP[22] + P[14][16]*SPP[16];
-        nextP[3][16] = P[3][16] + P[0][16]*SPP[1] + P[1][16]*SPP[19] + P[2][16]*SPP[15] - P[15][16]*SPP[21];
-        nextP[4][16] = P[4][16] + P[15][16]*SF[22] + P[0][16]*SPP[20] + P[1][16]*SPP[12] + P[2][16]*SPP[11];
-        nextP[5][16] = P[5][16] + P[15][16]*SF[20] - P[0][16]*SPP[7] + P[1][16]*SPP[10] + P[2][16]*SPP[0];
-        nextP[6][16] = P[6][16] + P[3][16]*dt;
-        nextP[7][16] = P[7][16] + P[4][16]*dt;
-        nextP[8][16] = P[8][16] + P[5][16]*dt;
-        nextP[9][16] = P[9][16];
-        nextP[10][16] = P[10][16];
-        nextP[11][16] = P[11][16];
-        nextP[12][16] = P[12][16];
-        nextP[13][16] = P[13][16];
-        nextP[14][16] = P[14][16];
-        nextP[15][16] = P[15][16];
-        nextP[16][16] = P[16][16];
-        nextP[0][17] = P[0][17]*SPP[5] - P[1][17]*SPP[4] + P[2][17]*SPP[8] + P[9][17]*SPP[22] + P[12][17]*SPP[18];
-        nextP[1][17] = P[1][17]*SPP[6] - P[0][17]*SPP[2] - P[2][17]*SPP[9] + P[10][17]*SPP[22] + P[13][17]*SPP[17];
-        nextP[2][17] = P[0][17]*SPP[14] - P[1][17]*SPP[3] + P[2][17]*SPP[13] + P[11][17]*SPP[22] + P[14][17]*SPP[16];
-        nextP[3][17] = P[3][17] + P[0][17]*SPP[1] + P[1][17]*SPP[19] + P[2][17]*SPP[15] - P[15][17]*SPP[21];
-        nextP[4][17] = P[4][17] + P[15][17]*SF[22] + P[0][17]*SPP[20] + P[1][17]*SPP[12] + P[2][17]*SPP[11];
-        nextP[5][17] = P[5][17] + P[15][17]*SF[20] - P[0][17]*SPP[7] + P[1][17]*SPP[10] + P[2][17]*SPP[0];
-        nextP[6][17] = P[6][17] + P[3][17]*dt;
-        nextP[7][17] = P[7][17] + P[4][17]*dt;
-        nextP[8][17] = P[8][17] + P[5][17]*dt;
-        nextP[9][17] = P[9][17];
-        nextP[10][17] = P[10][17];
-        nextP[11][17] = P[11][17];
-        nextP[12][17] = P[12][17];
-        nextP[13][17] = P[13][17];
-        nextP[14][17] = P[14][17];
-        nextP[15][17] = P[15][17];
-        nextP[16][17] = P[16][17];
-        nextP[17][17] = P[17][17];
-        nextP[0][18] = P[0][18]*SPP[5] - P[1][18]*SPP[4] + P[2][18]*SPP[8] + P[9][18]*SPP[22] + P[12][18]*SPP[18];
-        nextP[1][18] = P[1][18]*SPP[6] - P[0][18]*SPP[2] - P[2][18]*SPP[9] + P[10][18]*SPP[22] + P[13][18]*SPP[17];
-        nextP[2][18] = P[0][18]*SPP[14] - P[1][18]*SPP[3] + P[2][18]*SPP[13] + P[11][18]*SPP[22] + P[14][18]*SPP[16];
-        nextP[3][18] = P[3][18] + P[0][18]*SPP[1] + P[1][18]*SPP[19] + P[2][18]*SPP[15] - P[15][18]*SPP[21];
-        nextP[4][18] = P[4][18] + P[15][18]*SF[22] + P[0][18]*SPP[20] + P[1][18]*SPP[12] + P[2][18]*SPP[11];
-        nextP[5][18] = P[5][18] + P[15][18]*SF[20] - P[0][18]*SPP[7] + P[1][18]*SPP[10] + P[2][18]*SPP[0];
-        nextP[6][18] = P[6][18] + P[3][18]*dt;
-        nextP[7][18] = P[7][18] + P[4][18]*dt;
-        nextP[8][18] = P[8][18] + P[5][18]*dt;
-        nextP[9][18] = P[9][18];
-        nextP[10][18] = P[10][18];
-        nextP[11][18] = P[11][18];
-        nextP[12][18] = P[12][18];
-        nextP[13][18] = P[13][18];
-        nextP[14][18] = P[14][18];
-        nextP[15][18] = P[15][18];
-        nextP[16][18] = P[16][18];
-        nextP[17][18] = P[17][18];
-        nextP[18][18] = P[18][18];
-        nextP[0][19] = P[0][19]*SPP[5] - P[1][19]*SPP[4] + P[2][19]*SPP[8] + P[9][19]*SPP[22] + P[12][19]*SPP[18];
-        nextP[1][19] = P[1][19]*SPP[6] - P[0][19]*SPP[2] - P[2][19]*SPP[9] + P[10][19]*SPP[22] + P[13][19]*SPP[17];
-        nextP[2][19] = P[0][19]*SPP[14] - P[1][19]*SPP[3] + P[2][19]*SPP[13] + P[11][19]*SPP[22] + P[14][19]*SPP[16];
-        nextP[3][19] = P[3][19] + P[0][19]*SPP[1] + P[1][19]*SPP[19] + P[2][19]*SPP[15] - P[15][19]*SPP[21];
-        nextP[4][19] = P[4][19] + P[15][19]*SF[22] + P[0][19]*SPP[20] + P[1][19]*SPP[12] + P[2][19]*SPP[11];
-        nextP[5][19] = P[5][19] + P[15][19]*SF[20] - P[0][19]*SPP[7] + P[1][19]*SPP[10] + P[2][19]*SPP[0];
-        nextP[6][19] = P[6][19] + P[3][19]*dt;
-        nextP[7][19] = P[7][19] + P[4][19]*dt;
-        nextP[8][19] = P[8][19] + P[5][19]*dt;
-        nextP[9][19] = P[9][19];
-        nextP[10][19] = P[10][19];
-        nextP[11][19] = P[11][19];
-        nextP[12][19] = P[12][19];
-        nextP[13][19] = P[13][19];
-        nextP[14][19] = P[14][19];
-        nextP[15][19] = P[15][19];
-        nextP[16][19] = P[16][19];
-        nextP[17][19] = P[17][19];
-        nextP[18][19] = P[18][19];
-        nextP[19][19] = P[19][19];
-        nextP[0][20] = P[0][20]*SPP[5] - P[1][20]*SPP[4] + P[2][20]*SPP[8] + P[9][20]*SPP[22] + P[12][20]*SPP[18];
-        nextP[1][20] = P[1][20]*SPP[6] - P[0][20]*SPP[2] - P[2][20]*SPP[9] + P[10][20]*SPP[22] + P[13][20]*SPP[17];
-        nextP[2][20] = P[0][20]*SPP[14] - P[1][20]*SPP[3] + P[2][20]*SPP[13] + P[11][20]*SPP[22] + P[14][20]*SPP[16];
-        nextP[3][20] = P[3][20] + P[0][20]*SPP[1] + P[1][20]*SPP[19] + P[2][20]*SPP[15] - P[15][20]*SPP[21];
-        nextP[4][20] = P[4][20] + P[15][20]*SF[22] + P[0][20]*SPP[20] + P[1][20]*SPP[12] + P[2][20]*SPP[11];
-        nextP[5][20] = P[5][20] + P[15][20]*SF[20] - P[0][20]*SPP[7] + P[1][20]*SPP[10] + P[2][20]*SPP[0];
-        nextP[6][20] = P[6][20] + P[3][20]*dt;
-        nextP[7][20] = P[7][20] + P[4][20]*dt;
-        nextP[8][20] = P[8][20] + P[5][20]*dt;
-        nextP[9][20] = P[9][20];
-        nextP[10][20] = P[10][20];
-        nextP[11][20] = P[11][20];
-        nextP[12][20] = P[12][20];
-        nextP[13][20] = P[13][20];
-        nextP[14][20] = P[14][20];
-        nextP[15][20] = P[15][20];
-        nextP[16][20] = P[16][20];
-        nextP[17][20] = P[17][20];
-        nextP[18][20] = P[18][20];
-        nextP[19][20] = P[19][20];
-        nextP[20][20] = P[20][20];
-        nextP[0][21] = P[0][21]*SPP[5] - P[1][21]*SPP[4] + P[2][21]*SPP[8] + P[9][21]*SPP[22] + P[12][21]*SPP[18];
-        nextP[1][21] = P[1][21]*SPP[6] - P[0][21]*SPP[2] - P[2][21]*SPP[9] + P[10][21]*SPP[22] + P[13][21]*SPP[17];
-        nextP[2][21] = P[0][21]*SPP[14] - P[1][21]*SPP[3] + P[2][21]*SPP[13] + P[11][21]*SPP[22] + P[14][21]*SPP[16];
-        nextP[3][21] = P[3][21] + P[0][21]*SPP[1] + P[1][21]*SPP[19] + P[2][21]*SPP[15] - P[15][21]*SPP[21];
-        nextP[4][21] = P[4][21] + P[15][21]*SF[22] + P[0][21]*SPP[20] + P[1][21]*SPP[12] + P[2][21]*SPP[11];
-        nextP[5][21] = P[5][21] + P[15][21]*SF[20] - P[0][21]*SPP[7] + P[1][21]*SPP[10] + P[2][21]*SPP[0];
-        nextP[6][21] = P[6][21] + P[3][21]*dt;
-        nextP[7][21] = P[7][21] + P[4][21]*dt;
-        nextP[8][21] = P[8][21] + P[5][21]*dt;
-        nextP[9][21] = P[9][21];
-        nextP[10][21] = P[10][21];
-        nextP[11][21] = P[11][21];
-        nextP[12][21] = P[12][21];
-        nextP[13][21] = P[13][21];
-        nextP[14][21] = P[14][21];
-        nextP[15][21] = P[15][21];
-        nextP[16][21] = P[16][21];
-        nextP[17][21] = P[17][21];
-        nextP[18][21] = P[18][21];
-        nextP[19][21] = P[19][21];
-        nextP[20][21] = P[20][21];
-        nextP[21][21] = P[21][21];
+        if (!inhibitMagStates) {
+            nextP[0][16] = P[0][16]*SPP[5] - P[1][16]*SPP[4] + P[2][16]*SPP[8] + P[9][16]*SPP[22] + P[12][16]*SPP[18];
+            nextP[1][16] = P[1][16]*SPP[6] - P[0][16]*SPP[2] - P[2][16]*SPP[9] + P[10][16]*SPP[22] + P[13][16]*SPP[17];
+            nextP[2][16] = P[0][16]*SPP[14] - P[1][16]*SPP[3] + P[2][16]*SPP[13] + P[11][16]*SPP[22] + P[14][16]*SPP[16];
+            nextP[3][16] = P[3][16] + P[0][16]*SPP[1] + P[1][16]*SPP[19] + P[2][16]*SPP[15] - P[15][16]*SPP[21];
+            nextP[4][16] = P[4][16] + P[15][16]*SF[22] + P[0][16]*SPP[20] + P[1][16]*SPP[12] + P[2][16]*SPP[11];
+            nextP[5][16] = P[5][16] + P[15][16]*SF[20] - P[0][16]*SPP[7] + P[1][16]*SPP[10] + P[2][16]*SPP[0];
+            nextP[6][16] = P[6][16] + P[3][16]*dt;
+            nextP[7][16] = P[7][16] + P[4][16]*dt;
+            nextP[8][16] = P[8][16] + P[5][16]*dt;
+            nextP[9][16] = P[9][16];
+            nextP[10][16] = P[10][16];
+            nextP[11][16] = P[11][16];
+            nextP[12][16] = P[12][16];
+            nextP[13][16] = P[13][16];
+            nextP[14][16] = P[14][16];
+            nextP[15][16] = P[15][16];
+            nextP[16][16] = P[16][16];
+            nextP[0][17] = P[0][17]*SPP[5] - P[1][17]*SPP[4] + P[2][17]*SPP[8] + P[9][17]*SPP[22] + P[12][17]*SPP[18];
+            nextP[1][17] = P[1][17]*SPP[6] - P[0][17]*SPP[2] - P[2][17]*SPP[9] + P[10][17]*SPP[22] + P[13][17]*SPP[17];
+            nextP[2][17] = P[0][17]*SPP[14] - P[1][17]*SPP[3] + P[2][17]*SPP[13] + P[11][17]*SPP[22] + P[14][17]*SPP[16];
+            nextP[3][17] = P[3][17] + P[0][17]*SPP[1] + P[1][17]*SPP[19] + P[2][17]*SPP[15] - P[15][17]*SPP[21];
+            nextP[4][17] = P[4][17] + P[15][17]*SF[22] + P[0][17]*SPP[20] + P[1][17]*SPP[12] + P[2][17]*SPP[11];
+            nextP[5][17] = P[5][17] + P[15][17]*SF[20] - P[0][17]*SPP[7] + P[1][17]*SPP[10] + P[2][17]*SPP[0];
+            nextP[6][17] = P[6][17] + P[3][17]*dt;
+            nextP[7][17] = P[7][17] + P[4][17]*dt;
+            nextP[8][17] = P[8][17] + P[5][17]*dt;
+            nextP[9][17] = P[9][17];
+            nextP[10][17] = P[10][17];
+            nextP[11][17] = P[11][17];
+            nextP[12][17] = P[12][17];
+            nextP[13][17] = P[13][17];
+            nextP[14][17] = P[14][17];
+            nextP[15][17] = P[15][17];
+            nextP[16][17] = P[16][17];
+            nextP[17][17] = P[17][17];
+            nextP[0][18] = P[0][18]*SPP[5] - P[1][18]*SPP[4] + P[2][18]*SPP[8] + P[9][18]*SPP[22] + P[12][18]*SPP[18];
+            nextP[1][18] = P[1][18]*SPP[6] - P[0][18]*SPP[2] - P[2][18]*SPP[9] + P[10][18]*SPP[22] + P[13][18]*SPP[17];
+            nextP[2][18] = P[0][18]*SPP[14] - P[1][18]*SPP[3] + P[2][18]*SPP[13] + P[11][18]*SPP[22] + P[14][18]*SPP[16];
+            nextP[3][18] = P[3][18] + P[0][18]*SPP[1] + P[1][18]*SPP[19] + P[2][18]*SPP[15] - P[15][18]*SPP[21];
+            nextP[4][18] = P[4][18] + P[15][18]*SF[22] + P[0][18]*SPP[20] + P[1][18]*SPP[12] + P[2][18]*SPP[11];
+            nextP[5][18] = P[5][18] + P[15][18]*SF[20] - P[0][18]*SPP[7] + P[1][18]*SPP[10] + P[2][18]*SPP[0];
+            nextP[6][18] = P[6][18] + P[3][18]*dt;
+            nextP[7][18] = P[7][18] + P[4][18]*dt;
+            nextP[8][18] = P[8][18] + P[5][18]*dt;
+            nextP[9][18] = P[9][18];
+            nextP[10][18] = P[10][18];
+            nextP[11][18] = P[11][18];
+            nextP[12][18] = P[12][18];
+            nextP[13][18] = P[13][18];
+            nextP[14][18] = P[14][18];
+            nextP[15][18] = P[15][18];
+            nextP[16][18] = P[16][18];
+            nextP[17][18] = P[17][18];
+            nextP[18][18] = P[18][18];
+            nextP[0][19] = P[0][19]*SPP[5] - P[1][19]*SPP[4] + P[2][19]*SPP[8] + P[9][19]*SPP[22] + P[12][19]*SPP[18];
+            nextP[1][19] = P[1][19]*SPP[6] - P[0][19]*SPP[2] - P[2][19]*SPP[9] + P[10][19]*SPP[22] + P[13][19]*SPP[17];
+            nextP[2][19] = P[0][19]*SPP[14] - P[1][19]*SPP[3] + P[2][19]*SPP[13] + P[11][19]*SPP[22] + P[14][19]*SPP[16];
+            nextP[3][19] = P[3][19] + P[0][19]*SPP[1] + P[1][19]*SPP[19] + P[2][19]*SPP[15] - P[15][19]*SPP[21];
+            nextP[4][19] = P[4][19] + P[15][19]*SF[22] + P[0][19]*SPP[20] + P[1][19]*SPP[12] + P[2][19]*SPP[11];
+            nextP[5][19] = P[5][19] + P[15][19]*SF[20] - P[0][19]*SPP[7] + P[1][19]*SPP[10] + P[2][19]*SPP[0];
+            nextP[6][19] = P[6][19] + P[3][19]*dt;
+            nextP[7][19] = P[7][19] + P[4][19]*dt;
+            nextP[8][19] = P[8][19] + P[5][19]*dt;
+            nextP[9][19] = P[9][19];
+            nextP[10][19] = P[10][19];
+            nextP[11][19] = P[11][19];
+            nextP[12][19] = P[12][19];
+            nextP[13][19] = P[13][19];
+            nextP[14][19] = P[14][19];
+            nextP[15][19] = P[15][19];
+            nextP[16][19] = P[16][19];
+            nextP[17][19] = P[17][19];
+            nextP[18][19] = P[18][19];
+            nextP[19][19] = P[19][19];
+            nextP[0][20] = P[0][20]*SPP[5] - P[1][20]*SPP[4] + P[2][20]*SPP[8] + P[9][20]*SPP[22] + P[12][20]*SPP[18];
+            nextP[1][20] = P[1][20]*SPP[6] - P[0][20]*SPP[2] - P[2][20]*SPP[9] + P[10][20]*SPP[22] + P[13][20]*SPP[17];
+            nextP[2][20] = P[0][20]*SPP[14] - P[1][20]*SPP[3] + P[2][20]*SPP[13] + P[11][20]*SPP[22] + P[14][20]*SPP[16];
+            nextP[3][20] = P[3][20] + P[0][20]*SPP[1] + P[1][20]*SPP[19] + P[2][20]*SPP[15] - P[15][20]*SPP[21];
+            nextP[4][20] = P[4][20] + P[15][20]*SF[22] + P[0][20]*SPP[20] + P[1][20]*SPP[12] + P[2][20]*SPP[11];
+            nextP[5][20] = P[5][20] + P[15][20]*SF[20] - P[0][20]*SPP[7] + P[1][20]*SPP[10] + P[2][20]*SPP[0];
+            nextP[6][20] = P[6][20] + P[3][20]*dt;
+            nextP[7][20] = P[7][20] + P[4][20]*dt;
+            nextP[8][20] = P[8][20] + P[5][20]*dt;
+            nextP[9][20] = P[9][20];
+            nextP[10][20] = P[10][20];
+            nextP[11][20] = P[11][20];
+            nextP[12][20] = P[12][20];
+            nextP[13][20] = P[13][20];
+            nextP[14][20] = P[14][20];
+            nextP[15][20] = P[15][20];
+            nextP[16][20] = P[16][20];
+            nextP[17][20] = P[17][20];
+            nextP[18][20] = P[18][20];
+            nextP[19][20] = P[19][20];
+            nextP[20][20] = P[20][20];
+            nextP[0][21] = P[0][21]*SPP[5] - P[1][21]*SPP[4] + P[2][21]*SPP[8] + P[9][21]*SPP[22] + P[12][21]*SPP[18];
+            nextP[1][21] = P[1][21]*SPP[6] - P[0][21]*SPP[2] - P[2][21]*SPP[9] + P[10][21]*SPP[22] + P[13][21]*SPP[17];
+            nextP[2][21] = P[0][21]*SPP[14] - P[1][21]*SPP[3] + P[2][21]*SPP[13] + P[11][21]*SPP[22] + P[14][21]*SPP[16];
+            nextP[3][21] = P[3][21] + P[0][21]*SPP[1] + P[1][21]*SPP[19] + P[2][21]*SPP[15] - P[15][21]*SPP[21];
+            nextP[4][21] = P[4][21] + P[15][21]*SF[22] + P[0][21]*SPP[20] + P[1][21]*SPP[12] + P[2][21]*SPP[11];
+            nextP[5][21] = P[5][21] + P[15][21]*SF[20] - P[0][21]*SPP[7] + P[1][21]*SPP[10] + P[2][21]*SPP[0];
+            nextP[6][21] = P[6][21] + P[3][21]*dt;
+            nextP[7][21] = P[7][21] + P[4][21]*dt;
+            nextP[8][21] = P[8][21] + P[5][21]*dt;
+            nextP[9][21] = P[9][21];
+            nextP[10][21] = P[10][21];
+            nextP[11][21] = P[11][21];
+            nextP[12][21] = P[12][21];
+            nextP[13][21] = P[13][21];
+            nextP[14][21] = P[14][21];
+            nextP[15][21] = P[15][21];
+            nextP[16][21] = P[16][21];
+            nextP[17][21] = P[17][21];
+            nextP[18][21] = P[18][21];
+            nextP[19][21] = P[19][21];
+            nextP[20][21] = P[20][21];
+            nextP[21][21] = P[21][21];
+        } else {
+            // the magnetic field states were zeroed above so their predicted covariances are
+            // zero and there is no need to evaluate the full expressions
+            for (uint8_t colIndex=16; colIndex<=21; colIndex++) {
+                for (uint8_t rowIndex=0; rowIndex<=colIndex; rowIndex++) {
+                    nextP[rowIndex][colIndex] = 0.0f;
+                }
+            }
+        }
 
         if (stateIndexLim > 21) {
             nextP[0][22] = P[0][22]*SPP[5] - P[1][22]*SPP[4] + P[2][22]*SPP[8] + P[9][22]*SPP[22] + P[12][22]*SPP[18];
@@ -1225,15 +1238,6 @@ void NavEKF2_core::CovariancePrediction()
         }
     }
 
-    // Copy upper diagonal to lower diagonal taking advantage of symmetry
-    for (uint8_t colIndex=0; colIndex<=stateIndexLim; colIndex++)
-    {
-        for (uint8_t rowIndex=0; rowIndex<colIndex; rowIndex++)
-        {
-            nextP[colIndex][rowIndex] = nextP[rowIndex][colIndex];
-        }
-    }
-
     // add the general state process noise variances
     for (uint8_t i=0; i<=stateIndexLim; i++)
     {
@@ -1241,23 +1245,13 @@ void NavEKF2_core::CovariancePrediction()
     }
 
     // if the total position variance exceeds 1e4 (100m), then stop covariance
-    // growth by setting the predicted to the previous values
+    // growth by keeping the previous values for the horizontal position rows and columns
     // This prevent an ill conditioned matrix from occurring for long periods
     // without GPS
-    if ((P[6][6] + P[7][7]) > 1e4f)
-    {
-        for (uint8_t i=6; i<=7; i++)
-        {
-            for (uint8_t j=0; j<=stateIndexLim; j++)
-            {
-                nextP[i][j] = P[i][j];
-                nextP[j][i] = P[j][i];
-            }
-        }
-    }
+    bool holdHorizPos = (P[6][6] + P[7][7]) > 1e4f;
 
-    // copy covariances to output
-    CopyCovariances();
+    // copy the upper diagonal of the predicted covariances to both halves of the output
+    CopyCovariances(holdHorizPos);
 
     // constrain diagonals to prevent ill-conditioning
     ConstrainVariances();
@@ -1345,14 +1339,21 @@ void NavEKF2_core::ForceSymmetry()
 }
 
 // copy covariances across from covariance prediction calculation
-void NavEKF2_core::CopyCovariances()
+// only the upper diagonal of nextP is used as the matrix is symmetrical
+// if holdHorizPos is true the horizontal position rows and columns are left unchanged
+void NavEKF2_core::CopyCovariances(bool holdHorizPos)
 {
-    // copy predicted covariances
-    for (uint8_t i=0; i<=stateIndexLim; i++) {
-        for (uint8_t j=0; j<=stateIndexLim; j++)
-        {
-            P[i][j] = nextP[i][j];
+    for (uint8_t col=0; col<=stateIndexLim; col++) {
+        if (holdHorizPos && (col == 6 || col == 7)) {
+            continue;
+        }
+        for (uint8_t row=0; row<col; row++) {
+            if (holdHorizPos && (row == 6 || row == 7)) {
+                continue;
+            }
+            P[row][col] = P[col][row] = nextP[row][col];
         }
+        P[col][col] = nextP[col][col];
     }
 }
 
@@ -1511,4 +1512,51 @@ void NavEKF2_core::zeroAttCovOnly()
     }
 }
 
+/*
+  queue a status text. The core may be running on a worker thread, so
+  it must not call into the GCS itself
+ */
+void NavEKF2_core::queueStatusText(MAV_SEVERITY severity, const char *fmt, ...)
+{
+    if (statusTextCount >= EKF2_STATUS_TEXT_QUEUE_LEN) {
+        if (statusTextLost < UINT8_MAX) {
+            statusTextLost++;
+        }
+        return;
+    }
+    struct status_text &st = statusTextQueue[statusTextCount++];
+    st.severity = severity;
+    va_list arg_list;
+    va_start(arg_list, fmt);
+    hal.util->vsnprintf(st.text, sizeof(st.text), fmt, arg_list);
+    va_end(arg_list);
+}
+
+// send the queued status text, apply the requested parameter changes
+// and pass on the logging requests
+void NavEKF2_core::drainQueued(void)
+{
+    if (gpsTypeChangeRequested) {
+        gpsTypeChangeRequested = false;
+        if (frontend->_fusionModeGPS == 0) {
+            frontend->_fusionModeGPS.set(1);
+            gcs().send_text(MAV_SEVERITY_WARNING, "EK2: Changed EK2_GPS_TYPE to 1");
+        }
+    }
+    for (uint8_t i=0; i<statusTextCount; i++) {
+        gcs().send_text(statusTextQueue[i].severity, "%s", statusTextQueue[i].text);
+    }
+    statusTextCount = 0;
+    if (statusTextLost != 0) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "EKF2 IMU%u %u messages lost",(unsigned)imu_index,(unsigned)statusTextLost);
+        statusTextLost = 0;
+    }
+
+    frontend->logging.log_compass |= logRequest.compass;
+    frontend->logging.log_gps |= logRequest.gps;
+    frontend->logging.log_baro |= logRequest.baro;
+    frontend->logging.log_imu |= logRequest.imu;
+    memset(&logRequest, 0, sizeof(logRequest));
+}
+
 #endif // HAL_CPU_CLASS
@@ -0,0 +1,175 @@
+#include <AP_gtest.h>
+
+#include <AP_NavEKF2/AP_NavEKF2.h>
+#include <AP_NavEKF2/AP_NavEKF2_core.h>
+#include <AP_SerialManager/AP_SerialManager.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+static AP_SerialManager serial_manager;
+static RangeFinder rng(serial_manager, ROTATION_PITCH_270);
+static AP_Baro baro;
+static NavEKF2 ekf(nullptr, baro, rng);
+
+/*
+  a core set up with fixed inputs for one covariance prediction. hold_pos
+  makes the horizontal position variances large enough to stop their
+  growth
+ */
+class NavEKF2_core_Test
+{
+public:
+    NavEKF2_core_Test(bool inhibit_mag, bool hold_pos = false)
+    {
+        core = new NavEKF2_core();
+        core->frontend = &ekf;
+        core->dtEkfAvg = EKF_TARGET_DT;
+        core->stateIndexLim = 23;
+        core->hgtRate = 0.0f;
+        core->expectGndEffectTakeoff = false;
+        core->PV_AidingMode = NavEKF2_core::AID_ABSOLUTE;
+        core->inhibitWindStates = false;
+        core->inhibitMagStates = inhibit_mag;
+
+        core->stateStruct.quat.from_euler(0.1f, -0.2f, 1.0f);
+        core->stateStruct.velocity = Vector3f(3.0f, -1.0f, 0.5f);
+        core->stateStruct.gyro_bias = Vector3f(1e-5f, -2e-5f, 3e-5f);
+        core->stateStruct.gyro_scale = Vector3f(1.01f, 0.99f, 1.0f);
+        core->stateStruct.accel_zbias = 1e-4f;
+        core->imuDataDelayed.delAng = Vector3f(0.001f, -0.002f, 0.0005f);
+        core->imuDataDelayed.delVel = Vector3f(0.01f, 0.02f, -0.117f);
+        core->imuDataDelayed.delAngDT = EKF_TARGET_DT;
+        core->imuDataDelayed.delVelDT = EKF_TARGET_DT;
+
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                core->P[i][j] = 1e-3f * cosf(i + j) + (i == j ? 0.1f : 0.0f);
+                // left over from an earlier prediction
+                core->nextP[i][j] = 1000.0f;
+            }
+        }
+        if (hold_pos) {
+            core->P[6][6] = core->P[7][7] = 1e4f;
+        }
+    }
+
+    ~NavEKF2_core_Test()
+    {
+        delete core;
+    }
+
+    void predict()
+    {
+        core->CovariancePrediction();
+    }
+
+    /*
+      the prediction as it was done before the inhibited magnetic field
+      block was written as zeros and the symmetric copy was merged into
+      CopyCovariances(): full expressions for every state, the upper
+      triangle of nextP mirrored into the lower one, the held rows and
+      columns copied back into nextP and then all of nextP copied to P
+     */
+    void predict_previous()
+    {
+        // the magnetic field states are zeroed before the prediction
+        // when inhibited, so the full expressions see the same inputs
+        if (core->inhibitMagStates) {
+            core->zeroRows(core->P, 16, 21);
+            core->zeroCols(core->P, 16, 21);
+        }
+
+        float P_prior[24][24];
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                P_prior[i][j] = core->P[i][j];
+            }
+        }
+
+        const bool inhibit_mag = core->inhibitMagStates;
+        core->inhibitMagStates = false;
+        core->CovariancePrediction();
+        core->inhibitMagStates = inhibit_mag;
+
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                core->P[i][j] = P_prior[i][j];
+            }
+        }
+
+        const uint8_t lim = core->stateIndexLim;
+        for (uint8_t colIndex=0; colIndex<=lim; colIndex++) {
+            for (uint8_t rowIndex=0; rowIndex<colIndex; rowIndex++) {
+                core->nextP[colIndex][rowIndex] = core->nextP[rowIndex][colIndex];
+            }
+        }
+        if ((core->P[6][6] + core->P[7][7]) > 1e4f) {
+            for (uint8_t i=6; i<=7; i++) {
+                for (uint8_t j=0; j<=lim; j++) {
+                    core->nextP[i][j] = core->P[i][j];
+                    core->nextP[j][i] = core->P[j][i];
+                }
+            }
+        }
+        for (uint8_t i=0; i<=lim; i++) {
+            for (uint8_t j=0; j<=lim; j++) {
+                core->P[i][j] = core->nextP[i][j];
+            }
+        }
+        core->ConstrainVariances();
+    }
+
+    float nextP(uint8_t row, uint8_t col) const { return core->nextP[row][col]; }
+    float P(uint8_t row, uint8_t col) const { return core->P[row][col]; }
+
+private:
+    NavEKF2_core *core;
+};
+
+/*
+  with the magnetic field states inhibited their block of nextP is
+  written as zeros, which must match the full expressions evaluated on
+  the zeroed states
+ */
+TEST(NavEKF2_core, CovariancePredictionInhibitedMag)
+{
+    NavEKF2_core_Test current(true);
+    NavEKF2_core_Test previous(true);
+
+    current.predict();
+    previous.predict_previous();
+
+    for (uint8_t col=16; col<=21; col++) {
+        for (uint8_t row=0; row<=col; row++) {
+            EXPECT_FLOAT_EQ(previous.nextP(row, col), current.nextP(row, col)) << "nextP[" << (int)row << "][" << (int)col << "]";
+        }
+    }
+}
+
+/*
+  the predicted covariances must be exactly those of the previous
+  implementation, with the magnetic field states active or inhibited and
+  with or without the horizontal position hold
+ */
+TEST(NavEKF2_core, CovariancePredictionMatchesPrevious)
+{
+    for (uint8_t inhibit_mag=0; inhibit_mag<2; inhibit_mag++) {
+        for (uint8_t hold_pos=0; hold_pos<2; hold_pos++) {
+            NavEKF2_core_Test current(inhibit_mag, hold_pos);
+            NavEKF2_core_Test previous(inhibit_mag, hold_pos);
+
+            current.predict();
+            previous.predict_previous();
+
+            for (uint8_t row=0; row<24; row++) {
+                for (uint8_t col=0; col<24; col++) {
+                    EXPECT_EQ(previous.P(row, col), current.P(row, col))
+                        << "P[" << (int)row << "][" << (int)col << "] inhibit_mag=" << (int)inhibit_mag
+                        << " hold_pos=" << (int)hold_pos;
+                }
+            }
+        }
+    }
+}
+
+AP_GTEST_MAIN()
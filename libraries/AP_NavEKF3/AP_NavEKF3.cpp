@@ -6,6 +6,11 @@
 #include <GCS_MAVLink/GCS.h>
 #include <DataFlash/DataFlash.h>
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <unistd.h>
+#include <AP_HAL_Linux/Scheduler.h>
+#endif
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -575,6 +580,16 @@ const AP_Param::GroupInfo NavEKF3::var_info[] = {
     // @Units: m/s
     AP_GROUPINFO("WENC_VERR", 53, NavEKF3, _wencOdmVelErr, 0.1f),
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // @Param: THREADS
+    // @DisplayName: Run EKF cores on worker threads
+    // @Description: When enabled, the update of every EKF core except the first one is run on its own worker thread pinned to a separate CPU, and the cores are joined in core order before the outputs are read. Status text, parameter changes and logging requested by the cores are acted on afterwards in core order, as in sequential operation. The decision to skip the state prediction of a core is taken for all cores from one reading of the loop time before any of them runs, rather than after the cores before it have used their share of the loop time, so when the loop is short of time the outputs can differ from sequential operation. Only useful on multi-core Linux boards running more than one core.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("THREADS", 54, NavEKF3, _coreThreads, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -704,6 +719,12 @@ bool NavEKF3::InitialiseFilter(void)
             return false;
         }
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+        if (_coreThreads != 0 && num_cores > 1) {
+            startCoreWorkers();
+        }
+#endif
+
     }
 
     // Set up any cores that have been created
@@ -731,6 +752,7 @@ bool NavEKF3::InitialiseFilter(void)
     bool ret = true;
     for (uint8_t i=0; i<num_cores; i++) {
         ret &= core[i].InitialiseFilterBootstrap();
+        core[i].drainQueued();
     }
 
     // zero the structs used capture reset events
@@ -754,18 +776,30 @@ void NavEKF3::UpdateFilter(void)
     const AP_InertialSensor &ins = _ahrs->get_ins();
 
     bool statePredictEnabled[num_cores];
-    for (uint8_t i=0; i<num_cores; i++) {
-        // if we have not overrun by more than 3 IMU frames, and we
-        // have already used more than 1/3 of the CPU budget for this
-        // loop then suppress the prediction step. This allows
-        // multiple EKF instances to cooperate on scheduling
-        if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
-            (AP_HAL::micros() - ins.get_last_update_usec()) > _frameTimeUsec/3) {
-            statePredictEnabled[i] = false;
-        } else {
-            statePredictEnabled[i] = true;
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    if (coreWorkers != nullptr) {
+        // all the prediction decisions are taken from one reading of the
+        // loop time before any core runs, so the result does not depend
+        // on how the worker threads are scheduled. Unlike sequential
+        // operation, no core sees the time used by the cores before it
+        const uint32_t loopTime_us = AP_HAL::micros() - ins.get_last_update_usec();
+        for (uint8_t i=0; i<num_cores; i++) {
+            statePredictEnabled[i] = coreStatePredictEnabled(i, loopTime_us);
+        }
+        UpdateCoresParallel(statePredictEnabled);
+    } else
+#endif
+    {
+        for (uint8_t i=0; i<num_cores; i++) {
+            statePredictEnabled[i] = coreStatePredictEnabled(i, AP_HAL::micros() - ins.get_last_update_usec());
+            core[i].UpdateFilter(statePredictEnabled[i]);
         }
-        core[i].UpdateFilter(statePredictEnabled[i]);
+    }
+
+    // the cores queue their status text, parameter changes and logging
+    // so that only the main thread acts on them, in core order
+    for (uint8_t i=0; i<num_cores; i++) {
+        core[i].drainQueued();
     }
 
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
@@ -810,6 +844,86 @@ void NavEKF3::UpdateFilter(void)
     check_log_write();
 }
 
+/*
+  return true if the state prediction step of a core should run on this
+  frame. If we have not overrun by more than 3 IMU frames, and we have
+  already used more than 1/3 of the CPU budget for this loop then
+  suppress the prediction step. This allows multiple EKF instances to
+  cooperate on scheduling
+ */
+bool NavEKF3::coreStatePredictEnabled(uint8_t coreIndex, uint32_t loopTime_us) const
+{
+    if (core[coreIndex].getFramesSincePredict() < (_framesPerPrediction+3) &&
+        loopTime_us > _frameTimeUsec/3) {
+        return false;
+    }
+    return true;
+}
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+void NavEKF3::core_job::run()
+{
+    core->UpdateFilter(statePredictEnabled);
+}
+
+/*
+  start one worker thread for each core other than the first, pinning
+  each of them to its own CPU. If anything fails we fall back to
+  updating the cores sequentially
+ */
+void NavEKF3::startCoreWorkers(void)
+{
+    coreJobs = new core_job[num_cores];
+    coreWorkers = new Linux::WorkerThread[num_cores];
+    if (coreJobs == nullptr || coreWorkers == nullptr) {
+        delete[] coreJobs;
+        delete[] coreWorkers;
+        coreJobs = nullptr;
+        coreWorkers = nullptr;
+        return;
+    }
+
+    const long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (uint8_t i=1; i<num_cores; i++) {
+        coreJobs[i].core = &core[i];
+        coreJobs[i].statePredictEnabled = false;
+        if (num_cpus > 1) {
+            coreWorkers[i].set_cpu_affinity(i % num_cpus);
+        }
+        if (!coreWorkers[i].start("ekf3_core", AP_LINUX_SENSORS_SCHED_POLICY, AP_LINUX_SENSORS_SCHED_PRIO)) {
+            // a worker that did not start just leaves its core on the main thread
+            gcs().send_text(MAV_SEVERITY_WARNING, "NavEKF3: core %u thread failed", (unsigned)i);
+        }
+    }
+}
+
+/*
+  update the cores in parallel. Cores other than the first are handed to
+  their worker threads while the first core runs on the calling
+  thread. Each core only touches its own state, and queues anything
+  with side effects outside the core for drainQueued()
+ */
+void NavEKF3::UpdateCoresParallel(const bool *statePredictEnabled)
+{
+    bool submitted[num_cores];
+    submitted[0] = false;
+    for (uint8_t i=1; i<num_cores; i++) {
+        coreJobs[i].statePredictEnabled = statePredictEnabled[i];
+        submitted[i] = coreWorkers[i].submit(FUNCTOR_BIND(&coreJobs[i], &core_job::run, void));
+    }
+
+    core[0].UpdateFilter(statePredictEnabled[0]);
+
+    for (uint8_t i=1; i<num_cores; i++) {
+        if (submitted[i]) {
+            coreWorkers[i].wait();
+        } else {
+            core[i].UpdateFilter(statePredictEnabled[i]);
+        }
+    }
+}
+#endif
+
 // Check basic filter health metrics and return a consolidated health status
 bool NavEKF3::healthy(void) const
 {
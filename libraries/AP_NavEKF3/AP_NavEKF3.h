@@ -28,6 +28,10 @@
 #include <AP_Compass/AP_Compass.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <AP_HAL_Linux/WorkerThread.h>
+#endif
+
 class NavEKF3_core;
 class AP_AHRS;
 
@@ -409,6 +413,9 @@ private:
     AP_Float _visOdmVelErrMax;      // Observation 1-STD velocity error assumed for visual odometry sensor at lowest reported quality (m/s)
     AP_Float _visOdmVelErrMin;      // Observation 1-STD velocity error assumed for visual odometry sensor at highest reported quality (m/s)
     AP_Float _wencOdmVelErr;        // Observation 1-STD velocity error assumed for wheel odometry sensor (m/s)
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    AP_Int8 _coreThreads;           // Run the update of each core on its own worker thread
+#endif
 
 
     // Tuning parameters
@@ -491,4 +498,27 @@ private:
     // new_primary - index of the ekf instance that we are about to switch to as the primary
     // old_primary - index of the ekf instance that we are currently using as the primary
     void updateLaneSwitchPosDownResetData(uint8_t new_primary, uint8_t old_primary);
+
+    // return true if the state prediction step of a core should run on
+    // this frame, given the time used so far since the IMU update
+    bool coreStatePredictEnabled(uint8_t coreIndex, uint32_t loopTime_us) const;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // a core update handed to a worker thread
+    struct core_job {
+        NavEKF3_core *core;
+        bool statePredictEnabled;
+        void run();
+    };
+
+    // per core jobs and worker threads. Core 0 always runs on the calling thread
+    core_job *coreJobs = nullptr;
+    Linux::WorkerThread *coreWorkers = nullptr;
+
+    // start the worker threads used to update the cores in parallel
+    void startCoreWorkers(void);
+
+    // update all cores in parallel, returning once every core has finished
+    void UpdateCoresParallel(const bool *statePredictEnabled);
+#endif
 };
@@ -28,6 +28,7 @@
 #include "AP_NavEKF3.h"
 #include <AP_Math/vectorN.h>
 #include <AP_NavEKF3/AP_NavEKF3_Buffer.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
 
 // GPS pre-flight check bit locations
 #define MASK_GPS_NSATS      (1<<0)
@@ -64,10 +65,16 @@
 // mag fusion final reset altitude (using NED frame so altitude is negative)
 #define EKF3_MAG_FINAL_RESET_ALT 2.5f
 
+// number of status text messages a core can queue in one update. Any
+// more are counted and reported as lost
+#define EKF3_STATUS_TEXT_QUEUE_LEN 8
+
 class AP_AHRS;
 
 class NavEKF3_core
 {
+    friend class NavEKF3_core_Test;
+
 public:
     // Constructor
     NavEKF3_core(void);
@@ -353,6 +360,13 @@ public:
 
     // get timing statistics structure
     void getTimingStatistics(struct ekf_timing &timing);
+
+    // send the status text queued by the core, apply the parameter
+    // changes it asked for and pass its logging requests to the
+    // frontend. Called by the frontend on the main thread, in core
+    // order, after the core has been updated, possibly on a worker
+    // thread
+    void drainQueued(void);
     
 private:
     // Reference to the global EKF frontend for parameters
@@ -1225,6 +1239,31 @@ private:
     // string representing last reason for prearm failure
     char prearm_fail_string[40];
 
+    // status text waiting for drainQueued()
+    struct status_text {
+        MAV_SEVERITY severity;
+        char text[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1];
+    } statusTextQueue[EKF3_STATUS_TEXT_QUEUE_LEN];
+    uint8_t statusTextCount;
+    uint8_t statusTextLost;
+
+    // set when EK3_GPS_TYPE should be changed to 1 because the GPS
+    // gives no vertical velocity
+    bool gpsTypeChangeRequested;
+
+    // sensor data to be logged by the frontend, set by this core
+    // rather than in the frontend so that cores on worker threads
+    // never write to shared state
+    struct {
+        bool compass:1;
+        bool gps:1;
+        bool baro:1;
+        bool imu:1;
+    } logRequest;
+
+    // queue a status text to be sent by drainQueued()
+    void queueStatusText(MAV_SEVERITY severity, const char *fmt, ...) FMT_PRINTF(3, 4);
+
     // performance counters
     AP_HAL::Util::perf_counter_t  _perf_UpdateFilter;
     AP_HAL::Util::perf_counter_t  _perf_CovariancePrediction;
@@ -0,0 +1,63 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF3/AP_NavEKF3.h>
+#include <AP_NavEKF3/AP_NavEKF3_core.h>
+#include <AP_SerialManager/AP_SerialManager.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static AP_SerialManager serial_manager;
+static RangeFinder rng(serial_manager, ROTATION_PITCH_270);
+static AP_Baro baro;
+static NavEKF3 ekf(nullptr, baro, rng);
+
+class NavEKF3_core_Test
+{
+public:
+    /*
+      cost of one covariance prediction with all 24 states, with the
+      magnetic field states active or inhibited (x) and with or without
+      the horizontal position hold (y)
+     */
+    static void CovariancePrediction(benchmark::State& state)
+    {
+        NavEKF3_core *core = new NavEKF3_core();
+        core->frontend = &ekf;
+        core->dtEkfAvg = EKF_TARGET_DT;
+        core->stateIndexLim = 23;
+        core->hgtRate = 0.0f;
+        core->inhibitMagStates = state.range_x() != 0;
+        core->stateStruct.quat.from_euler(0.1f, -0.2f, 1.0f);
+        core->imuDataDelayed.delAng = Vector3f(0.001f, -0.002f, 0.0005f);
+        core->imuDataDelayed.delVel = Vector3f(0.01f, 0.02f, -0.117f);
+        core->imuDataDelayed.delAngDT = EKF_TARGET_DT;
+        core->imuDataDelayed.delVelDT = EKF_TARGET_DT;
+
+        float P_start[24][24];
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                P_start[i][j] = 1e-3f * cosf(i + j) + (i == j ? 0.1f : 0.0f);
+            }
+        }
+        if (state.range_y() != 0) {
+            P_start[7][7] = P_start[8][8] = 1e4f;
+        }
+
+        while (state.KeepRunning()) {
+            // start each run from the same covariances. Pausing the timer
+            // costs a large part of one prediction, so the copy is timed
+            // instead
+            memcpy(core->P, P_start, sizeof(P_start));
+            core->hgtRate = 0.0f;
+
+            core->CovariancePrediction();
+            gbenchmark_escape(&core->P);
+        }
+
+        delete core;
+    }
+};
+
+BENCHMARK(NavEKF3_core_Test::CovariancePrediction)->ArgPair(0, 0)->ArgPair(1, 0)->ArgPair(0, 1);
+
+BENCHMARK_MAIN()
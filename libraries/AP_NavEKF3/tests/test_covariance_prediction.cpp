@@ -0,0 +1,186 @@
+#include <AP_gtest.h>
+
+#include <AP_NavEKF3/AP_NavEKF3.h>
+#include <AP_NavEKF3/AP_NavEKF3_core.h>
+#include <AP_SerialManager/AP_SerialManager.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+static AP_SerialManager serial_manager;
+static RangeFinder rng(serial_manager, ROTATION_PITCH_270);
+static AP_Baro baro;
+static NavEKF3 ekf(nullptr, baro, rng);
+
+/*
+  a core set up with fixed inputs for one covariance prediction. When
+  inhibited the magnetic field states are zeroed as ConstrainVariances()
+  leaves them, and hold_pos makes the horizontal position variances
+  large enough to stop their growth
+ */
+class NavEKF3_core_Test
+{
+public:
+    NavEKF3_core_Test(bool inhibit_mag, bool hold_pos = false)
+    {
+        core = new NavEKF3_core();
+        core->frontend = &ekf;
+        core->dtEkfAvg = EKF_TARGET_DT;
+        core->stateIndexLim = 23;
+        core->hgtRate = 0.0f;
+        core->inhibitDelAngBiasStates = false;
+        core->inhibitDelVelBiasStates = false;
+        core->inhibitWindStates = false;
+        core->inhibitMagStates = inhibit_mag;
+
+        core->stateStruct.quat.from_euler(0.1f, -0.2f, 1.0f);
+        core->stateStruct.velocity = Vector3f(3.0f, -1.0f, 0.5f);
+        core->stateStruct.gyro_bias = Vector3f(1e-5f, -2e-5f, 3e-5f);
+        core->stateStruct.accel_bias = Vector3f(-1e-4f, 2e-4f, 1e-4f);
+        core->imuDataDelayed.delAng = Vector3f(0.001f, -0.002f, 0.0005f);
+        core->imuDataDelayed.delVel = Vector3f(0.01f, 0.02f, -0.117f);
+        core->imuDataDelayed.delAngDT = EKF_TARGET_DT;
+        core->imuDataDelayed.delVelDT = EKF_TARGET_DT;
+
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                const bool mag = (i >= 16 && i <= 21) || (j >= 16 && j <= 21);
+                core->P[i][j] = (mag && inhibit_mag) ? 0.0f : 1e-3f * cosf(i + j) + (i == j ? 0.1f : 0.0f);
+                // left over from an earlier prediction
+                core->nextP[i][j] = 1000.0f;
+            }
+        }
+        if (hold_pos) {
+            core->P[7][7] = core->P[8][8] = 1e4f;
+        }
+    }
+
+    ~NavEKF3_core_Test()
+    {
+        delete core;
+    }
+
+    void predict()
+    {
+        core->CovariancePrediction();
+    }
+
+    /*
+      the prediction as it was done before the inhibited magnetic field
+      block was skipped and the horizontal position hold was merged into
+      the copy to P: full expressions for every state, then the held rows
+      and columns copied back into nextP before all of nextP goes to P
+     */
+    void predict_previous()
+    {
+        float P_prior[24][24];
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                P_prior[i][j] = core->P[i][j];
+            }
+        }
+
+        const bool inhibit_mag = core->inhibitMagStates;
+        core->inhibitMagStates = false;
+        core->CovariancePrediction();
+        core->inhibitMagStates = inhibit_mag;
+
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                core->P[i][j] = P_prior[i][j];
+            }
+        }
+
+        const uint8_t lim = core->stateIndexLim;
+        if ((core->P[7][7] + core->P[8][8]) > 1e4f) {
+            for (uint8_t i=7; i<=8; i++) {
+                for (uint8_t j=0; j<=lim; j++) {
+                    core->nextP[i][j] = core->P[i][j];
+                    core->nextP[j][i] = core->P[j][i];
+                }
+            }
+        }
+        for (uint8_t row = 0; row <= lim; row++) {
+            core->P[row][row] = core->nextP[row][row];
+            for (uint8_t column = 0 ; column < row; column++) {
+                core->P[row][column] = core->P[column][row] = core->nextP[column][row];
+            }
+        }
+        core->ConstrainVariances();
+    }
+
+    void zero_mag()
+    {
+        core->zeroRows(core->P, 16, 21);
+        core->zeroCols(core->P, 16, 21);
+    }
+
+    float nextP(uint8_t row, uint8_t col) const { return core->nextP[row][col]; }
+    float P(uint8_t row, uint8_t col) const { return core->P[row][col]; }
+
+private:
+    NavEKF3_core *core;
+};
+
+/*
+  with the magnetic field states inhibited the skipped block of nextP
+  must match the full expressions evaluated on the zeroed states
+ */
+TEST(NavEKF3_core, CovariancePredictionInhibitedMag)
+{
+    NavEKF3_core_Test full(false);
+    NavEKF3_core_Test skipped(true);
+
+    // the full evaluation needs the same zeroed states
+    full.zero_mag();
+
+    full.predict();
+    skipped.predict();
+
+    for (uint8_t col=0; col<24; col++) {
+        for (uint8_t row=0; row<=col; row++) {
+            if (row == col && row >= 16 && row <= 21) {
+                // only the active states get process noise
+                EXPECT_FLOAT_EQ(0.0f, skipped.nextP(row, col));
+                continue;
+            }
+            EXPECT_FLOAT_EQ(full.nextP(row, col), skipped.nextP(row, col)) << "nextP[" << (int)row << "][" << (int)col << "]";
+        }
+    }
+
+    for (uint8_t row=0; row<24; row++) {
+        for (uint8_t col=0; col<24; col++) {
+            if (row == col && row >= 16 && row <= 21) {
+                continue;
+            }
+            EXPECT_FLOAT_EQ(full.P(row, col), skipped.P(row, col)) << "P[" << (int)row << "][" << (int)col << "]";
+        }
+    }
+}
+
+/*
+  the predicted covariances must be exactly those of the previous
+  implementation, with the magnetic field states active or inhibited and
+  with or without the horizontal position hold
+ */
+TEST(NavEKF3_core, CovariancePredictionMatchesPrevious)
+{
+    for (uint8_t inhibit_mag=0; inhibit_mag<2; inhibit_mag++) {
+        for (uint8_t hold_pos=0; hold_pos<2; hold_pos++) {
+            NavEKF3_core_Test current(inhibit_mag, hold_pos);
+            NavEKF3_core_Test previous(inhibit_mag, hold_pos);
+
+            current.predict();
+            previous.predict_previous();
+
+            for (uint8_t row=0; row<24; row++) {
+                for (uint8_t col=0; col<24; col++) {
+                    EXPECT_EQ(previous.P(row, col), current.P(row, col))
+                        << "P[" << (int)row << "][" << (int)col << "] inhibit_mag=" << (int)inhibit_mag
+                        << " hold_pos=" << (int)hold_pos;
+                }
+            }
+        }
+    }
+}
+
+AP_GTEST_MAIN()
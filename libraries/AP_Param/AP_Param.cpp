@@ -24,6 +24,7 @@
 #include "AP_Param.h"
 
 #include <cmath>
+#include <ctype.h>
 #include <string.h>
 
 #include <AP_Common/AP_Common.h>
@@ -59,6 +60,16 @@ extern const AP_HAL::HAL &hal;
 // number of rows in the _var_info[] table
 uint16_t AP_Param::_num_vars;
 
+#if AP_PARAM_FIND_INDEX
+// sorted index of parameter names, built by setup() and load_all()
+struct AP_Param::find_index_entry *AP_Param::_find_index;
+uint16_t AP_Param::_find_index_count;
+struct AP_Param::find_index_entry *AP_Param::_find_index_unindexed;
+uint8_t AP_Param::_find_index_unindexed_count;
+uint16_t AP_Param::_find_index_buckets[AP_PARAM_FIND_INDEX_BUCKETS+1];
+const AP_Param::Info *AP_Param::_find_index_var_info;
+#endif
+
 // cached parameter count
 uint16_t AP_Param::_parameter_count;
 
@@ -296,6 +307,10 @@ bool AP_Param::setup(void)
         erase_all();
     }
 
+#if AP_PARAM_FIND_INDEX
+    find_index_build();
+#endif
+
     return true;
 }
 
@@ -402,10 +417,21 @@ const struct AP_Param::Info *AP_Param::find_by_header_group(struct Param_header
 
 // find the info structure given a header
 // return the Info structure and a pointer to the variables storage
-const struct AP_Param::Info *AP_Param::find_by_header(struct Param_header phdr, void **ptr)
-{
+const struct AP_Param::Info *AP_Param::find_by_header(struct Param_header phdr, void **ptr,
+                                                     const uint16_t *key_index)
+{
+    uint16_t start = 0;
+    uint16_t end = _num_vars;
+    if (key_index != nullptr) {
+        // only the one entry with this key can match
+        start = key_index[get_key(phdr)];
+        if (start >= _num_vars) {
+            return nullptr;
+        }
+        end = start + 1;
+    }
     // loop over all named variables
-    for (uint16_t i=0; i<_num_vars; i++) {
+    for (uint16_t i=start; i<end; i++) {
         uint8_t type = _var_info[i].type;
         uint16_t key = _var_info[i].key;
         if (key != get_key(phdr)) {
@@ -801,6 +827,12 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype)
 {
+#if AP_PARAM_FIND_INDEX
+    AP_Param *indexed;
+    if (find_indexed(name, ptype, indexed)) {
+        return indexed;
+    }
+#endif
     for (uint16_t i=0; i<_num_vars; i++) {
         uint8_t type = _var_info[i].type;
         if (type == AP_PARAM_GROUP) {
@@ -831,6 +863,365 @@ AP_Param::find(const char *name, enum ap_var_type *ptype)
     return nullptr;
 }
 
+#if AP_PARAM_FIND_INDEX
+/*
+  FNV-1a hash of a parameter name. The search compares most of a name
+  without regard to case, so the hash is of the upper case name
+ */
+uint32_t AP_Param::find_index_hash(const char *name)
+{
+    uint32_t h = 2166136261U;
+    while (*name) {
+        h ^= (uint8_t)toupper(*name++);
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*
+  add an entry to the index, or just count it if the index is not
+  allocated yet
+ */
+uint16_t AP_Param::find_index_add(struct find_index_entry &e, const char *name, uint16_t count)
+{
+    if (_find_index != nullptr) {
+        e.hash = find_index_hash(name);
+        _find_index[count] = e;
+    }
+    return count + 1;
+}
+
+/*
+  add a group whose table is behind a pointer to the list of prefixes
+  the index does not cover, or just count it if the list is not
+  allocated yet
+ */
+uint8_t AP_Param::find_index_add_unindexed(const struct find_index_entry &e, uint8_t count)
+{
+    if (_find_index_unindexed != nullptr) {
+        _find_index_unindexed[count] = e;
+    }
+    return count + 1;
+}
+
+/*
+  add all parameters in a group to the index, following the same
+  naming rules as find_group()
+ */
+uint16_t AP_Param::find_index_add_group(struct find_index_entry &e,
+                                        const struct GroupInfo *group_info,
+                                        char *name,
+                                        uint8_t name_len,
+                                        uint16_t count)
+{
+    const uint8_t level = e.depth;
+    if (level > GroupNesting::numlevels) {
+        return count;
+    }
+    e.depth = level + 1;
+    uint8_t type;
+    for (uint8_t i=0;
+         (type=group_info[i].type) != AP_PARAM_NONE;
+         i++) {
+        const uint8_t len = name_len + strnlen(group_info[i].name, AP_MAX_NAME_SIZE);
+        if (len > AP_MAX_NAME_SIZE) {
+            // find() only looks up names of up to AP_MAX_NAME_SIZE
+            // in the index
+            continue;
+        }
+        strncpy(&name[name_len], group_info[i].name, AP_MAX_NAME_SIZE+1-name_len);
+        e.path[level] = i;
+        e.vec_idx = 0;
+        if (type == AP_PARAM_GROUP) {
+            // group tables found through a pointer can change at
+            // runtime, leave those to the full search
+            if (group_info[i].flags & AP_PARAM_FLAG_INFO_POINTER) {
+                _find_index_unindexed_count = find_index_add_unindexed(e, _find_index_unindexed_count);
+                continue;
+            }
+            count = find_index_add_group(e, group_info[i].group_info, name, len, count);
+            continue;
+        }
+        count = find_index_add(e, name, count);
+        if (type == AP_PARAM_VECTOR3F) {
+            // find_group() also accepts the _X, _Y and _Z elements
+            for (uint8_t v=1; v<=3; v++) {
+                name[len] = '_';
+                name[len+1] = "XYZ"[v-1];
+                name[len+2] = 0;
+                e.vec_idx = v;
+                count = find_index_add(e, name, count);
+            }
+        }
+    }
+    e.path[level] = 0;
+    e.depth = level;
+    return count;
+}
+
+int AP_Param::find_index_compare(const void *a, const void *b)
+{
+    const struct find_index_entry *e1 = (const struct find_index_entry *)a;
+    const struct find_index_entry *e2 = (const struct find_index_entry *)b;
+    if (e1->hash != e2->hash) {
+        return e1->hash < e2->hash ? -1 : 1;
+    }
+    // on a collision keep _var_info[] order so the first match in
+    // the table wins, as with the full search
+    if (e1->vindex != e2->vindex) {
+        return e1->vindex < e2->vindex ? -1 : 1;
+    }
+    int ret = memcmp(e1->path, e2->path, sizeof(e1->path));
+    if (ret != 0) {
+        return ret;
+    }
+    return (int)e1->vec_idx - (int)e2->vec_idx;
+}
+
+/*
+  build the index of all parameter names in _var_info[]. This is
+  called from setup() and load_all(), which run on the main thread
+  before the scheduler starts, and only once for each _var_info[]
+  table, so lookups from other threads never see a partly built index
+ */
+void AP_Param::find_index_build(void)
+{
+    if (_find_index_var_info == _var_info || _var_info == nullptr) {
+        return;
+    }
+
+    // first pass counts the names, second pass fills in the index
+    uint16_t count = 0;
+    for (uint8_t pass=0; pass<2; pass++) {
+        count = 0;
+        _find_index_unindexed_count = 0;
+        for (uint16_t i=0; i<_num_vars; i++) {
+            struct find_index_entry e {};
+            char name[AP_MAX_NAME_SIZE+3];
+            e.vindex = i;
+            strncpy(name, _var_info[i].name, AP_MAX_NAME_SIZE);
+            name[AP_MAX_NAME_SIZE] = 0;
+            if (_var_info[i].type != AP_PARAM_GROUP) {
+                count = find_index_add(e, name, count);
+            } else if (_var_info[i].flags & AP_PARAM_FLAG_INFO_POINTER) {
+                _find_index_unindexed_count = find_index_add_unindexed(e, _find_index_unindexed_count);
+            } else {
+                count = find_index_add_group(e, _var_info[i].group_info, name, strlen(name), count);
+            }
+        }
+        if (pass == 0) {
+            if (count == 0) {
+                return;
+            }
+            _find_index = new find_index_entry[count];
+            if (_find_index == nullptr) {
+                return;
+            }
+            if (_find_index_unindexed_count != 0) {
+                _find_index_unindexed = new find_index_entry[_find_index_unindexed_count];
+                if (_find_index_unindexed == nullptr) {
+                    delete[] _find_index;
+                    _find_index = nullptr;
+                    return;
+                }
+            }
+        }
+    }
+    qsort(_find_index, count, sizeof(_find_index[0]), find_index_compare);
+    _find_index_count = count;
+
+    // record where each bucket of hashes starts, so lookups only need
+    // to scan a handful of entries
+    uint16_t i = 0;
+    for (uint16_t b=0; b<=AP_PARAM_FIND_INDEX_BUCKETS; b++) {
+        while (i < count && find_index_bucket(_find_index[i].hash) < b) {
+            i++;
+        }
+        _find_index_buckets[b] = i;
+    }
+
+    _find_index_var_info = _var_info;
+}
+
+/*
+  check that name matches the next part of a parameter name, and skip
+  past it. The full search compares the name of a top level group
+  with case, and everything else without
+ */
+static bool find_index_match_part(const char *&name, const char *part, bool ignore_case)
+{
+    const size_t len = strnlen(part, AP_MAX_NAME_SIZE);
+    if (ignore_case) {
+        if (strncasecmp(name, part, len) != 0) {
+            return false;
+        }
+    } else if (strncmp(name, part, len) != 0) {
+        return false;
+    }
+    name += len;
+    return true;
+}
+
+/*
+  return the parameter for an index entry if its name is name, or
+  nullptr if the name differs or the parameter is not currently
+  reachable. This accepts exactly the names find_group() accepts
+ */
+AP_Param *AP_Param::find_index_match(const struct find_index_entry &e, const char *name, enum ap_var_type *ptype)
+{
+    const struct Info &info = _var_info[e.vindex];
+    if (e.depth == 0) {
+        ptrdiff_t base;
+        if (strcasecmp(name, info.name) != 0 || !get_base(info, base)) {
+            return nullptr;
+        }
+        *ptype = (enum ap_var_type)info.type;
+        return (AP_Param *)base;
+    }
+
+    if (!find_index_match_part(name, info.name, false)) {
+        return nullptr;
+    }
+    const struct GroupInfo *group_info = info.group_info;
+    ptrdiff_t group_offset = 0;
+    for (uint8_t level=0; level<e.depth-1; level++) {
+        const struct GroupInfo &ginfo = group_info[e.path[level]];
+        if (!find_index_match_part(name, ginfo.name, true) ||
+            !adjust_group_offset(e.vindex, ginfo, group_offset)) {
+            return nullptr;
+        }
+        group_info = ginfo.group_info;
+    }
+
+    ptrdiff_t base;
+    if (!get_base(info, base)) {
+        return nullptr;
+    }
+    const struct GroupInfo &ginfo = group_info[e.path[e.depth-1]];
+    AP_Param *ap = (AP_Param *)(base + ginfo.offset + group_offset);
+    if (e.vec_idx == 0) {
+        if (strcasecmp(name, ginfo.name) != 0) {
+            return nullptr;
+        }
+        *ptype = (enum ap_var_type)ginfo.type;
+        return ap;
+    }
+    // find_group() matches the element suffix of a Vector3f with case
+    if (!find_index_match_part(name, ginfo.name, false) ||
+        name[0] != '_' || name[1] != "XYZ"[e.vec_idx-1] || name[2] != 0) {
+        return nullptr;
+    }
+    *ptype = AP_PARAM_FLOAT;
+    return (AP_Param *)&((AP_Float *)ap)[e.vec_idx-1];
+}
+
+/*
+  return true if name could be a parameter in one of the groups left
+  out of the index because their table is behind a pointer
+ */
+bool AP_Param::find_index_unindexed(const char *name)
+{
+    for (uint8_t i=0; i<_find_index_unindexed_count; i++) {
+        const struct find_index_entry &e = _find_index_unindexed[i];
+        const char *p = name;
+        if (!find_index_match_part(p, _var_info[e.vindex].name, false)) {
+            continue;
+        }
+        const struct GroupInfo *group_info = _var_info[e.vindex].group_info;
+        uint8_t level;
+        for (level=0; level<e.depth; level++) {
+            const struct GroupInfo &ginfo = group_info[e.path[level]];
+            if (!find_index_match_part(p, ginfo.name, true)) {
+                break;
+            }
+            group_info = ginfo.group_info;
+        }
+        if (level == e.depth) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  return the parameter for an index entry without checking its name,
+  or nullptr if it is not currently reachable
+ */
+AP_Param *AP_Param::find_index_object(const struct find_index_entry &e, enum ap_var_type *ptype)
+{
+    const struct Info &info = _var_info[e.vindex];
+    ptrdiff_t base;
+    if (!get_base(info, base)) {
+        return nullptr;
+    }
+    if (e.depth == 0) {
+        *ptype = (enum ap_var_type)info.type;
+        return (AP_Param *)base;
+    }
+
+    const struct GroupInfo *group_info = info.group_info;
+    ptrdiff_t group_offset = 0;
+    for (uint8_t level=0; level<e.depth-1; level++) {
+        const struct GroupInfo &ginfo = group_info[e.path[level]];
+        if (!adjust_group_offset(e.vindex, ginfo, group_offset)) {
+            return nullptr;
+        }
+        group_info = ginfo.group_info;
+    }
+
+    const struct GroupInfo &ginfo = group_info[e.path[e.depth-1]];
+    AP_Param *ap = (AP_Param *)(base + ginfo.offset + group_offset);
+    if (e.vec_idx == 0) {
+        *ptype = (enum ap_var_type)ginfo.type;
+        return ap;
+    }
+    *ptype = AP_PARAM_FLOAT;
+    return (AP_Param *)&((AP_Float *)ap)[e.vec_idx-1];
+}
+
+/*
+  search the name index, returning the position in _find_index[] of
+  the entry for name, or -1 if the index has no reachable parameter of
+  that name. The caller checks the index is current
+ */
+int32_t AP_Param::find_index_search(const char *name, enum ap_var_type *ptype, AP_Param *&ap)
+{
+    const uint32_t hash = find_index_hash(name);
+    const uint16_t b = find_index_bucket(hash);
+
+    for (uint16_t i=_find_index_buckets[b]; i<_find_index_buckets[b+1]; i++) {
+        if (_find_index[i].hash != hash) {
+            continue;
+        }
+        ap = find_index_match(_find_index[i], name, ptype);
+        if (ap != nullptr) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+  find a parameter using the name index. Returns false if the index
+  can't answer for this name and the full search is needed
+ */
+bool AP_Param::find_indexed(const char *name, enum ap_var_type *ptype, AP_Param *&ap)
+{
+    ap = nullptr;
+    if (_find_index_var_info != _var_info ||
+        strnlen(name, AP_MAX_NAME_SIZE+1) > AP_MAX_NAME_SIZE) {
+        return false;
+    }
+    if (find_index_search(name, ptype, ap) >= 0) {
+        return true;
+    }
+    // every name the full search accepts is in the index except
+    // those in groups with a table behind a pointer, so otherwise a
+    // miss is a miss
+    return !find_index_unindexed(name);
+}
+#endif // AP_PARAM_FIND_INDEX
+
 // Find a variable by index. Note that this is quite slow.
 //
 AP_Param *
@@ -1252,10 +1643,32 @@ void AP_Param::setup_sketch_defaults(void)
 //
 bool AP_Param::load_all(bool check_defaults_file)
 {
+    static AP_HAL::Util::perf_counter_t perf_load_all = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "param_load_all");
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+    bool ret = false;
 
-    reload_defaults_file(check_defaults_file);
+    hal.util->perf_begin(perf_load_all);
+
+#if AP_PARAM_FIND_INDEX
+    // the defaults file is applied with find()
+    find_index_build();
+#endif
+
+    // everything configured in storage is overwritten by the loop
+    // below, so the defaults can be applied without checking storage
+    // for each of them
+    load_defaults(check_defaults_file, false);
+
+    // map from storage key to _var_info[] index, so each stored
+    // variable can be matched without walking _var_info[]
+    uint16_t *key_index = new uint16_t[_sentinal_key+1];
+    if (key_index != nullptr) {
+        memset(key_index, 0xFF, sizeof(key_index[0]) * (_sentinal_key+1));
+        for (uint16_t i=0; i<_num_vars; i++) {
+            key_index[_var_info[i].key] = i;
+        }
+    }
 
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
@@ -1263,13 +1676,14 @@ bool AP_Param::load_all(bool check_defaults_file)
         // against power off while adding a variable
         if (is_sentinal(phdr)) {
             // we've reached the sentinal
-            return true;
+            ret = true;
+            break;
         }
 
         const struct AP_Param::Info *info;
         void *ptr;
 
-        info = find_by_header(phdr, &ptr);
+        info = find_by_header(phdr, &ptr, key_index);
         if (info != nullptr) {
             _storage.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
         }
@@ -1277,15 +1691,30 @@ bool AP_Param::load_all(bool check_defaults_file)
         ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
     }
 
-    // we didn't find the sentinal
-    Debug("no sentinal in load_all");
-    return false;
+    delete[] key_index;
+    hal.util->perf_end(perf_load_all);
+
+    if (!ret) {
+        // we didn't find the sentinal
+        Debug("no sentinal in load_all");
+    }
+    return ret;
 }
 
 /*
   reload from hal.util defaults file
  */
 void AP_Param::reload_defaults_file(bool panic_on_error)
+{
+    load_defaults(panic_on_error, true);
+}
+
+/*
+  load the hal.util defaults file. If check_storage is false the
+  defaults are applied to all variables, including those configured
+  in storage
+ */
+void AP_Param::load_defaults(bool panic_on_error, bool check_storage)
 {
 #if HAL_OS_POSIX_IO == 1
     /*
@@ -1294,11 +1723,14 @@ void AP_Param::reload_defaults_file(bool panic_on_error)
      */
     const char *default_file = hal.util->get_custom_defaults_file();
     if (default_file) {
-        if (load_defaults_file(default_file, panic_on_error)) {
+        static AP_HAL::Util::perf_counter_t perf_defaults = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "param_defaults");
+        hal.util->perf_begin(perf_defaults);
+        if (load_defaults_file(default_file, panic_on_error, check_storage)) {
             printf("Loaded defaults from %s\n", default_file);
         } else {
             printf("Failed to load defaults from %s\n", default_file);
         }
+        hal.util->perf_end(perf_defaults);
     }
 #endif
 }
@@ -1809,8 +2241,8 @@ bool AP_Param::parse_param_line(char *line, char **vname, float &value)
     return true;
 }
 
-// increments num_defaults for each default found in filename
-bool AP_Param::count_defaults_in_file(const char *filename, uint16_t &num_defaults, bool panic_on_error)
+// increments num_lines for each line that could hold a default in filename
+bool AP_Param::count_defaults_in_file(const char *filename, uint16_t &num_lines)
 {
     FILE *f = fopen(filename, "r");
     if (f == nullptr) {
@@ -1819,7 +2251,8 @@ bool AP_Param::count_defaults_in_file(const char *filename, uint16_t &num_defaul
     char line[100];
 
     /*
-      work out how many parameter default structures to allocate
+      work out how many parameter default structures to allocate. The
+      names are only looked up once, by read_param_defaults_file()
      */
     while (fgets(line, sizeof(line)-1, f)) {
         char *pname;
@@ -1827,25 +2260,48 @@ bool AP_Param::count_defaults_in_file(const char *filename, uint16_t &num_defaul
         if (!parse_param_line(line, &pname, value)) {
             continue;
         }
-        enum ap_var_type var_type;
-        if (!find(pname, &var_type)) {
-            if (panic_on_error) {
-                fclose(f);
-                ::printf("invalid param %s in defaults file\n", pname);
-                AP_HAL::panic("AP_Param: Invalid param in defaults file");
-                return false;
-            } else {
-                continue;
-            }
-        }
-        num_defaults++;
+        num_lines++;
     }
     fclose(f);
 
     return true;
 }
 
-bool AP_Param::read_param_defaults_file(const char *filename)
+/*
+  add an override to param_overrides[], which is kept sorted by
+  object pointer for get_default_value(). If a parameter is given more
+  than once the first value is the default, as before
+ */
+void AP_Param::add_param_override(const AP_Param *vp, float value)
+{
+    const uint16_t lo = param_override_index(vp);
+    if (lo < num_param_overrides && param_overrides[lo].object_ptr == vp) {
+        return;
+    }
+    memmove(&param_overrides[lo+1], &param_overrides[lo],
+            (num_param_overrides - lo) * sizeof(param_overrides[0]));
+    param_overrides[lo].object_ptr = vp;
+    param_overrides[lo].value = value;
+    num_param_overrides++;
+}
+
+/*
+  apply one default, recording it as the default for get_default_value()
+ */
+void AP_Param::apply_default(AP_Param *vp, enum ap_var_type var_type, float value,
+                             uint16_t max_defaults, bool check_storage)
+{
+    if (num_param_overrides < max_defaults) {
+        add_param_override(vp, value);
+    }
+    if (!check_storage || !vp->configured_in_storage()) {
+        vp->set_float(value, var_type);
+    }
+}
+
+bool AP_Param::read_param_defaults_file(const char *filename, uint16_t max_defaults,
+                                        bool panic_on_error, bool check_storage,
+                                        struct defaults_cache *cache)
 {
     FILE *f = fopen(filename, "r");
     if (f == nullptr) {
@@ -1853,7 +2309,6 @@ bool AP_Param::read_param_defaults_file(const char *filename)
         return false;
     }
 
-    uint16_t idx = 0;
     char line[100];
     while (fgets(line, sizeof(line)-1, f)) {
         char *pname;
@@ -1864,14 +2319,25 @@ bool AP_Param::read_param_defaults_file(const char *filename)
         enum ap_var_type var_type;
         AP_Param *vp = find(pname, &var_type);
         if (!vp) {
+            if (panic_on_error) {
+                fclose(f);
+                ::printf("invalid param %s in defaults file\n", pname);
+                AP_HAL::panic("AP_Param: Invalid param in defaults file");
+                return false;
+            }
+#if AP_PARAM_DEFAULTS_CACHE
+            if (cache != nullptr) {
+                cache->valid = false;
+            }
+#endif
             continue;
         }
-        param_overrides[idx].object_ptr = vp;
-        param_overrides[idx].value = value;
-        idx++;
-        if (!vp->configured_in_storage()) {
-            vp->set_float(value, var_type);
+#if AP_PARAM_DEFAULTS_CACHE
+        if (cache != nullptr) {
+            defaults_cache_add(*cache, pname, value);
         }
+#endif
+        apply_default(vp, var_type, value, max_defaults, check_storage);
     }
     fclose(f);
     return true;
@@ -1880,12 +2346,20 @@ bool AP_Param::read_param_defaults_file(const char *filename)
 /*
   load a default set of parameters from a file
  */
-bool AP_Param::load_defaults_file(const char *filename, bool panic_on_error)
+bool AP_Param::load_defaults_file(const char *filename, bool panic_on_error, bool check_storage)
 {
     if (filename == nullptr) {
         return false;
     }
 
+#if AP_PARAM_DEFAULTS_CACHE
+    uint64_t cache_key;
+    const bool have_cache_key = defaults_cache_key(filename, cache_key);
+    if (have_cache_key && load_defaults_cache(filename, cache_key, check_storage)) {
+        return true;
+    }
+#endif
+
     char *mutable_filename = strdup(filename);
     if (mutable_filename == nullptr) {
         AP_HAL::panic("AP_Param: Failed to allocate mutable string");
@@ -1896,16 +2370,14 @@ bool AP_Param::load_defaults_file(const char *filename, bool panic_on_error)
     for (char *pname = strtok_r(mutable_filename, ",", &saveptr);
          pname != nullptr;
          pname = strtok_r(nullptr, ",", &saveptr)) {
-        if (!count_defaults_in_file(pname, num_defaults, panic_on_error)) {
+        if (!count_defaults_in_file(pname, num_defaults)) {
             free(mutable_filename);
             return false;
         }
     }
     free(mutable_filename);
 
-    if (param_overrides != nullptr) {
-        free(param_overrides);
-    }
+    delete[] param_overrides;
     num_param_overrides = 0;
 
     param_overrides = new param_override[num_defaults];
@@ -1914,37 +2386,270 @@ bool AP_Param::load_defaults_file(const char *filename, bool panic_on_error)
         return false;
     }
 
+    struct defaults_cache *cache = nullptr;
+#if AP_PARAM_DEFAULTS_CACHE
+    struct defaults_cache new_cache {};
+    if (have_cache_key) {
+        new_cache.entries = new defaults_cache_entry[num_defaults];
+        new_cache.size = num_defaults;
+        new_cache.valid = new_cache.entries != nullptr;
+        cache = &new_cache;
+    }
+#endif
+
     saveptr = nullptr;
     mutable_filename = strdup(filename);
     if (mutable_filename == nullptr) {
         AP_HAL::panic("AP_Param: Failed to allocate mutable string");
     }
+    bool ret = true;
     for (char *pname = strtok_r(mutable_filename, ",", &saveptr);
          pname != nullptr;
          pname = strtok_r(nullptr, ",", &saveptr)) {
-        if (!read_param_defaults_file(pname)) {
-            free(mutable_filename);
-            return false;
+        if (!read_param_defaults_file(pname, num_defaults, panic_on_error, check_storage, cache)) {
+            ret = false;
+            break;
         }
     }
     free(mutable_filename);
 
-    num_param_overrides = num_defaults;
+#if AP_PARAM_DEFAULTS_CACHE
+    // a file changed while it was read is cached on the next boot
+    uint64_t new_key;
+    if (ret && new_cache.valid &&
+        defaults_cache_key(filename, new_key) && new_key == cache_key) {
+        save_defaults_cache(filename, cache_key, new_cache);
+    }
+    delete[] new_cache.entries;
+#endif
+
+    return ret;
+}
+
+#if AP_PARAM_DEFAULTS_CACHE
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DEFAULTS_CACHE_MAGIC   0x43445041 // "APDC"
+#define DEFAULTS_CACHE_VERSION 1
+
+/*
+  64 bit FNV-1a hash, for the defaults cache key
+ */
+static void defaults_cache_hash(uint64_t &h, const void *data, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)data;
+    while (len--) {
+        h ^= *b++;
+        h *= 1099511628211ULL;
+    }
+}
+
+/*
+  work out the key for the defaults cache from the find() index, which
+  changes with the names in _var_info[], and from the names, sizes,
+  inodes and modification times of the defaults files. Returns false
+  if the defaults can't be cached
+ */
+bool AP_Param::defaults_cache_key(const char *filename, uint64_t &key)
+{
+    if (_find_index_var_info != _var_info || _find_index == nullptr) {
+        return false;
+    }
+    key = 14695981039346656037ULL;
+    for (uint16_t i=0; i<_find_index_count; i++) {
+        const struct find_index_entry &e = _find_index[i];
+        const uint8_t bits = e.depth | (e.vec_idx << 4);
+        defaults_cache_hash(key, &e.hash, sizeof(e.hash));
+        defaults_cache_hash(key, &e.vindex, sizeof(e.vindex));
+        defaults_cache_hash(key, e.path, sizeof(e.path));
+        defaults_cache_hash(key, &bits, sizeof(bits));
+    }
+    defaults_cache_hash(key, filename, strlen(filename));
 
+    char *mutable_filename = strdup(filename);
+    if (mutable_filename == nullptr) {
+        return false;
+    }
+    bool ret = true;
+    char *saveptr = nullptr;
+    for (char *pname = strtok_r(mutable_filename, ",", &saveptr);
+         pname != nullptr;
+         pname = strtok_r(nullptr, ",", &saveptr)) {
+        struct stat st;
+        if (stat(pname, &st) != 0) {
+            ret = false;
+            break;
+        }
+        const uint64_t file_id[] = { (uint64_t)st.st_size, (uint64_t)st.st_ino, (uint64_t)st.st_mtime };
+        defaults_cache_hash(key, file_id, sizeof(file_id));
+    }
+    free(mutable_filename);
+    return ret;
+}
+
+/*
+  the cache is kept next to the first defaults file
+ */
+char *AP_Param::defaults_cache_path(const char *filename)
+{
+    const size_t len = strcspn(filename, ",");
+    char *path = nullptr;
+    if (asprintf(&path, "%.*s.cache", (int)len, filename) <= 0) {
+        return nullptr;
+    }
+    return path;
+}
+
+/*
+  add a parsed defaults file line to a new cache
+ */
+void AP_Param::defaults_cache_add(struct defaults_cache &cache, const char *name, float value)
+{
+    if (!cache.valid) {
+        return;
+    }
+    if (cache.count >= cache.size) {
+        // the file grew since it was counted
+        cache.valid = false;
+        return;
+    }
+    enum ap_var_type var_type;
+    AP_Param *ap;
+    const int32_t index = find_index_search(name, &var_type, ap);
+    if (index < 0) {
+        // only found by the full search, so it can't be cached
+        cache.valid = false;
+        return;
+    }
+    cache.entries[cache.count].index = index;
+    cache.entries[cache.count].value = value;
+    cache.count++;
+}
+
+/*
+  apply the defaults from the cache if it matches key. Returns false,
+  having changed nothing, if the defaults file has to be parsed
+ */
+bool AP_Param::load_defaults_cache(const char *filename, uint64_t key, bool check_storage)
+{
+    char *path = defaults_cache_path(filename);
+    if (path == nullptr) {
+        return false;
+    }
+    FILE *f = fopen(path, "rb");
+    free(path);
+    if (f == nullptr) {
+        return false;
+    }
+    struct defaults_cache_header hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        hdr.magic != DEFAULTS_CACHE_MAGIC ||
+        hdr.version != DEFAULTS_CACHE_VERSION ||
+        hdr.key != key) {
+        fclose(f);
+        return false;
+    }
+    struct defaults_cache_entry *entries = new defaults_cache_entry[hdr.num_entries];
+    if (entries == nullptr) {
+        fclose(f);
+        return false;
+    }
+    bool ok = fread(entries, sizeof(entries[0]), hdr.num_entries, f) == hdr.num_entries;
+    fclose(f);
+
+    // every parameter must be reachable before any is changed, so a
+    // miss leaves the defaults file to give the same result as before
+    for (uint16_t i=0; ok && i<hdr.num_entries; i++) {
+        enum ap_var_type var_type;
+        ok = entries[i].index < _find_index_count &&
+            find_index_object(_find_index[entries[i].index], &var_type) != nullptr;
+    }
+    if (!ok) {
+        delete[] entries;
+        return false;
+    }
+
+    delete[] param_overrides;
+    num_param_overrides = 0;
+    param_overrides = new param_override[hdr.num_entries];
+    if (param_overrides == nullptr) {
+        AP_HAL::panic("AP_Param: Failed to allocate overrides");
+    }
+    for (uint16_t i=0; i<hdr.num_entries; i++) {
+        enum ap_var_type var_type;
+        AP_Param *vp = find_index_object(_find_index[entries[i].index], &var_type);
+        apply_default(vp, var_type, entries[i].value, hdr.num_entries, check_storage);
+    }
+    delete[] entries;
     return true;
 }
 
+/*
+  write the cache for the parsed defaults file. It is written to a
+  temporary file and renamed over the old cache, so a cache that is
+  read is always complete. Failing to write it only costs the next
+  boot a parse
+ */
+void AP_Param::save_defaults_cache(const char *filename, uint64_t key, const struct defaults_cache &cache)
+{
+    char *path = defaults_cache_path(filename);
+    if (path == nullptr) {
+        return;
+    }
+    char *tmp_path = nullptr;
+    if (asprintf(&tmp_path, "%s.tmp", path) <= 0) {
+        free(path);
+        return;
+    }
+    FILE *f = fopen(tmp_path, "wb");
+    if (f != nullptr) {
+        struct defaults_cache_header hdr {};
+        hdr.magic = DEFAULTS_CACHE_MAGIC;
+        hdr.version = DEFAULTS_CACHE_VERSION;
+        hdr.num_entries = cache.count;
+        hdr.key = key;
+        bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+            fwrite(cache.entries, sizeof(cache.entries[0]), cache.count, f) == cache.count;
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || rename(tmp_path, path) != 0) {
+            unlink(tmp_path);
+        }
+    }
+    free(tmp_path);
+    free(path);
+}
+#endif // AP_PARAM_DEFAULTS_CACHE
+
 #endif // HAL_OS_POSIX_IO
 
+/*
+  return the index of the first entry in param_overrides[] whose
+  object pointer is not less than vp
+ */
+uint16_t AP_Param::param_override_index(const AP_Param *vp)
+{
+    // param_overrides[] is sorted by object pointer
+    uint16_t lo = 0, hi = num_param_overrides;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (param_overrides[mid].object_ptr < vp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
 /* 
    find a default value given a pointer to a default value in flash
  */
 float AP_Param::get_default_value(const AP_Param *vp, const float *def_value_ptr)
 {
-    for (uint16_t i=0; i<num_param_overrides; i++) {
-        if (vp == param_overrides[i].object_ptr) {
-            return param_overrides[i].value;
-        }
+    const uint16_t lo = param_override_index(vp);
+    if (lo < num_param_overrides && param_overrides[lo].object_ptr == vp) {
+        return param_overrides[lo].value;
     }
     return *def_value_ptr;
 }
@@ -31,6 +31,20 @@
 
 #define AP_MAX_NAME_SIZE 16
 
+// keep a sorted index of parameter names to speed up find()
+#ifndef AP_PARAM_FIND_INDEX
+#define AP_PARAM_FIND_INDEX !HAL_MINIMIZE_FEATURES
+#endif
+#define AP_PARAM_FIND_INDEX_BUCKET_BITS 8
+#define AP_PARAM_FIND_INDEX_BUCKETS (1U<<AP_PARAM_FIND_INDEX_BUCKET_BITS)
+
+// keep the parsed defaults file in a binary cache next to it, so later
+// boots skip parsing and name lookups. Entries refer to the find()
+// index, so this needs it
+#ifndef AP_PARAM_DEFAULTS_CACHE
+#define AP_PARAM_DEFAULTS_CACHE (AP_PARAM_FIND_INDEX && (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL))
+#endif
+
 /*
   flags for variables in var_info and group tables
  */
@@ -233,6 +247,13 @@ public:
     ///
     static AP_Param * find(const char *name, enum ap_var_type *ptype);
 
+#if AP_PARAM_FIND_INDEX
+    /// Build the name index used by find(). setup() and load_all()
+    /// call this, so only code that uses neither needs to
+    ///
+    static void find_index_build(void);
+#endif
+
     /// set a default value by name
     ///
     /// @param  name            The full name of the variable to be found.
@@ -486,7 +507,8 @@ private:
                                     ptrdiff_t group_offset);
     static const struct Info *  find_by_header(
                                     struct Param_header phdr,
-                                    void **ptr);
+                                    void **ptr,
+                                    const uint16_t *key_index = nullptr);
     void                        add_vector3f_suffix(
                                     char *buffer,
                                     size_t buffer_size,
@@ -497,6 +519,48 @@ private:
                                     ptrdiff_t group_offset,
                                     const struct GroupInfo *group_info,
                                     enum ap_var_type *ptype);
+#if AP_PARAM_FIND_INDEX
+    /*
+      an entry in the find() index. Rather than a pointer this holds
+      the path through _var_info[] and the group tables, so pointer
+      groups are resolved at lookup time
+     */
+    struct find_index_entry {
+        uint32_t hash;      // hash of the full parameter name
+        uint16_t vindex;    // index in _var_info[]
+        uint8_t path[GroupNesting::numlevels+1]; // group_info[] index at each level
+        uint8_t depth:4;    // number of valid entries in path
+        uint8_t vec_idx:4;  // 1 to 3 for the _X, _Y and _Z elements of a Vector3f
+    };
+    static uint32_t             find_index_hash(const char *name);
+    static uint16_t             find_index_bucket(uint32_t hash) {
+        return hash >> (32 - AP_PARAM_FIND_INDEX_BUCKET_BITS);
+    }
+    static uint16_t             find_index_add_group(
+                                    struct find_index_entry &e,
+                                    const struct GroupInfo *group_info,
+                                    char *name,
+                                    uint8_t name_len,
+                                    uint16_t count);
+    static uint16_t             find_index_add(
+                                    struct find_index_entry &e,
+                                    const char *name,
+                                    uint16_t count);
+    static uint8_t              find_index_add_unindexed(
+                                    const struct find_index_entry &e,
+                                    uint8_t count);
+    static AP_Param *           find_index_match(
+                                    const struct find_index_entry &e,
+                                    const char *name,
+                                    enum ap_var_type *ptype);
+    static bool                 find_index_unindexed(const char *name);
+    static bool                 find_indexed(const char *name, enum ap_var_type *ptype, AP_Param *&ap);
+    static int32_t              find_index_search(const char *name, enum ap_var_type *ptype, AP_Param *&ap);
+    static AP_Param *           find_index_object(
+                                    const struct find_index_entry &e,
+                                    enum ap_var_type *ptype);
+    static int                  find_index_compare(const void *a, const void *b);
+#endif
     static void                 write_sentinal(uint16_t ofs);
     static uint16_t             get_key(const Param_header &phdr);
     static void                 set_key(Param_header &phdr, uint16_t key);
@@ -523,19 +587,70 @@ private:
     static float get_default_value(const AP_Param *object_ptr, const float *def_value_ptr);
 
 #if HAL_OS_POSIX_IO == 1
+#if AP_PARAM_DEFAULTS_CACHE
+    /*
+      the defaults file as it is kept in the defaults cache. Each line
+      is the position of the parameter in _find_index[] and its value,
+      in file order. The cache is only used if its key matches the
+      find() index, the defaults file names and each file's size,
+      inode and modification time
+     */
+    struct defaults_cache_entry {
+        uint16_t index;
+        float value;
+    };
+    struct defaults_cache_header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t num_entries;
+        uint64_t key;
+    };
+    struct defaults_cache {
+        struct defaults_cache_entry *entries;
+        uint16_t size;
+        uint16_t count;
+        // false once a line can't be found through the index
+        bool valid;
+    };
+    static bool defaults_cache_key(const char *filename, uint64_t &key);
+    static char *defaults_cache_path(const char *filename);
+    static bool load_defaults_cache(const char *filename, uint64_t key, bool check_storage);
+    static void save_defaults_cache(const char *filename, uint64_t key, const struct defaults_cache &cache);
+    static void defaults_cache_add(struct defaults_cache &cache, const char *name, float value);
+#else
+    struct defaults_cache;
+#endif
+
     /*
       load a parameter defaults file. This happens as part of load_all()
      */
     static bool parse_param_line(char *line, char **vname, float &value);
-    static bool count_defaults_in_file(const char *filename, uint16_t &num_defaults, bool panic_on_error);
-    static bool read_param_defaults_file(const char *filename);
-    static bool load_defaults_file(const char *filename, bool panic_on_error);
+    static bool count_defaults_in_file(const char *filename, uint16_t &num_lines);
+    static bool read_param_defaults_file(const char *filename, uint16_t max_defaults,
+                                         bool panic_on_error, bool check_storage,
+                                         struct defaults_cache *cache);
+    static bool load_defaults_file(const char *filename, bool panic_on_error, bool check_storage);
+    static void add_param_override(const AP_Param *vp, float value);
+    static void apply_default(AP_Param *vp, enum ap_var_type var_type, float value,
+                              uint16_t max_defaults, bool check_storage);
 #endif
+    static void load_defaults(bool panic_on_error, bool check_storage);
+    static uint16_t param_override_index(const AP_Param *vp);
     
     // send a parameter to all GCS instances
     void send_parameter(const char *name, enum ap_var_type param_header_type, uint8_t idx) const;
     
     static StorageAccess        _storage;
+#if AP_PARAM_FIND_INDEX
+    static struct find_index_entry *_find_index;
+    static uint16_t             _find_index_count;
+    // start of each range of hash values in _find_index
+    static uint16_t             _find_index_buckets[AP_PARAM_FIND_INDEX_BUCKETS+1];
+    // groups with a table behind a pointer, which are not in the index
+    static struct find_index_entry *_find_index_unindexed;
+    static uint8_t              _find_index_unindexed_count;
+    static const struct Info *  _find_index_var_info;
+#endif
     static uint16_t             _num_vars;
     static uint16_t             _parameter_count;
     static const struct Info *  _var_info;
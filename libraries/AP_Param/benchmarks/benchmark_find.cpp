@@ -0,0 +1,157 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  AP_Param::find() over a parameter tree of roughly the size of
+  ArduPlane's (about 1600 names), using the same group features the
+  vehicles use: plain, nested and pointer subgroups and Vector3f
+  elements. Build with AP_PARAM_FIND_INDEX=0 to time the full search
+ */
+
+class BenchLeaf {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Float p[8];
+    AP_Int8 enable;
+    AP_Vector3f ofs;
+};
+
+#define LEAF_PARAM(n) AP_GROUPINFO("P" #n, n, BenchLeaf, p[n], 0)
+
+const AP_Param::GroupInfo BenchLeaf::var_info[] = {
+    LEAF_PARAM(0), LEAF_PARAM(1), LEAF_PARAM(2), LEAF_PARAM(3),
+    LEAF_PARAM(4), LEAF_PARAM(5), LEAF_PARAM(6), LEAF_PARAM(7),
+    AP_GROUPINFO("ENABLE", 8, BenchLeaf, enable, 0),
+    AP_GROUPINFO("OFS", 9, BenchLeaf, ofs, 0),
+    AP_GROUPEND
+};
+
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Float p[16];
+    BenchLeaf leaf;
+    BenchLeaf *leaf_ptr;
+};
+
+#define GROUP_PARAM(n) AP_GROUPINFO("PARAM" #n, n, BenchGroup, p[n], 0)
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    GROUP_PARAM(0), GROUP_PARAM(1), GROUP_PARAM(2), GROUP_PARAM(3),
+    GROUP_PARAM(4), GROUP_PARAM(5), GROUP_PARAM(6), GROUP_PARAM(7),
+    GROUP_PARAM(8), GROUP_PARAM(9), GROUP_PARAM(10), GROUP_PARAM(11),
+    GROUP_PARAM(12), GROUP_PARAM(13), GROUP_PARAM(14), GROUP_PARAM(15),
+    AP_SUBGROUPINFO(leaf, "L_", 16, BenchGroup, BenchLeaf),
+    AP_SUBGROUPPTR(leaf_ptr, "Q_", 17, BenchGroup, BenchLeaf),
+    AP_GROUPEND
+};
+
+#define BENCH_NUM_GROUPS 40
+
+static AP_Int16 format_version;
+static AP_Float scalars[4];
+static BenchGroup groups[BENCH_NUM_GROUPS];
+static BenchLeaf leaves[BENCH_NUM_GROUPS];
+
+#define BENCH_SCALAR(n) { AP_PARAM_FLOAT, "SCALAR" #n, n+1, &scalars[n], { def_value : 0 }, 0 }
+#define BENCH_GROUP(n) { AP_PARAM_GROUP, "G" #n "_", n+10, &groups[n], { group_info : BenchGroup::var_info }, 0 }
+
+static const AP_Param::Info var_info[] = {
+    { AP_PARAM_INT16, "FORMAT_VERSION", 0, &format_version, { def_value : 0 }, 0 },
+    BENCH_SCALAR(0), BENCH_SCALAR(1), BENCH_SCALAR(2), BENCH_SCALAR(3),
+    BENCH_GROUP(0), BENCH_GROUP(1), BENCH_GROUP(2), BENCH_GROUP(3),
+    BENCH_GROUP(4), BENCH_GROUP(5), BENCH_GROUP(6), BENCH_GROUP(7),
+    BENCH_GROUP(8), BENCH_GROUP(9), BENCH_GROUP(10), BENCH_GROUP(11),
+    BENCH_GROUP(12), BENCH_GROUP(13), BENCH_GROUP(14), BENCH_GROUP(15),
+    BENCH_GROUP(16), BENCH_GROUP(17), BENCH_GROUP(18), BENCH_GROUP(19),
+    BENCH_GROUP(20), BENCH_GROUP(21), BENCH_GROUP(22), BENCH_GROUP(23),
+    BENCH_GROUP(24), BENCH_GROUP(25), BENCH_GROUP(26), BENCH_GROUP(27),
+    BENCH_GROUP(28), BENCH_GROUP(29), BENCH_GROUP(30), BENCH_GROUP(31),
+    BENCH_GROUP(32), BENCH_GROUP(33), BENCH_GROUP(34), BENCH_GROUP(35),
+    BENCH_GROUP(36), BENCH_GROUP(37), BENCH_GROUP(38), BENCH_GROUP(39),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+static void setup_pointers(void)
+{
+    for (uint8_t i=0; i<BENCH_NUM_GROUPS; i++) {
+        groups[i].leaf_ptr = &leaves[i];
+    }
+#if AP_PARAM_FIND_INDEX
+    AP_Param::find_index_build();
+#endif
+}
+
+static void BM_FindFirst(benchmark::State& state)
+{
+    enum ap_var_type ptype;
+
+    setup_pointers();
+    while (state.KeepRunning()) {
+        AP_Param *ap = AP_Param::find("SCALAR0", &ptype);
+        gbenchmark_escape(ap);
+    }
+}
+
+static void BM_FindLast(benchmark::State& state)
+{
+    enum ap_var_type ptype;
+
+    setup_pointers();
+    while (state.KeepRunning()) {
+        AP_Param *ap = AP_Param::find("G39_Q_OFS_Z", &ptype);
+        gbenchmark_escape(ap);
+    }
+}
+
+static void BM_FindMissing(benchmark::State& state)
+{
+    enum ap_var_type ptype;
+
+    setup_pointers();
+    while (state.KeepRunning()) {
+        AP_Param *ap = AP_Param::find("G39_NO_SUCH", &ptype);
+        gbenchmark_escape(ap);
+    }
+}
+
+/*
+  look up every parameter in turn, as a full parameter upload from a
+  GCS does
+ */
+static void BM_FindAll(benchmark::State& state)
+{
+    AP_Param::ParamToken token;
+    enum ap_var_type ptype;
+    char names[2000][AP_MAX_NAME_SIZE+1];
+    uint16_t count = 0;
+
+    setup_pointers();
+    for (AP_Param *ap = AP_Param::first(&token, &ptype);
+         ap != nullptr && count < ARRAY_SIZE(names);
+         ap = AP_Param::next_scalar(&token, &ptype)) {
+        ap->copy_name_token(token, names[count++], sizeof(names[0]), true);
+    }
+
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<count; i++) {
+            AP_Param *ap = AP_Param::find(names[i], &ptype);
+            gbenchmark_escape(ap);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(BM_FindFirst);
+BENCHMARK(BM_FindLast);
+BENCHMARK(BM_FindMissing);
+BENCHMARK(BM_FindAll);
+
+BENCHMARK_MAIN()
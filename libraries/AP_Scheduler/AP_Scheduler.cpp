@@ -23,8 +23,13 @@
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_Vehicle/AP_Vehicle.h>
+#include <DataFlash/DataFlash.h>
 #include <stdio.h>
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <AP_HAL_Linux/Scheduler.h>
+#endif
+
 #if APM_BUILD_TYPE(APM_BUILD_ArduCopter) || APM_BUILD_TYPE(APM_BUILD_ArduSub)
 #define SCHEDULER_DEFAULT_LOOP_RATE 400
 #else
@@ -35,6 +40,8 @@ extern const AP_HAL::HAL& hal;
 
 int8_t AP_Scheduler::current_task = -1;
 
+AP_Scheduler *AP_Scheduler::_s_instance = nullptr;
+
 const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @Param: DEBUG
     // @DisplayName: Scheduler debug level
@@ -51,6 +58,30 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("LOOP_RATE",  1, AP_Scheduler, _loop_rate_hz, SCHEDULER_DEFAULT_LOOP_RATE),
 
+    // @Param: PROFILE
+    // @DisplayName: Scheduler task profiling
+    // @Description: When enabled the scheduler keeps runtime, overrun and slip statistics for every task. These are logged in the SCHD message when performance logging is enabled. This only takes effect on restart
+    // @Values: 0:Disabled,1:Enabled
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("PROFILE",  2, AP_Scheduler, _profile, 1),
+
+    // @Param: ADAPTIVE
+    // @DisplayName: Adaptive task scheduling
+    // @Description: When enabled the scheduler learns how long each task really takes and admits tasks against that instead of the worst case in the task table. Due tasks are run most starved first, relative to their rate, so that under load slow tasks lose rate evenly instead of tasks late in the table missing out. This only takes effect on restart
+    // @Values: 0:Disabled,1:Enabled
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("ADAPTIVE",  3, AP_Scheduler, _adaptive, 0),
+
+    // @Param: ASYNC
+    // @DisplayName: Asynchronous tasks
+    // @Description: When enabled, tasks which the vehicle marks as safe to run off the main thread are run on a small pool of worker threads, on boards which support it. This keeps their runtime off the attitude control path on multi-core boards. This only takes effect on restart
+    // @Values: 0:Disabled,1:Enabled
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("ASYNC",  4, AP_Scheduler, _async, 0),
+
     AP_GROUPEND
 };
 
@@ -66,6 +97,8 @@ AP_Scheduler::AP_Scheduler(void)
     } else if (_loop_rate_hz > 400) {
         _loop_rate_hz.set(400);
     }
+
+    _s_instance = this;
 }
 
 // initialise the scheduler
@@ -76,6 +109,161 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks)
     _last_run = new uint16_t[_num_tasks];
     memset(_last_run, 0, sizeof(_last_run[0]) * _num_tasks);
     _tick_counter = 0;
+
+    if (_profile) {
+        _task_stats = new TaskStats[_num_tasks];
+        if (_task_stats != nullptr) {
+            reset_task_stats();
+        }
+    }
+
+    if (_adaptive) {
+        _task_order = new uint8_t[_num_tasks];
+        _task_time_est = new uint32_t[_num_tasks];
+        if (_task_order == nullptr || _task_time_est == nullptr) {
+            delete[] _task_order;
+            delete[] _task_time_est;
+            _task_order = nullptr;
+            _task_time_est = nullptr;
+        } else {
+            // start from the worst case in the task table
+            for (uint8_t i=0; i<_num_tasks; i++) {
+                _task_time_est[i] = (uint32_t)_tasks[i].max_time_micros << AP_SCHEDULER_TIME_EST_SHIFT;
+            }
+        }
+    }
+
+    if (_async) {
+        start_async_workers();
+    }
+}
+
+/*
+  start the worker threads shared by the tasks marked asynchronous. If
+  none can be started every task stays on the main thread
+ */
+void AP_Scheduler::start_async_workers(void)
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    uint8_t num_async = 0;
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        if (_tasks[i].flags & AP_SCHEDULER_TASK_ASYNC) {
+            num_async++;
+        }
+    }
+    if (num_async == 0) {
+        return;
+    }
+    const uint8_t num_workers = MIN(num_async, AP_SCHEDULER_ASYNC_WORKERS);
+    for (uint8_t i=0; i<num_workers; i++) {
+        Linux::WorkerThread *worker = new Linux::WorkerThread();
+        if (worker == nullptr) {
+            break;
+        }
+        if (!worker->start("sched_async", AP_LINUX_TASKS_SCHED_POLICY, AP_LINUX_TASKS_SCHED_PRIO)) {
+            delete worker;
+            break;
+        }
+        _async_workers[_num_async_workers++] = worker;
+    }
+    if (_num_async_workers == 0) {
+        ::printf("Scheduler: async tasks stay on main thread\n");
+        return;
+    }
+    _async_jobs = new async_job[_num_tasks];
+    if (_async_jobs == nullptr) {
+        return;
+    }
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        _async_jobs[i].function = _tasks[i].function;
+        _async_jobs[i].time_taken = 0;
+        _async_jobs[i].running = false;
+        _async_jobs[i].pending = false;
+    }
+#endif
+}
+
+/*
+  return true if asynchronous tasks are run by worker threads
+ */
+bool AP_Scheduler::async_workers_running(void) const
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    return _async_jobs != nullptr;
+#else
+    return false;
+#endif
+}
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+void AP_Scheduler::async_job::run(void)
+{
+    const uint32_t start = AP_HAL::micros();
+    function();
+    time_taken = AP_HAL::micros() - start;
+    running.store(false, std::memory_order_release);
+}
+#endif
+
+/*
+  hand a due task to a free worker thread. Returns false if the task
+  runs on the main thread. The previous run's runtime is recorded
+  here, once the worker has finished with it. slipped is true when
+  this due run has already been counted as a slip
+ */
+bool AP_Scheduler::run_task_async(uint8_t i, bool slipped)
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    if (_async_jobs == nullptr || !(_tasks[i].flags & AP_SCHEDULER_TASK_ASYNC)) {
+        return false;
+    }
+    async_job &job = _async_jobs[i];
+    if (job.running.load(std::memory_order_acquire)) {
+        // still running from last time
+        skip_task_async(i, slipped);
+        return true;
+    }
+    if (job.pending) {
+        if (_task_stats != nullptr) {
+            update_task_stats(i, job.time_taken, job.time_taken > _tasks[i].max_time_micros);
+        }
+        job.pending = false;
+    }
+    job.running = true;
+    for (uint8_t w=0; w<_num_async_workers; w++) {
+        // submit() refuses a worker which is still busy
+        if (_async_workers[w]->submit(FUNCTOR_BIND(&job, &async_job::run, void))) {
+            job.pending = true;
+            _last_run[i] = _tick_counter;
+            return true;
+        }
+    }
+    // every worker is busy with other tasks
+    job.running = false;
+    skip_task_async(i, slipped);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*
+  skip a due run of an asynchronous task which couldn't be started. It
+  counts as one slip, unless run_task() already counted it as late, and
+  the task is next due a whole interval later rather than retried (and
+  counted again) on every tick
+ */
+void AP_Scheduler::skip_task_async(uint8_t i, bool slipped)
+{
+    if (!slipped && _task_stats != nullptr && _task_stats[i].slips < UINT16_MAX) {
+        _task_stats[i].slips++;
+    }
+    if (_debug > 4) {
+        ::printf("Scheduler skip async task[%u-%s]\n",
+                 (unsigned)i,
+                 _tasks[i].name);
+    }
+    _last_run[i] = _tick_counter;
 }
 
 // one tick has passed
@@ -84,6 +272,149 @@ void AP_Scheduler::tick(void)
     _tick_counter++;
 }
 
+/*
+  number of ticks between runs of a task
+ */
+uint16_t AP_Scheduler::interval_ticks(uint8_t i) const
+{
+    uint16_t interval_ticks = _loop_rate_hz / _tasks[i].rate_hz;
+    if (interval_ticks < 1) {
+        interval_ticks = 1;
+    }
+    return interval_ticks;
+}
+
+/*
+  return true if a task is due to run on this tick
+ */
+bool AP_Scheduler::task_due(uint8_t i) const
+{
+    if ((_tasks[i].flags & AP_SCHEDULER_TASK_ASYNC_ONLY) && !async_workers_running()) {
+        return false;
+    }
+    const uint16_t dt = _tick_counter - _last_run[i];
+    return dt >= interval_ticks(i);
+}
+
+/*
+  return true if task a is further past its deadline than task b,
+  relative to their rates. Tasks which run every tick are part of the
+  fast loop and always come first. Ties keep table order
+ */
+bool AP_Scheduler::more_starved(uint8_t a, uint8_t b) const
+{
+    const uint32_t interval_a = interval_ticks(a);
+    const uint32_t interval_b = interval_ticks(b);
+    if (interval_a == 1 || interval_b == 1) {
+        return interval_a == 1 && interval_b != 1;
+    }
+    const uint32_t dt_a = (uint16_t)(_tick_counter - _last_run[a]);
+    const uint32_t dt_b = (uint16_t)(_tick_counter - _last_run[b]);
+    return dt_a * interval_b > dt_b * interval_a;
+}
+
+/*
+  run one due task if it fits in the time available. now and
+  time_available are updated for the time it took. Returns false if
+  the time available has been used up
+ */
+bool AP_Scheduler::run_task(uint8_t i, uint32_t &now, uint32_t &time_available)
+{
+    const uint16_t dt = _tick_counter - _last_run[i];
+    const uint16_t interval = interval_ticks(i);
+
+    // this task is due to run. Do we have enough time to run it?
+    _task_time_allowed = _tasks[i].max_time_micros;
+
+    const bool slipped = dt >= interval*2;
+    if (slipped) {
+        // we've slipped a whole run of this task!
+        if (_task_stats != nullptr && _task_stats[i].slips < UINT16_MAX) {
+            _task_stats[i].slips++;
+        }
+        if (_debug > 4) {
+            ::printf("Scheduler slip task[%u-%s] (%u/%u/%u)\n",
+                     (unsigned)i,
+                     _tasks[i].name,
+                     (unsigned)dt,
+                     (unsigned)interval,
+                     (unsigned)_task_time_allowed);
+        }
+    }
+
+    if (run_task_async(i, slipped)) {
+        // it costs the main thread nothing
+        return true;
+    }
+
+    // in adaptive mode admit the task on its learned runtime rather
+    // than the worst case from the task table
+    const uint32_t time_needed = _task_time_est ? task_time_est_us(i) : _task_time_allowed;
+    if (time_needed > time_available) {
+        return true;
+    }
+
+    // run it
+    _task_time_started = now;
+    current_task = i;
+    if (_debug > 1 && _perf_counters && _perf_counters[i]) {
+        hal.util->perf_begin(_perf_counters[i]);
+    }
+    _tasks[i].function();
+    if (_debug > 1 && _perf_counters && _perf_counters[i]) {
+        hal.util->perf_end(_perf_counters[i]);
+    }
+    current_task = -1;
+
+    // record the tick counter when we ran. This drives
+    // when we next run the event
+    _last_run[i] = _tick_counter;
+
+    // work out how long the event actually took
+    now = AP_HAL::micros();
+    uint32_t time_taken = now - _task_time_started;
+
+    if (_task_stats != nullptr) {
+        update_task_stats(i, time_taken, time_taken > _task_time_allowed);
+    }
+    if (_task_time_est != nullptr) {
+        update_task_time_est(i, time_taken);
+    }
+
+    if (time_taken > _task_time_allowed) {
+        // the event overran!
+        if (_debug > 4) {
+            ::printf("Scheduler overrun task[%u-%s] (%u/%u)\n",
+                     (unsigned)i,
+                     _tasks[i].name,
+                     (unsigned)time_taken,
+                     (unsigned)_task_time_allowed);
+        }
+    }
+    if (time_taken >= time_available) {
+        return false;
+    }
+    time_available -= time_taken;
+    return true;
+}
+
+/*
+  learn a task's runtime. The estimate rises quickly and decays
+  slowly, so it tracks the upper end of the runtime distribution
+  rather than the mean. It is kept in fixed point so the slow decay
+  still moves it when it is only a few microseconds above the runtime
+ */
+void AP_Scheduler::update_task_time_est(uint8_t i, uint32_t time_taken)
+{
+    const uint32_t t = MIN(time_taken, (uint32_t)UINT16_MAX) << AP_SCHEDULER_TIME_EST_SHIFT;
+    uint32_t &est = _task_time_est[i];
+    if (t > est) {
+        est += (t - est + 7) / 8;
+    } else {
+        est -= (est - t) / 128;
+    }
+}
+
 /*
   run one tick
   this will run as many scheduler tasks as we can in the specified time
@@ -102,63 +433,29 @@ void AP_Scheduler::run(uint32_t time_available)
         }
     }
     
-    for (uint8_t i=0; i<_num_tasks; i++) {
-        uint16_t dt = _tick_counter - _last_run[i];
-        uint16_t interval_ticks = _loop_rate_hz / _tasks[i].rate_hz;
-        if (interval_ticks < 1) {
-            interval_ticks = 1;
-        }
-        if (dt >= interval_ticks) {
-            // this task is due to run. Do we have enough time to run it?
-            _task_time_allowed = _tasks[i].max_time_micros;
-
-            if (dt >= interval_ticks*2) {
-                // we've slipped a whole run of this task!
-                if (_debug > 4) {
-                    ::printf("Scheduler slip task[%u-%s] (%u/%u/%u)\n",
-                             (unsigned)i,
-                             _tasks[i].name,
-                             (unsigned)dt,
-                             (unsigned)interval_ticks,
-                             (unsigned)_task_time_allowed);
-                }
+    if (_task_order != nullptr) {
+        // adaptive mode: collect the due tasks, most starved first
+        uint8_t num_due = 0;
+        for (uint8_t i=0; i<_num_tasks; i++) {
+            if (!task_due(i)) {
+                continue;
             }
-
-            if (_task_time_allowed <= time_available) {
-                // run it
-                _task_time_started = now;
-                current_task = i;
-                if (_debug > 1 && _perf_counters && _perf_counters[i]) {
-                    hal.util->perf_begin(_perf_counters[i]);
-                }
-                _tasks[i].function();
-                if (_debug > 1 && _perf_counters && _perf_counters[i]) {
-                    hal.util->perf_end(_perf_counters[i]);
-                }
-                current_task = -1;
-
-                // record the tick counter when we ran. This drives
-                // when we next run the event
-                _last_run[i] = _tick_counter;
-
-                // work out how long the event actually took
-                now = AP_HAL::micros();
-                uint32_t time_taken = now - _task_time_started;
-
-                if (time_taken > _task_time_allowed) {
-                    // the event overran!
-                    if (_debug > 4) {
-                        ::printf("Scheduler overrun task[%u-%s] (%u/%u)\n",
-                                 (unsigned)i,
-                                 _tasks[i].name,
-                                 (unsigned)time_taken,
-                                 (unsigned)_task_time_allowed);
-                    }
-                }
-                if (time_taken >= time_available) {
-                    goto update_spare_ticks;
-                }
-                time_available -= time_taken;
+            uint8_t j = num_due++;
+            while (j > 0 && more_starved(i, _task_order[j-1])) {
+                _task_order[j] = _task_order[j-1];
+                j--;
+            }
+            _task_order[j] = i;
+        }
+        for (uint8_t k=0; k<num_due; k++) {
+            if (!run_task(_task_order[k], now, time_available)) {
+                goto update_spare_ticks;
+            }
+        }
+    } else {
+        for (uint8_t i=0; i<_num_tasks; i++) {
+            if (task_due(i) && !run_task(i, now, time_available)) {
+                goto update_spare_ticks;
             }
         }
     }
@@ -197,3 +494,120 @@ float AP_Scheduler::load_average(uint32_t tick_time_usec) const
     uint32_t used_time = tick_time_usec - (_spare_micros/_spare_ticks);
     return used_time / (float)tick_time_usec;
 }
+
+/*
+  record one run of a task
+ */
+void AP_Scheduler::update_task_stats(uint8_t i, uint32_t time_taken, bool overrun)
+{
+    TaskStats &stats = _task_stats[i];
+    const uint16_t t = MIN(time_taken, (uint32_t)UINT16_MAX);
+
+    stats.count++;
+    stats.total_us += time_taken;
+    if (t < stats.min_us) {
+        stats.min_us = t;
+    }
+    if (t > stats.max_us) {
+        stats.max_us = t;
+    }
+    if (overrun && stats.overruns < UINT16_MAX) {
+        stats.overruns++;
+    }
+
+    uint8_t bucket = 0;
+    while (bucket < AP_SCHEDULER_HIST_BUCKETS-1 && (time_taken >> (bucket+1)) != 0) {
+        bucket++;
+    }
+    stats.histogram[bucket]++;
+}
+
+const AP_Scheduler::TaskStats *AP_Scheduler::task_stats(uint8_t i) const
+{
+    if (_task_stats == nullptr || i >= _num_tasks) {
+        return nullptr;
+    }
+    return &_task_stats[i];
+}
+
+/*
+  estimate a runtime percentile, interpolating linearly within the
+  histogram bucket that holds it. The result is limited to the
+  largest runtime seen
+ */
+uint16_t AP_Scheduler::task_stats_percentile(const TaskStats &stats, float pct)
+{
+    if (stats.count == 0) {
+        return 0;
+    }
+    const float target = pct * stats.count;
+    uint32_t below = 0;
+    for (uint8_t b=0; b<AP_SCHEDULER_HIST_BUCKETS; b++) {
+        const uint32_t n = stats.histogram[b];
+        if (n > 0 && below + n >= target) {
+            const float lower = (b == 0) ? 0 : (1U << b);
+            const float upper = (b == AP_SCHEDULER_HIST_BUCKETS-1) ? stats.max_us : (1U << (b+1));
+            const float t = lower + (upper - lower) * (target - below) / n;
+            return MIN(t, stats.max_us);
+        }
+        below += n;
+    }
+    return stats.max_us;
+}
+
+void AP_Scheduler::reset_task_stats(void)
+{
+    if (_task_stats == nullptr) {
+        return;
+    }
+    memset(_task_stats, 0, sizeof(_task_stats[0]) * _num_tasks);
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        _task_stats[i].min_us = UINT16_MAX;
+    }
+    _task_stats_start_ms = AP_HAL::millis();
+}
+
+/*
+  rate a task has actually run at in the current statistics window
+ */
+float AP_Scheduler::task_achieved_rate_hz(uint8_t i) const
+{
+    const uint32_t window_ms = AP_HAL::millis() - _task_stats_start_ms;
+    if (_task_stats == nullptr || i >= _num_tasks || window_ms == 0) {
+        return 0.0f;
+    }
+    return _task_stats[i].count * 1000.0f / window_ms;
+}
+
+/*
+  write a SCHD message for each task which ran or slipped in the
+  current statistics window
+ */
+void AP_Scheduler::write_task_stats_log(void) const
+{
+    DataFlash_Class *dataflash = DataFlash_Class::instance();
+    if (_task_stats == nullptr || dataflash == nullptr) {
+        return;
+    }
+    const uint64_t now = AP_HAL::micros64();
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const TaskStats &stats = _task_stats[i];
+        if (stats.count == 0 && stats.slips == 0) {
+            continue;
+        }
+        dataflash->Log_Write("SCHD", "TimeUS,Id,Name,Cnt,Avg,Min,P99,Max,Ovr,Slp,Rate,Est",
+                             "QBNIHHHHHHfH",
+                             now,
+                             i,
+                             _tasks[i].name,
+                             stats.count,
+                             stats.count ? (uint16_t)MIN(stats.total_us / stats.count, (uint64_t)UINT16_MAX) : 0,
+                             stats.count ? stats.min_us : 0,
+                             task_stats_percentile(stats, 0.99f),
+                             stats.max_us,
+                             stats.overruns,
+                             stats.slips,
+                             (double)task_achieved_rate_hz(i),
+                             _task_time_est ? task_time_est_us(i) : _tasks[i].max_time_micros);
+    }
+}
@@ -23,18 +23,59 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_HAL/Util.h>
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <atomic>
+#include <AP_HAL_Linux/WorkerThread.h>
+#endif
+
 #define AP_SCHEDULER_NAME_INITIALIZER(_name) .name = #_name,
 
+// number of task runtime histogram buckets. Bucket 0 counts runs
+// taking under 2 microseconds, bucket n counts [2^n, 2^(n+1))
+// microseconds and the last bucket counts everything longer
+#define AP_SCHEDULER_HIST_BUCKETS 14
+
+// adaptive mode task runtime estimates are in 1/256 microseconds
+#define AP_SCHEDULER_TIME_EST_SHIFT 8
+
+// number of worker threads shared by the asynchronous tasks
+#define AP_SCHEDULER_ASYNC_WORKERS 2
+
+/*
+  task flags.
+
+  AP_SCHEDULER_TASK_ASYNC: the task may run on a small pool of worker
+  threads instead of the main thread (Linux only, when SCHED_ASYNC is
+  set). It can then run at the same time as the fast loop and any
+  other task, so it must only touch state it owns, or take the
+  semaphore of any state it shares. The scheduler guarantees that runs
+  of one task never overlap. A due run is skipped and counted as one
+  slip if the previous run hasn't finished or no worker is free.
+ */
+#define AP_SCHEDULER_TASK_ASYNC (1U<<0)
+
 /*
-  useful macro for creating scheduler task table
+  AP_SCHEDULER_TASK_ASYNC_ONLY: together with AP_SCHEDULER_TASK_ASYNC,
+  for tasks which do nothing on the main thread. When there are no
+  worker threads the task is never due, so it takes no time from the
+  other tasks and counts no slips.
  */
-#define SCHED_TASK_CLASS(classname, classptr, func, _rate_hz, _max_time_micros) { \
+#define AP_SCHEDULER_TASK_ASYNC_ONLY (1U<<1)
+
+/*
+  useful macros for creating scheduler task table
+ */
+#define SCHED_TASK_CLASS_FLAGS(classname, classptr, func, _rate_hz, _max_time_micros, _flags) { \
     .function = FUNCTOR_BIND(classptr, &classname::func, void),\
     AP_SCHEDULER_NAME_INITIALIZER(func)\
     .rate_hz = _rate_hz,\
-    .max_time_micros = _max_time_micros\
+    .max_time_micros = _max_time_micros,\
+    .flags = _flags\
 }
 
+#define SCHED_TASK_CLASS(classname, classptr, func, _rate_hz, _max_time_micros) \
+    SCHED_TASK_CLASS_FLAGS(classname, classptr, func, _rate_hz, _max_time_micros, 0)
+
 /*
   A task scheduler for APM main loops
 
@@ -50,6 +91,8 @@
 
 class AP_Scheduler
 {
+    friend class AP_Scheduler_Test;
+
 public:
     // constructor
     AP_Scheduler(void);
@@ -61,8 +104,25 @@ public:
         const char *name;
         float rate_hz;
         uint16_t max_time_micros;
+        uint8_t flags;
+    };
+
+    // runtime statistics for one task, accumulated since the last
+    // call to reset_task_stats()
+    struct TaskStats {
+        uint32_t count;
+        uint64_t total_us;
+        uint16_t min_us;
+        uint16_t max_us;
+        uint16_t overruns;
+        uint16_t slips;
+        uint32_t histogram[AP_SCHEDULER_HIST_BUCKETS];
     };
 
+    static AP_Scheduler *get_instance(void) {
+        return _s_instance;
+    }
+
     // initialise scheduler
     void init(const Task *tasks, uint8_t num_tasks);
 
@@ -95,10 +155,59 @@ public:
     // current running task, or -1 if none. Used to debug stuck tasks
     static int8_t current_task;
 
+    // number of tasks in the task table
+    uint8_t num_tasks(void) const { return _num_tasks; }
+
+    // name of a task in the task table
+    const char *task_name(uint8_t i) const { return _tasks[i].name; }
+
+    // statistics for a task, or nullptr if profiling is disabled
+    const TaskStats *task_stats(uint8_t i) const;
+
+    // estimate a percentile (0 to 1) of a task's runtime in
+    // microseconds from its histogram
+    static uint16_t task_stats_percentile(const TaskStats &stats, float pct);
+
+    // rate in Hz a task has run at since the last reset
+    float task_achieved_rate_hz(uint8_t i) const;
+
+    // log statistics for every task which ran since the last reset
+    void write_task_stats_log(void) const;
+
+    // start a new statistics window
+    void reset_task_stats(void);
+
 private:
+    static AP_Scheduler *_s_instance;
+
+    // record one run of a task in its statistics
+    void update_task_stats(uint8_t i, uint32_t time_taken, bool overrun);
+
+    uint16_t interval_ticks(uint8_t i) const;
+    bool task_due(uint8_t i) const;
+    bool more_starved(uint8_t a, uint8_t b) const;
+    bool run_task(uint8_t i, uint32_t &now, uint32_t &time_available);
+    void update_task_time_est(uint8_t i, uint32_t time_taken);
+    uint16_t task_time_est_us(uint8_t i) const {
+        return (_task_time_est[i] + (1U << AP_SCHEDULER_TIME_EST_SHIFT) - 1) >> AP_SCHEDULER_TIME_EST_SHIFT;
+    }
+    void start_async_workers(void);
+    bool async_workers_running(void) const;
+    bool run_task_async(uint8_t i, bool slipped);
+    void skip_task_async(uint8_t i, bool slipped);
+
     // used to enable scheduler debugging
     AP_Int8 _debug;
 
+    // used to enable per-task runtime statistics
+    AP_Int8 _profile;
+
+    // used to enable learned task budgets and starvation ordering
+    AP_Int8 _adaptive;
+
+    // used to enable running asynchronous tasks on worker threads
+    AP_Int8 _async;
+
     // overall scheduling rate in Hz
     AP_Int16 _loop_rate_hz;  // The value of this variable can be changed with the non-initialization. (Ex. Tuning by GDB)
     
@@ -129,4 +238,33 @@ private:
 
     // performance counters
     AP_HAL::Util::perf_counter_t *_perf_counters;
+
+    // per-task runtime statistics
+    TaskStats *_task_stats;
+
+    // start of the current statistics window
+    uint32_t _task_stats_start_ms;
+
+    // adaptive mode: learned runtime of each task, and scratch
+    // space for ordering the tasks due on a tick
+    uint32_t *_task_time_est;
+    uint8_t *_task_order;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // one run of an asynchronous task, timed on the worker thread.
+    // running is cleared by the worker once time_taken is written
+    struct async_job {
+        task_fn_t function;
+        uint32_t time_taken;
+        std::atomic<bool> running;
+        bool pending;
+        void run(void);
+    };
+    // worker threads shared by all asynchronous tasks, and a job per
+    // task. _async_jobs is nullptr when every task runs on the main
+    // thread
+    Linux::WorkerThread *_async_workers[AP_SCHEDULER_ASYNC_WORKERS];
+    uint8_t _num_async_workers;
+    async_job *_async_jobs;
+#endif
 };
@@ -22,14 +22,21 @@ private:
     uint32_t ins_counter;
     static const AP_Scheduler::Task scheduler_tasks[];
 
+    // state shared with slow_work, which may run on its own thread
+    AP_HAL::Semaphore *slow_sem;
+    uint32_t slow_counter;
+    float slow_result;
+
     void ins_update(void);
     void one_hz_print(void);
     void five_second_call(void);
+    void slow_work(void);
 };
 
 static SchedTest schedtest;
 
 #define SCHED_TASK(func, _interval_ticks, _max_time_micros) SCHED_TASK_CLASS(SchedTest, &schedtest, func, _interval_ticks, _max_time_micros)
+#define SCHED_TASK_ASYNC(func, _interval_ticks, _max_time_micros) SCHED_TASK_CLASS_FLAGS(SchedTest, &schedtest, func, _interval_ticks, _max_time_micros, AP_SCHEDULER_TASK_ASYNC)
 
 /*
   scheduler table - all regular tasks are listed here, along with how
@@ -40,6 +47,7 @@ const AP_Scheduler::Task SchedTest::scheduler_tasks[] = {
     SCHED_TASK(ins_update,             50,   1000),
     SCHED_TASK(one_hz_print,            1,   1000),
     SCHED_TASK(five_second_call,      0.2,   1800),
+    SCHED_TASK_ASYNC(slow_work,        10,   5000),
 };
 
 
@@ -48,6 +56,8 @@ void SchedTest::setup(void)
 
     AP_BoardConfig{}.init();
 
+    slow_sem = hal.util->new_semaphore();
+
     ins.init(scheduler.get_loop_rate_hz());
 
     // initialise the scheduler
@@ -89,6 +99,27 @@ void SchedTest::one_hz_print(void)
 void SchedTest::five_second_call(void)
 {
     hal.console->printf("five_seconds: t=%lu ins_counter=%u\n", (unsigned long)AP_HAL::millis(), ins_counter);
+    if (slow_sem != nullptr && slow_sem->take(1)) {
+        hal.console->printf("slow_work: counter=%u result=%f\n", slow_counter, (double)slow_result);
+        slow_sem->give();
+    }
+}
+
+/*
+  a few milliseconds of number crunching. With SCHED_ASYNC set this
+  runs off the main thread, so results are published under slow_sem
+ */
+void SchedTest::slow_work(void)
+{
+    float sum = 0;
+    for (uint32_t i=1; i<200000; i++) {
+        sum += 1.0f / i;
+    }
+    if (slow_sem != nullptr && slow_sem->take(1)) {
+        slow_counter++;
+        slow_result = sum;
+        slow_sem->give();
+    }
 }
 
 /*
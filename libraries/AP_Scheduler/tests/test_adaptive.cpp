@@ -0,0 +1,157 @@
+#include <AP_gtest.h>
+
+#include <AP_Scheduler/AP_Scheduler.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class TestTasks
+{
+public:
+    void fast(void) { fast_runs++; }
+    void slow(void) { slow_runs++; }
+    void rare(void) {}
+
+    uint32_t fast_runs;
+    uint32_t slow_runs;
+};
+
+static TestTasks test_tasks;
+
+// at the 50Hz loop rate these run every 1, 5 and 50 ticks
+static const AP_Scheduler::Task tasks[] = {
+    SCHED_TASK_CLASS(TestTasks, &test_tasks, fast, 50, 100),
+    SCHED_TASK_CLASS(TestTasks, &test_tasks, slow, 10, 1000),
+    SCHED_TASK_CLASS(TestTasks, &test_tasks, rare,  1, 200),
+};
+
+class AP_Scheduler_Test
+{
+public:
+    static void init(AP_Scheduler &scheduler, bool adaptive)
+    {
+        scheduler._loop_rate_hz.set(50);
+        scheduler._adaptive.set(adaptive);
+        scheduler.init(tasks, ARRAY_SIZE(tasks));
+    }
+
+    static void learn(AP_Scheduler &scheduler, uint8_t i, uint32_t time_taken)
+    {
+        scheduler.update_task_time_est(i, time_taken);
+    }
+
+    static uint16_t estimate_us(const AP_Scheduler &scheduler, uint8_t i)
+    {
+        return scheduler.task_time_est_us(i);
+    }
+
+    static void set_estimate_us(AP_Scheduler &scheduler, uint8_t i, uint16_t us)
+    {
+        scheduler._task_time_est[i] = (uint32_t)us << AP_SCHEDULER_TIME_EST_SHIFT;
+    }
+
+    static void set_ticks_since_run(AP_Scheduler &scheduler, uint8_t i, uint16_t ticks)
+    {
+        scheduler._last_run[i] = scheduler._tick_counter - ticks;
+    }
+
+    static bool more_starved(const AP_Scheduler &scheduler, uint8_t a, uint8_t b)
+    {
+        return scheduler.more_starved(a, b);
+    }
+};
+
+/*
+  the estimate starts from the task table budget and decays to within
+  a microsecond of a shorter runtime
+ */
+TEST(AP_Scheduler, AdaptiveEstimateDecays)
+{
+    static AP_Scheduler scheduler;
+    AP_Scheduler_Test::init(scheduler, true);
+
+    EXPECT_EQ(200U, AP_Scheduler_Test::estimate_us(scheduler, 2));
+    for (uint16_t n=0; n<2000; n++) {
+        AP_Scheduler_Test::learn(scheduler, 2, 150);
+    }
+    EXPECT_GE(AP_Scheduler_Test::estimate_us(scheduler, 2), 150U);
+    EXPECT_LE(AP_Scheduler_Test::estimate_us(scheduler, 2), 151U);
+}
+
+/*
+  a longer runtime closes an eighth of the gap on each run
+ */
+TEST(AP_Scheduler, AdaptiveEstimateRises)
+{
+    static AP_Scheduler scheduler;
+    AP_Scheduler_Test::init(scheduler, true);
+
+    AP_Scheduler_Test::learn(scheduler, 2, 1000);
+    EXPECT_EQ(300U, AP_Scheduler_Test::estimate_us(scheduler, 2));
+    for (uint8_t n=0; n<40; n++) {
+        AP_Scheduler_Test::learn(scheduler, 2, 1000);
+    }
+    EXPECT_GE(AP_Scheduler_Test::estimate_us(scheduler, 2), 990U);
+    EXPECT_LE(AP_Scheduler_Test::estimate_us(scheduler, 2), 1000U);
+}
+
+/*
+  a task whose table budget doesn't fit the time available is admitted
+  in adaptive mode once its learned runtime does
+ */
+TEST(AP_Scheduler, AdaptiveAdmitsOnLearnedRuntime)
+{
+    static AP_Scheduler fixed;
+    static AP_Scheduler adaptive;
+    AP_Scheduler_Test::init(fixed, false);
+    AP_Scheduler_Test::init(adaptive, true);
+    AP_Scheduler_Test::set_estimate_us(adaptive, 1, 100);
+
+    for (uint8_t n=0; n<5; n++) {
+        fixed.tick();
+        adaptive.tick();
+    }
+
+    test_tasks.slow_runs = 0;
+    fixed.run(500);
+    EXPECT_EQ(0U, test_tasks.slow_runs);
+
+    test_tasks.slow_runs = 0;
+    adaptive.run(500);
+    EXPECT_EQ(1U, test_tasks.slow_runs);
+}
+
+/*
+  due tasks are ordered by how late they are relative to their
+  interval, with tasks that run every tick first
+ */
+TEST(AP_Scheduler, AdaptiveMostStarvedFirst)
+{
+    static AP_Scheduler scheduler;
+    AP_Scheduler_Test::init(scheduler, true);
+    for (uint8_t n=0; n<100; n++) {
+        scheduler.tick();
+    }
+
+    // the fast loop task always comes first
+    AP_Scheduler_Test::set_ticks_since_run(scheduler, 0, 1);
+    AP_Scheduler_Test::set_ticks_since_run(scheduler, 1, 50);
+    EXPECT_TRUE(AP_Scheduler_Test::more_starved(scheduler, 0, 1));
+    EXPECT_FALSE(AP_Scheduler_Test::more_starved(scheduler, 1, 0));
+
+    // two intervals late beats 1.2 intervals late
+    AP_Scheduler_Test::set_ticks_since_run(scheduler, 1, 10);
+    AP_Scheduler_Test::set_ticks_since_run(scheduler, 2, 60);
+    EXPECT_TRUE(AP_Scheduler_Test::more_starved(scheduler, 1, 2));
+    EXPECT_FALSE(AP_Scheduler_Test::more_starved(scheduler, 2, 1));
+
+    // and loses to three intervals late
+    AP_Scheduler_Test::set_ticks_since_run(scheduler, 2, 150);
+    EXPECT_TRUE(AP_Scheduler_Test::more_starved(scheduler, 2, 1));
+
+    // equally late keeps table order
+    AP_Scheduler_Test::set_ticks_since_run(scheduler, 2, 100);
+    EXPECT_FALSE(AP_Scheduler_Test::more_starved(scheduler, 1, 2));
+    EXPECT_FALSE(AP_Scheduler_Test::more_starved(scheduler, 2, 1));
+}
+
+AP_GTEST_MAIN()
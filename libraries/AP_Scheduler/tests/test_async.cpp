@@ -0,0 +1,172 @@
+#include <AP_gtest.h>
+
+#include <AP_Scheduler/AP_Scheduler.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <atomic>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class TestTasks
+{
+public:
+    void plain(void) { plain_runs++; }
+    void io(void) { io_runs++; }
+
+    uint32_t plain_runs;
+    uint32_t io_runs;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // runs until released, so the next due run finds it still going
+    void blocking(void)
+    {
+        blocking_thread = pthread_self();
+        blocking_runs++;
+        while (!release.load()) {
+            usleep(100);
+        }
+    }
+
+    pthread_t blocking_thread;
+    std::atomic<uint32_t> blocking_runs;
+    std::atomic<bool> release;
+#endif
+};
+
+static TestTasks test_tasks;
+
+// at the 50Hz loop rate these are all due on every tick
+static const AP_Scheduler::Task main_tasks[] = {
+    SCHED_TASK_CLASS_FLAGS(TestTasks, &test_tasks, plain, 50, 100, AP_SCHEDULER_TASK_ASYNC),
+    SCHED_TASK_CLASS_FLAGS(TestTasks, &test_tasks, io,    50, 2000, AP_SCHEDULER_TASK_ASYNC | AP_SCHEDULER_TASK_ASYNC_ONLY),
+};
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+static const AP_Scheduler::Task worker_tasks[] = {
+    SCHED_TASK_CLASS_FLAGS(TestTasks, &test_tasks, blocking, 50, 100, AP_SCHEDULER_TASK_ASYNC),
+};
+#endif
+
+class AP_Scheduler_Test
+{
+public:
+    static void init(AP_Scheduler &scheduler, const AP_Scheduler::Task *tasks, uint8_t num_tasks, bool async)
+    {
+        scheduler._loop_rate_hz.set(50);
+        scheduler._profile.set(1);
+        scheduler._async.set(async);
+        scheduler.init(tasks, num_tasks);
+    }
+
+    static uint16_t slips(const AP_Scheduler &scheduler, uint8_t i)
+    {
+        return scheduler._task_stats[i].slips;
+    }
+
+    static void set_ticks_since_run(AP_Scheduler &scheduler, uint8_t i, uint16_t ticks)
+    {
+        scheduler._last_run[i] = scheduler._tick_counter - ticks;
+    }
+
+    static bool workers_running(const AP_Scheduler &scheduler)
+    {
+        return scheduler.async_workers_running();
+    }
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    static bool job_running(const AP_Scheduler &scheduler, uint8_t i)
+    {
+        return scheduler._async_jobs[i].running.load();
+    }
+
+    static void wait_workers(AP_Scheduler &scheduler)
+    {
+        for (uint8_t w=0; w<scheduler._num_async_workers; w++) {
+            scheduler._async_workers[w]->wait();
+        }
+    }
+#endif
+};
+
+/*
+  without worker threads asynchronous tasks run on the main thread,
+  except those which only do anything off it. They are never due, so
+  they count no slips either
+ */
+TEST(AP_Scheduler, AsyncOnlyNotRunOnMainThread)
+{
+    static AP_Scheduler scheduler;
+    AP_Scheduler_Test::init(scheduler, main_tasks, ARRAY_SIZE(main_tasks), false);
+    EXPECT_FALSE(AP_Scheduler_Test::workers_running(scheduler));
+
+    for (uint8_t n=0; n<10; n++) {
+        scheduler.tick();
+        scheduler.run(10000);
+    }
+    EXPECT_EQ(10U, test_tasks.plain_runs);
+    EXPECT_EQ(0U, test_tasks.io_runs);
+    EXPECT_EQ(0U, AP_Scheduler_Test::slips(scheduler, 1));
+}
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+/*
+  wait up to a second for a condition set by a worker thread
+ */
+template <typename F>
+static bool wait_for(F condition)
+{
+    for (uint16_t n=0; n<1000; n++) {
+        if (condition()) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return condition();
+}
+
+/*
+  an asynchronous task runs on a worker thread. While it is still
+  running each due run is skipped and counted as one slip, not handed
+  to a worker again
+ */
+TEST(AP_Scheduler, AsyncRunsOnWorker)
+{
+    static AP_Scheduler scheduler;
+    AP_Scheduler_Test::init(scheduler, worker_tasks, ARRAY_SIZE(worker_tasks), true);
+    ASSERT_TRUE(AP_Scheduler_Test::workers_running(scheduler));
+
+    scheduler.tick();
+    scheduler.run(10000);
+    ASSERT_TRUE(wait_for([] { return test_tasks.blocking_runs.load() == 1; }));
+    EXPECT_FALSE(pthread_equal(pthread_self(), test_tasks.blocking_thread));
+
+    for (uint8_t n=0; n<5; n++) {
+        scheduler.tick();
+        scheduler.run(10000);
+    }
+    EXPECT_EQ(5U, AP_Scheduler_Test::slips(scheduler, 0));
+
+    // a run which is late as well as skipped is still one slip
+    scheduler.tick();
+    AP_Scheduler_Test::set_ticks_since_run(scheduler, 0, 2);
+    scheduler.run(10000);
+    EXPECT_EQ(6U, AP_Scheduler_Test::slips(scheduler, 0));
+    EXPECT_EQ(1U, test_tasks.blocking_runs.load());
+
+    test_tasks.release = true;
+    AP_Scheduler_Test::wait_workers(scheduler);
+    EXPECT_FALSE(AP_Scheduler_Test::job_running(scheduler, 0));
+    EXPECT_EQ(1U, test_tasks.blocking_runs.load());
+
+    // once it has finished the next due run starts it again
+    scheduler.tick();
+    scheduler.run(10000);
+    AP_Scheduler_Test::wait_workers(scheduler);
+    EXPECT_EQ(2U, test_tasks.blocking_runs.load());
+}
+#endif
+
+AP_GTEST_MAIN()
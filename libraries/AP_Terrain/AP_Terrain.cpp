@@ -37,7 +37,7 @@ extern const AP_HAL::HAL& hal;
 const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Param: ENABLE
     // @DisplayName: Terrain data enable
-    // @Description: enable terrain data. This enables the vehicle storing a database of terrain data on the SD card. The terrain data is requested from the ground station as needed, and stored for later use on the SD card. To be useful the ground station must support TERRAIN_REQUEST messages and have access to a terrain database, such as the SRTM database.
+    // @Description: enable terrain data. This enables the vehicle storing a database of terrain data on the SD card. The terrain data is requested from the ground station as needed, and stored for later use on the SD card. To be useful the ground station must support TERRAIN_REQUEST messages and have access to a terrain database, such as the SRTM database. On Linux and SITL a TERRAIN.PAK made by Tools/scripts/terrain_pack.py in the terrain directory is used first. It is locked in memory, so it is only used if it is no larger than 64MB and the locked memory limit (ulimit -l) is at least its size.
     // @Values: 0:Disable,1:Enable
     // @User: Advanced
     AP_GROUPINFO_FLAGS("ENABLE", 0, AP_Terrain, enable, 1, AP_PARAM_FLAG_ENABLE),
@@ -50,6 +50,16 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("SPACING",   1, AP_Terrain, grid_spacing, 100),
 
+#if TERRAIN_PREFETCH
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: Number of terrain grid blocks kept in memory, each taking about 2 kilobytes. Blocks ahead of the vehicle along its velocity and the current mission legs are loaded from the SD card, or requested from the ground station, into this cache before they are needed. Only available on Linux boards.
+    // @Range: 12 1024
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ",  2, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE_DEFAULT),
+#endif
+
     AP_GROUPEND
 };
 
@@ -58,9 +68,12 @@ AP_Terrain::AP_Terrain(AP_AHRS &_ahrs, const AP_Mission &_mission, const AP_Rall
     ahrs(_ahrs),
     mission(_mission),
     rally(_rally),
+    last_cache_idx(0),
     disk_io_state(DiskIoIdle),
     fd(-1),
     timer_setup(false),
+    io_on_task(false),
+    io_busy(false),
     file_lat_degrees(0),
     file_lon_degrees(0),
     io_failure(false),
@@ -73,6 +86,7 @@ AP_Terrain::AP_Terrain(AP_AHRS &_ahrs, const AP_Mission &_mission, const AP_Rall
     memset(&home_loc, 0, sizeof(home_loc));
     memset(&disk_block, 0, sizeof(disk_block));
     memset(last_request_time_ms, 0, sizeof(last_request_time_ms));
+    memset(&cache_stats, 0, sizeof(cache_stats));
 }
 
 /*
@@ -105,9 +119,6 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
 
     calculate_grid_info(loc, info);
 
-    // find the grid
-    const struct grid_block &grid = find_grid_cache(info).grid;
-
     /*
       note that we rely on the one square overlap to ensure these
       calculations don't go past the end of the arrays
@@ -115,22 +126,45 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     ASSERT_RANGE(info.idx_x, 0, TERRAIN_GRID_BLOCK_SIZE_X-2);
     ASSERT_RANGE(info.idx_y, 0, TERRAIN_GRID_BLOCK_SIZE_Y-2);
 
-
-    // check we have all 4 required heights
-    if (!check_bitmap(grid, info.idx_x,   info.idx_y) ||
-        !check_bitmap(grid, info.idx_x,   info.idx_y+1) ||
-        !check_bitmap(grid, info.idx_x+1, info.idx_y) ||
-        !check_bitmap(grid, info.idx_x+1, info.idx_y+1)) {
-        return false;
+    // find the grid, first in the packed database where it can be
+    // read in place, then in the cache
+    const struct grid_block *grid = nullptr;
+#if TERRAIN_PACK
+    grid = pack_find_block(info);
+    if (grid != nullptr && !have_heights(*grid, info)) {
+        grid = nullptr;
     }
+#endif
+    if (grid == nullptr) {
+        struct grid_cache &gcache = find_grid_cache(info);
+
+        // check we have all 4 required heights
+        if (gcache.state == GRID_CACHE_DISKWAIT || !have_heights(gcache.grid, info)) {
+            cache_stats.misses++;
+            if (gcache.miss_ms == 0) {
+                gcache.miss_ms = MAX(AP_HAL::millis(), 1U);
+            }
+            return false;
+        }
+        if (gcache.miss_ms != 0) {
+            // the heights we missed on have arrived, from disk or GCS
+            const uint32_t wait_ms = AP_HAL::millis() - gcache.miss_ms;
+            gcache.miss_ms = 0;
+            cache_stats.served++;
+            cache_stats.wait_total_ms += wait_ms;
+            cache_stats.wait_max_ms = MAX(cache_stats.wait_max_ms, wait_ms);
+        }
+        grid = &gcache.grid;
+    }
+    cache_stats.hits++;
 
     // hXY are the heights of the 4 surrounding grid points
     int16_t h00, h01, h10, h11;
 
-    h00 = grid.height[info.idx_x+0][info.idx_y+0];
-    h01 = grid.height[info.idx_x+0][info.idx_y+1];
-    h10 = grid.height[info.idx_x+1][info.idx_y+0];
-    h11 = grid.height[info.idx_x+1][info.idx_y+1];
+    h00 = grid->height[info.idx_x+0][info.idx_y+0];
+    h01 = grid->height[info.idx_x+0][info.idx_y+1];
+    h10 = grid->height[info.idx_x+1][info.idx_y+0];
+    h11 = grid->height[info.idx_x+1][info.idx_y+1];
 
     // do a simple dual linear interpolation. We could do something
     // fancier, but it probably isn't worth it as long as the
@@ -323,6 +357,15 @@ void AP_Terrain::update(void)
     // check for pending rally data
     update_rally_data();
 
+#if TERRAIN_PREFETCH
+    // load blocks we are heading for
+    update_prefetch();
+#endif
+
+#if TERRAIN_PACK
+    pack_report();
+#endif
+
     // update capabilities and status
     if (enable) {
         hal.util->set_capabilities(MAV_PROTOCOL_CAPABILITY_TERRAIN);
@@ -376,6 +419,18 @@ void AP_Terrain::log_terrain_data(DataFlash_Class &dataflash)
         loaded         : loaded
     };
     dataflash.WriteBlock(&pkt, sizeof(pkt));
+
+    DATAFLASH_LOG_MESSAGE(terc_msg, "TERC", "TimeUS,Size,Hit,Miss,Pref,Load,LatAvg,LatMax", "QHIIIIII",
+                          uint64_t, uint16_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+    terc_msg.write(pkt.time_us,
+                   cache_size,
+                   cache_stats.hits,
+                   cache_stats.misses,
+                   cache_stats.prefetched,
+                   cache_stats.loads,
+                   cache_stats.served ? cache_stats.wait_total_ms / cache_stats.served : 0,
+                   cache_stats.wait_max_ms);
+    memset(&cache_stats, 0, sizeof(cache_stats));
 }
 
 /*
@@ -390,13 +445,17 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
+    uint16_t size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+#if TERRAIN_PREFETCH
+    size = constrain_int16(config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE, TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX);
+#endif
+    cache = (struct grid_cache *)calloc(size, sizeof(cache[0]));
     if (cache == nullptr) {
         enable.set(0);
         gcs().send_text(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+    cache_size = size;
     return true;
 }
 
@@ -31,6 +31,8 @@
 #include <AP_Mission/AP_Mission.h>
 #include <AP_Rally/AP_Rally.h>
 
+#include <atomic>
+
 #define TERRAIN_DEBUG 0
 
 
@@ -55,6 +57,41 @@
 // number of grid_blocks in the LRU memory cache
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+// boards with memory to spare keep a larger cache, sized by
+// TERRAIN_CACHE_SZ, and load blocks ahead of the vehicle into it
+#define TERRAIN_PREFETCH 1
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE_DEFAULT 64
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX 1024
+
+// how far ahead to prefetch, in seconds of flight at the current speed
+#define TERRAIN_PREFETCH_TIME_S 60
+
+// most disk reads queued by prefetching at once, so reads for the
+// current location don't wait behind a long queue
+#define TERRAIN_PREFETCH_MAX_PENDING 4
+
+// number of blocks remembered as missing from disk
+#define TERRAIN_DISK_MISSING_SIZE 64
+
+// a packed terrain database in the terrain directory is memory
+// mapped and used before the cache, see terrain_pack_header
+#define TERRAIN_PACK 1
+#define TERRAIN_PACK_FILE "TERRAIN.PAK"
+
+// packs are read in and locked in memory when opened, which needs an
+// RLIMIT_MEMLOCK (ulimit -l) at least the size of the pack. Larger ones
+// aren't used
+#define TERRAIN_PACK_SIZE_MAX (64*1024*1024UL)
+
+// bytes of the pack read in and locked per disk IO run, so a large pack
+// doesn't hold up the other IO processes while it loads
+#define TERRAIN_PACK_LOAD_SLICE (1024*1024UL)
+#else
+#define TERRAIN_PREFETCH 0
+#define TERRAIN_PACK 0
+#endif
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
@@ -90,6 +127,11 @@ public:
     // update terrain state. Should be called at 1Hz or more
     void update(void);
 
+    // do disk IO, for vehicles which list this as an asynchronous
+    // scheduler task. It only takes over from the IO timer when run
+    // off the main thread
+    void io_task(void);
+
     // return status enum for health reporting
     enum TerrainStatus status(void) const { return system_status; }
 
@@ -220,6 +262,43 @@ private:
         uint8_t buffer[2048];
     };
 
+#if TERRAIN_PACK
+    /*
+      a packed terrain database is a single read-only file holding
+      the grid blocks of one grid spacing for any number of degree
+      squares, made from a tree of .DAT files by
+      Tools/scripts/terrain_pack.py. It is laid out as:
+
+        terrain_pack_header
+        terrain_pack_degree[num_degrees], sorted by latitude then longitude
+        uint32_t slots[num_slots], for each degree rows*cols block
+            numbers in grid_idx_x*cols+grid_idx_y order, or
+            TERRAIN_PACK_NO_BLOCK where there is no data
+        padding up to blocks_offset, a multiple of 2048
+        grid_io_block[num_blocks]
+     */
+#define TERRAIN_PACK_MAGIC "APTPACK1"
+#define TERRAIN_PACK_NO_BLOCK 0xFFFFFFFFU
+    struct PACKED terrain_pack_header {
+        char magic[8];
+        uint16_t version;       // TERRAIN_GRID_FORMAT_VERSION of the blocks
+        uint16_t spacing;       // grid spacing of all blocks in meters
+        uint32_t num_degrees;
+        uint32_t num_slots;
+        uint32_t num_blocks;
+        uint32_t blocks_offset;
+    };
+
+    struct PACKED terrain_pack_degree {
+        int16_t lon_degrees;
+        int8_t lat_degrees;
+        uint8_t reserved;
+        uint16_t rows;          // number of grid_idx_x values
+        uint16_t cols;          // number of grid_idx_y values
+        uint32_t first_slot;
+    };
+#endif
+
     enum GridCacheState {
         GRID_CACHE_INVALID=0,    // when first initialised
         GRID_CACHE_DISKWAIT=1,   // when waiting for disk read
@@ -238,6 +317,10 @@ private:
 
         // the last time access was requested to this block, used for LRU
         uint32_t last_access_ms;
+
+        // the first lookup that missed on this block, zero once a
+        // lookup has found the heights it needed
+        uint32_t miss_ms;
     };
 
     /*
@@ -277,6 +360,9 @@ private:
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    // the cached grid for a grid_info, or nullptr if it isn't cached
+    struct grid_cache *lookup_grid_cache(const struct grid_info &info);
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -313,6 +399,7 @@ private:
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
+    void disk_io(void);
     void open_file(void);
     void seek_offset(void);
     void write_block(void);
@@ -328,10 +415,46 @@ private:
      */
     void update_rally_data(void);
 
+#if TERRAIN_PACK
+    /*
+      packed terrain database, opened and loaded by the disk IO and
+      reported on by update()
+     */
+    void pack_open(void);
+    void pack_load(void);
+    void pack_reject(const char *reason, int err);
+    void pack_report(void);
+    const union grid_io_block *pack_lookup(const struct grid_info &info);
+    const struct grid_block *pack_find_block(const struct grid_info &info);
+    bool pack_has_block(const struct grid_info &info);
+#endif
+
+    // true if a grid has the 4 heights around a grid_info
+    bool have_heights(const struct grid_block &grid, const struct grid_info &info);
+
+#if TERRAIN_PREFETCH
+    /*
+      load blocks ahead of the vehicle into the cache
+     */
+    void update_prefetch(void);
+    bool prefetch_path(const Location &from, const Location &to, float &budget, uint8_t &queued);
+    bool prefetch(const Location &loc, uint8_t &queued);
+
+    /*
+      index of blocks known to be missing from disk, so they can be
+      requested from the GCS without waiting for a disk read
+     */
+    bool disk_missing_find(int32_t lat, int32_t lon, bool remove);
+    void disk_missing_add(int32_t lat, int32_t lon);
+#endif
+
 
     // parameters
     AP_Int8  enable;
     AP_Int16 grid_spacing; // meters between grid points
+#if TERRAIN_PREFETCH
+    AP_Int16 config_cache_size;
+#endif
 
     // reference to AHRS, so we can ask for our position,
     // heading and speed
@@ -346,9 +469,50 @@ private:
     const AP_Rally &rally;
 
     // cache of grids in memory, LRU
-    uint8_t cache_size = 0;
+    uint16_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // index of the last grid found, checked first on the next lookup
+    uint16_t last_cache_idx;
+
+    // cache statistics, reset each time they are logged
+    struct {
+        uint32_t hits;          // lookups of data already in memory
+        uint32_t misses;        // lookups that had to wait for disk or GCS
+        uint32_t prefetched;    // blocks put in the cache ahead of the vehicle
+        uint32_t loads;         // disk reads completed
+        uint32_t served;        // missed blocks later found by a lookup
+        uint32_t wait_total_ms; // from the first miss until the data was found
+        uint32_t wait_max_ms;
+    } cache_stats;
+
+#if TERRAIN_PREFETCH
+    struct disk_missing_entry {
+        int32_t lat;
+        int32_t lon;
+        uint16_t spacing;
+    } disk_missing[TERRAIN_DISK_MISSING_SIZE];
+    uint8_t disk_missing_next;
+#endif
+
+#if TERRAIN_PACK
+    // set by the IO timer once the packed database is mapped. The
+    // release store publishes the pack_ fields below to the main thread
+    std::atomic<bool> pack_ready {false};
+    bool pack_checked = false;
+    const uint8_t *pack_map = nullptr;
+    size_t pack_size = 0;
+    size_t pack_locked = 0;
+    // why the pack isn't used, for update() to report. The release
+    // store publishes pack_errno
+    std::atomic<const char *> pack_error {nullptr};
+    int pack_errno = 0;
+    const struct terrain_pack_header *pack_header = nullptr;
+    const struct terrain_pack_degree *pack_degrees = nullptr;
+    const uint32_t *pack_slots = nullptr;
+    uint32_t pack_last_degree = 0;
+#endif
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -371,6 +535,12 @@ private:
     // has the timer been setup?
     bool timer_setup;
 
+    // set once io_task() runs off the main thread, so the IO timer
+    // leaves the disk to it. io_busy keeps the two from overlapping
+    // while it takes over
+    std::atomic<bool> io_on_task;
+    std::atomic<bool> io_busy;
+
     // degrees lat and lon of file
     int8_t file_lat_degrees;
     int16_t file_lon_degrees;
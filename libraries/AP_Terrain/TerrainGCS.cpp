@@ -73,6 +73,13 @@ bool AP_Terrain::request_missing(mavlink_channel_t chan, struct grid_cache &gcac
  */
 bool AP_Terrain::request_missing(mavlink_channel_t chan, const struct grid_info &info)
 {
+#if TERRAIN_PACK
+    if (pack_has_block(info)) {
+        // nothing to load or ask for
+        return false;
+    }
+#endif
+
     // find the grid
     struct grid_cache &gcache = find_grid_cache(info);
     return request_missing(chan, gcache);
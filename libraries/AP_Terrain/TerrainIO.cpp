@@ -36,17 +36,23 @@
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  check for blocks that need to be read from disk. The most recently
+  used block goes first, so a lookup for the current location isn't
+  held up by blocks being prefetched
  */
 void AP_Terrain::check_disk_read(void)
 {
+    int16_t newest = -1;
     for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
+        if (cache[i].state == GRID_CACHE_DISKWAIT &&
+            (newest == -1 || cache[i].last_access_ms > cache[newest].last_access_ms)) {
+            newest = i;
         }
-    }    
+    }
+    if (newest != -1) {
+        disk_block.block = cache[newest].grid;
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -79,24 +85,25 @@ void AP_Terrain::schedule_disk_io(void)
 
     switch (disk_io_state) {
     case DiskIoIdle:
-        // look for a block that needs reading or writing
-        check_disk_read();
-        if (disk_io_state == DiskIoIdle) {
-            // still idle, check for writes
-            check_disk_write();            
-        }
         break;
         
     case DiskIoDoneRead: {
         // a read has completed
         int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
         if (cache_idx != -1) {
+            const uint32_t now = AP_HAL::millis();
             if (disk_block.block.bitmap != 0) {
                 // when bitmap is zero we read an empty block
                 cache[cache_idx].grid = disk_block.block;
             }
+#if TERRAIN_PREFETCH
+            else {
+                disk_missing_add(disk_block.block.lat, disk_block.block.lon);
+            }
+#endif
             cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
+            cache[cache_idx].last_access_ms = now;
+            cache_stats.loads++;
         }
         disk_io_state = DiskIoIdle;
         break;
@@ -111,6 +118,9 @@ void AP_Terrain::schedule_disk_io(void)
                 cache[cache_idx].state = GRID_CACHE_VALID;
             }
         }
+#if TERRAIN_PREFETCH
+        disk_missing_find(disk_block.block.lat, disk_block.block.lon, true);
+#endif
         disk_io_state = DiskIoIdle;
         break;
     }
@@ -118,7 +128,15 @@ void AP_Terrain::schedule_disk_io(void)
     case DiskIoWaitWrite:
     case DiskIoWaitRead:
         // waiting for io_timer()
-        break;
+        return;
+    }
+
+    // start the next read or write straight away, rather than on the
+    // next call
+    check_disk_read();
+    if (disk_io_state == DiskIoIdle) {
+        // still idle, check for writes
+        check_disk_write();            
     }
 }
 
@@ -323,6 +341,48 @@ void AP_Terrain::read_block(void)
  */
 void AP_Terrain::io_timer(void)
 {
+    if (io_on_task) {
+        return;
+    }
+    if (io_busy.exchange(true, std::memory_order_acquire)) {
+        return;
+    }
+    disk_io();
+    io_busy.store(false, std::memory_order_release);
+}
+
+/*
+  disk IO from a scheduler worker thread. A slow card then holds up
+  terrain alone rather than every other IO process on the IO thread
+ */
+void AP_Terrain::io_task(void)
+{
+    if (hal.scheduler->in_main_thread()) {
+        // never block the main thread on the disk
+        return;
+    }
+    io_on_task = true;
+    if (io_busy.exchange(true, std::memory_order_acquire)) {
+        // the IO timer is finishing its last run
+        return;
+    }
+    disk_io();
+    io_busy.store(false, std::memory_order_release);
+}
+
+/*
+  carry out the pending read or write
+ */
+void AP_Terrain::disk_io(void)
+{
+#if TERRAIN_PACK
+    if (!pack_checked) {
+        pack_open();
+    } else if (pack_map != nullptr && !pack_ready.load(std::memory_order_relaxed)) {
+        pack_load();
+    }
+#endif
+
     if (io_failure) {
         // don't keep trying io, so we don't thrash the filesystem
         // code while flying
@@ -0,0 +1,259 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  read terrain from a memory mapped packed terrain database
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+#include <GCS_MAVLink/GCS.h>
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE && TERRAIN_PACK
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  sort key of a degree square, ordering by latitude then longitude
+ */
+static int32_t pack_degree_key(int8_t lat_degrees, int16_t lon_degrees)
+{
+    return lat_degrees * 1024L + lon_degrees;
+}
+
+/*
+  map the packed terrain database if there is one. Called once from
+  the disk IO, so the main thread never waits for it. The pack is then
+  read in by pack_load() before lookups use it.
+
+  The pack must only ever be replaced by renaming a new file over it,
+  as terrain_pack.py does. Truncating or rewriting the mapped file in
+  place makes lookups fault with SIGBUS
+ */
+void AP_Terrain::pack_open(void)
+{
+    pack_checked = true;
+
+    const char* terrain_dir = hal.util->get_custom_terrain_directory();
+    if (terrain_dir == nullptr) {
+        terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+    }
+    char *path = nullptr;
+    if (asprintf(&path, "%s/%s", terrain_dir, TERRAIN_PACK_FILE) <= 0) {
+        return;
+    }
+    int pfd = ::open(path, O_RDONLY|O_CLOEXEC);
+    free(path);
+    if (pfd == -1) {
+        // no packed database, the .DAT files are used alone
+        return;
+    }
+    struct stat st;
+    if (fstat(pfd, &st) != 0 || st.st_size < (off_t)sizeof(struct terrain_pack_header)) {
+        ::close(pfd);
+        pack_reject("Terrain: pack invalid, not used", 0);
+        return;
+    }
+    if (st.st_size > (off_t)TERRAIN_PACK_SIZE_MAX) {
+        // too big to hold in memory. Reading it through the mapping
+        // would fault on the main thread, and an SD read error there
+        // is a SIGBUS rather than a failed read
+        ::close(pfd);
+        pack_reject("Terrain: pack over 64MB, not used", 0);
+        return;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, pfd, 0);
+    const int err = errno;
+    ::close(pfd);
+    if (p == MAP_FAILED) {
+        pack_reject("Terrain: pack not mapped", err);
+        return;
+    }
+    pack_map = (const uint8_t *)p;
+    pack_size = st.st_size;
+    pack_locked = 0;
+}
+
+/*
+  read in and lock the next slice of the mapped pack, and once it is all
+  locked check the index and let lookups use it.
+
+  Neither the checks nor lookups on the main thread touch the disk once
+  the pack is locked. mlock() fails rather than faulting if a page
+  can't be read. Without the lock the pack isn't used, as evicted pages
+  would be read back by a lookup and a read error there is a SIGBUS.
+  Locking needs an RLIMIT_MEMLOCK of at least the size of the pack, or
+  CAP_IPC_LOCK
+ */
+void AP_Terrain::pack_load(void)
+{
+    const size_t len = MIN(pack_size - pack_locked, (size_t)TERRAIN_PACK_LOAD_SLICE);
+    if (mlock(&pack_map[pack_locked], len) != 0) {
+        pack_reject("Terrain: pack not locked, check ulimit -l", errno);
+        return;
+    }
+    pack_locked += len;
+    if (pack_locked < pack_size) {
+        return;
+    }
+
+    const uint8_t *map = pack_map;
+    const size_t size = pack_size;
+    const struct terrain_pack_header *hdr = (const struct terrain_pack_header *)map;
+    const struct terrain_pack_degree *degrees = (const struct terrain_pack_degree *)&map[sizeof(*hdr)];
+
+    // check the index lies within the file before trusting it
+    const uint64_t index_end = sizeof(*hdr) +
+        hdr->num_degrees * (uint64_t)sizeof(struct terrain_pack_degree) +
+        hdr->num_slots * (uint64_t)sizeof(uint32_t);
+    bool ok = memcmp(hdr->magic, TERRAIN_PACK_MAGIC, sizeof(hdr->magic)) == 0 &&
+        hdr->version == TERRAIN_GRID_FORMAT_VERSION &&
+        hdr->blocks_offset % sizeof(union grid_io_block) == 0 &&
+        index_end <= hdr->blocks_offset &&
+        hdr->blocks_offset + hdr->num_blocks * (uint64_t)sizeof(union grid_io_block) <= size;
+    for (uint32_t i=0; ok && i<hdr->num_degrees; i++) {
+        ok = degrees[i].first_slot + degrees[i].rows * (uint64_t)degrees[i].cols <= hdr->num_slots;
+    }
+    if (!ok) {
+        pack_reject("Terrain: pack invalid, not used", 0);
+        return;
+    }
+
+    pack_header = hdr;
+    pack_degrees = degrees;
+    pack_slots = (const uint32_t *)&degrees[hdr->num_degrees];
+    pack_last_degree = 0;
+    pack_ready.store(true, std::memory_order_release);
+}
+
+/*
+  give up on the pack, unmapping it if it was mapped. update() reports
+  the reason, with the error number if there is one
+ */
+void AP_Terrain::pack_reject(const char *reason, int err)
+{
+    if (pack_map != nullptr) {
+        munmap((void *)pack_map, pack_size);
+        pack_map = nullptr;
+        pack_size = 0;
+    }
+    pack_errno = err;
+    pack_error.store(reason, std::memory_order_release);
+}
+
+/*
+  report on the main thread why the pack isn't used
+ */
+void AP_Terrain::pack_report(void)
+{
+    const char *reason = pack_error.exchange(nullptr, std::memory_order_acquire);
+    if (reason == nullptr) {
+        return;
+    }
+    gcs().send_text(MAV_SEVERITY_WARNING, "%s", reason);
+    if (pack_errno != 0) {
+        hal.console->printf("%s: %s\n", reason, strerror(pack_errno));
+    } else {
+        hal.console->printf("%s\n", reason);
+    }
+}
+
+/*
+  find the slot for a grid_info in the packed database index, or
+  nullptr if it doesn't have one. The block itself isn't read
+ */
+const union AP_Terrain::grid_io_block *AP_Terrain::pack_lookup(const struct grid_info &info)
+{
+    if (!pack_ready.load(std::memory_order_acquire) || pack_header->spacing != grid_spacing) {
+        return nullptr;
+    }
+
+    // most lookups are in the same degree square as the last one
+    const int32_t key = pack_degree_key(info.lat_degrees, info.lon_degrees);
+    uint32_t d = pack_last_degree;
+    if (d >= pack_header->num_degrees ||
+        pack_degree_key(pack_degrees[d].lat_degrees, pack_degrees[d].lon_degrees) != key) {
+        uint32_t lo = 0;
+        uint32_t hi = pack_header->num_degrees;
+        while (lo < hi) {
+            const uint32_t mid = (lo + hi) / 2;
+            if (pack_degree_key(pack_degrees[mid].lat_degrees, pack_degrees[mid].lon_degrees) < key) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == pack_header->num_degrees ||
+            pack_degree_key(pack_degrees[lo].lat_degrees, pack_degrees[lo].lon_degrees) != key) {
+            return nullptr;
+        }
+        d = lo;
+        pack_last_degree = d;
+    }
+
+    const struct terrain_pack_degree &degree = pack_degrees[d];
+    if (info.grid_idx_x >= degree.rows || info.grid_idx_y >= degree.cols) {
+        return nullptr;
+    }
+    const uint32_t n = pack_slots[degree.first_slot + info.grid_idx_x * (uint32_t)degree.cols + info.grid_idx_y];
+    if (n >= pack_header->num_blocks) {
+        // TERRAIN_PACK_NO_BLOCK
+        return nullptr;
+    }
+    const union grid_io_block *blocks = (const union grid_io_block *)&pack_map[pack_header->blocks_offset];
+    return &blocks[n];
+}
+
+/*
+  find the block for a grid_info in the packed database, or nullptr
+  if it doesn't have it
+ */
+const AP_Terrain::grid_block *AP_Terrain::pack_find_block(const struct grid_info &info)
+{
+    const union grid_io_block *io_block = pack_lookup(info);
+    if (io_block == nullptr) {
+        return nullptr;
+    }
+    const struct grid_block &block = io_block->block;
+    if (block.lat != info.grid_lat ||
+        block.lon != info.grid_lon ||
+        block.spacing != grid_spacing) {
+        return nullptr;
+    }
+    return &block;
+}
+
+/*
+  true if the packed database has all of the block for a grid_info,
+  so it needn't be loaded or requested
+ */
+bool AP_Terrain::pack_has_block(const struct grid_info &info)
+{
+    const struct grid_block *block = pack_find_block(info);
+    return block != nullptr && (block->bitmap & bitmap_mask) == bitmap_mask;
+}
+
+#endif // AP_TERRAIN_AVAILABLE && TERRAIN_PACK
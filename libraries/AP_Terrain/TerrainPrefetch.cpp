@@ -0,0 +1,191 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  load terrain data ahead of the vehicle before it is needed
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+#include <GCS_MAVLink/GCS.h>
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE && TERRAIN_PREFETCH
+
+extern const AP_HAL::HAL& hal;
+
+// number of mission legs to look along
+#define TERRAIN_PREFETCH_LEGS 3
+
+/*
+  put the blocks the vehicle will reach within TERRAIN_PREFETCH_TIME_S
+  in the cache: first along its velocity, then along the current
+  mission leg and the ones after it. Blocks on disk are read by the
+  usual disk IO, the rest are requested from the GCS by send_request()
+ */
+void AP_Terrain::update_prefetch(void)
+{
+    if (enable == 0 || !allocate() || grid_spacing <= 0) {
+        return;
+    }
+
+    uint8_t queued = 0;
+    for (uint16_t i=0; i<cache_size && queued<TERRAIN_PREFETCH_MAX_PENDING; i++) {
+        if (cache[i].state == GRID_CACHE_DISKWAIT) {
+            queued++;
+        }
+    }
+    if (queued >= TERRAIN_PREFETCH_MAX_PENDING) {
+        // wait for the disk to catch up
+        return;
+    }
+
+    Location loc;
+    if (!ahrs.get_position(loc)) {
+        return;
+    }
+
+    // look at least a couple of blocks ahead, even when hovering
+    const Vector2f velocity = ahrs.groundspeed_vector();
+    const float speed = velocity.length();
+    const float block_size = TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing;
+    float budget = MAX(speed * TERRAIN_PREFETCH_TIME_S, 2 * block_size);
+
+    if (speed > 1) {
+        Location ahead = loc;
+        location_offset(ahead,
+                        velocity.x * TERRAIN_PREFETCH_TIME_S,
+                        velocity.y * TERRAIN_PREFETCH_TIME_S);
+        float velocity_budget = budget;
+        if (!prefetch_path(loc, ahead, velocity_budget, queued)) {
+            return;
+        }
+    }
+
+    if (mission.state() != AP_Mission::MISSION_RUNNING) {
+        return;
+    }
+    Location from = loc;
+    uint8_t legs = 0;
+    for (uint16_t index = mission.get_current_nav_index();
+         index != 0 && legs < TERRAIN_PREFETCH_LEGS;
+         index++) {
+        AP_Mission::Mission_Command cmd;
+        if (!mission.read_cmd_from_storage(index, cmd)) {
+            break;
+        }
+        if (!AP_Mission::is_nav_cmd(cmd) ||
+            (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+            continue;
+        }
+        if (!prefetch_path(from, cmd.content.location, budget, queued)) {
+            return;
+        }
+        from = cmd.content.location;
+        legs++;
+    }
+}
+
+/*
+  prefetch blocks every half block along a path, until the budget
+  distance runs out. Returns false once nothing more should be
+  prefetched this time round
+ */
+bool AP_Terrain::prefetch_path(const Location &from, const Location &to, float &budget, uint8_t &queued)
+{
+    const float step = 0.5f * TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing;
+    const Vector2f diff = location_diff(from, to);
+    const float length = diff.length();
+    float distance = 0;
+    while (true) {
+        const float frac = length > 0 ? MIN(distance, length) / length : 0;
+        Location loc = from;
+        location_offset(loc, diff.x * frac, diff.y * frac);
+        if (!prefetch(loc, queued)) {
+            return false;
+        }
+        if (distance >= length) {
+            return true;
+        }
+        distance += step;
+        budget -= step;
+        if (budget <= 0) {
+            return false;
+        }
+    }
+}
+
+/*
+  put the block holding loc in the cache if it isn't there yet
+ */
+bool AP_Terrain::prefetch(const Location &loc, uint8_t &queued)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+    if (lookup_grid_cache(info) != nullptr) {
+        return true;
+    }
+#if TERRAIN_PACK
+    if (pack_lookup(info) != nullptr) {
+        // read in place. A partly filled packed block is completed
+        // through the cache when the vehicle gets there
+        return true;
+    }
+#endif
+    if (queued >= TERRAIN_PREFETCH_MAX_PENDING) {
+        return false;
+    }
+    find_grid_cache(info);
+    cache_stats.prefetched++;
+    queued++;
+    return true;
+}
+
+/*
+  see if a block is known to be missing from disk, optionally
+  forgetting it
+ */
+bool AP_Terrain::disk_missing_find(int32_t lat, int32_t lon, bool remove)
+{
+    for (uint8_t i=0; i<TERRAIN_DISK_MISSING_SIZE; i++) {
+        struct disk_missing_entry &e = disk_missing[i];
+        if (e.lat == lat && e.lon == lon && e.spacing == grid_spacing) {
+            if (remove) {
+                memset(&e, 0, sizeof(e));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  remember that a block is missing from disk, replacing the oldest
+  entry
+ */
+void AP_Terrain::disk_missing_add(int32_t lat, int32_t lon)
+{
+    if (disk_missing_find(lat, lon, false)) {
+        return;
+    }
+    struct disk_missing_entry &e = disk_missing[disk_missing_next];
+    e.lat = lat;
+    e.lon = lon;
+    e.spacing = grid_spacing;
+    disk_missing_next = (disk_missing_next + 1) % TERRAIN_DISK_MISSING_SIZE;
+}
+
+#endif // AP_TERRAIN_AVAILABLE && TERRAIN_PREFETCH
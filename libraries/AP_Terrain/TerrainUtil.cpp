@@ -60,6 +60,17 @@ bool AP_Terrain::check_bitmap(const struct grid_block &grid, uint8_t idx_x, uint
     return (grid.bitmap & (((uint64_t)1U)<<bitnum)) != 0;
 }
 
+/*
+  check that a grid has the 4 heights surrounding a grid_info
+ */
+bool AP_Terrain::have_heights(const struct grid_block &grid, const struct grid_info &info)
+{
+    return check_bitmap(grid, info.idx_x,   info.idx_y) &&
+        check_bitmap(grid, info.idx_x,   info.idx_y+1) &&
+        check_bitmap(grid, info.idx_x+1, info.idx_y) &&
+        check_bitmap(grid, info.idx_x+1, info.idx_y+1);
+}
+
 /*
   given a location, calculate the 32x28 grid SW corner, plus the
   grid indices
@@ -112,20 +123,45 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 
 
 /*
-  find a grid structure given a grid_info
+  find the cached grid structure for a grid_info without changing
+  the cache
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+AP_Terrain::grid_cache *AP_Terrain::lookup_grid_cache(const struct grid_info &info)
 {
-    uint16_t oldest_i = 0;
-
-    // see if we have that grid
+    // most lookups are for the same grid as the last one
+    if (last_cache_idx < cache_size) {
+        struct grid_cache &grid = cache[last_cache_idx];
+        if (grid.grid.lat == info.grid_lat &&
+            grid.grid.lon == info.grid_lon &&
+            grid.grid.spacing == grid_spacing) {
+            return &grid;
+        }
+    }
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].grid.lat == info.grid_lat && 
             cache[i].grid.lon == info.grid_lon &&
             cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
+            last_cache_idx = i;
+            return &cache[i];
         }
+    }
+    return nullptr;
+}
+
+/*
+  find a grid structure given a grid_info
+ */
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+{
+    // see if we have that grid
+    struct grid_cache *found = lookup_grid_cache(info);
+    if (found != nullptr) {
+        found->last_access_ms = AP_HAL::millis();
+        return *found;
+    }
+
+    uint16_t oldest_i = 0;
+    for (uint16_t i=1; i<cache_size; i++) {
         if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
             oldest_i = i;
         }
@@ -145,10 +181,18 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
     grid.last_access_ms = AP_HAL::millis();
+    last_cache_idx = oldest_i;
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
+#if TERRAIN_PREFETCH
+    if (disk_missing_find(info.grid_lat, info.grid_lon, false)) {
+        // we looked for it before, it can come straight from the GCS
+        grid.state = GRID_CACHE_VALID;
+    }
+#endif
+
     return grid;
 }
 
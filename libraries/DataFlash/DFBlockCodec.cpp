@@ -0,0 +1,727 @@
+#include "DFBlockCodec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <AP_Math/AP_Math.h>
+
+#include "LogStructure.h"
+
+static const uint8_t block_magic[4] = { 'D', 'F', 'B', 'K' };
+
+/*
+  on-disk block header, followed by data_len bytes of data
+ */
+struct PACKED df_block_header {
+    uint8_t magic[4];
+    uint8_t encoding;
+    uint8_t reserved[3];
+    uint32_t raw_len;
+    uint32_t data_len;
+};
+
+static_assert(sizeof(struct df_block_header) == DF_BLOCK_HEADER_LEN, "block header size");
+
+// worst case size of the columns for raw_len bytes of messages. A 16
+// bit delta can take three bytes, which is the largest expansion of
+// any field type; dropping the header bytes more than pays for the
+// type sequence
+static uint32_t max_columns_length(uint32_t raw_len)
+{
+    return raw_len + raw_len/2 + 8;
+}
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &v)
+{
+    v = 0;
+    for (uint8_t shift=0; shift<64; shift += 7) {
+        if (p == end) {
+            return false;
+        }
+        const uint8_t b = *p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DFBlockFormats::DFBlockFormats()
+{
+    reset();
+}
+
+void DFBlockFormats::reset()
+{
+    memset(_length, 0, sizeof(_length));
+    memset(_format, 0, sizeof(_format));
+    _length[LOG_FORMAT_MSG] = sizeof(struct log_Format);
+    strncpy(_format[LOG_FORMAT_MSG], "BBnNZ", sizeof(_format[0]));
+}
+
+void DFBlockFormats::learn(const uint8_t *fmt_msg)
+{
+    const struct log_Format *f = (const struct log_Format *)fmt_msg;
+    if (f->type == LOG_FORMAT_MSG || f->length < LOG_PACKET_HEADER_LEN) {
+        return;
+    }
+    _length[f->type] = f->length;
+    memcpy(_format[f->type], f->format, sizeof(_format[0]));
+}
+
+bool DFBlockFormats::changes_format(const uint8_t *fmt_msg) const
+{
+    const struct log_Format *f = (const struct log_Format *)fmt_msg;
+    if (f->type == LOG_FORMAT_MSG || f->length < LOG_PACKET_HEADER_LEN) {
+        return false;
+    }
+    return _length[f->type] != f->length ||
+        memcmp(_format[f->type], f->format, sizeof(_format[0])) != 0;
+}
+
+uint8_t DFBlockFormats::fields(uint8_t type, field f[DF_BLOCK_MAX_FIELDS]) const
+{
+    const uint8_t body_len = _length[type] - LOG_PACKET_HEADER_LEN;
+    uint8_t n = 0;
+    uint16_t total = 0;
+    for (uint8_t i=0; i<sizeof(_format[0]) && _format[type][i] != 0; i++) {
+        uint8_t kind = FIELD_INT;
+        uint8_t width;
+        switch (_format[type][i]) {
+        case 'b': case 'B': case 'M':
+            width = 1;
+            break;
+        case 'h': case 'H': case 'c': case 'C':
+            width = 2;
+            break;
+        case 'i': case 'I': case 'e': case 'E': case 'L':
+            width = 4;
+            break;
+        case 'q': case 'Q':
+            width = 8;
+            break;
+        case 'f':
+            kind = FIELD_FLOAT;
+            width = 4;
+            break;
+        case 'd':
+            kind = FIELD_FLOAT;
+            width = 8;
+            break;
+        case 'n':
+            kind = FIELD_BYTES;
+            width = 4;
+            break;
+        case 'N':
+            kind = FIELD_BYTES;
+            width = 16;
+            break;
+        case 'Z':
+            kind = FIELD_BYTES;
+            width = 64;
+            break;
+        default:
+            // unknown field type, can't split the body
+            total = 0xFFFF;
+            width = 0;
+            break;
+        }
+        if (total == 0xFFFF) {
+            break;
+        }
+        f[n].kind = kind;
+        f[n].width = width;
+        total += width;
+        n++;
+    }
+    if (total != body_len) {
+        f[0].kind = FIELD_BYTES;
+        f[0].width = body_len;
+        return body_len ? 1 : 0;
+    }
+    return n;
+}
+
+DFBlockEncoder::~DFBlockEncoder()
+{
+    delete[] _columns;
+    delete[] _rows;
+    delete[] _hash_table;
+}
+
+bool DFBlockEncoder::init(uint32_t max_raw)
+{
+    if (max_raw > DF_BLOCK_MAX_RAW) {
+        max_raw = DF_BLOCK_MAX_RAW;
+    }
+    _columns = new uint8_t[max_columns_length(max_raw)];
+    _rows = new uint16_t[max_raw / LOG_PACKET_HEADER_LEN + 1];
+    _hash_table = new uint16_t[DF_LZ_HASH_SIZE];
+    if (_columns == nullptr || _rows == nullptr || _hash_table == nullptr) {
+        delete[] _columns;
+        delete[] _rows;
+        delete[] _hash_table;
+        _columns = nullptr;
+        _rows = nullptr;
+        _hash_table = nullptr;
+        return false;
+    }
+    _max_raw = max_raw;
+    return true;
+}
+
+uint32_t DFBlockEncoder::max_block_length(uint32_t max_raw)
+{
+    return DF_BLOCK_HEADER_LEN + max_columns_length(max_raw);
+}
+
+/*
+  find the complete messages at the start of in[], learning any
+  formats they define. Returns the number of bytes they take
+ */
+uint32_t DFBlockEncoder::scan(const uint8_t *in, uint32_t in_len, uint16_t &nmsgs, uint8_t *order, uint16_t &ntypes)
+{
+    memset(_count, 0, sizeof(_count));
+    nmsgs = 0;
+    ntypes = 0;
+    uint32_t ofs = 0;
+    while (ofs + LOG_PACKET_HEADER_LEN <= in_len) {
+        const uint8_t *msg = &in[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            break;
+        }
+        const uint8_t type = msg[2];
+        const uint8_t len = length(type);
+        if (len == 0 || ofs + len > in_len) {
+            break;
+        }
+        if (type == LOG_FORMAT_MSG && _count[msg[3]] != 0 && changes_format(msg)) {
+            // messages of that type earlier in this block have to be
+            // decoded with the old format, start a new block
+            break;
+        }
+        if (_count[type]++ == 0) {
+            order[ntypes++] = type;
+        }
+        if (type == LOG_FORMAT_MSG) {
+            learn(msg);
+        }
+        nmsgs++;
+        ofs += len;
+    }
+    return ofs;
+}
+
+/*
+  length of unparseable data at the start of in[], up to the next
+  header of a known message type
+ */
+uint32_t DFBlockEncoder::resync(const uint8_t *in, uint32_t in_len) const
+{
+    for (uint32_t ofs=1; ofs + LOG_PACKET_HEADER_LEN <= in_len; ofs++) {
+        if (in[ofs] == HEAD_BYTE1 && in[ofs+1] == HEAD_BYTE2 && length(in[ofs+2]) != 0) {
+            return ofs;
+        }
+    }
+    return in_len;
+}
+
+/*
+  write the type sequence and the columns of each type into _columns,
+  returning their length
+ */
+uint32_t DFBlockEncoder::encode_columns(const uint8_t *in, uint32_t consumed, uint16_t nmsgs,
+                                        const uint8_t *order, uint16_t ntypes)
+{
+    uint8_t *p = put_varint(_columns, nmsgs);
+
+    // sort the message offsets by type, keeping their order
+    uint16_t idx = 0;
+    for (uint16_t i=0; i<ntypes; i++) {
+        _first[order[i]] = idx;
+        idx += _count[order[i]];
+    }
+    for (uint32_t ofs=0; ofs<consumed; ofs += length(in[ofs+2])) {
+        const uint8_t type = in[ofs+2];
+        *p++ = type;
+        _rows[_first[type]++] = ofs;
+    }
+
+    for (uint16_t i=0; i<ntypes; i++) {
+        const uint8_t type = order[i];
+        const uint16_t n = _count[type];
+        const uint16_t *rows = &_rows[_first[type] - n];
+        field f[DF_BLOCK_MAX_FIELDS];
+        const uint8_t nfields = fields(type, f);
+        uint8_t o = LOG_PACKET_HEADER_LEN;
+        for (uint8_t j=0; j<nfields; j++) {
+            const uint8_t w = f[j].width;
+            switch (f[j].kind) {
+            case FIELD_INT:
+                if (w == 1) {
+                    uint8_t prev = 0;
+                    for (uint16_t r=0; r<n; r++) {
+                        const uint8_t v = in[rows[r]+o];
+                        *p++ = v - prev;
+                        prev = v;
+                    }
+                } else {
+                    // log messages are little endian, as are all
+                    // the boards we log on
+                    const uint8_t shift = 64 - 8*w;
+                    uint64_t prev = 0;
+                    for (uint16_t r=0; r<n; r++) {
+                        uint64_t v = 0;
+                        memcpy(&v, &in[rows[r]+o], w);
+                        const int64_t d = int64_t((v - prev) << shift) >> shift;
+                        p = put_varint(p, (uint64_t(d) << 1) ^ uint64_t(d >> 63));
+                        prev = v;
+                    }
+                }
+                break;
+            case FIELD_FLOAT:
+                // most significant byte plane first: sign and
+                // exponent change slowly
+                for (int8_t b=w-1; b>=0; b--) {
+                    uint8_t prev = 0;
+                    for (uint16_t r=0; r<n; r++) {
+                        const uint8_t v = in[rows[r]+o+b];
+                        *p++ = v ^ prev;
+                        prev = v;
+                    }
+                }
+                break;
+            case FIELD_BYTES:
+                for (uint16_t r=0; r<n; r++) {
+                    memcpy(p, &in[rows[r]+o], w);
+                    p += w;
+                }
+                break;
+            }
+            o += w;
+        }
+    }
+    return p - _columns;
+}
+
+uint32_t DFBlockEncoder::encode(const uint8_t *in, uint32_t in_len, uint8_t *out, uint32_t &out_len)
+{
+    out_len = 0;
+    if (_columns == nullptr) {
+        return 0;
+    }
+    if (in_len > _max_raw) {
+        in_len = _max_raw;
+    }
+
+    uint16_t nmsgs;
+    uint16_t ntypes;
+    uint8_t order[256];
+    uint32_t consumed = scan(in, in_len, nmsgs, order, ntypes);
+
+    struct df_block_header hdr {};
+    uint8_t *data = &out[DF_BLOCK_HEADER_LEN];
+    if (nmsgs == 0) {
+        if (in_len < LOG_PACKET_HEADER_LEN ||
+            (in[0] == HEAD_BYTE1 && in[1] == HEAD_BYTE2 && length(in[2]) != 0)) {
+            // waiting for the rest of a message
+            return 0;
+        }
+        // pass data we can't parse through as it is
+        consumed = resync(in, in_len);
+        memcpy(data, in, consumed);
+        hdr.encoding = DF_BLOCK_RAW;
+        hdr.data_len = consumed;
+    } else {
+        const uint32_t columns_len = encode_columns(in, consumed, nmsgs, order, ntypes);
+        hdr.encoding = DF_BLOCK_COLUMNS_LZ;
+        hdr.data_len = df_lz_compress(_columns, columns_len, data, columns_len-1, _hash_table);
+        if (hdr.data_len == 0) {
+            hdr.encoding = DF_BLOCK_COLUMNS;
+            hdr.data_len = columns_len;
+            memcpy(data, _columns, columns_len);
+        }
+    }
+    memcpy(hdr.magic, block_magic, sizeof(hdr.magic));
+    hdr.raw_len = consumed;
+    memcpy(out, &hdr, sizeof(hdr));
+    out_len = DF_BLOCK_HEADER_LEN + hdr.data_len;
+    return consumed;
+}
+
+DFBlockDecoder::~DFBlockDecoder()
+{
+    free(_columns);
+    free(_rows);
+}
+
+bool DFBlockDecoder::is_block(const uint8_t *data, uint32_t len)
+{
+    return len >= DF_BLOCK_HEADER_LEN && memcmp(data, block_magic, sizeof(block_magic)) == 0;
+}
+
+uint32_t DFBlockDecoder::block_length(const uint8_t *hdr)
+{
+    struct df_block_header h;
+    memcpy(&h, hdr, sizeof(h));
+    if (memcmp(h.magic, block_magic, sizeof(h.magic)) != 0 ||
+        h.encoding > DF_BLOCK_COLUMNS_LZ ||
+        h.raw_len > DF_BLOCK_MAX_RAW ||
+        h.data_len > max_columns_length(h.raw_len)) {
+        return 0;
+    }
+    return DF_BLOCK_HEADER_LEN + h.data_len;
+}
+
+uint32_t DFBlockDecoder::raw_length(const uint8_t *hdr)
+{
+    struct df_block_header h;
+    memcpy(&h, hdr, sizeof(h));
+    return h.raw_len;
+}
+
+bool DFBlockDecoder::grow(uint8_t *&buf, uint32_t &size, uint32_t needed)
+{
+    if (size >= needed) {
+        return true;
+    }
+    uint8_t *b = (uint8_t *)realloc(buf, needed);
+    if (b == nullptr) {
+        return false;
+    }
+    buf = b;
+    size = needed;
+    return true;
+}
+
+bool DFBlockDecoder::decode(const uint8_t *block, uint32_t len, uint8_t *out)
+{
+    const uint32_t block_len = block_length(block);
+    if (block_len == 0 || len < block_len) {
+        return false;
+    }
+    struct df_block_header h;
+    memcpy(&h, block, sizeof(h));
+    const uint8_t *data = &block[DF_BLOCK_HEADER_LEN];
+
+    switch (h.encoding) {
+    case DF_BLOCK_RAW:
+        if (h.data_len != h.raw_len) {
+            return false;
+        }
+        memcpy(out, data, h.raw_len);
+        return true;
+
+    case DF_BLOCK_COLUMNS:
+        return decode_columns(data, h.data_len, out, h.raw_len);
+
+    case DF_BLOCK_COLUMNS_LZ: {
+        const uint32_t space = max_columns_length(h.raw_len);
+        if (!grow(_columns, _columns_size, space)) {
+            return false;
+        }
+        const uint32_t columns_len = df_lz_decompress(data, h.data_len, _columns, space);
+        if (columns_len == 0) {
+            return false;
+        }
+        return decode_columns(_columns, columns_len, out, h.raw_len);
+    }
+    }
+    return false;
+}
+
+/*
+  rebuild the messages of each type in turn from their columns, then
+  interleave them in the order given by the type sequence
+ */
+bool DFBlockDecoder::decode_columns(const uint8_t *p, uint32_t len, uint8_t *out, uint32_t raw_len)
+{
+    const uint8_t *end = p + len;
+    uint64_t nmsgs;
+    if (!get_varint(p, end, nmsgs) ||
+        nmsgs == 0 ||
+        nmsgs > raw_len / LOG_PACKET_HEADER_LEN ||
+        uint64_t(end - p) < nmsgs) {
+        return false;
+    }
+    const uint8_t *types = p;
+    p += nmsgs;
+
+    uint16_t count[256] {};
+    uint8_t order[256];
+    uint16_t ntypes = 0;
+    for (uint32_t i=0; i<nmsgs; i++) {
+        if (count[types[i]]++ == 0) {
+            order[ntypes++] = types[i];
+        }
+    }
+
+    if (!grow(_rows, _rows_size, raw_len)) {
+        return false;
+    }
+
+    uint32_t start[256];
+    uint8_t row_len[256];
+    uint32_t region = 0;
+    for (uint16_t i=0; i<ntypes; i++) {
+        const uint8_t type = order[i];
+        const uint8_t rlen = length(type);
+        const uint16_t n = count[type];
+        if (rlen == 0 || region + uint32_t(n) * rlen > raw_len) {
+            return false;
+        }
+        start[type] = region;
+        row_len[type] = rlen;
+        uint8_t *base = &_rows[region];
+        region += uint32_t(n) * rlen;
+
+        for (uint16_t r=0; r<n; r++) {
+            base[r*rlen] = HEAD_BYTE1;
+            base[r*rlen+1] = HEAD_BYTE2;
+            base[r*rlen+2] = type;
+        }
+
+        field f[DF_BLOCK_MAX_FIELDS];
+        const uint8_t nfields = fields(type, f);
+        uint8_t o = LOG_PACKET_HEADER_LEN;
+        for (uint8_t j=0; j<nfields; j++) {
+            const uint8_t w = f[j].width;
+            switch (f[j].kind) {
+            case FIELD_INT:
+                if (w == 1) {
+                    if (end - p < n) {
+                        return false;
+                    }
+                    uint8_t prev = 0;
+                    for (uint16_t r=0; r<n; r++) {
+                        prev += *p++;
+                        base[r*rlen+o] = prev;
+                    }
+                } else {
+                    uint64_t prev = 0;
+                    for (uint16_t r=0; r<n; r++) {
+                        uint64_t v;
+                        if (!get_varint(p, end, v)) {
+                            return false;
+                        }
+                        prev += (v >> 1) ^ (~(v & 1) + 1);
+                        memcpy(&base[r*rlen+o], &prev, w);
+                    }
+                }
+                break;
+            case FIELD_FLOAT:
+                if (end - p < uint32_t(n) * w) {
+                    return false;
+                }
+                for (int8_t b=w-1; b>=0; b--) {
+                    uint8_t prev = 0;
+                    for (uint16_t r=0; r<n; r++) {
+                        prev ^= *p++;
+                        base[r*rlen+o+b] = prev;
+                    }
+                }
+                break;
+            case FIELD_BYTES:
+                if (end - p < uint32_t(n) * w) {
+                    return false;
+                }
+                for (uint16_t r=0; r<n; r++) {
+                    memcpy(&base[r*rlen+o], p, w);
+                    p += w;
+                }
+                break;
+            }
+            o += w;
+        }
+
+        if (type == LOG_FORMAT_MSG) {
+            // later types in this block may be defined here
+            for (uint16_t r=0; r<n; r++) {
+                learn(&base[r*rlen]);
+            }
+        }
+    }
+    if (region != raw_len || p != end) {
+        return false;
+    }
+
+    uint32_t ofs = 0;
+    for (uint32_t i=0; i<nmsgs; i++) {
+        const uint8_t type = types[i];
+        memcpy(&out[ofs], &_rows[start[type]], row_len[type]);
+        start[type] += row_len[type];
+        ofs += row_len[type];
+    }
+    return true;
+}
+
+/*
+  LZ4 block format, see
+  https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+ */
+#define LZ_MIN_MATCH    4
+#define LZ_MF_LIMIT     12 // no match may start in the last 12 bytes
+#define LZ_LAST_LITERALS 5 // the last 5 bytes are always literals
+#define LZ_HASH_SHIFT   (32 - 12)
+
+static_assert((1U << (32 - LZ_HASH_SHIFT)) == DF_LZ_HASH_SIZE, "hash table size");
+
+static inline uint32_t lz_hash(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761U) >> LZ_HASH_SHIFT;
+}
+
+static uint8_t *lz_put_length(uint8_t *op, uint32_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+/*
+  emit literals [anchor, anchor+lit_len) and, if match_len is not
+  zero, a match. Returns nullptr if dst_end would be passed
+ */
+static uint8_t *lz_sequence(uint8_t *op, const uint8_t *dst_end,
+                            const uint8_t *anchor, uint32_t lit_len,
+                            uint16_t offset, uint32_t match_len)
+{
+    if (op + 1 + lit_len/255 + 1 + lit_len + 2 + match_len/255 + 1 > dst_end) {
+        return nullptr;
+    }
+    uint8_t *token = op++;
+    *token = MIN(lit_len, 15U) << 4;
+    if (lit_len >= 15) {
+        op = lz_put_length(op, lit_len - 15);
+    }
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+    if (match_len == 0) {
+        return op;
+    }
+    *op++ = offset & 0xFF;
+    *op++ = offset >> 8;
+    match_len -= LZ_MIN_MATCH;
+    *token |= MIN(match_len, 15U);
+    if (match_len >= 15) {
+        op = lz_put_length(op, match_len - 15);
+    }
+    return op;
+}
+
+uint32_t df_lz_compress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_space, uint16_t *hash_table)
+{
+    uint8_t *op = dst;
+    const uint8_t *dst_end = dst + dst_space;
+    uint32_t anchor = 0;
+
+    if (len > LZ_MF_LIMIT) {
+        memset(hash_table, 0, DF_LZ_HASH_SIZE * sizeof(hash_table[0]));
+        const uint32_t match_limit = len - LZ_MF_LIMIT;
+        const uint32_t match_end = len - LZ_LAST_LITERALS;
+        uint32_t ip = 1;
+        hash_table[lz_hash(src)] = 0;
+        while (ip < match_limit) {
+            const uint32_t h = lz_hash(&src[ip]);
+            // positions are stored modulo 64k, so only candidates
+            // within reach of a 16 bit offset can match
+            const uint32_t ref = (ip & ~0xFFFFU) | hash_table[h];
+            hash_table[h] = ip;
+            if (ref >= ip || ip - ref > 0xFFFF || memcmp(&src[ref], &src[ip], LZ_MIN_MATCH) != 0) {
+                // skip faster through data that doesn't compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            uint32_t match_len = LZ_MIN_MATCH;
+            while (ip + match_len < match_end && src[ref+match_len] == src[ip+match_len]) {
+                match_len++;
+            }
+            op = lz_sequence(op, dst_end, &src[anchor], ip - anchor, ip - ref, match_len);
+            if (op == nullptr) {
+                return 0;
+            }
+            ip += match_len;
+            anchor = ip;
+            if (ip < match_limit) {
+                hash_table[lz_hash(&src[ip-2])] = ip-2;
+            }
+        }
+    }
+
+    op = lz_sequence(op, dst_end, &src[anchor], len - anchor, 0, 0);
+    if (op == nullptr) {
+        return 0;
+    }
+    return op - dst;
+}
+
+static bool lz_get_length(const uint8_t *&ip, const uint8_t *end, uint32_t &len)
+{
+    uint8_t b;
+    do {
+        if (ip == end) {
+            return false;
+        }
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+uint32_t df_lz_decompress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_space)
+{
+    const uint8_t *ip = src;
+    const uint8_t *end = src + len;
+    uint32_t op = 0;
+    while (ip < end) {
+        const uint8_t token = *ip++;
+        uint32_t lit_len = token >> 4;
+        if (lit_len == 15 && !lz_get_length(ip, end, lit_len)) {
+            return 0;
+        }
+        if (uint32_t(end - ip) < lit_len || dst_space - op < lit_len) {
+            return 0;
+        }
+        memcpy(&dst[op], ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip == end) {
+            // the last sequence has no match
+            break;
+        }
+        if (end - ip < 2) {
+            return 0;
+        }
+        const uint16_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        uint32_t match_len = token & 0x0F;
+        if (match_len == 15 && !lz_get_length(ip, end, match_len)) {
+            return 0;
+        }
+        match_len += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || dst_space - op < match_len) {
+            return 0;
+        }
+        // matches may overlap their own output
+        for (uint32_t i=0; i<match_len; i++, op++) {
+            dst[op] = dst[op - offset];
+        }
+    }
+    return op;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+/*
+  block compressed DataFlash logs
+
+  A compressed log is a sequence of blocks, each holding a whole
+  number of ordinary log messages. Within a block the messages are
+  grouped by type and stored column by column: integer fields as
+  zigzag varint deltas against the previous message of the same type,
+  float fields XORed against the previous value and split into byte
+  planes, strings as they are. The column data is then compressed in
+  the LZ4 block format.
+
+  Blocks only depend on earlier blocks through the FMT messages they
+  contain, so decoding a truncated log gives every complete block.
+ */
+
+#include <inttypes.h>
+
+#define DF_BLOCK_HEADER_LEN 16
+#define DF_BLOCK_MAX_RAW    65535U
+
+// block encodings
+#define DF_BLOCK_RAW        0 // messages as they are, used when they can't be parsed
+#define DF_BLOCK_COLUMNS    1 // columns without LZ compression
+#define DF_BLOCK_COLUMNS_LZ 2 // LZ compressed columns
+
+/*
+  formats of the message types seen so far in a log, learnt from its
+  FMT messages
+ */
+class DFBlockFormats {
+public:
+    DFBlockFormats();
+
+    // forget everything but the format of FMT itself
+    void reset();
+
+    enum field_kind {
+        FIELD_INT,   // delta coded integer
+        FIELD_FLOAT, // XOR coded float or double
+        FIELD_BYTES, // stored as it is
+    };
+    struct field {
+        uint8_t kind;
+        uint8_t width;
+    };
+#define DF_BLOCK_MAX_FIELDS 16
+
+    // message length including header, 0 if the type is unknown
+    uint8_t length(uint8_t type) const { return _length[type]; }
+
+    // fill in the fields of a message body, returning their
+    // number. Bodies with formats we can't size are one FIELD_BYTES
+    uint8_t fields(uint8_t type, field f[DF_BLOCK_MAX_FIELDS]) const;
+
+protected:
+    // learn the format in a complete FMT message
+    void learn(const uint8_t *fmt_msg);
+
+    // true if fmt_msg would change an already known format
+    bool changes_format(const uint8_t *fmt_msg) const;
+
+private:
+    uint8_t _length[256];
+    char _format[256][16];
+};
+
+class DFBlockEncoder : public DFBlockFormats {
+public:
+    ~DFBlockEncoder();
+
+    // allocate buffers for blocks of up to max_raw bytes of messages
+    bool init(uint32_t max_raw);
+
+    // space needed for one encoded block
+    static uint32_t max_block_length(uint32_t max_raw);
+
+    /*
+      encode messages from the start of in[] into one block in out[],
+      which must have room for max_block_length() bytes. Returns the
+      number of bytes of in[] consumed and sets out_len, both 0 if
+      in[] does not hold a complete message yet
+     */
+    uint32_t encode(const uint8_t *in, uint32_t in_len, uint8_t *out, uint32_t &out_len);
+
+private:
+    uint32_t _max_raw = 0;
+    uint8_t *_columns = nullptr;
+    uint16_t *_rows = nullptr;
+    uint16_t *_hash_table = nullptr;
+    uint16_t _count[256];
+    uint16_t _first[256];
+
+    uint32_t scan(const uint8_t *in, uint32_t in_len, uint16_t &nmsgs, uint8_t *order, uint16_t &ntypes);
+    uint32_t resync(const uint8_t *in, uint32_t in_len) const;
+    uint32_t encode_columns(const uint8_t *in, uint32_t consumed, uint16_t nmsgs,
+                            const uint8_t *order, uint16_t ntypes);
+};
+
+class DFBlockDecoder : public DFBlockFormats {
+public:
+    ~DFBlockDecoder();
+
+    // true if data holds at least a block header
+    static bool is_block(const uint8_t *data, uint32_t len);
+
+    // length of the block starting with hdr, header included, or 0
+    // if hdr is not a valid block header
+    static uint32_t block_length(const uint8_t *hdr);
+
+    // number of bytes of messages in the block starting with hdr
+    static uint32_t raw_length(const uint8_t *hdr);
+
+    // decode a complete block into out[], which must have room for
+    // raw_length() bytes
+    bool decode(const uint8_t *block, uint32_t len, uint8_t *out);
+
+private:
+    uint8_t *_columns = nullptr;
+    uint32_t _columns_size = 0;
+    uint8_t *_rows = nullptr;
+    uint32_t _rows_size = 0;
+
+    bool grow(uint8_t *&buf, uint32_t &size, uint32_t needed);
+    bool decode_columns(const uint8_t *p, uint32_t len, uint8_t *out, uint32_t raw_len);
+};
+
+/*
+  LZ4 block format compression of src into dst. Returns the
+  compressed length, or 0 if it would not fit in dst_space.
+  hash_table must hold DF_LZ_HASH_SIZE entries
+ */
+#define DF_LZ_HASH_SIZE 4096
+uint32_t df_lz_compress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_space, uint16_t *hash_table);
+
+/*
+  decompress an LZ4 block into at most dst_space bytes. Returns the
+  decompressed length, or 0 if the block is corrupt or too large
+ */
+uint32_t df_lz_decompress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_space);
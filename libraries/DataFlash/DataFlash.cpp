@@ -45,6 +45,13 @@ const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
     // @User: Standard
     AP_GROUPINFO("_FILE_DSRMROT",  4, DataFlash_Class, _params.file_disarm_rot,       0),
 
+    // @Param: _FILE_COMPRESS
+    // @DisplayName: Compress log files
+    // @Description: When set, the DataFlash_File backend groups messages of the same type into columns and compresses them before writing, typically making logs a third of the size or less. Compressed logs have to be unpacked with Replay --unpack before other log tools can read them. Only available on Linux boards, needs about 100 kilobytes of extra memory and takes effect after a reboot.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_COMPRESS",  5, DataFlash_Class, _params.file_compress,       0),
+
     AP_GROUPEND
 };
 
@@ -524,6 +531,14 @@ uint32_t DataFlash_Class::num_dropped() const
     return backends[0]->num_dropped();
 }
 
+bool DataFlash_Class::get_io_stats(io_stats &stats) const
+{
+    if (_next_backend == 0) {
+        return false;
+    }
+    return backends[0]->get_io_stats(stats);
+}
+
 
 // end functions pass straight through to backend
 
@@ -560,6 +575,18 @@ void DataFlash_Class::Log_Write(const char *name, const char *labels, const char
     }
 }
 
+void DataFlash_Class::Log_Write_Packed(struct log_write_fmt &f, const void *pkt, uint8_t len)
+{
+    for (uint8_t i=0; i<_next_backend; i++) {
+        if (!(f.sent_mask & (1U<<i))) {
+            if (!backends[i]->Log_Write_Emit_FMT(f.msg_type)) {
+                continue;
+            }
+            f.sent_mask |= (1U<<i);
+        }
+        backends[i]->WriteBlock(pkt, len);
+    }
+}
 
 DataFlash_Class::log_write_fmt *DataFlash_Class::msg_fmt_for_name(const char *name, const char *labels, const char *fmt)
 {
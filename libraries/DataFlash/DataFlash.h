@@ -157,6 +157,13 @@ public:
 
     void Log_Write(const char *name, const char *labels, const char *fmt, ...);
 
+    /*
+      dynamic message with its message type and packet layout resolved
+      once, for messages written at high rate. Declare with
+      DATAFLASH_LOG_MESSAGE() below
+     */
+    template <typename... Ts> class LogMessage;
+
     // This structure provides information on the internal member data of a PID for logging purposes
     struct PID_Info {
         float desired;
@@ -186,6 +193,19 @@ public:
     // number of blocks that have been dropped
     uint32_t num_dropped(void) const;
 
+    // write path statistics for the first backend, since boot. Only
+    // the IO thread updates them
+    struct io_stats {
+        uint32_t writes;          // write calls to the storage device
+        uint32_t bytes_written;
+        uint32_t write_max_us;    // longest single write call
+        uint32_t sync_max_us;     // longest wait for data to reach storage
+        uint32_t buffer_max_used; // high-water mark of the write buffer
+        uint32_t bytes_logged;    // log data taken from the write buffer, before compression
+        uint32_t encode_max_us;   // longest compression of one block
+    };
+    bool get_io_stats(io_stats &stats) const;
+
     // accesss to public parameters
     bool log_while_disarmed(void) const { return _params.log_disarmed != 0; }
     uint8_t log_replay(void) const { return _params.log_replay; }
@@ -200,6 +220,7 @@ public:
         AP_Int8 file_disarm_rot;
         AP_Int8 log_disarmed;
         AP_Int8 log_replay;
+        AP_Int8 file_compress;
     } _params;
 
     const struct LogStructure *structure(uint16_t num) const;
@@ -257,6 +278,9 @@ private:
 
     // return (possibly allocating) a log_write_fmt for a name
     struct log_write_fmt *msg_fmt_for_name(const char *name, const char *labels, const char *fmt);
+
+    // write an already packed dynamic message to all backends
+    void Log_Write_Packed(struct log_write_fmt &f, const void *pkt, uint8_t len);
     
     // returns true if msg_type is associated with a message
     bool msg_type_in_use(uint8_t msg_type) const;
@@ -341,3 +365,94 @@ private:
     /* end support for retrieving logs via mavlink: */
 
 };
+
+/*
+  compile time description of the fields of a LogMessage: which format
+  characters each C type can be logged as, the packed size of the
+  fields and how to pack them. Only fixed size numeric fields are
+  supported; messages with strings use Log_Write()
+ */
+template <typename T> struct DataFlash_LogField;
+template <> struct DataFlash_LogField<int8_t>   { static constexpr bool accepts(char c) { return c == 'b'; } };
+template <> struct DataFlash_LogField<uint8_t>  { static constexpr bool accepts(char c) { return c == 'B' || c == 'M'; } };
+template <> struct DataFlash_LogField<int16_t>  { static constexpr bool accepts(char c) { return c == 'h' || c == 'c'; } };
+template <> struct DataFlash_LogField<uint16_t> { static constexpr bool accepts(char c) { return c == 'H' || c == 'C'; } };
+template <> struct DataFlash_LogField<int32_t>  { static constexpr bool accepts(char c) { return c == 'i' || c == 'e' || c == 'L'; } };
+template <> struct DataFlash_LogField<uint32_t> { static constexpr bool accepts(char c) { return c == 'I' || c == 'E'; } };
+template <> struct DataFlash_LogField<int64_t>  { static constexpr bool accepts(char c) { return c == 'q'; } };
+template <> struct DataFlash_LogField<uint64_t> { static constexpr bool accepts(char c) { return c == 'Q'; } };
+template <> struct DataFlash_LogField<float>    { static constexpr bool accepts(char c) { return c == 'f'; } };
+template <> struct DataFlash_LogField<double>   { static constexpr bool accepts(char c) { return c == 'd'; } };
+
+template <typename... Ts> struct DataFlash_LogFields;
+
+template <> struct DataFlash_LogFields<> {
+    static constexpr uint8_t size = 0;
+    static constexpr bool matches(const char *fmt) { return fmt[0] == 0; }
+    static void pack(uint8_t *buf) {}
+};
+
+template <typename T, typename... Rest> struct DataFlash_LogFields<T, Rest...> {
+    static constexpr uint8_t size = sizeof(T) + DataFlash_LogFields<Rest...>::size;
+    static constexpr bool matches(const char *fmt) {
+        return fmt[0] != 0 && DataFlash_LogField<T>::accepts(fmt[0]) &&
+            DataFlash_LogFields<Rest...>::matches(fmt + 1);
+    }
+    static void pack(uint8_t *buf, T value, Rest... rest) {
+        memcpy(buf, &value, sizeof(T));
+        DataFlash_LogFields<Rest...>::pack(buf + sizeof(T), rest...);
+    }
+};
+
+template <typename... Ts>
+class DataFlash_Class::LogMessage {
+public:
+    LogMessage(const char *name, const char *labels, const char *fmt) :
+        _name(name),
+        _labels(labels),
+        _fmt(fmt),
+        _f(nullptr)
+    {}
+
+    void write(Ts... values) {
+        DataFlash_Class *dataflash = DataFlash_Class::instance();
+        if (dataflash == nullptr) {
+            return;
+        }
+        if (_f == nullptr) {
+            // first write; the format is never freed so we can keep it
+            _f = dataflash->msg_fmt_for_name(_name, _labels, _fmt);
+            if (_f == nullptr) {
+                dataflash->internal_error();
+                return;
+            }
+        }
+        uint8_t pkt[LOG_PACKET_HEADER_LEN + DataFlash_LogFields<Ts...>::size];
+        pkt[0] = HEAD_BYTE1;
+        pkt[1] = HEAD_BYTE2;
+        pkt[2] = _f->msg_type;
+        DataFlash_LogFields<Ts...>::pack(&pkt[LOG_PACKET_HEADER_LEN], values...);
+        dataflash->Log_Write_Packed(*_f, pkt, sizeof(pkt));
+    }
+
+    // message type, or 0 if not yet allocated
+    uint8_t msg_type() const { return _f ? _f->msg_type : 0; }
+
+private:
+    const char *_name;
+    const char *_labels;
+    const char *_fmt;
+    struct log_write_fmt *_f;
+};
+
+/*
+  declare a static LogMessage named var, checking at compile time that
+  fmt matches the field types. For example:
+
+    DATAFLASH_LOG_MESSAGE(msg, "TEST", "TimeUS,Value", "Qf", uint64_t, float);
+    msg.write(AP_HAL::micros64(), value);
+ */
+#define DATAFLASH_LOG_MESSAGE(var, name, labels, fmt, ...)                \
+    static_assert(DataFlash_LogFields<__VA_ARGS__>::matches(fmt),        \
+                  "log format " fmt " does not match its field types");  \
+    static DataFlash_Class::LogMessage<__VA_ARGS__> var(name, labels, fmt)
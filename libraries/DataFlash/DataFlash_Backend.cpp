@@ -294,7 +294,12 @@ bool DataFlash_Backend::WritePrioritisedBlock(const void *pBuffer, uint16_t size
     if (!WritesOK()) {
         return false;
     }
-    return _WritePrioritisedBlock(pBuffer, size, is_critical);
+    if (!_WritePrioritisedBlock(pBuffer, size, is_critical)) {
+        return false;
+    }
+    // trace with the message type, which follows the two header bytes
+    HAL_TRACE(TRACE_LOG_ENQUEUE, size > 2 ? ((const uint8_t *)pBuffer)[2] : 0);
+    return true;
 }
 
 bool DataFlash_Backend::ShouldLog(bool is_critical)
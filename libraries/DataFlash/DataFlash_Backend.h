@@ -104,6 +104,13 @@ public:
         return _dropped;
     }
 
+    // copy the write path statistics, returning false if they can't
+    // be read right now
+    virtual bool get_io_stats(DataFlash_Class::io_stats &stats) {
+        stats = _io_stats;
+        return true;
+    }
+
     /*
      * Log_Write support
      */
@@ -156,6 +163,7 @@ protected:
 
     uint32_t _internal_errors;
     uint32_t _dropped;
+    DataFlash_Class::io_stats _io_stats {};
 
     // must be called when a new log is being started:
     virtual void start_new_log_reset_variables();
@@ -30,6 +30,9 @@
 #include <time.h>
 #include <dirent.h>
 #include <GCS_MAVLink/GCS.h>
+#if DATAFLASH_FILE_WRITEV
+#include <sys/uio.h>
+#endif
 #if defined(__APPLE__) && defined(__MACH__)
 #include <sys/param.h>
 #include <sys/mount.h>
@@ -95,6 +98,11 @@ void DataFlash_File::Init()
         AP_HAL::panic("Failed to create DataFlash_File semaphore");
         return;
     }
+    write_fd_semaphore = hal.util->new_semaphore();
+    if (write_fd_semaphore == nullptr) {
+        AP_HAL::panic("Failed to create DataFlash_File write_fd_semaphore");
+        return;
+    }
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
     // try to cope with an existing lowercase log directory
@@ -147,10 +155,43 @@ void DataFlash_File::Init()
 
     hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)bufsize);
 
+#if DATAFLASH_FILE_COMPRESS
+    if (_front._params.file_compress) {
+        _compress_init(bufsize);
+    }
+#endif
+
     _initialised = true;
     hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void));
 }
 
+#if DATAFLASH_FILE_COMPRESS
+/*
+  allocate the block encoder. Blocks are limited to half the write
+  buffer so the buffer can fill to a whole block while the previous
+  one is being written
+ */
+void DataFlash_File::_compress_init(uint32_t bufsize)
+{
+    _block_raw_max = MIN(bufsize / 2, DATAFLASH_FILE_BLOCK_RAW);
+    _encoder = new DFBlockEncoder();
+    _block_in = new uint8_t[_block_raw_max];
+    _block_out = new uint8_t[DFBlockEncoder::max_block_length(_block_raw_max)];
+    if (_encoder == nullptr || _block_in == nullptr || _block_out == nullptr ||
+        !_encoder->init(_block_raw_max)) {
+        hal.console->printf("DataFlash_File: out of memory for compression\n");
+        delete _encoder;
+        delete[] _block_in;
+        delete[] _block_out;
+        _encoder = nullptr;
+        _block_in = nullptr;
+        _block_out = nullptr;
+        return;
+    }
+    hal.console->printf("DataFlash_File: compressing in blocks of %u\n", (unsigned)_block_raw_max);
+}
+#endif
+
 bool DataFlash_File::file_exists(const char *filename) const
 {
 #if DATAFLASH_FILE_MINIMAL
@@ -197,6 +238,34 @@ void DataFlash_File::periodic_1Hz(const uint32_t now)
         _write_fd = -1;
         _initialised = false;
     }
+
+    DataFlash_Class::io_stats stats;
+    if (logging_started() && get_io_stats(stats)) {
+        _front.Log_Write("DFIO", "TimeUS,Writes,Bytes,WrMax,SyncMax,BufMax,Logged,EncMax,Drop", "QIIIIIIII",
+                         AP_HAL::micros64(),
+                         stats.writes,
+                         stats.bytes_written,
+                         stats.write_max_us,
+                         stats.sync_max_us,
+                         stats.buffer_max_used,
+                         stats.bytes_logged,
+                         stats.encode_max_us,
+                         _dropped);
+    }
+}
+
+/*
+  copy the IO statistics. The IO thread updates them with
+  write_fd_semaphore held, so taking it gives a consistent snapshot
+ */
+bool DataFlash_File::get_io_stats(DataFlash_Class::io_stats &stats)
+{
+    if (!write_fd_semaphore->take_nonblocking()) {
+        return false;
+    }
+    stats = _io_stats;
+    write_fd_semaphore->give();
+    return true;
 }
 
 void DataFlash_File::periodic_fullrate(const uint32_t now)
@@ -513,7 +582,7 @@ void DataFlash_File::EraseAll()
 
 bool DataFlash_File::WritesOK() const
 {
-    if (_write_fd == -1) {
+    if (_write_fd == -1 || _stop_pending) {
         return false;
     }
     if (_open_error) {
@@ -823,10 +892,26 @@ uint16_t DataFlash_File::get_num_logs()
 }
 
 /*
-  stop logging
+  stop logging. The IO thread holds write_fd_semaphore for a whole
+  write and sync, so rather than wait for a slow card on the main
+  thread the file is left for the IO thread to close when it is done
  */
 void DataFlash_File::stop_logging(void)
 {
+    if (!write_fd_semaphore->take_nonblocking()) {
+        _stop_pending = true;
+        return;
+    }
+    _close_write_fd();
+    write_fd_semaphore->give();
+}
+
+/*
+  close the log file. The caller must hold write_fd_semaphore
+ */
+void DataFlash_File::_close_write_fd(void)
+{
+    _stop_pending = false;
     if (_write_fd != -1) {
         int fd = _write_fd;
         _write_fd = -1;
@@ -847,7 +932,52 @@ void DataFlash_File::PrepForArming()
  */
 uint16_t DataFlash_File::start_new_log(void)
 {
-    stop_logging();
+    // write_fd_semaphore is held from closing the last file until the
+    // new one is set up. If the IO thread is still writing, it closes
+    // the last file and the new log is started by a later call
+    if (!write_fd_semaphore->take_nonblocking()) {
+        _stop_pending = true;
+        return 0xFFFF;
+    }
+    const uint16_t log_num = _open_new_log();
+    write_fd_semaphore->give();
+    if (log_num == 0xFFFF) {
+        return 0xFFFF;
+    }
+
+    // now update lastlog.txt with the new log number
+    char *fname = _lastlog_file_name();
+
+    // we avoid fopen()/fprintf() here as it is not available on as many
+    // systems as open/write (specifically the QURT RTOS)
+    int fd = open(fname, O_WRONLY|O_CREAT|O_CLOEXEC, 0644);
+    free(fname);
+    if (fd == -1) {
+        _open_error = true;
+        return 0xFFFF;
+    }
+
+    char buf[30];
+    snprintf(buf, sizeof(buf), "%u\r\n", (unsigned)log_num);
+    const ssize_t to_write = strlen(buf);
+    const ssize_t written = write(fd, buf, to_write);
+    close(fd);
+
+    if (written < to_write) {
+        _open_error = true;
+        return 0xFFFF;
+    }
+
+    return log_num;
+}
+
+/*
+  close the last log file and open the next one, returning its number
+  or 0xFFFF on failure. The caller must hold write_fd_semaphore
+ */
+uint16_t DataFlash_File::_open_new_log(void)
+{
+    _close_write_fd();
 
     start_new_log_reset_variables();
 
@@ -881,10 +1011,10 @@ uint16_t DataFlash_File::start_new_log(void)
         _open_error = true;
         return 0xFFFF;
     }
-    _write_fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0666);
+    const int fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0666);
     _cached_oldest_log = 0;
 
-    if (_write_fd == -1) {
+    if (fd == -1) {
         _initialised = false;
         _open_error = true;
         int saved_errno = errno;
@@ -896,31 +1026,26 @@ uint16_t DataFlash_File::start_new_log(void)
         return 0xFFFF;
     }
     free(fname);
+
+    // the IO thread can't run until write_fd_semaphore is given, so
+    // the state of the new file can be set up here
     _write_offset = 0;
+#if DATAFLASH_FILE_SYNC_RANGE
+    _sync_pending_offset = 0;
+    _sync_pending_len = 0;
+#endif
     _writebuf.clear();
-
-    // now update lastlog.txt with the new log number
-    fname = _lastlog_file_name();
-
-    // we avoid fopen()/fprintf() here as it is not available on as many
-    // systems as open/write (specifically the QURT RTOS)
-    int fd = open(fname, O_WRONLY|O_CREAT|O_CLOEXEC, 0644);
-    free(fname);
-    if (fd == -1) {
-        _open_error = true;
-        return 0xFFFF;
-    }
-
-    char buf[30];
-    snprintf(buf, sizeof(buf), "%u\r\n", (unsigned)log_num);
-    const ssize_t to_write = strlen(buf);
-    const ssize_t written = write(fd, buf, to_write);
-    close(fd);
-
-    if (written < to_write) {
-        _open_error = true;
-        return 0xFFFF;
-    }
+#if DATAFLASH_FILE_COMPRESS
+    // the setting is latched per log, a file is either all blocks or
+    // all plain messages
+    _compressing = (_encoder != nullptr);
+    if (_compressing) {
+        _encoder->reset();
+    }
+    _block_len = 0;
+    _block_ofs = 0;
+#endif
+    _write_fd = fd;
 
     return log_num;
 }
@@ -1078,7 +1203,7 @@ void DataFlash_File::flush(void)
 {
     uint32_t tnow = AP_HAL::millis();
     hal.scheduler->suspend_timer_procs();
-    while (_write_fd != -1 && _initialised && !_open_error && _writebuf.available()) {
+    while (_write_fd != -1 && _initialised && !_open_error && _io_pending()) {
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         if (tnow > 2001) { // avoid resetting _last_write_time to 0
@@ -1093,13 +1218,89 @@ void DataFlash_File::flush(void)
 }
 #endif
 
+// true if there is log data not yet written to the file
+bool DataFlash_File::_io_pending() const
+{
+#if DATAFLASH_FILE_COMPRESS
+    if (_block_ofs < _block_len) {
+        return true;
+    }
+#endif
+    return _writebuf.available() != 0;
+}
+
+/*
+  check for free space at most once per _free_space_check_interval,
+  stopping logging if we are out of it
+ */
+bool DataFlash_File::_io_space_ok(uint32_t tnow)
+{
+    if (tnow - _free_space_last_check_time > _free_space_check_interval) {
+        _free_space_last_check_time = tnow;
+        if (disk_space_avail() < _free_space_min_avail) {
+            hal.console->printf("Out of space for logging\n");
+            _close_write_fd();
+            _open_error = true; // prevent logging starting again
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  account for a write to the log file. Returns false if it failed
+ */
+bool DataFlash_File::_io_write_done(ssize_t nwritten, uint32_t write_us)
+{
+    if (nwritten <= 0) {
+        hal.util->perf_count(_perf_errors);
+        close(_write_fd);
+        _write_fd = -1;
+        _initialised = false;
+        return false;
+    }
+    _write_offset += nwritten;
+    _io_stats.writes++;
+    _io_stats.bytes_written += nwritten;
+    _io_stats.write_max_us = MAX(_io_stats.write_max_us, write_us);
+    return true;
+}
+
 void DataFlash_File::_io_timer(void)
 {
     uint32_t tnow = AP_HAL::millis();
     _io_timer_heartbeat = tnow;
-    if (_write_fd == -1 || !_initialised || _open_error) {
+    // holding write_fd_semaphore keeps the file and its write state
+    // from changing under us
+    if (!write_fd_semaphore->take_nonblocking()) {
         return;
     }
+    if (_stop_pending) {
+        // stop_logging() found us writing and left the file to us
+        _close_write_fd();
+    }
+    // the buffer only drains here, so its fill level just before we
+    // take from it is its high-water mark
+    _io_stats.buffer_max_used = MAX(_io_stats.buffer_max_used, _writebuf.available());
+    if (_write_fd != -1 && _initialised && !_open_error) {
+        _io_timer_write(tnow);
+    }
+    write_fd_semaphore->give();
+}
+
+/*
+  write out buffered log data. Called from _io_timer() with
+  write_fd_semaphore held
+ */
+void DataFlash_File::_io_timer_write(uint32_t tnow)
+{
+
+#if DATAFLASH_FILE_COMPRESS
+    if (_compressing) {
+        _io_timer_compressed(tnow);
+        return;
+    }
+#endif
 
     uint32_t nbytes = _writebuf.available();
     if (nbytes == 0) {
@@ -1111,19 +1312,20 @@ void DataFlash_File::_io_timer(void)
         // least once per 2 seconds if data is available
         return;
     }
-    if (tnow - _free_space_last_check_time > _free_space_check_interval) {
-        _free_space_last_check_time = tnow;
-        if (disk_space_avail() < _free_space_min_avail) {
-            hal.console->printf("Out of space for logging\n");
-            stop_logging();
-            _open_error = true; // prevent logging starting again
-            return;
-        }
+    if (!_io_space_ok(tnow)) {
+        return;
     }
 
     hal.util->perf_begin(_perf_write);
 
     _last_write_time = tnow;
+#if DATAFLASH_FILE_WRITEV
+    // writev() lets us send the whole wrapped buffer in one call, so
+    // only limit the batch to keep the time spent in one call bounded
+    if (nbytes > 8U * _writebuf_chunk) {
+        nbytes = 8U * _writebuf_chunk;
+    }
+#else
     if (nbytes > _writebuf_chunk) {
         // be kind to the FAT PX4 filesystem
         nbytes = _writebuf_chunk;
@@ -1132,6 +1334,7 @@ void DataFlash_File::_io_timer(void)
     uint32_t size;
     const uint8_t *head = _writebuf.readptr(size);
     nbytes = MIN(nbytes, size);
+#endif
 
     // try to align writes on a 512 byte boundary to avoid filesystem reads
     if ((nbytes + _write_offset) % 512 != 0) {
@@ -1141,27 +1344,112 @@ void DataFlash_File::_io_timer(void)
         }
     }
 
+    const uint32_t write_start_us = AP_HAL::micros();
+#if DATAFLASH_FILE_WRITEV
+    ByteBuffer::IoVec vec[2];
+    const uint8_t n_vec = _writebuf.peekiovec(vec, nbytes);
+    struct iovec iov[2];
+    for (uint8_t i=0; i<n_vec; i++) {
+        iov[i].iov_base = vec[i].data;
+        iov[i].iov_len = vec[i].len;
+    }
+    ssize_t nwritten = ::writev(_write_fd, iov, n_vec);
+#else
     ssize_t nwritten = ::write(_write_fd, head, nbytes);
-    if (nwritten <= 0) {
-        hal.util->perf_count(_perf_errors);
-        close(_write_fd);
-        _write_fd = -1;
-        _initialised = false;
-    } else {
-        _write_offset += nwritten;
-        _writebuf.advance(nwritten);
-        /*
-          the best strategy for minimizing corruption on microSD cards
-          seems to be to write in 4k chunks and fsync the file on each
-          chunk, ensuring the directory entry is updated after each
-          write.
-         */
-#if CONFIG_HAL_BOARD != HAL_BOARD_SITL && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_QURT
-        ::fsync(_write_fd);
 #endif
+    if (_io_write_done(nwritten, AP_HAL::micros() - write_start_us)) {
+        _writebuf.advance(nwritten);
+        _io_stats.bytes_logged += nwritten;
+        _io_sync(nwritten);
+    }
+    hal.util->perf_end(_perf_write);
+}
+
+#if DATAFLASH_FILE_COMPRESS
+/*
+  encode the write buffer into blocks and write them out. A block is
+  only started once a full block of messages is waiting, as bigger
+  blocks compress better, or after 2 seconds without a write
+ */
+void DataFlash_File::_io_timer_compressed(uint32_t tnow)
+{
+    if (_block_ofs == _block_len) {
+        const uint32_t nbytes = _writebuf.available();
+        if (nbytes == 0) {
+            return;
+        }
+        if (nbytes < _block_raw_max &&
+            tnow - _last_write_time < 2000UL) {
+            return;
+        }
+        if (!_io_space_ok(tnow)) {
+            return;
+        }
+        const uint32_t encode_start_us = AP_HAL::micros();
+        const uint32_t n = _writebuf.peekbytes(_block_in, MIN(nbytes, _block_raw_max));
+        const uint32_t consumed = _encoder->encode(_block_in, n, _block_out, _block_len);
+        _writebuf.advance(consumed);
+        _block_ofs = 0;
+        _io_stats.bytes_logged += consumed;
+        _io_stats.encode_max_us = MAX(_io_stats.encode_max_us, AP_HAL::micros() - encode_start_us);
+        if (_block_len == 0) {
+            return;
+        }
+    }
+
+    hal.util->perf_begin(_perf_write);
+    _last_write_time = tnow;
+    const uint32_t write_start_us = AP_HAL::micros();
+    const ssize_t nwritten = ::write(_write_fd, &_block_out[_block_ofs], _block_len - _block_ofs);
+    if (_io_write_done(nwritten, AP_HAL::micros() - write_start_us)) {
+        _block_ofs += nwritten;
+        _io_sync(nwritten);
     }
     hal.util->perf_end(_perf_write);
 }
+#endif
+
+/*
+  the best strategy for minimizing corruption on microSD cards seems to
+  be to write in 4k chunks and fsync the file on each chunk, ensuring
+  the directory entry is updated after each write.
+
+  On Linux that fsync() blocks the IO thread until the card has taken
+  the data, during which the write buffer fills. Instead we start
+  writeback of the chunk just written and wait for the previous one,
+  which has had a whole write cycle to complete, so the card is busy
+  while we prepare the next write. A full fsync() still happens once a
+  second to keep the file size on disk up to date.
+ */
+void DataFlash_File::_io_sync(uint32_t nwritten)
+{
+#if DATAFLASH_FILE_SYNC_RANGE
+    hal.util->perf_begin(_perf_fsync);
+    const uint32_t sync_start_us = AP_HAL::micros();
+    const uint32_t chunk_start = _write_offset - nwritten;
+    ::sync_file_range(_write_fd, chunk_start, nwritten, SYNC_FILE_RANGE_WRITE);
+    if (_sync_pending_len != 0) {
+        ::sync_file_range(_write_fd, _sync_pending_offset, _sync_pending_len,
+                          SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER);
+    }
+    _sync_pending_offset = chunk_start;
+    _sync_pending_len = nwritten;
+
+    const uint32_t tnow = AP_HAL::millis();
+    if (tnow - _last_fsync_time >= 1000) {
+        _last_fsync_time = tnow;
+        ::fsync(_write_fd);
+    }
+    _io_stats.sync_max_us = MAX(_io_stats.sync_max_us, AP_HAL::micros() - sync_start_us);
+    hal.util->perf_end(_perf_fsync);
+#elif CONFIG_HAL_BOARD != HAL_BOARD_SITL && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_QURT
+    hal.util->perf_begin(_perf_fsync);
+    const uint32_t sync_start_us = AP_HAL::micros();
+    ::fsync(_write_fd);
+    _io_stats.sync_max_us = MAX(_io_stats.sync_max_us, AP_HAL::micros() - sync_start_us);
+    hal.util->perf_end(_perf_fsync);
+#endif
+}
 
 // this sensor is enabled if we should be logging at the moment
 bool DataFlash_File::logging_enabled() const
@@ -23,6 +23,31 @@
 #define DATAFLASH_FILE_MINIMAL 0
 #endif
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+// write both halves of a wrapped ring buffer with a single writev()
+#define DATAFLASH_FILE_WRITEV 1
+#else
+#define DATAFLASH_FILE_WRITEV 0
+#endif
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE
+// start writeback of each chunk with sync_file_range() and only wait
+// for the previous chunk, instead of fsync()ing every chunk
+#define DATAFLASH_FILE_SYNC_RANGE 1
+#else
+#define DATAFLASH_FILE_SYNC_RANGE 0
+#endif
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+// optionally write logs as compressed blocks, see DFBlockCodec.h
+#define DATAFLASH_FILE_COMPRESS 1
+#include "DFBlockCodec.h"
+// most messages encoded into one block
+#define DATAFLASH_FILE_BLOCK_RAW 16384U
+#else
+#define DATAFLASH_FILE_COMPRESS 0
+#endif
+
 class DataFlash_File : public DataFlash_Backend
 {
 public:
@@ -67,6 +92,8 @@ public:
     void periodic_1Hz(const uint32_t now) override;
     void periodic_fullrate(const uint32_t now) override;
 
+    bool get_io_stats(DataFlash_Class::io_stats &stats) override;
+
     // this method is used when reporting system status over mavlink
     bool logging_enabled() const override;
     bool logging_failed() const override;
@@ -134,8 +161,42 @@ private:
     uint32_t _get_log_time(const uint16_t log_num) const;
 
     void stop_logging(void) override;
+    void _close_write_fd(void);
+    uint16_t _open_new_log(void);
+
+    // set when the log is stopped while the IO thread is writing. The
+    // IO thread then closes the file
+    volatile bool _stop_pending = false;
 
     void _io_timer(void);
+    void _io_timer_write(uint32_t tnow);
+    bool _io_space_ok(uint32_t tnow);
+    bool _io_write_done(ssize_t nwritten, uint32_t write_us);
+    void _io_sync(uint32_t nwritten);
+
+#if DATAFLASH_FILE_COMPRESS
+    // block compression in the IO thread, only allocated when
+    // LOG_FILE_COMPRESS is set
+    DFBlockEncoder *_encoder = nullptr;
+    uint8_t *_block_in = nullptr;  // messages being encoded
+    uint8_t *_block_out = nullptr; // encoded block being written
+    uint32_t _block_raw_max = 0;
+    uint32_t _block_len = 0;       // length of the block in _block_out
+    uint32_t _block_ofs = 0;       // bytes of it already written
+    bool _compressing = false;     // the current log is compressed
+
+    void _compress_init(uint32_t bufsize);
+    void _io_timer_compressed(uint32_t tnow);
+#endif
+    bool _io_pending() const;
+
+#if DATAFLASH_FILE_SYNC_RANGE
+    // start of the chunk whose writeback has been started but not
+    // waited for, and its length
+    uint32_t _sync_pending_offset = 0;
+    uint32_t _sync_pending_len = 0;
+    uint32_t _last_fsync_time = 0;
+#endif
 
     uint32_t critical_message_reserved_space() const {
         // possibly make this a proportional to buffer size?
@@ -166,6 +227,9 @@ private:
     const uint32_t _free_space_min_avail = 8388608; // bytes
 
     AP_HAL::Semaphore *semaphore;
+    // held by the IO thread while it writes, and by anything that
+    // changes _write_fd
+    AP_HAL::Semaphore *write_fd_semaphore;
     
     // performance counters
     AP_HAL::Util::perf_counter_t  _perf_write;
@@ -0,0 +1,154 @@
+#include <AP_gbenchmark.h>
+
+#include <stdarg.h>
+
+#include <DataFlash/DataFlash.h>
+#include <DataFlash/DataFlash_Backend.h>
+#include <DataFlash/DFMessageWriter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  cost of writing a dynamic message with Log_Write() against a
+  LogMessage, both for the lookup done by DataFlash_Class and for the
+  packing done by the backend. The backend is never started, so blocks
+  are dropped by the ShouldLog() check both paths share
+ */
+class DataFlash_Null : public DataFlash_Backend {
+public:
+    DataFlash_Null(DataFlash_Class &front, DFMessageWriter_DFLogStart *writer) :
+        DataFlash_Backend(front, writer) {}
+
+    bool CardInserted(void) const override { return true; }
+    void EraseAll() override {}
+    bool NeedPrep() override { return false; }
+    void Prep() override {}
+    uint16_t find_last_log() override { return 0; }
+    void get_log_boundaries(uint16_t log_num, uint16_t & start_page, uint16_t & end_page) override {}
+    void get_log_info(uint16_t log_num, uint32_t &size, uint32_t &time_utc) override {}
+    int16_t get_log_data(uint16_t log_num, uint16_t page, uint32_t offset, uint16_t len, uint8_t *data) override { return 0; }
+    uint16_t get_num_logs() override { return 0; }
+    void LogReadProcess(const uint16_t list_entry,
+                        uint16_t start_page, uint16_t end_page,
+                        print_mode_fn printMode,
+                        AP_HAL::BetterStream *port) override {}
+    void DumpPageInfo(AP_HAL::BetterStream *port) override {}
+    void ShowDeviceInfo(AP_HAL::BetterStream *port) override {}
+    void ListAvailableLogs(AP_HAL::BetterStream *port) override {}
+    bool logging_started(void) const override { return true; }
+    uint32_t bufferspace_available() override { return 4096; }
+    uint16_t start_new_log(void) override { return 0; }
+    void stop_logging(void) override {}
+    bool logging_enabled() const override { return true; }
+    bool logging_failed() const override { return false; }
+
+protected:
+    bool WritesOK() const override { return true; }
+    bool ReadBlock(void *pkt, uint16_t size) override { return false; }
+    bool _WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical) override { return true; }
+};
+
+static AP_Int32 log_bitmask;
+static DataFlash_Class dataflash("benchmark", log_bitmask);
+static DFMessageWriter_DFLogStart writer("benchmark");
+static DataFlash_Null backend(dataflash, &writer);
+
+static const char *other_names[] = {
+    "BM00", "BM01", "BM02", "BM03", "BM04", "BM05", "BM06", "BM07",
+    "BM08", "BM09", "BM10", "BM11", "BM12", "BM13", "BM14", "BM15",
+};
+
+/*
+  a vehicle registers a number of dynamic messages; ours is found after
+  walking past all of them
+ */
+static void register_other_messages()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    for (uint8_t i=0; i<ARRAY_SIZE(other_names); i++) {
+        dataflash.Log_Write(other_names[i], "TimeUS,V", "Qf", AP_HAL::micros64(), 0.0);
+    }
+    done = true;
+}
+
+static bool backend_log_write(uint8_t msg_type, ...)
+{
+    va_list ap;
+    va_start(ap, msg_type);
+    bool ret = backend.Log_Write(msg_type, ap);
+    va_end(ap);
+    return ret;
+}
+
+static void BM_LogWrite(benchmark::State& state)
+{
+    register_other_messages();
+    float v = 0;
+
+    while (state.KeepRunning()) {
+        dataflash.Log_Write("BMLW", "TimeUS,A,B,C,D,E", "Qfffff",
+                            AP_HAL::micros64(), (double)v, (double)v, (double)v, (double)v, (double)v);
+        v += 0.1f;
+    }
+}
+
+static void BM_LogMessage(benchmark::State& state)
+{
+    register_other_messages();
+    DATAFLASH_LOG_MESSAGE(msg, "BMLM", "TimeUS,A,B,C,D,E", "Qfffff",
+                          uint64_t, float, float, float, float, float);
+    float v = 0;
+
+    while (state.KeepRunning()) {
+        msg.write(AP_HAL::micros64(), v, v, v, v, v);
+        v += 0.1f;
+    }
+}
+
+/*
+  the per-write work of a backend: interpreting the format string
+  against a va_list, or copying a packet packed at the call site
+ */
+static void BM_LogWriteBackend(benchmark::State& state)
+{
+    DATAFLASH_LOG_MESSAGE(msg, "BMLB", "TimeUS,A,B,C,D,E", "Qfffff",
+                          uint64_t, float, float, float, float, float);
+    msg.write(0, 0, 0, 0, 0, 0);
+    const uint8_t msg_type = msg.msg_type();
+    float v = 0;
+
+    while (state.KeepRunning()) {
+        backend_log_write(msg_type, AP_HAL::micros64(),
+                          (double)v, (double)v, (double)v, (double)v, (double)v);
+        v += 0.1f;
+    }
+}
+
+static void BM_LogMessageBackend(benchmark::State& state)
+{
+    typedef DataFlash_LogFields<uint64_t, float, float, float, float, float> fields;
+    DATAFLASH_LOG_MESSAGE(msg, "BMMB", "TimeUS,A,B,C,D,E", "Qfffff",
+                          uint64_t, float, float, float, float, float);
+    msg.write(0, 0, 0, 0, 0, 0);
+    float v = 0;
+
+    while (state.KeepRunning()) {
+        uint8_t pkt[LOG_PACKET_HEADER_LEN + fields::size];
+        pkt[0] = HEAD_BYTE1;
+        pkt[1] = HEAD_BYTE2;
+        pkt[2] = msg.msg_type();
+        fields::pack(&pkt[LOG_PACKET_HEADER_LEN], AP_HAL::micros64(), v, v, v, v, v);
+        backend.WriteBlock(pkt, sizeof(pkt));
+        v += 0.1f;
+    }
+}
+
+BENCHMARK(BM_LogWrite);
+BENCHMARK(BM_LogMessage);
+BENCHMARK(BM_LogWriteBackend);
+BENCHMARK(BM_LogMessageBackend);
+
+BENCHMARK_MAIN()
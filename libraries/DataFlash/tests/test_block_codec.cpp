@@ -0,0 +1,271 @@
+#include <AP_gtest.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <AP_Math/AP_Math.h>
+#include <DataFlash/DFBlockCodec.h>
+#include <DataFlash/LogStructure.h>
+
+#define LOG_TEST_MSG  1
+#define LOG_OTHER_MSG 2
+#define LOG_ARRAY_MSG 3
+
+struct PACKED log_Test {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    float roll;
+    float pitch;
+    int32_t lat;
+    int16_t temp;
+    uint8_t status;
+    char name[16];
+};
+
+struct PACKED log_Other {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    double alt;
+    uint16_t count;
+};
+
+// 'a' is not a format the codec can split
+struct PACKED log_Array {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    int16_t data[32];
+};
+
+class LogBuilder {
+public:
+    uint8_t data[200000];
+    uint32_t len = 0;
+
+    void add(const void *msg, uint8_t size) {
+        memcpy(&data[len], msg, size);
+        len += size;
+    }
+
+    void add_fmt(uint8_t type, uint8_t length, const char *name, const char *format) {
+        struct log_Format f {};
+        f.head1 = HEAD_BYTE1;
+        f.head2 = HEAD_BYTE2;
+        f.msgid = LOG_FORMAT_MSG;
+        f.type = type;
+        f.length = length;
+        strncpy(f.name, name, sizeof(f.name));
+        strncpy(f.format, format, sizeof(f.format));
+        add(&f, sizeof(f));
+    }
+
+    // a flight-like log: mostly smooth sensor data at different rates
+    void build(uint32_t n) {
+        add_fmt(LOG_FORMAT_MSG, sizeof(struct log_Format), "FMT", "BBnNZ");
+        add_fmt(LOG_TEST_MSG, sizeof(struct log_Test), "TST", "QffLcBN");
+        add_fmt(LOG_OTHER_MSG, sizeof(struct log_Other), "OTH", "QdH");
+        add_fmt(LOG_ARRAY_MSG, sizeof(struct log_Array), "ARR", "Qa");
+        for (uint32_t i = 0; i < n; i++) {
+            struct log_Test t {};
+            t.head1 = HEAD_BYTE1;
+            t.head2 = HEAD_BYTE2;
+            t.msgid = LOG_TEST_MSG;
+            t.time_us = 1000000 + i * 2500 + (random() % 20);
+            t.roll = sinf(i * 0.01f) * 0.3f;
+            t.pitch = -0.05f + (random() % 100) * 1.0e-5f;
+            t.lat = -353632610 + i / 10;
+            t.temp = 4500 + (random() % 3);
+            t.status = (i / 1000) & 1;
+            strncpy(t.name, "flying", sizeof(t.name));
+            add(&t, sizeof(t));
+            if (i % 4 == 0) {
+                struct log_Other o {};
+                o.head1 = HEAD_BYTE1;
+                o.head2 = HEAD_BYTE2;
+                o.msgid = LOG_OTHER_MSG;
+                o.time_us = t.time_us + 100;
+                o.alt = 584.0 + i * 0.001;
+                o.count = i / 4;
+                add(&o, sizeof(o));
+            }
+            if (i % 50 == 0) {
+                struct log_Array a {};
+                a.head1 = HEAD_BYTE1;
+                a.head2 = HEAD_BYTE2;
+                a.msgid = LOG_ARRAY_MSG;
+                a.time_us = t.time_us + 200;
+                for (uint8_t j = 0; j < 32; j++) {
+                    a.data[j] = random() % 200 - 100;
+                }
+                add(&a, sizeof(a));
+            }
+        }
+    }
+};
+
+/*
+  encode data in blocks of at most block_raw bytes, decode them again
+  and return the encoded size
+ */
+static uint32_t roundtrip(const uint8_t *data, uint32_t len, uint32_t block_raw)
+{
+    DFBlockEncoder encoder;
+    DFBlockDecoder decoder;
+    EXPECT_TRUE(encoder.init(block_raw));
+
+    uint8_t *block = new uint8_t[DFBlockEncoder::max_block_length(block_raw)];
+    uint8_t *decoded = new uint8_t[len];
+    uint32_t ofs = 0;
+    uint32_t decoded_len = 0;
+    uint32_t encoded_len = 0;
+    while (ofs < len) {
+        uint32_t block_len;
+        const uint32_t n = encoder.encode(&data[ofs], MIN(len - ofs, block_raw), block, block_len);
+        EXPECT_GT(n, 0U);
+        if (n == 0) {
+            break;
+        }
+        ofs += n;
+        encoded_len += block_len;
+
+        EXPECT_TRUE(DFBlockDecoder::is_block(block, block_len));
+        EXPECT_EQ(block_len, DFBlockDecoder::block_length(block));
+        EXPECT_EQ(n, DFBlockDecoder::raw_length(block));
+        EXPECT_TRUE(decoder.decode(block, block_len, &decoded[decoded_len]));
+        decoded_len += n;
+    }
+    EXPECT_EQ(len, decoded_len);
+    EXPECT_EQ(0, memcmp(data, decoded, len));
+    delete[] block;
+    delete[] decoded;
+    return encoded_len;
+}
+
+TEST(DFBlockCodecTest, RoundTrip)
+{
+    static LogBuilder log;
+    srandom(1);
+    log.build(3000);
+
+    const uint32_t encoded = roundtrip(log.data, log.len, 16384);
+    // smooth data should compress well
+    EXPECT_LT(encoded, log.len / 3);
+
+    // block boundaries fall in different places with other sizes
+    roundtrip(log.data, log.len, 4096);
+    roundtrip(log.data, log.len, 1000);
+}
+
+/*
+  bytes that don't parse as messages are passed through unchanged
+ */
+TEST(DFBlockCodecTest, Garbage)
+{
+    static LogBuilder log;
+    srandom(2);
+    log.build(200);
+    const uint32_t ofs = log.len;
+    for (uint16_t i = 0; i < 777; i++) {
+        log.data[log.len++] = random();
+    }
+    log.build(200);
+    // the second FMT messages repeat the first ones
+    memcpy(&log.data[log.len], log.data, ofs);
+    log.len += ofs;
+
+    roundtrip(log.data, log.len, 4096);
+}
+
+/*
+  redefining a type used earlier in the same block ends the block
+ */
+TEST(DFBlockCodecTest, Redefine)
+{
+    static LogBuilder log;
+    srandom(3);
+    log.build(20);
+    log.add_fmt(LOG_OTHER_MSG, sizeof(struct log_Test), "OTH", "QffLcBN");
+    for (uint8_t i = 0; i < 20; i++) {
+        struct log_Test t {};
+        t.head1 = HEAD_BYTE1;
+        t.head2 = HEAD_BYTE2;
+        t.msgid = LOG_OTHER_MSG;
+        t.time_us = i;
+        log.add(&t, sizeof(t));
+    }
+
+    roundtrip(log.data, log.len, 16384);
+}
+
+TEST(DFBlockCodecTest, PartialMessage)
+{
+    static LogBuilder log;
+    log.build(1);
+
+    DFBlockEncoder encoder;
+    ASSERT_TRUE(encoder.init(4096));
+    static uint8_t block[8192];
+    uint32_t block_len;
+    // only the first FMT message is complete
+    EXPECT_EQ(sizeof(struct log_Format),
+              encoder.encode(log.data, sizeof(struct log_Format) + 10, block, block_len));
+    EXPECT_EQ(0U, encoder.encode(log.data + sizeof(struct log_Format), 10, block, block_len));
+    EXPECT_EQ(0U, block_len);
+}
+
+TEST(DFBlockCodecTest, Corrupt)
+{
+    static LogBuilder log;
+    srandom(4);
+    log.build(500);
+
+    DFBlockEncoder encoder;
+    DFBlockDecoder decoder;
+    ASSERT_TRUE(encoder.init(16384));
+    static uint8_t block[32768];
+    static uint8_t decoded[16384];
+    uint32_t block_len;
+    encoder.encode(log.data, 16384, block, block_len);
+
+    // a block cut short by a crash
+    EXPECT_FALSE(decoder.decode(block, block_len - 1, decoded));
+    block[0] = 0;
+    EXPECT_EQ(0U, DFBlockDecoder::block_length(block));
+}
+
+TEST(DFBlockCodecTest, LZ)
+{
+    static uint8_t src[50000];
+    static uint8_t dst[60000];
+    static uint8_t out[50000];
+    uint16_t hash_table[DF_LZ_HASH_SIZE];
+
+    // repetitive data compresses
+    for (uint32_t i = 0; i < sizeof(src); i++) {
+        src[i] = (i % 37) * 3;
+    }
+    uint32_t n = df_lz_compress(src, sizeof(src), dst, sizeof(dst), hash_table);
+    EXPECT_GT(n, 0U);
+    EXPECT_LT(n, sizeof(src) / 20);
+    EXPECT_EQ(sizeof(src), df_lz_decompress(dst, n, out, sizeof(out)));
+    EXPECT_EQ(0, memcmp(src, out, sizeof(src)));
+
+    // random data does not, and must not overflow dst
+    srandom(5);
+    for (uint32_t i = 0; i < sizeof(src); i++) {
+        src[i] = random();
+    }
+    EXPECT_EQ(0U, df_lz_compress(src, sizeof(src), dst, sizeof(src), hash_table));
+    n = df_lz_compress(src, sizeof(src), dst, sizeof(dst), hash_table);
+    EXPECT_GT(n, 0U);
+    EXPECT_EQ(sizeof(src), df_lz_decompress(dst, n, out, sizeof(out)));
+    EXPECT_EQ(0, memcmp(src, out, sizeof(src)));
+
+    // short inputs are all literals
+    for (uint8_t len = 0; len < 20; len++) {
+        n = df_lz_compress(src, len, dst, sizeof(dst), hash_table);
+        EXPECT_EQ(len, df_lz_decompress(dst, n, out, sizeof(out)));
+    }
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,144 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "HarmonicNotchFilter.h"
+
+#include <AP_HAL/AP_HAL.h>
+
+const AP_Param::GroupInfo HarmonicNotchFilterParams::var_info[] = {
+
+    // @Param: ENABLE
+    // @DisplayName: Harmonic Notch Filter enable
+    // @Description: Harmonic Notch Filter enable
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO_FLAGS("ENABLE", 1, HarmonicNotchFilterParams, _enable, 0, AP_PARAM_FLAG_ENABLE),
+
+    // @Param: FREQ
+    // @DisplayName: Harmonic Notch Filter base frequency
+    // @Description: Notch centre frequency of the base harmonic. When the frequency follows throttle or RPM this is the lowest it will go
+    // @Units: Hz
+    // @Range: 10 400
+    // @User: Advanced
+    AP_GROUPINFO("FREQ", 2, HarmonicNotchFilterParams, _center_freq_hz, 80),
+
+    // @Param: BW
+    // @DisplayName: Harmonic Notch Filter bandwidth
+    // @Description: Bandwidth of each notch
+    // @Units: Hz
+    // @Range: 5 100
+    // @User: Advanced
+    AP_GROUPINFO("BW", 3, HarmonicNotchFilterParams, _bandwidth_hz, 40),
+
+    // @Param: ATT
+    // @DisplayName: Harmonic Notch Filter attenuation
+    // @Description: Attenuation at the centre of each notch
+    // @Units: dB
+    // @Range: 5 30
+    // @User: Advanced
+    AP_GROUPINFO("ATT", 4, HarmonicNotchFilterParams, _attenuation_dB, 15),
+
+    // @Param: HMNCS
+    // @DisplayName: Harmonic Notch Filter harmonics
+    // @Description: Bitmask of harmonics to notch. The first harmonic is the base frequency
+    // @Bitmask: 0:1st harmonic,1:2nd harmonic,2:3rd harmonic,3:4th harmonic,4:5th harmonic,5:6th harmonic,6:7th harmonic,7:8th harmonic
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("HMNCS", 5, HarmonicNotchFilterParams, _harmonics, 3),
+
+    // @Param: REF
+    // @DisplayName: Harmonic Notch Filter reference value
+    // @Description: In throttle mode the throttle (0 to 1) at which the motors run at FREQ. In RPM mode the ratio of notch frequency to RPM sensor frequency. Zero disables tracking
+    // @Range: 0.0 1.0
+    // @User: Advanced
+    AP_GROUPINFO("REF", 6, HarmonicNotchFilterParams, _reference, 0),
+
+    // @Param: MODE
+    // @DisplayName: Harmonic Notch Filter tracking mode
+    // @Description: How the base frequency of the notches is set
+    // @Values: 0:Fixed,1:Throttle,2:RPM Sensor
+    // @User: Advanced
+    AP_GROUPINFO("MODE", 7, HarmonicNotchFilterParams, _tracking_mode, TRACKING_THROTTLE),
+
+    AP_GROUPEND
+};
+
+HarmonicNotchFilterParams::HarmonicNotchFilterParams(void)
+{
+    AP_Param::setup_object_defaults(this, var_info);
+}
+
+template <class T>
+HarmonicNotchFilter<T>::~HarmonicNotchFilter()
+{
+    delete[] _filters;
+}
+
+template <class T>
+void HarmonicNotchFilter<T>::allocate_filters(uint8_t harmonics)
+{
+    delete[] _filters;
+    _filters = nullptr;
+    _num_filters = 0;
+
+    uint8_t count = 0;
+    for (uint8_t i=0; i<HNF_MAX_HARMONICS; i++) {
+        if (harmonics & (1U<<i)) {
+            _multiplier[count++] = i+1;
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+    _filters = new NotchFilter<T>[count];
+    if (_filters == nullptr) {
+        AP_HAL::panic("Failed to allocate %u notch filters", (unsigned)count);
+    }
+    _num_filters = count;
+}
+
+template <class T>
+void HarmonicNotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB)
+{
+    // keep the same Q for all harmonics, so bandwidth scales with frequency
+    for (uint8_t i=0; i<_num_filters; i++) {
+        const float m = _multiplier[i];
+        _filters[i].init(sample_freq_hz, center_freq_hz * m, bandwidth_hz * m, attenuation_dB);
+    }
+}
+
+template <class T>
+T HarmonicNotchFilter<T>::apply(const T &sample)
+{
+    T output = sample;
+    for (uint8_t i=0; i<_num_filters; i++) {
+        output = _filters[i].apply(output);
+    }
+    return output;
+}
+
+template <class T>
+void HarmonicNotchFilter<T>::reset()
+{
+    for (uint8_t i=0; i<_num_filters; i++) {
+        _filters[i].reset();
+    }
+}
+
+/*
+ * Make an instances
+ * Otherwise we have to move the constructor implementations to the header file :P
+ */
+template class HarmonicNotchFilter<Vector3f>;
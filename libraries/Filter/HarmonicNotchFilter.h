@@ -0,0 +1,93 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/// @file   HarmonicNotchFilter.h
+/// @brief  A bank of notch filters on a base frequency and its harmonics
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+#include "NotchFilter.h"
+
+// maximum number of harmonics, the first being the base frequency
+#define HNF_MAX_HARMONICS 8
+
+/*
+  notch filters on the base frequency and a chosen set of its
+  harmonics, for removing motor and propeller noise. The base
+  frequency can be moved while running to follow motor speed
+ */
+template <class T>
+class HarmonicNotchFilter {
+public:
+    HarmonicNotchFilter() : _filters(nullptr), _num_filters(0) {}
+    ~HarmonicNotchFilter();
+
+    // allocate a filter for each bit set in the harmonics mask. Bit
+    // 0 is the base frequency, bit 1 twice the base frequency and so on
+    void allocate_filters(uint8_t harmonics);
+
+    // set the parameters of all the notches. Harmonics above the
+    // Nyquist frequency are disabled
+    void init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB);
+
+    // apply all the notches to one sample
+    T apply(const T &sample);
+
+    // clear the state of all the notches
+    void reset();
+
+private:
+    NotchFilter<T> *_filters;
+    // multiple of the base frequency for each filter
+    uint8_t _multiplier[HNF_MAX_HARMONICS];
+    uint8_t _num_filters;
+};
+
+typedef HarmonicNotchFilter<Vector3f> HarmonicNotchFilterVector3f;
+
+/*
+  parameters for a harmonic notch filter
+ */
+class HarmonicNotchFilterParams {
+public:
+    // how the base frequency follows the vehicle
+    enum Tracking_Mode {
+        TRACKING_FIXED    = 0,
+        TRACKING_THROTTLE = 1,
+        TRACKING_RPM      = 2,
+    };
+
+    HarmonicNotchFilterParams(void);
+
+    bool enabled(void) const { return _enable != 0; }
+    float center_freq_hz(void) const { return _center_freq_hz; }
+    float bandwidth_hz(void) const { return _bandwidth_hz; }
+    float attenuation_dB(void) const { return _attenuation_dB; }
+    uint8_t harmonics(void) const { return _harmonics; }
+    float reference(void) const { return _reference; }
+    enum Tracking_Mode tracking_mode(void) const { return (enum Tracking_Mode)_tracking_mode.get(); }
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+private:
+    AP_Int8 _enable;
+    AP_Float _center_freq_hz;
+    AP_Float _bandwidth_hz;
+    AP_Float _attenuation_dB;
+    AP_Int8 _harmonics;
+    AP_Float _reference;
+    AP_Int8 _tracking_mode;
+};
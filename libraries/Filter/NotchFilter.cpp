@@ -0,0 +1,121 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "NotchFilter.h"
+
+/*
+  calculate the coefficients of the notch. The filter is disabled
+  (passes samples unchanged) if the notch does not fit below the
+  Nyquist frequency
+ */
+template <class T>
+void NotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB)
+{
+    if (_initialised &&
+        is_equal(sample_freq_hz, _sample_freq_hz) &&
+        is_equal(center_freq_hz, _center_freq_hz) &&
+        is_equal(bandwidth_hz, _bandwidth_hz) &&
+        is_equal(attenuation_dB, _attenuation_dB)) {
+        return;
+    }
+
+    _sample_freq_hz = sample_freq_hz;
+    _center_freq_hz = center_freq_hz;
+    _bandwidth_hz = bandwidth_hz;
+    _attenuation_dB = attenuation_dB;
+
+    const float half_bw = bandwidth_hz * 0.5f;
+    if (center_freq_hz <= half_bw || bandwidth_hz <= 0 ||
+        center_freq_hz + half_bw >= sample_freq_hz * 0.5f) {
+        _initialised = false;
+        return;
+    }
+
+    // quality factor from the bandwidth in octaves
+    const float octaves = log2f(center_freq_hz / (center_freq_hz - half_bw)) * 2.0f;
+    const float pow_octaves = powf(2.0f, octaves);
+    const float Q = sqrtf(pow_octaves) / (pow_octaves - 1.0f);
+
+    // depth of the notch, 0 is a full notch
+    const float A = powf(10.0f, -attenuation_dB / 40.0f);
+
+    const float omega = 2.0f * M_PI * center_freq_hz / sample_freq_hz;
+    const float alpha = sinf(omega) / (2.0f * Q);
+    const float a0_inv = 1.0f / (1.0f + alpha);
+
+    _b0 = (1.0f + alpha * A * A) * a0_inv;
+    _b1 = -2.0f * cosf(omega) * a0_inv;
+    _b2 = (1.0f - alpha * A * A) * a0_inv;
+    _a1 = _b1;
+    _a2 = (1.0f - alpha) * a0_inv;
+
+    if (!_initialised) {
+        reset();
+    }
+    _initialised = true;
+}
+
+template <class T>
+T NotchFilter<T>::apply(const T &sample)
+{
+    if (!_initialised) {
+        return sample;
+    }
+
+    T output = sample * _b0 + _x1 * _b1 + _x2 * _b2 - _y1 * _a1 - _y2 * _a2;
+
+    _x2 = _x1;
+    _x1 = sample;
+    _y2 = _y1;
+    _y1 = output;
+
+    return output;
+}
+
+template <class T>
+void NotchFilter<T>::reset()
+{
+    _x1 = _x2 = _y1 = _y2 = T();
+}
+
+/*
+  Vector3f version with the three axes written out, so the compiler
+  keeps the state in registers and can vectorise across axes
+ */
+template <>
+Vector3f NotchFilter<Vector3f>::apply(const Vector3f &sample)
+{
+    if (!_initialised) {
+        return sample;
+    }
+
+    Vector3f output;
+    output.x = _b0 * sample.x + _b1 * _x1.x + _b2 * _x2.x - _a1 * _y1.x - _a2 * _y2.x;
+    output.y = _b0 * sample.y + _b1 * _x1.y + _b2 * _x2.y - _a1 * _y1.y - _a2 * _y2.y;
+    output.z = _b0 * sample.z + _b1 * _x1.z + _b2 * _x2.z - _a1 * _y1.z - _a2 * _y2.z;
+
+    _x2 = _x1;
+    _x1 = sample;
+    _y2 = _y1;
+    _y1 = output;
+
+    return output;
+}
+
+/*
+ * Make an instances
+ * Otherwise we have to move the constructor implementations to the header file :P
+ */
+template class NotchFilter<float>;
+template class NotchFilter<Vector3f>;
@@ -0,0 +1,63 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/// @file   NotchFilter.h
+/// @brief  A second order (biquad) notch filter
+
+#include <AP_Math/AP_Math.h>
+#include <cmath>
+#include <inttypes.h>
+
+/*
+  a biquad band-stop filter with configurable centre frequency,
+  bandwidth and attenuation. The filter is implemented in direct form
+  I so the centre frequency can be moved while running without large
+  transients
+ */
+template <class T>
+class NotchFilter {
+public:
+    NotchFilter() : _initialised(false) {}
+
+    // set filter parameters. Coefficients are only recalculated
+    // when a parameter has changed
+    void init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB);
+
+    // apply the filter to one sample
+    T apply(const T &sample);
+
+    // clear the filter state
+    void reset();
+
+    float get_center_freq_hz(void) const { return _center_freq_hz; }
+    bool initialised(void) const { return _initialised; }
+
+private:
+    bool _initialised;
+    float _sample_freq_hz;
+    float _center_freq_hz;
+    float _bandwidth_hz;
+    float _attenuation_dB;
+
+    // normalised coefficients (a0 == 1)
+    float _b0, _b1, _b2, _a1, _a2;
+
+    // previous inputs and outputs
+    T _x1, _x2, _y1, _y2;
+};
+
+typedef NotchFilter<float> NotchFilterFloat;
+typedef NotchFilter<Vector3f> NotchFilterVector3f;
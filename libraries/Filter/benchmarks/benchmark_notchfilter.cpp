@@ -0,0 +1,88 @@
+#include <AP_gbenchmark.h>
+
+#include <Filter/HarmonicNotchFilter.h>
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/NotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  per-sample cost of the gyro filters at the 8kHz raw gyro rate
+ */
+static const float sample_rate = 8000;
+
+#define NUM_SAMPLES 256
+
+static Vector3f samples[NUM_SAMPLES];
+
+static void fill_samples()
+{
+    for (uint16_t i=0; i<NUM_SAMPLES; i++) {
+        const float t = i / sample_rate;
+        samples[i] = Vector3f(sinf(2 * M_PI * 90 * t),
+                              cosf(2 * M_PI * 180 * t),
+                              sinf(2 * M_PI * 35 * t));
+    }
+}
+
+static void BM_LowPassFilter2pVector3f(benchmark::State& state)
+{
+    fill_samples();
+    LowPassFilter2pVector3f filter(sample_rate, 20);
+    uint16_t i = 0;
+
+    while (state.KeepRunning()) {
+        Vector3f out = filter.apply(samples[i++ % NUM_SAMPLES]);
+        gbenchmark_escape(&out);
+    }
+}
+
+static void BM_NotchFilterVector3f(benchmark::State& state)
+{
+    fill_samples();
+    NotchFilterVector3f filter;
+    filter.init(sample_rate, 90, 40, 15);
+    uint16_t i = 0;
+
+    while (state.KeepRunning()) {
+        Vector3f out = filter.apply(samples[i++ % NUM_SAMPLES]);
+        gbenchmark_escape(&out);
+    }
+}
+
+static void BM_HarmonicNotchFilterVector3f(benchmark::State& state)
+{
+    fill_samples();
+    HarmonicNotchFilterVector3f filter;
+    filter.allocate_filters((1U << state.range_x()) - 1);
+    filter.init(sample_rate, 90, 40, 15);
+    uint16_t i = 0;
+
+    while (state.KeepRunning()) {
+        Vector3f out = filter.apply(samples[i++ % NUM_SAMPLES]);
+        gbenchmark_escape(&out);
+    }
+}
+
+/*
+  cost of moving the notch, done once per main loop when tracking
+  throttle or RPM
+ */
+static void BM_HarmonicNotchFilterUpdate(benchmark::State& state)
+{
+    HarmonicNotchFilterVector3f filter;
+    filter.allocate_filters(0x3);
+    float freq = 90;
+
+    while (state.KeepRunning()) {
+        freq = freq < 200 ? freq + 0.1f : 90;
+        filter.init(sample_rate, freq, 40, 15);
+    }
+}
+
+BENCHMARK(BM_LowPassFilter2pVector3f);
+BENCHMARK(BM_NotchFilterVector3f);
+BENCHMARK(BM_HarmonicNotchFilterVector3f)->DenseRange(1, 4);
+BENCHMARK(BM_HarmonicNotchFilterUpdate);
+
+BENCHMARK_MAIN()
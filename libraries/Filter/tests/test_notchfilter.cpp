@@ -0,0 +1,87 @@
+#include <AP_gtest.h>
+
+#include <Filter/HarmonicNotchFilter.h>
+#include <Filter/NotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const float sample_rate = 1000;
+
+/*
+  run a sine wave at freq through the filter and return the peak
+  output amplitude once the filter has settled
+ */
+template <class F>
+static float sine_gain(F &filter, float freq)
+{
+    float peak = 0;
+    for (uint16_t i=0; i<4000; i++) {
+        const float t = i / sample_rate;
+        const float out = filter.apply(sinf(2 * M_PI * freq * t));
+        if (i >= 2000) {
+            peak = MAX(peak, fabsf(out));
+        }
+    }
+    return peak;
+}
+
+TEST(NotchFilterTest, Attenuation)
+{
+    NotchFilterFloat filter;
+    filter.init(sample_rate, 100, 20, 20);
+    EXPECT_NEAR(0.1f, sine_gain(filter, 100), 0.02f);
+}
+
+TEST(NotchFilterTest, PassBand)
+{
+    NotchFilterFloat low;
+    low.init(sample_rate, 100, 20, 40);
+    EXPECT_NEAR(1.0f, sine_gain(low, 10), 0.02f);
+
+    NotchFilterFloat high;
+    high.init(sample_rate, 100, 20, 40);
+    EXPECT_NEAR(1.0f, sine_gain(high, 250), 0.02f);
+}
+
+TEST(NotchFilterTest, AboveNyquistPassesThrough)
+{
+    NotchFilterFloat filter;
+    filter.init(sample_rate, 495, 20, 40);
+    EXPECT_FALSE(filter.initialised());
+    EXPECT_FLOAT_EQ(0.5f, filter.apply(0.5f));
+}
+
+TEST(NotchFilterTest, Vector3fMatchesFloat)
+{
+    NotchFilterFloat f;
+    NotchFilterVector3f v;
+    f.init(sample_rate, 80, 30, 25);
+    v.init(sample_rate, 80, 30, 25);
+    for (uint16_t i=0; i<500; i++) {
+        const float x = sinf(i * 0.7f) + 0.3f * cosf(i * 2.1f);
+        const float expected = f.apply(x);
+        const Vector3f out = v.apply(Vector3f(x, -x, 2 * x));
+        EXPECT_FLOAT_EQ(expected, out.x);
+        EXPECT_FLOAT_EQ(-expected, out.y);
+        EXPECT_FLOAT_EQ(2 * expected, out.z);
+    }
+}
+
+TEST(HarmonicNotchFilterTest, Harmonics)
+{
+    HarmonicNotchFilterVector3f filter;
+    // base frequency and 3rd harmonic
+    filter.allocate_filters(0x5);
+    filter.init(sample_rate, 60, 20, 40);
+
+    struct sine_x {
+        HarmonicNotchFilterVector3f &f;
+        float apply(float x) { return f.apply(Vector3f(x, 0, 0)).x; }
+    } wrapper { filter };
+
+    EXPECT_LT(sine_gain(wrapper, 60), 0.05f);
+    EXPECT_LT(sine_gain(wrapper, 180), 0.05f);
+    EXPECT_GT(sine_gain(wrapper, 120), 0.8f);
+}
+
+AP_GTEST_MAIN()
@@ -18,6 +18,8 @@
 #include <AP_HAL/utility/RingBuffer.h>
 #include <AP_Frsky_Telem/AP_Frsky_Telem.h>
 #include <AP_ServoRelayEvents/AP_ServoRelayEvents.h>
+#include <AP_GyroFFT/AP_GyroFFT.h>
+#include <AP_Scheduler/AP_Scheduler.h>
 
 // check if a message will fit in the payload space available
 #define HAVE_PAYLOAD_SPACE(chan, id) (comm_get_txspace(chan) >= GCS_MAVLINK::packet_overhead_chan(chan)+MAVLINK_MSG_ID_ ## id ## _LEN)
@@ -74,6 +76,8 @@ enum ap_message {
     MSG_BATTERY_STATUS,
     MSG_AOA_SSA,
     MSG_LANDING,
+    MSG_GYRO_FFT,
+    MSG_SCHED_STATS,
     MSG_RETRY_DEFERRED // this must be last
 };
 
@@ -172,6 +176,8 @@ public:
     void send_autopilot_version(uint8_t major_version, uint8_t minor_version, uint8_t patch_version, uint8_t version_type) const;
     void send_local_position(const AP_AHRS &ahrs) const;
     void send_vibration(const AP_InertialSensor &ins) const;
+    bool send_gyro_fft(const AP_GyroFFT &fft) const;
+    bool send_sched_stats(const AP_Scheduler &scheduler);
     void send_home(const Location &home) const;
     void send_heartbeat(uint8_t type, uint8_t base_mode, uint32_t custom_mode, uint8_t system_status);
     void send_servo_output_raw(bool hil);
@@ -322,6 +328,9 @@ private:
     // this allows us to detect the user wanting the CLI to start
     uint8_t        crlf_count;
 
+    // next scheduler task to report in send_sched_stats()
+    uint8_t        sched_stats_task;
+
     // waypoints
     uint16_t        waypoint_dest_sysid; // where to send requests
     uint16_t        waypoint_dest_compid; // "
@@ -1527,6 +1527,73 @@ void GCS_MAVLINK::send_vibration(const AP_InertialSensor &ins) const
         ins.get_accel_clip_count(2));
 }
 
+/*
+  send gyro FFT noise peaks as NAMED_VALUE_FLOAT messages. Returns
+  false, sending nothing, if there isn't room for all of them
+ */
+bool GCS_MAVLINK::send_gyro_fft(const AP_GyroFFT &fft) const
+{
+    struct AP_GyroFFT::peaks peaks;
+    if (!fft.get_peaks(peaks)) {
+        return true;
+    }
+    const struct {
+        const char *name;
+        float value;
+    } values[] = {
+        { "FFT_FX",  peaks.freq_hz.x },
+        { "FFT_FY",  peaks.freq_hz.y },
+        { "FFT_FZ",  peaks.freq_hz.z },
+        { "FFT_EX",  peaks.energy.x },
+        { "FFT_EY",  peaks.energy.y },
+        { "FFT_EZ",  peaks.energy.z },
+        { "FFT_CTR", peaks.center_freq_hz },
+    };
+    // send all of the values or none, so a set is never split
+    if (comm_get_txspace(chan) < ARRAY_SIZE(values) * (packet_overhead() + MAVLINK_MSG_ID_NAMED_VALUE_FLOAT_LEN)) {
+        return false;
+    }
+    const uint32_t now = AP_HAL::millis();
+    for (uint8_t i=0; i<ARRAY_SIZE(values); i++) {
+        mavlink_msg_named_value_float_send(chan, now, values[i].name, values[i].value);
+    }
+    return true;
+}
+
+/*
+  send runtime statistics for one scheduler task as a DEBUG_VECT named
+  by the task's index and name, with x, y and z holding the average,
+  99th percentile and maximum runtime in microseconds. Successive calls walk through the task table
+ */
+bool GCS_MAVLINK::send_sched_stats(const AP_Scheduler &scheduler)
+{
+    if (scheduler.num_tasks() == 0) {
+        return true;
+    }
+    if (sched_stats_task >= scheduler.num_tasks()) {
+        sched_stats_task = 0;
+    }
+    const AP_Scheduler::TaskStats *stats = scheduler.task_stats(sched_stats_task);
+    if (stats == nullptr) {
+        return true;
+    }
+    CHECK_PAYLOAD_SIZE(DEBUG_VECT);
+    // names longer than the field would be ambiguous, so the task
+    // index leads the name, as in "12:update_"
+    char name[10];
+    hal.util->snprintf(name, sizeof(name), "%u:%s",
+                       (unsigned)sched_stats_task,
+                       scheduler.task_name(sched_stats_task));
+    mavlink_msg_debug_vect_send(chan,
+                                name,
+                                AP_HAL::micros64(),
+                                stats->count ? (float)stats->total_us / stats->count : 0.0f,
+                                AP_Scheduler::task_stats_percentile(*stats, 0.99f),
+                                stats->max_us);
+    sched_stats_task++;
+    return true;
+}
+
 void GCS_MAVLINK::send_home(const Location &home) const
 {
     if (HAVE_PAYLOAD_SPACE(chan, HOME_POSITION)) {
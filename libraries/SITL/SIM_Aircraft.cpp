@@ -214,7 +214,7 @@ void Aircraft::time_advance()
         time_now_us += frame_time_us;
     }
     last_time_us = time_now_us;
-    if (use_time_sync) {
+    if (use_time_sync && !lockstep) {
         sync_frame_time();
     }
 }
@@ -53,6 +53,15 @@ public:
      */
     void set_speedup(float speedup);
 
+    /*
+      set lockstep mode. The model is stepped only when the autopilot
+      waits for time to pass, and is never paced against the wall
+      clock, so the simulation runs as fast as the CPU allows
+     */
+    void set_lockstep(bool _lockstep) {
+        lockstep = _lockstep;
+    }
+
     /*
       set instance number
      */
@@ -162,6 +171,7 @@ protected:
     const char *autotest_dir;
     const char *frame;
     bool use_time_sync = true;
+    bool lockstep = false;
     float last_speedup = -1.0f;
 
     enum {